@@ -0,0 +1,91 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Ledger.h"
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+constexpr std::size_t kProbes = 4096;
+
+std::string cardNumber(std::size_t i) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "4000%012zu", i);
+    return buffer;
+}
+
+// N registered cards plus kProbes card numbers picked across them. Building 10M cards takes
+// a few seconds, so each size is built once per process and shared by the benchmarks.
+struct CardBase {
+    Ledger ledger;
+    AuthService auth{ledger};
+    std::vector<std::string> hits;
+    std::vector<std::string> misses;
+
+    explicit CardBase(std::size_t cards) {
+        auth.reserve(cards);
+        for (std::size_t i = 0; i < cards; ++i) {
+            auth.importCard(cardNumber(i), "1234", {}, false);
+        }
+        std::uint64_t rng = 0x9E3779B97F4A7C15ull;
+        for (std::size_t i = 0; i < kProbes; ++i) {
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            hits.push_back(cardNumber(rng % cards));
+            misses.push_back(cardNumber(cards + rng % cards));
+        }
+    }
+
+    static CardBase& get(std::size_t cards) {
+        static std::map<std::size_t, std::unique_ptr<CardBase>> bases;
+        std::unique_ptr<CardBase>& base = bases[cards];
+        if (!base) base = std::make_unique<CardBase>(cards);
+        return *base;
+    }
+};
+
+void cardCounts(benchmark::internal::Benchmark* bench) {
+    bench->Arg(1'000)->Arg(1'000'000)->Arg(10'000'000);
+}
+
+}  // namespace
+
+static void BM_AuthService_CheckIfCardExist(benchmark::State& state) {
+    CardBase& base = CardBase::get(static_cast<std::size_t>(state.range(0)));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base.auth.checkIfCardExist(base.hits[next]));
+        next = (next + 1) % kProbes;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AuthService_CheckIfCardExist)->Apply(cardCounts);
+
+static void BM_AuthService_CheckIfCardExistMiss(benchmark::State& state) {
+    CardBase& base = CardBase::get(static_cast<std::size_t>(state.range(0)));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base.auth.checkIfCardExist(base.misses[next]));
+        next = (next + 1) % kProbes;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AuthService_CheckIfCardExistMiss)->Apply(cardCounts);
+
+static void BM_AuthService_CheckPIN(benchmark::State& state) {
+    CardBase& base = CardBase::get(static_cast<std::size_t>(state.range(0)));
+    const std::string pin = "1234";
+    std::size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base.auth.checkPIN(pin, base.hits[next]));
+        next = (next + 1) % kProbes;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AuthService_CheckPIN)->Apply(cardCounts);
@@ -0,0 +1,54 @@
+#include "atm/machine/DispensePlanner.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+// A typical load: 100, 50, 20 and 10 notes, 2000 of each.
+std::vector<Cassette> typicalCassettes() {
+    return {{Money(10000), 2000}, {Money(5000), 2000}, {Money(2000), 2000}, {Money(1000), 2000}};
+}
+
+// Rebuilding the tables, as after every dispense or refill.
+void BM_DispensePlanner_Build(benchmark::State& state) {
+    const std::vector<Cassette> cassettes = typicalCassettes();
+    DispensePlanner planner;
+    for (auto _ : state) {
+        planner.build(cassettes);
+        benchmark::DoNotOptimize(planner.total());
+    }
+}
+BENCHMARK(BM_DispensePlanner_Build);
+
+// Looking up a plan, walking amounts of 10.00 to 2000.00 (inside the table).
+void BM_DispensePlanner_Plan(benchmark::State& state) {
+    const std::vector<Cassette> cassettes = typicalCassettes();
+    DispensePlanner planner;
+    planner.build(cassettes);
+    std::int64_t cents = 1000;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(planner.plan(Money(cents)));
+        cents = cents >= 200000 ? 1000 : cents + 1000;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DispensePlanner_Plan);
+
+// Rejecting an amount the notes cannot make up and proposing the nearest ones.
+void BM_DispensePlanner_RejectAndPropose(benchmark::State& state) {
+    const std::vector<Cassette> cassettes = typicalCassettes();
+    DispensePlanner planner;
+    planner.build(cassettes);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(planner.canDispense(Money(12345)));
+        benchmark::DoNotOptimize(planner.nearestBelow(Money(12345)));
+        benchmark::DoNotOptimize(planner.nearestAbove(Money(12345)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DispensePlanner_RejectAndPropose);
+
+}  // namespace
@@ -0,0 +1,93 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/Gateway.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <string>
+
+using namespace atm;
+
+namespace {
+
+// One card with one account; the benchmarks compare calling the Bank directly with the same
+// call through a Gateway (blocking, BankCall-based, and cached).
+struct OneCardBank {
+    Ledger ledger;
+    TransactionManager transactions{ledger};
+    AuthService auth{ledger};
+    Bank bank{transactions, auth};
+    AccountId account;
+    const std::string card = "4000000000000001";
+    const std::string pin = "1234";
+
+    OneCardBank() {
+        auth.setPinForCard(card, pin);
+        account = auth.addAccountToCard(card, SavingAccount("Savings", Money(1'000'000)));
+    }
+};
+
+}  // namespace
+
+static void BM_Bank_ShowBalance(benchmark::State& state) {
+    OneCardBank fixture;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.bank.showBalance(fixture.account));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Bank_ShowBalance);
+
+static void BM_Gateway_ShowBalance(benchmark::State& state) {
+    OneCardBank fixture;
+    Gateway gateway(fixture.bank);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gateway.showBalance(fixture.account));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Gateway_ShowBalance);
+
+static void BM_Gateway_ShowBalanceAsync(benchmark::State& state) {
+    // The path the state machine takes: start a BankCall, then read it.
+    OneCardBank fixture;
+    Gateway gateway(fixture.bank);
+    for (auto _ : state) {
+        BankCall<Money> call = gateway.showBalanceAsync(fixture.account);
+        benchmark::DoNotOptimize(call.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Gateway_ShowBalanceAsync);
+
+static void BM_Gateway_ShowBalanceCached(benchmark::State& state) {
+    OneCardBank fixture;
+    Gateway gateway(fixture.bank);
+    gateway.enableCache(std::chrono::seconds(60), 16);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gateway.showBalance(fixture.account));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Gateway_ShowBalanceCached);
+
+static void BM_Bank_Authenticate(benchmark::State& state) {
+    OneCardBank fixture;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.bank.authenticate(fixture.card, fixture.pin));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Bank_Authenticate);
+
+static void BM_Gateway_Authenticate(benchmark::State& state) {
+    OneCardBank fixture;
+    Gateway gateway(fixture.bank);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gateway.authenticate(fixture.card, fixture.pin));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Gateway_Authenticate);
@@ -0,0 +1,27 @@
+#include "atm/machine/Metrics.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdint>
+
+using namespace atm;
+
+namespace {
+
+Counter shardedCounter;
+std::atomic<std::uint64_t> sharedCounter{0};
+
+// Counter::inc: each thread adds to its own cache line.
+void BM_Metrics_CounterInc(benchmark::State& state) {
+    for (auto _ : state) shardedCounter.inc();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Metrics_CounterInc)->Threads(1)->Threads(4);
+
+// Baseline: one atomic all threads add to.
+void BM_Metrics_SharedAtomicInc(benchmark::State& state) {
+    for (auto _ : state) sharedCounter.fetch_add(1, std::memory_order_relaxed);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Metrics_SharedAtomicInc)->Threads(1)->Threads(4);
+
+}  // namespace
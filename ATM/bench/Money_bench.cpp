@@ -0,0 +1,42 @@
+#include "atm/bank/Money.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+std::vector<Money> amounts(std::size_t n) {
+    std::vector<Money> values;
+    values.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) values.emplace_back(static_cast<std::int64_t>((i * 7919) % 100000));
+    return values;
+}
+
+}  // namespace
+
+static void BM_Money_Sum(benchmark::State& state) {
+    const std::vector<Money> values = amounts(1024);
+    for (auto _ : state) {
+        Money total;
+        for (Money value : values) total += value;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(values.size()));
+}
+BENCHMARK(BM_Money_Sum);
+
+static void BM_Money_CompareAndSubtract(benchmark::State& state) {
+    // The shape of a withdrawal check: compare against a balance, then subtract.
+    const std::vector<Money> values = amounts(1024);
+    for (auto _ : state) {
+        Money balance(50'000'000);
+        for (Money value : values) {
+            if (value <= balance) balance = balance - value;
+        }
+        benchmark::DoNotOptimize(balance);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(values.size()));
+}
+BENCHMARK(BM_Money_CompareAndSubtract);
@@ -0,0 +1,51 @@
+#include "atm/bank/RequestDedupe.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+using namespace atm;
+
+namespace {
+
+// begin + finish for a new request in a full table of state.range(0) requests (each one evicts
+// the oldest in its probe window); each thread uses its own ids.
+void BM_RequestDedupe_NewRequest(benchmark::State& state) {
+    static RequestDedupe* dedupe = nullptr;
+    const std::size_t requests = static_cast<std::size_t>(state.range(0));
+    if (state.thread_index() == 0) {
+        dedupe = new RequestDedupe(requests);
+        for (RequestId id = 1; id <= requests * 2; ++id) {
+            dedupe->begin(id, 0, nullptr);
+            dedupe->finish(id, true);
+        }
+    }
+    RequestId id = (static_cast<RequestId>(state.thread_index()) + 1) << 40;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dedupe->begin(++id, 0, nullptr));
+        dedupe->finish(id, true);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete dedupe;
+        dedupe = nullptr;
+    }
+}
+BENCHMARK(BM_RequestDedupe_NewRequest)->Arg(1 << 16)->Arg(1 << 22)->Threads(1)->Threads(4);
+
+// A retry answered from the table.
+void BM_RequestDedupe_Repeat(benchmark::State& state) {
+    RequestDedupe dedupe(1 << 16);
+    for (RequestId id = 1; id <= 1024; ++id) {
+        dedupe.begin(id, 0, nullptr);
+        dedupe.finish(id, true);
+    }
+    RequestId id = 0;
+    bool result = false;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dedupe.begin(id % 1024 + 1, 0, &result));
+        ++id;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RequestDedupe_Repeat);
+
+}  // namespace
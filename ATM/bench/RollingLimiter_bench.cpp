@@ -0,0 +1,31 @@
+#include "atm/bank/RollingLimiter.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+using namespace atm;
+
+namespace {
+
+// tryAdd against a table sized for state.range(0) cards, all of them in use; each thread walks
+// its own stride of keys.
+void BM_RollingLimiter_TryAdd(benchmark::State& state) {
+    static RollingLimiter* limiter = nullptr;
+    const std::uint64_t cards = static_cast<std::uint64_t>(state.range(0));
+    if (state.thread_index() == 0) {
+        limiter = new RollingLimiter(1'000'000'000, cards + cards / 2);
+        for (std::uint64_t key = 1; key <= cards; ++key) limiter->tryAdd(key, 1, 0);
+    }
+    std::uint64_t key = static_cast<std::uint64_t>(state.thread_index()) * 7919 % cards;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(limiter->tryAdd(key + 1, 1, 0));
+        key = (key + 104729) % cards;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete limiter;
+        limiter = nullptr;
+    }
+}
+BENCHMARK(BM_RollingLimiter_TryAdd)->Arg(1 << 10)->Arg(1 << 20)->Threads(1)->Threads(4);
+
+}  // namespace
@@ -0,0 +1,64 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/ATM.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/Hardware.h"
+#include "atm/machine/ScriptedUserInterface.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+
+using namespace atm;
+
+namespace {
+
+// Runs whole sessions (card in to card out) through ATM::runOnce with a scripted customer.
+void runSessions(benchmark::State& state, const char* script) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("bench1", "1234");
+    auth.addAccountToCard("bench1", SavingAccount("Savings", Money(1'000'000'000)));
+    Bank bank(transactions, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    AtmConfig config;
+    config.initialCashCents = 1'000'000'000'000;
+    auto dispenser = std::make_shared<CashDispenser>(Money(config.initialCashCents));
+    auto sessions = std::make_shared<SessionScript>();
+    if (!sessions->append(script)) {
+        state.SkipWithError("bad session script");
+        return;
+    }
+    auto ui = std::make_shared<ScriptedUserInterface>(sessions);
+    ATM atm(ui, dispenser, std::make_shared<DepositSlot>(*dispenser), gateway, config);
+
+    std::int64_t steps = 0;
+    for (auto _ : state) {
+        const std::uint64_t done = ui->sessionsDone();
+        while (ui->sessionsDone() == done || atm.getCurrentState() != StateId::Idle) {
+            atm.runOnce();
+            ++steps;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["steps/session"] = static_cast<double>(steps) / static_cast<double>(state.iterations());
+}
+
+}  // namespace
+
+static void BM_Session_Balance(benchmark::State& state) {
+    runSessions(state, "bench1 1234 1 B\n");
+}
+BENCHMARK(BM_Session_Balance);
+
+static void BM_Session_WithdrawDeposit(benchmark::State& state) {
+    runSessions(state, "bench1 1234 1 W2000 D2000\n");
+}
+BENCHMARK(BM_Session_WithdrawDeposit);
+
+static void BM_Session_WrongPinThenBalance(benchmark::State& state) {
+    runSessions(state, "bench1 0000,1234 1 B B\n");
+}
+BENCHMARK(BM_Session_WrongPinThenBalance);
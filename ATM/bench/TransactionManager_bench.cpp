@@ -0,0 +1,57 @@
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+// Accounts spread over the ledger's shards; state.range(0) is the account count.
+struct Accounts {
+    Ledger ledger;
+    TransactionManager transactions{ledger};
+    std::vector<AccountId> ids;
+
+    explicit Accounts(std::size_t count) {
+        ids.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            ids.push_back(ledger.openAccount(SavingAccount("Bench", Money(1'000'000'000'000))));
+        }
+    }
+};
+
+}  // namespace
+
+static void BM_TransactionManager_Withdraw(benchmark::State& state) {
+    Accounts accounts(static_cast<std::size_t>(state.range(0)));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(accounts.transactions.withdrawCash(accounts.ids[next], Money(100)));
+        if (++next == accounts.ids.size()) next = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransactionManager_Withdraw)->Arg(1)->Arg(1024);
+
+static void BM_TransactionManager_Deposit(benchmark::State& state) {
+    Accounts accounts(static_cast<std::size_t>(state.range(0)));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(accounts.transactions.depositCash(accounts.ids[next], Money(100)));
+        if (++next == accounts.ids.size()) next = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransactionManager_Deposit)->Arg(1)->Arg(1024);
+
+// Every refusal is logged, so this measures the cost a withdrawal storm puts on the caller.
+static void BM_TransactionManager_WithdrawRefused(benchmark::State& state) {
+    Accounts accounts(1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(accounts.transactions.withdrawCash(accounts.ids[0], Money(-1)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransactionManager_WithdrawRefused)->Threads(1)->Threads(4);
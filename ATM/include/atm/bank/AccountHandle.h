@@ -0,0 +1,21 @@
+#pragma once
+// AccountHandle.h - Stable account ID and the lightweight handle sessions hold.
+
+#include <cstdint>
+#include <string>
+
+namespace atm {
+
+/// Stable bank-side account identifier (0 is never assigned).
+using AccountId = std::uint64_t;
+
+/// Value that no ledger account ever uses.
+inline constexpr AccountId kInvalidAccountId = 0;
+
+/// Reference to a ledger account as seen by the ATM: ID plus display name, no balance.
+struct AccountHandle {
+    AccountId id = kInvalidAccountId;
+    std::string name;
+};
+
+}  // namespace atm
@@ -0,0 +1,60 @@
+#pragma once
+// AsyncBankAdapter.h - Runs a blocking IBankService behind the IAsyncBankService interface.
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "atm/bank/IAsyncBankService.h"
+#include "atm/bank/IBankService.h"
+
+namespace atm {
+
+/// Adapts a blocking bank (e.g. Bank) to IAsyncBankService. With no workers each call runs
+/// inline and returns an already-completed BankCall; with workers calls run on a small
+/// thread pool and complete from there, so the caller's thread is never blocked.
+class AsyncBankAdapter : public IAsyncBankService {
+public:
+    /// Constructs the adapter.
+    /// @param service Blocking bank to call; must be safe to call from the worker threads.
+    /// @param workers Worker threads (0 = answer inline on the caller's thread).
+    explicit AsyncBankAdapter(IBankService& service, unsigned workers = 0);
+    /// Finishes queued requests, then stops the workers.
+    ~AsyncBankAdapter() override;
+
+    AsyncBankAdapter(const AsyncBankAdapter&) = delete;
+    AsyncBankAdapter& operator=(const AsyncBankAdapter&) = delete;
+
+    BankCall<bool> checkIfCardExist(const std::string& card) override;
+    BankCall<bool> checkPIN(const std::string& pin, const std::string& card) override;
+    BankCall<AuthResult> authenticate(const std::string& card, const std::string& pin) override;
+    BankCall<bool> blockCard(const std::string& card) override;
+    BankCall<Money> showBalance(AccountId account) override;
+    BankCall<bool> withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                RequestId request) override;
+    BankCall<bool> depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) override;
+    BankCall<bool> reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                               RequestId hold) override;
+    BankCall<std::optional<bool>> commitCash(RequestId hold) override;
+    BankCall<bool> releaseCash(RequestId hold) override;
+    BankCall<std::vector<HistoryEntry>> getMiniStatement(AccountId account, std::size_t count) override;
+    BankCall<std::vector<AccountHandle>> getAccountListForCard(const std::string& card) override;
+
+private:
+    /// Runs fn() inline or on a worker and returns its result as a BankCall.
+    template <typename T, typename Fn>
+    BankCall<T> submit(Fn fn);
+    void workerLoop();
+
+    IBankService& service_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::deque<std::function<void()>> queue_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace atm
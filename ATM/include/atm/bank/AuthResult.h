@@ -0,0 +1,26 @@
+#pragma once
+// AuthResult.h - Outcome of one combined card + PIN + accounts authentication call.
+
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+
+namespace atm {
+
+/// Whether the bank knows the card and will accept it.
+enum class CardStatus { Active, Unknown, Blocked };
+
+/// Whether the PIN matched; NotChecked when the card is not active.
+enum class PinVerdict { Accepted, Rejected, NotChecked };
+
+/// Everything a login needs, returned by IBankService::authenticate in one response.
+struct AuthResult {
+    CardStatus cardStatus = CardStatus::Unknown;
+    PinVerdict pinVerdict = PinVerdict::NotChecked;
+    /// Wrong PINs the bank still allows before it wants the card blocked.
+    int remainingAttempts = 0;
+    /// Accounts linked to the card; filled only when the PIN was accepted.
+    std::vector<AccountHandle> accounts;
+};
+
+}  // namespace atm
@@ -1,16 +1,44 @@
 #pragma once
-// AuthService.h - Card and PIN validation, account list per card.
+// AuthService.h - Card and PIN validation, account list per card (one flat CardIndex).
+#include <cstdint>
+#include <functional>
+#include <shared_mutex>
+#include <span>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
 
 #include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
+#include "atm/bank/CardIndex.h"
+#include "atm/bank/Ledger.h"
 
 namespace atm {
 
+class SnapshotView;
+struct SnapshotCard;
+
+/// One card as exported for snapshots (PINs only as digests).
+struct CardRecordView {
+    std::string_view card;
+    bool hasPin = false;
+    std::uint64_t pinDigest = 0;
+    bool blocked = false;
+    std::span<const AccountId> accounts;
+};
+
+/// Card registry; safe to call from several threads (e.g. AsyncBankAdapter workers).
 class AuthService {
 public:
+    /// Wrong PINs allowed before authenticate reports no attempts left.
+    static constexpr int kDefaultMaxPinAttempts = 3;
+
+    /// Constructs the service on top of the ledger that holds the card's accounts.
+    /// @param ledger Ledger where linked accounts live.
+    /// @param maxPinAttempts Wrong PINs allowed (counted across sessions, reset on success).
+    explicit AuthService(Ledger& ledger, int maxPinAttempts = kDefaultMaxPinAttempts);
+
     /// Returns true if the card is registered and not blocked.
     /// @param card Card number to check.
     /// @return true if card is registered and not blocked.
@@ -20,26 +48,62 @@ public:
     /// @param card Card number.
     /// @return true if PIN matches.
     bool checkPIN(const std::string& pin, const std::string& card) const;
+    /// Checks card and PIN with one index lookup and returns the linked accounts if accepted.
+    /// A wrong PIN increments the card's failed-attempt count; a right one resets it.
+    /// @param card Card number.
+    /// @param pin PIN to verify.
+    /// @return Card status, PIN verdict, remaining attempts and accounts.
+    AuthResult authenticate(const std::string& card, const std::string& pin);
     /// Blocks the card so it can no longer be used.
     /// @param card Card number to block.
     void blockCard(const std::string& card);
-    /// Returns the accounts linked to the card.
+    /// Returns handles for the accounts linked to the card.
+    /// @param card Card number.
+    /// @return Account handles linked to the card (empty if unknown).
+    std::vector<AccountHandle> getAccountListForCard(const std::string& card) const;
+    /// Opens the account in the ledger and links it to a card.
     /// @param card Card number.
-    /// @return Accounts linked to the card (empty if unknown).
-    std::vector<Account> getAccountListForCard(const std::string& card) const;
-    /// Links an account to a card.
+    /// @param account Name and opening balance of the new account.
+    /// @return ID of the new ledger account.
+    AccountId addAccountToCard(const std::string& card, const Account& account);
+    /// Links an existing ledger account to a card (e.g. a joint account).
     /// @param card Card number.
-    /// @param account Account to link.
-    void addAccountToCard(const std::string& card, const Account& account);
+    /// @param id ID of an account already in the ledger.
+    void linkAccountToCard(const std::string& card, AccountId id);
     /// Sets the PIN for a card.
     /// @param card Card number.
     /// @param pin PIN to associate with the card.
     void setPinForCard(const std::string& card, const std::string& pin);
+    /// Registers a card in one call (bulk provisioning): PIN, linked accounts, blocked flag.
+    /// @param card Card number.
+    /// @param pin PIN (empty leaves the current PIN unchanged).
+    /// @param accounts Ledger account IDs to link.
+    /// @param blocked true to register the card as blocked.
+    void importCard(std::string_view card, std::string_view pin, std::span<const AccountId> accounts,
+                    bool blocked);
+    /// Pre-sizes the card tables.
+    /// @param cards Expected number of additional cards.
+    void reserve(std::size_t cards);
+    /// Answers lookups for cards not registered in memory from a mapped snapshot.
+    /// Cards set up in memory afterwards take precedence; blocks from either side apply.
+    /// @param snapshot Snapshot to consult; must outlive the service.
+    void attachSnapshot(const SnapshotView* snapshot);
+    /// Calls fn once per known card (snapshot and in-memory, merged).
+    /// @param fn Visitor.
+    void forEachCard(const std::function<void(const CardRecordView&)>& fn) const;
 
 private:
-    std::unordered_map<std::string, std::vector<Account>> cardAccount_;
-    std::unordered_set<std::string> blockedCards_;
-    std::unordered_map<std::string, std::string> cardToPIN_;
+    const SnapshotCard* findSnapshotCard(std::string_view card) const;
+    static bool isBlocked(const CardRecord* record, const SnapshotCard* snapshotCard);
+    std::span<const AccountId> accountIdsOf(const CardRecord* record, const SnapshotCard* snapshotCard) const;
+    std::vector<AccountHandle> handlesFor(std::span<const AccountId> ids) const;
+
+    Ledger& ledger_;
+    int maxPinAttempts_;
+    const SnapshotView* snapshot_ = nullptr;
+    // Readers (logins, lookups) share the lock; provisioning and blocks take it exclusively.
+    mutable std::shared_mutex mutex_;
+    CardIndex cards_;
 };
 
 }  // namespace atm
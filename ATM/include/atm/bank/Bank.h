@@ -24,31 +24,75 @@ public:
     /// @param card Card number.
     /// @return true if PIN matches the one stored for the card.
     bool checkPIN(const std::string& pin, const std::string& card) override;
+    /// Checks card and PIN and returns the linked accounts in one call.
+    /// @param card Card number.
+    /// @param pin PIN entered by user.
+    /// @return Card status, PIN verdict, remaining attempts and accounts.
+    AuthResult authenticate(const std::string& card, const std::string& pin) override;
     /// Blocks the card so it can no longer be used.
     /// @param card Card number to block.
     void blockCard(const std::string& card) override;
     /// Returns the current balance of the account.
     /// @param account Account to query.
     /// @return Current balance in cents.
-    Money showBalance(Account* account) override;
+    Money showBalance(AccountId account) override;
     /// Withdraws the amount from the account if valid and sufficient funds.
     /// @param account Account to debit.
     /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param request Id shared by every attempt of this withdrawal (newRequestId()); kNoRequest is not deduplicated.
     /// @return true if withdrawal succeeded.
-    bool withdrawCash(Account* account, Money amount) override;
+    bool withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId request) override;
     /// Deposits the amount into the account if non-negative.
     /// @param account Account to credit.
     /// @param amount Amount in cents.
+    /// @param terminal ATM taking the deposit.
+    /// @param request Id shared by every attempt of this deposit (newRequestId()); kNoRequest is not deduplicated.
     /// @return true if deposit succeeded.
-    bool depositCash(Account* account, Money amount) override;
+    bool depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) override;
+    /// Reserves funds for a withdrawal (TransactionManager::reserveWithdrawal); a repeat is answered from the
+    /// dedupe table if one is attached.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param hold Id of the withdrawal; names the hold.
+    /// @return true if the funds are held.
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override;
+    /// Makes a held withdrawal final.
+    /// @param hold Id passed to reserveCash.
+    /// @return true if the withdrawal is committed.
+    bool commitCash(RequestId hold) override;
+    /// Returns the funds of a held withdrawal.
+    /// @param hold Id passed to reserveCash.
+    /// @return true if the funds are back in the account.
+    bool releaseCash(RequestId hold) override;
+    /// Returns the account's most recent transactions (empty if the transaction manager keeps no history).
+    /// @param account Account to query.
+    /// @param count Maximum number of entries.
+    /// @return Entries, newest first.
+    std::vector<HistoryEntry> getMiniStatement(AccountId account, std::size_t count) override;
     /// Returns the list of accounts linked to the card.
     /// @param card Card number.
-    /// @return List of accounts linked to the card.
-    std::vector<Account> getAccountListForCard(const std::string& card) override;
+    /// @return Handles of the accounts linked to the card.
+    std::vector<AccountHandle> getAccountListForCard(const std::string& card) override;
+
+    /// Answers repeated withdrawals and deposits (same request id) from the table instead of running
+    /// them again. Calls with kNoRequest are not checked.
+    /// @param dedupe Table to use, or nullptr to turn deduplication off; must outlive the bank.
+    void setRequestDedupe(RequestDedupe* dedupe) { dedupe_ = dedupe; }
+    /// @return The attached dedupe table, or nullptr.
+    RequestDedupe* getRequestDedupe() const { return dedupe_; }
 
 private:
+    /// Runs op once per request id; repeats get the first result.
+    template <typename Op>
+    bool runOnce(RequestId request, std::uint64_t fingerprint, AccountId account, Money amount, Op op);
+
     TransactionManager& transactionManager_;
     AuthService& authService_;
+    RequestDedupe* dedupe_ = nullptr;
 };
 
 }  // namespace atm
@@ -0,0 +1,143 @@
+#pragma once
+// BankCall.h - Result of an asynchronous bank request: poll, wait, or get a completion callback.
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace atm {
+
+namespace detail {
+
+struct BankCallStateBase {
+    std::mutex mutex;
+    std::condition_variable completed;
+    bool ready = false;
+    std::vector<std::function<void()>> callbacks;
+
+    /// Marks the call complete and runs the callbacks (outside the lock).
+    void finish(std::unique_lock<std::mutex>& lock) {
+        ready = true;
+        std::vector<std::function<void()>> pending = std::move(callbacks);
+        lock.unlock();
+        completed.notify_all();
+        for (auto& callback : pending) callback();
+    }
+};
+
+template <typename T>
+struct BankCallState : BankCallStateBase {
+    std::optional<T> value;
+};
+
+}  // namespace detail
+
+/// Type-independent part of a BankCall: readiness, waiting and callbacks.
+/// Copies share the same request.
+class BankCallBase {
+public:
+    BankCallBase() = default;
+
+    /// Returns true if this refers to a request (default-constructed calls do not).
+    /// @return true if valid.
+    bool valid() const { return state_ != nullptr; }
+    /// Returns true once the bank has answered.
+    /// @return true if the result is available.
+    bool ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->ready;
+    }
+    /// Blocks the calling thread until the bank has answered.
+    void wait() const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->completed.wait(lock, [this] { return state_->ready; });
+    }
+    /// Runs fn once the bank has answered: immediately if it already has, otherwise on the
+    /// thread that completes the request.
+    /// @param fn Callback; must not block.
+    void onReady(std::function<void()> fn) const {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (!state_->ready) {
+            state_->callbacks.push_back(std::move(fn));
+            return;
+        }
+        lock.unlock();
+        fn();
+    }
+    /// Returns true if both refer to the same request.
+    /// @param other Call to compare with.
+    /// @return true if same request.
+    bool sameRequest(const BankCallBase& other) const { return state_ == other.state_; }
+
+protected:
+    explicit BankCallBase(std::shared_ptr<detail::BankCallStateBase> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<detail::BankCallStateBase> state_;
+};
+
+template <typename T>
+class BankPromise;
+
+/// Pending result of type T from an IAsyncBankService call.
+template <typename T>
+class BankCall : public BankCallBase {
+public:
+    BankCall() = default;
+
+    /// Creates a call that is already complete (e.g. answered inline).
+    /// @param value Result.
+    /// @return Completed call.
+    static BankCall completed(T value) {
+        auto state = std::make_shared<detail::BankCallState<T>>();
+        state->value = std::move(value);
+        state->ready = true;
+        return BankCall(std::move(state));
+    }
+
+    /// Returns the result, waiting for it if needed.
+    /// @return Result (a copy; the call keeps its own).
+    T get() const {
+        wait();
+        return *typed()->value;
+    }
+    /// Runs fn with the result once the bank has answered (see onReady).
+    /// @param fn Callback receiving the result.
+    void then(std::function<void(const T&)> fn) const {
+        auto state = typed();
+        onReady([state, fn = std::move(fn)] { fn(*state->value); });
+    }
+
+private:
+    friend class BankPromise<T>;
+    explicit BankCall(std::shared_ptr<detail::BankCallState<T>> state) : BankCallBase(std::move(state)) {}
+    std::shared_ptr<detail::BankCallState<T>> typed() const {
+        return std::static_pointer_cast<detail::BankCallState<T>>(state_);
+    }
+};
+
+/// Producer side of a BankCall; completed exactly once by whoever runs the request.
+template <typename T>
+class BankPromise {
+public:
+    BankPromise() : state_(std::make_shared<detail::BankCallState<T>>()) {}
+
+    /// Returns the call handed to the requester.
+    /// @return Call sharing this promise's result.
+    BankCall<T> call() const { return BankCall<T>(state_); }
+    /// Stores the result, wakes waiters and runs callbacks.
+    /// @param value Result.
+    void complete(T value) {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->value = std::move(value);
+        state_->finish(lock);
+    }
+
+private:
+    std::shared_ptr<detail::BankCallState<T>> state_;
+};
+
+}  // namespace atm
@@ -0,0 +1,128 @@
+#pragma once
+// BankProtocol.h - Binary wire format between ATMs (RemoteBankService) and atm_bank_server.
+//
+// Every message is a frame: u32 bodyLength, then the body
+//   u32 requestId, u8 opcode, arguments (requests) or results (responses).
+// Integers are little-endian; strings are u16 length + bytes. Responses echo the request's
+// id and opcode, so a connection can have many requests in flight and answers may come back
+// in any order.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
+#include "atm/bank/HistoryEntry.h"
+#include "atm/bank/Money.h"
+
+namespace atm {
+
+class IBankService;
+
+enum class BankOpcode : std::uint8_t {
+    CheckIfCardExist = 1,
+    CheckPin = 2,
+    Authenticate = 3,
+    BlockCard = 4,
+    ShowBalance = 5,
+    Withdraw = 6,
+    Deposit = 7,
+    GetAccountList = 8,
+    MiniStatement = 9,
+    Reserve = 10,
+    Commit = 11,
+    Release = 12,
+};
+
+namespace protocol {
+
+/// Bytes before the body (the u32 length).
+inline constexpr std::size_t kLengthPrefix = 4;
+/// Body bytes before the arguments (requestId + opcode).
+inline constexpr std::size_t kBodyHeader = 5;
+/// Largest body accepted; anything bigger is treated as a broken peer.
+inline constexpr std::uint32_t kMaxBody = 1 << 20;
+/// Most history entries one MiniStatement response carries (keeps it far below kMaxBody).
+inline constexpr std::uint16_t kMaxStatementEntries = 1024;
+
+/// Appends little-endian values and u16-prefixed strings to a frame under construction.
+class FrameWriter {
+public:
+    /// Starts a frame in out (appended after what is already there).
+    /// @param out Buffer to append to.
+    /// @param requestId Request id.
+    /// @param opcode Operation.
+    FrameWriter(std::string& out, std::uint32_t requestId, BankOpcode opcode);
+    /// Fills in the length prefix; call once after the last put.
+    void finish();
+
+    template <typename T>
+    void put(T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out_.append(bytes, sizeof(T));
+    }
+    void putString(std::string_view value);
+    void putAccounts(const std::vector<AccountHandle>& accounts);
+    void putAuthResult(const AuthResult& result);
+    void putHistory(const std::vector<HistoryEntry>& entries);
+
+private:
+    std::string& out_;
+    std::size_t start_;
+};
+
+/// Reads values back from a frame body; any overrun sets ok() to false.
+class FrameReader {
+public:
+    /// @param body Frame body (without the length prefix).
+    explicit FrameReader(std::string_view body);
+
+    std::uint32_t requestId() const { return requestId_; }
+    BankOpcode opcode() const { return opcode_; }
+    bool ok() const { return ok_; }
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (data_.size() - pos_ < sizeof(T)) {
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+    std::string getString();
+    std::vector<AccountHandle> getAccounts();
+    AuthResult getAuthResult();
+    std::vector<HistoryEntry> getHistory();
+
+private:
+    std::string_view data_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+    std::uint32_t requestId_ = 0;
+    BankOpcode opcode_ = BankOpcode::CheckIfCardExist;
+};
+
+/// Finds the next complete frame at the start of a receive buffer.
+/// @param buffer Bytes received so far.
+/// @return Total frame size (prefix + body), 0 if incomplete, nullopt if the length is invalid.
+std::optional<std::size_t> completeFrame(std::string_view buffer);
+
+/// Decodes one request body, runs it against the bank and appends the response frame.
+/// @param bank Bank to call.
+/// @param body Request body (without the length prefix).
+/// @param out Buffer to append the response frame to.
+/// @return false if the request was malformed (nothing appended).
+bool handleRequest(IBankService& bank, std::string_view body, std::string& out);
+
+}  // namespace protocol
+
+}  // namespace atm
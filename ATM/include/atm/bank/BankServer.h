@@ -0,0 +1,107 @@
+#pragma once
+// BankServer.h - Serves an IBankService over Unix/TCP sockets: one epoll loop, a worker pool.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "atm/bank/BankSocket.h"
+
+namespace atm {
+
+class IBankService;
+
+struct BankServerConfig {
+    /// Listen address, e.g. "unix:/tmp/atm-bank.sock" or "tcp:127.0.0.1:7070".
+    std::string address = "tcp:127.0.0.1:7070";
+    /// Threads running bank calls (0 = hardware concurrency).
+    unsigned workers = 0;
+};
+
+/// Counters for monitoring and the load generator.
+struct BankServerStats {
+    std::uint64_t connectionsAccepted = 0;
+    std::uint64_t connectionsOpen = 0;
+    std::uint64_t requests = 0;
+    /// Unparseable frames and requests that could not be answered; each closes its connection.
+    std::uint64_t malformed = 0;
+};
+
+/// The event loop thread accepts connections, reads request frames and writes responses.
+/// Complete requests go to the worker pool, which runs them against the bank and hands the
+/// encoded responses back to the loop through an eventfd. Linux only (epoll).
+class BankServer {
+public:
+    /// @param bank Bank to serve; called from the worker threads, so it must be thread-safe.
+    /// @param config Listen address and worker count.
+    BankServer(IBankService& bank, BankServerConfig config);
+    /// Stops the server if running.
+    ~BankServer();
+
+    BankServer(const BankServer&) = delete;
+    BankServer& operator=(const BankServer&) = delete;
+
+    /// Binds and starts the loop and workers.
+    /// @param error If not null, receives the reason on failure.
+    /// @return true if listening.
+    bool start(std::string* error = nullptr);
+    /// Closes all connections and joins the threads.
+    void stop();
+    /// Returns the bound address (resolves a TCP port of 0).
+    /// @return Address clients should connect to.
+    BankAddress address() const { return bound_; }
+    /// Returns the counters.
+    /// @return Snapshot of the counters.
+    BankServerStats stats() const;
+
+private:
+    struct Connection;
+    struct Task {
+        std::shared_ptr<Connection> connection;
+        std::string body;
+    };
+
+    void eventLoop();
+    void workerLoop();
+    void accept();
+    void readFrom(const std::shared_ptr<Connection>& connection);
+    void flush(const std::shared_ptr<Connection>& connection);
+    void close(const std::shared_ptr<Connection>& connection);
+    void setWriteInterest(Connection& connection, bool enabled);
+
+    IBankService& bank_;
+    BankServerConfig config_;
+    BankAddress bound_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread loop_;
+    std::vector<std::thread> workers_;
+
+    // Loop thread only.
+    std::unordered_map<int, std::shared_ptr<Connection>> connections_;
+
+    std::mutex taskMutex_;
+    std::condition_variable taskAvailable_;
+    std::deque<Task> tasks_;
+    bool stopping_ = false;
+
+    // Connections with responses waiting to be written (filled by workers, drained by the loop).
+    std::mutex readyMutex_;
+    std::vector<std::shared_ptr<Connection>> readyToWrite_;
+
+    std::atomic<std::uint64_t> accepted_{0};
+    std::atomic<std::uint64_t> open_{0};
+    std::atomic<std::uint64_t> requests_{0};
+    std::atomic<std::uint64_t> malformed_{0};
+};
+
+}  // namespace atm
@@ -0,0 +1,58 @@
+#pragma once
+// BankSocket.h - POSIX socket helpers shared by atm_bank_server and RemoteBankService.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace atm {
+
+/// Where the bank server listens: a Unix socket path or a TCP host and port.
+struct BankAddress {
+    enum class Kind { Unix, Tcp };
+    Kind kind = Kind::Tcp;
+    std::string path;
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 0;
+
+    /// Parses "unix:/path/to.sock", "tcp:host:port" or "host:port".
+    /// @param text Address text.
+    /// @return Address, or nullopt if malformed.
+    static std::optional<BankAddress> parse(std::string_view text);
+    /// Formats the address back into the parse() syntax.
+    /// @return Address text.
+    std::string toString() const;
+};
+
+namespace net {
+
+/// Opens a non-blocking listening socket (an existing Unix socket file is replaced).
+/// @param address Address to bind; a TCP port of 0 picks a free one (see localAddress).
+/// @param error If not null, receives the reason on failure.
+/// @return File descriptor, or -1.
+int listenOn(const BankAddress& address, std::string* error = nullptr);
+/// Returns the address a listening socket is bound to (resolves TCP port 0).
+/// @param fd Listening socket.
+/// @param address Address passed to listenOn.
+/// @return Bound address.
+BankAddress localAddress(int fd, const BankAddress& address);
+/// Connects a blocking socket (TCP_NODELAY set for TCP).
+/// @param address Server address.
+/// @param error If not null, receives the reason on failure.
+/// @return File descriptor, or -1.
+int connectTo(const BankAddress& address, std::string* error = nullptr);
+/// Switches a socket to non-blocking mode.
+/// @param fd Socket.
+/// @return true on success.
+bool setNonBlocking(int fd);
+/// Writes the whole buffer to a blocking socket.
+/// @return false if the peer went away.
+bool writeAll(int fd, const char* data, std::size_t size);
+/// Raises the soft open-file limit to the hard limit (for servers/clients with many sockets).
+void raiseFileLimit();
+
+}  // namespace net
+
+}  // namespace atm
@@ -0,0 +1,96 @@
+#pragma once
+// BulkLoader.h - Bulk import of cards and accounts from CSV or a compact binary format.
+//
+// CSV: one account per row, "card,pin,account_name,balance_cents[,blocked]". Rows of the same
+// card must be consecutive. An optional first line starting with "card," is a header. Fields
+// may be wrapped in double quotes (no embedded quotes).
+//
+// Binary: "ATMBULK1" followed by rows of
+//   u8 cardLen, card, u8 pinLen, pin, u16 nameLen, name, i64 balanceCents, u8 blocked
+// (little-endian).
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace atm {
+
+class AuthService;
+class Ledger;
+
+/// Bulk import tuning.
+struct BulkLoadOptions {
+    /// Worker threads for parsing and ledger inserts (0 = hardware concurrency).
+    unsigned threads = 0;
+};
+
+/// Outcome of a bulk import. On error nothing is imported.
+struct BulkLoadReport {
+    bool ok = false;
+    std::size_t rows = 0;
+    std::size_t cards = 0;
+    /// 1-based line (CSV) or row (binary) number of the first bad row; 0 if none.
+    std::size_t errorRow = 0;
+    std::string error;
+    double seconds = 0.0;
+
+    /// Returns rows imported per second.
+    /// @return Rows per second (0 if nothing was timed).
+    double rowsPerSecond() const { return seconds > 0.0 ? static_cast<double>(rows) / seconds : 0.0; }
+};
+
+/// One parsed row; views point into the caller's input buffer (no per-row allocation).
+struct BulkRow {
+    std::string_view card;
+    std::string_view pin;
+    std::string_view accountName;
+    std::int64_t balanceCents = 0;
+    bool blocked = false;
+};
+
+class BulkLoader {
+public:
+    /// Constructs a loader importing into the given services.
+    /// @param auth Auth service to register cards in.
+    /// @param ledger Ledger to open accounts in.
+    /// @param options Thread count.
+    BulkLoader(AuthService& auth, Ledger& ledger, BulkLoadOptions options = BulkLoadOptions{});
+
+    /// Imports a CSV file.
+    /// @param path CSV file path.
+    /// @return Report with rows/sec, or the first bad line.
+    BulkLoadReport loadCsvFile(const std::string& path);
+    /// Imports CSV text already in memory.
+    /// @param csv CSV text.
+    /// @return Report with rows/sec, or the first bad line.
+    BulkLoadReport loadCsv(std::string_view csv);
+    /// Imports a binary bulk file.
+    /// @param path Binary file path.
+    /// @return Report with rows/sec, or the first bad row.
+    BulkLoadReport loadBinaryFile(const std::string& path);
+    /// Imports binary bulk data already in memory.
+    /// @param data Binary data including the magic.
+    /// @return Report with rows/sec, or the first bad row.
+    BulkLoadReport loadBinary(std::string_view data);
+
+    /// Converts CSV text to the binary format (e.g. to provision once, load many times).
+    /// @param csv CSV text.
+    /// @param out Receives the binary data.
+    /// @return Report describing the parse (ok=false and errorRow on a bad line).
+    static BulkLoadReport csvToBinary(std::string_view csv, std::string& out);
+
+    /// Magic at the start of binary bulk files.
+    static constexpr std::string_view kBinaryMagic = "ATMBULK1";
+
+private:
+    BulkLoadReport import(const std::vector<std::vector<BulkRow>>& chunks, BulkLoadReport report);
+    unsigned threadCount() const;
+
+    AuthService& auth_;
+    Ledger& ledger_;
+    BulkLoadOptions options_;
+};
+
+}  // namespace atm
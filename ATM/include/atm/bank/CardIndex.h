@@ -0,0 +1,103 @@
+#pragma once
+// CardIndex.h - Flat open-addressing table of cards keyed by packed card numbers.
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+
+namespace atm {
+
+/// Card number packed 6 bits per character (0-9, A-Z, a-z, '-'), up to 20 characters.
+struct CardKey {
+    std::uint64_t lo = 0;  ///< Characters 0-9.
+    std::uint64_t hi = 0;  ///< Characters 10-19.
+
+    bool operator==(const CardKey&) const = default;
+};
+
+/// Everything AuthService knows about one card; 32 bytes, two per cache line.
+struct CardRecord {
+    static constexpr std::uint8_t kUsed = 1;
+    static constexpr std::uint8_t kHasPin = 2;
+    static constexpr std::uint8_t kBlocked = 4;
+
+    CardKey key;
+    std::uint64_t pinDigest = 0;     ///< pinDigest(card, pin) when kHasPin is set.
+    std::uint32_t accountBegin = 0;  ///< First linked account in CardIndex::accountsOf storage.
+    std::uint16_t accountCount = 0;
+    std::uint8_t flags = 0;
+    std::uint8_t failedAttempts = 0;
+
+    bool hasPin() const { return (flags & kHasPin) != 0; }
+    bool blocked() const { return (flags & kBlocked) != 0; }
+};
+static_assert(sizeof(CardRecord) == 32, "CardRecord must stay two per cache line");
+
+class CardIndex {
+public:
+    /// Packs a card number into a fixed-width key.
+    /// @param card Card number.
+    /// @return Key, or nullopt if the card is empty, longer than 20 characters or uses other characters.
+    static std::optional<CardKey> pack(std::string_view card);
+    /// Recovers the card number from a packed key.
+    /// @param key Packed key.
+    /// @return Card number.
+    static std::string unpack(const CardKey& key);
+
+    /// Finds a card.
+    /// @param card Card number.
+    /// @return Record, or nullptr if the card is unknown. Invalidated by the next insert.
+    const CardRecord* find(std::string_view card) const;
+    CardRecord* find(std::string_view card);
+    /// Finds a card, inserting an empty record if needed.
+    /// @param card Card number.
+    /// @return Record. Invalidated by the next insert.
+    CardRecord& findOrInsert(std::string_view card);
+    /// Links accounts to a card (appended after the ones it already has).
+    /// @param record Record from find/findOrInsert.
+    /// @param accounts Account IDs to append.
+    void appendAccounts(CardRecord& record, std::span<const AccountId> accounts);
+    /// Returns the accounts linked to a card.
+    /// @param record Record from find/findOrInsert.
+    /// @return Account IDs (valid until the next appendAccounts).
+    std::span<const AccountId> accountsOf(const CardRecord& record) const;
+
+    /// Pre-sizes the table for the given total number of cards.
+    /// @param cards Expected number of cards.
+    void reserve(std::size_t cards);
+    /// Returns the number of cards.
+    /// @return Card count.
+    std::size_t size() const { return size_ + overflow_.size(); }
+    /// Returns the bytes held by the table and account storage (excluding overflow cards).
+    /// @return Heap bytes.
+    std::size_t memoryBytes() const;
+
+    /// Calls fn(card, record) for every card, in no particular order.
+    /// @param fn Visitor.
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const CardRecord& slot : slots_) {
+            if (slot.flags & CardRecord::kUsed) fn(std::string_view(unpack(slot.key)), slot);
+        }
+        for (const auto& entry : overflow_) fn(std::string_view(entry.first), entry.second);
+    }
+
+private:
+    std::size_t slotFor(const CardKey& key) const;
+    void rehash(std::size_t slotCount);
+
+    std::vector<CardRecord> slots_;  // power-of-two size, linear probing, load <= 3/4
+    std::size_t size_ = 0;
+    std::vector<AccountId> accountIds_;
+    // Cards that do not pack (long or unusual numbers) keep a node-based fallback.
+    std::unordered_map<std::string, CardRecord> overflow_;
+};
+
+}  // namespace atm
@@ -0,0 +1,42 @@
+#pragma once
+// Checksum.h - CRC-32 (IEEE) used to validate on-disk journal records and snapshots.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace atm {
+
+namespace detail {
+
+constexpr std::array<std::uint32_t, 256> makeCrc32Table() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint32_t, 256> kCrc32Table = makeCrc32Table();
+
+}  // namespace detail
+
+/// Computes (or continues) a CRC-32 over a byte range.
+/// @param data Bytes to checksum.
+/// @param size Number of bytes.
+/// @param previous CRC of the preceding bytes when checksumming in pieces (0 to start).
+/// @return CRC-32 of everything checksummed so far.
+inline std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t previous = 0) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    std::uint32_t c = previous ^ 0xFFFFFFFFu;
+    for (std::size_t i = 0; i < size; ++i) {
+        c = detail::kCrc32Table[(c ^ bytes[i]) & 0xFFu] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+}  // namespace atm
@@ -0,0 +1,60 @@
+#pragma once
+// Hashing.h - Stable (platform-independent) hashes for card numbers and PIN digests.
+
+#include <cstdint>
+#include <string_view>
+
+namespace atm {
+
+/// 64-bit FNV-1a; stable across runs and platforms, so it can be persisted.
+/// @param data Bytes to hash.
+/// @param seed Starting state (use the default unless chaining).
+/// @return Hash value.
+constexpr std::uint64_t fnv1a64(std::string_view data, std::uint64_t seed = 14695981039346656037ull) {
+    std::uint64_t h = seed;
+    for (char c : data) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/// splitmix64 finalizer: spreads every input bit over the whole result.
+/// @param h Value to mix.
+/// @return Mixed value.
+constexpr std::uint64_t mix64(std::uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return h;
+}
+
+/// Identifies a card outside the card registry (withdrawal limits) without the card number.
+using CardHash = std::uint64_t;
+
+/// Card hash of withdrawals not tied to a card (tests, tools); such withdrawals skip card limits.
+inline constexpr CardHash kNoCard = 0;
+
+/// Card hash of a card number: its fnv1a64 hash, never kNoCard.
+/// @param card Card number.
+/// @return Hash.
+constexpr CardHash cardHash(std::string_view card) {
+    const std::uint64_t h = fnv1a64(card);
+    return h == kNoCard ? 1 : h;
+}
+
+/// Digest stored instead of a plaintext PIN; salted with the card number.
+/// @param card Card number.
+/// @param pin PIN.
+/// @return Digest to compare against.
+constexpr std::uint64_t pinDigest(std::string_view card, std::string_view pin) {
+    std::uint64_t h = fnv1a64(card);
+    h = fnv1a64(std::string_view(":", 1), h);
+    h = fnv1a64(pin, h);
+    // Final avalanche so similar PINs do not give similar digests.
+    return mix64(h);
+}
+
+}  // namespace atm
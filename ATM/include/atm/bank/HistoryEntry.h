@@ -0,0 +1,30 @@
+#pragma once
+// HistoryEntry.h - One line of an account's transaction history and the terminal ID it carries.
+
+#include <cstdint>
+
+#include "atm/bank/Money.h"
+
+namespace atm {
+
+/// Identifies the ATM a transaction came from (AtmConfig::terminalId).
+using TerminalId = std::uint32_t;
+
+/// Terminal ID of transactions not made at an ATM (tests, tools, bulk loads).
+inline constexpr TerminalId kNoTerminal = 0;
+
+/// Kind of balance change recorded in the history.
+enum class HistoryType : std::uint8_t { Withdraw, Deposit };
+
+/// One successful withdrawal or deposit, as shown on a mini-statement.
+struct HistoryEntry {
+    /// Wall-clock time in microseconds since the Unix epoch.
+    std::int64_t timeUs = 0;
+    HistoryType type = HistoryType::Withdraw;
+    Money amount;
+    /// Account balance right after this transaction.
+    Money balance;
+    TerminalId terminal = kNoTerminal;
+};
+
+}  // namespace atm
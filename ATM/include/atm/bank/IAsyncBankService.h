@@ -0,0 +1,92 @@
+#pragma once
+// IAsyncBankService.h - Non-blocking bank interface: every call returns a BankCall.
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/BankCall.h"
+#include "atm/bank/HistoryEntry.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/RequestDedupe.h"
+
+namespace atm {
+
+/// Same operations as IBankService, but the caller is never blocked: results arrive
+/// through the returned BankCall (poll, wait, or completion callback).
+class IAsyncBankService {
+public:
+    virtual ~IAsyncBankService() = default;
+
+    /// Checks that the card exists and is not blocked.
+    /// @param card Card number.
+    /// @return Pending true if the card exists and is not blocked.
+    virtual BankCall<bool> checkIfCardExist(const std::string& card) = 0;
+    /// Checks the PIN for the card.
+    /// @param pin PIN to verify.
+    /// @param card Card number.
+    /// @return Pending true if the PIN is correct.
+    virtual BankCall<bool> checkPIN(const std::string& pin, const std::string& card) = 0;
+    /// Checks card and PIN and returns the linked accounts.
+    /// @param card Card number.
+    /// @param pin PIN to verify.
+    /// @return Pending card status, PIN verdict, remaining attempts and accounts.
+    virtual BankCall<AuthResult> authenticate(const std::string& card, const std::string& pin) = 0;
+    /// Blocks the card.
+    /// @param card Card number to block.
+    /// @return Pending true once the block is recorded.
+    virtual BankCall<bool> blockCard(const std::string& card) = 0;
+    /// Returns the current balance of the account.
+    /// @param account Account to query.
+    /// @return Pending balance.
+    virtual BankCall<Money> showBalance(AccountId account) = 0;
+    /// Withdraws the amount from the account.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param request Id shared by every attempt of this withdrawal (newRequestId()); kNoRequest is not deduplicated.
+    /// @return Pending true if the withdrawal succeeded.
+    virtual BankCall<bool> withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                        RequestId request) = 0;
+    /// Deposits the amount into the account.
+    /// @param account Account to credit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM taking the deposit.
+    /// @param request Id shared by every attempt of this deposit (newRequestId()); kNoRequest is not deduplicated.
+    /// @return Pending true if the deposit succeeded.
+    virtual BankCall<bool> depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) = 0;
+    /// Reserves funds for a withdrawal until commitCash or releaseCash.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param hold Id of the withdrawal (newRequestId()); names the hold.
+    /// @return Pending true if the funds are held.
+    virtual BankCall<bool> reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                       RequestId hold) = 0;
+    /// Makes a held withdrawal final.
+    /// @param hold Id passed to reserveCash.
+    /// @return Pending true if the withdrawal is committed, false if the bank refused, or nullopt if
+    ///         no answer came back (the commit may or may not have run; sending it again is safe).
+    virtual BankCall<std::optional<bool>> commitCash(RequestId hold) = 0;
+    /// Returns the funds of a held withdrawal.
+    /// @param hold Id passed to reserveCash.
+    /// @return Pending true if the funds are back in the account.
+    virtual BankCall<bool> releaseCash(RequestId hold) = 0;
+    /// Returns the account's most recent transactions.
+    /// @param account Account to query.
+    /// @param count Maximum number of entries.
+    /// @return Pending entries, newest first.
+    virtual BankCall<std::vector<HistoryEntry>> getMiniStatement(AccountId account, std::size_t count) = 0;
+    /// Returns the accounts linked to the card.
+    /// @param card Card number.
+    /// @return Pending account handles.
+    virtual BankCall<std::vector<AccountHandle>> getAccountListForCard(const std::string& card) = 0;
+};
+
+}  // namespace atm
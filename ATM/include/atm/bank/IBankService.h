@@ -1,11 +1,16 @@
 #pragma once
 // IBankService.h - Bank interface used by the ATM.
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
-#include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/HistoryEntry.h"
 #include "atm/bank/Money.h"
+#include "atm/bank/RequestDedupe.h"
 
 namespace atm {
 
@@ -22,27 +27,60 @@ public:
     /// @param card Card number.
     /// @return true if PIN is correct.
     virtual bool checkPIN(const std::string& pin, const std::string& card) = 0;
+    /// Checks card and PIN and, if accepted, returns the linked accounts, all in one call
+    /// (one round trip for a remote bank). Counts wrong PINs on the bank side.
+    /// @param card Card number.
+    /// @param pin PIN to verify.
+    /// @return Card status, PIN verdict, remaining attempts and accounts.
+    virtual AuthResult authenticate(const std::string& card, const std::string& pin) = 0;
     /// Blocks the card.
     /// @param card Card number to block.
     virtual void blockCard(const std::string& card) = 0;
     /// Returns the current balance of the account.
     /// @param account Account to query.
     /// @return Current balance.
-    virtual Money showBalance(Account* account) = 0;
+    virtual Money showBalance(AccountId account) = 0;
     /// Withdraws the amount from the account.
     /// @param account Account to debit.
     /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param request Id shared by every attempt of this withdrawal (newRequestId()); kNoRequest is not deduplicated.
     /// @return true if withdrawal succeeded.
-    virtual bool withdrawCash(Account* account, Money amount) = 0;
+    virtual bool withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                              RequestId request) = 0;
     /// Deposits the amount into the account.
     /// @param account Account to credit.
     /// @param amount Amount in cents.
+    /// @param terminal ATM taking the deposit.
+    /// @param request Id shared by every attempt of this deposit (newRequestId()); kNoRequest is not deduplicated.
     /// @return true if deposit succeeded.
-    virtual bool depositCash(Account* account, Money amount) = 0;
+    virtual bool depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) = 0;
+    /// Reserves funds for a withdrawal; they leave the balance now and wait for commitCash or releaseCash.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param hold Id of the withdrawal (newRequestId()); names the hold. A retry with the same id is answered, not run again.
+    /// @return true if the funds are held.
+    virtual bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) = 0;
+    /// Makes a held withdrawal final (the notes were presented). Safe to retry.
+    /// @param hold Id passed to reserveCash.
+    /// @return true if the withdrawal is committed; false if the hold was released, expired or unknown.
+    virtual bool commitCash(RequestId hold) = 0;
+    /// Returns the funds of a held withdrawal (dispensing failed). Safe to retry.
+    /// @param hold Id passed to reserveCash.
+    /// @return true if the funds are back in the account.
+    virtual bool releaseCash(RequestId hold) = 0;
+    /// Returns the account's most recent transactions.
+    /// @param account Account to query.
+    /// @param count Maximum number of entries.
+    /// @return Entries, newest first.
+    virtual std::vector<HistoryEntry> getMiniStatement(AccountId account, std::size_t count) = 0;
     /// Returns the accounts linked to the card.
     /// @param card Card number.
-    /// @return Accounts linked to the card.
-    virtual std::vector<Account> getAccountListForCard(const std::string& card) = 0;
+    /// @return Handles of the accounts linked to the card.
+    virtual std::vector<AccountHandle> getAccountListForCard(const std::string& card) = 0;
 };
 
 }  // namespace atm
@@ -0,0 +1,141 @@
+#pragma once
+// Ledger.h - Bank-side account store keyed by AccountId, split into independently locked shards.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/Money.h"
+
+namespace atm {
+
+class SnapshotView;
+
+/// Outcome of a balance change on the ledger.
+enum class LedgerStatus {
+    Ok,
+    UnknownAccount,
+    InsufficientFunds
+};
+
+/// Shard locks only guard each shard's index; balances are cents updated lock-free through
+/// std::atomic_ref (CAS for debits, fetch_add for credits), so debits on the same shard never
+/// wait on each other and a debit can never drive a balance below zero. Accounts loaded from a
+/// snapshot stay in the mapped file and are updated there in place.
+class Ledger {
+public:
+    /// Constructs an empty ledger.
+    /// @param shardCount Number of shards (each has its own lock); 0 is treated as 1.
+    explicit Ledger(std::size_t shardCount = kDefaultShardCount);
+
+    Ledger(const Ledger&) = delete;
+    Ledger& operator=(const Ledger&) = delete;
+
+    /// Adds an account and returns its new stable ID.
+    /// @param account Name and opening balance.
+    /// @return ID assigned to the account.
+    AccountId openAccount(const Account& account);
+    /// Hands out a block of consecutive IDs for openAccountWithId (bulk loads).
+    /// @param count Number of IDs.
+    /// @return First ID of the block.
+    AccountId reserveAccountIds(std::size_t count);
+    /// Opens an account under an ID from reserveAccountIds; safe to call from many threads.
+    /// @param id Reserved ID.
+    /// @param name Display name.
+    /// @param balance Opening balance.
+    /// @return false if the ID was not reserved or is already open.
+    bool openAccountWithId(AccountId id, std::string_view name, Money balance);
+    /// Pre-sizes the shard tables for the given number of additional accounts.
+    /// @param accounts Expected number of accounts.
+    void reserve(std::size_t accounts);
+    /// Returns true if the ID refers to an open account.
+    /// @param id Account ID.
+    /// @return true if the account exists.
+    bool contains(AccountId id) const;
+    /// Returns the current balance.
+    /// @param id Account ID.
+    /// @return Balance, or nullopt if the account does not exist.
+    std::optional<Money> getBalance(AccountId id) const;
+    /// Returns the display name.
+    /// @param id Account ID.
+    /// @return Name, or empty if the account does not exist.
+    std::string getName(AccountId id) const;
+    /// Returns a handle (ID and name) for the account.
+    /// @param id Account ID.
+    /// @return Handle; id is kInvalidAccountId if the account does not exist.
+    AccountHandle getHandle(AccountId id) const;
+    /// Atomically subtracts the amount unless that would make the balance negative.
+    /// @param id Account ID.
+    /// @param amount Amount to subtract (callers validate it is positive).
+    /// @param resulting If not null, receives the balance after the debit.
+    /// @return Ok, UnknownAccount, or InsufficientFunds (balance unchanged).
+    LedgerStatus debit(AccountId id, Money amount, Money* resulting = nullptr);
+    /// Atomically adds the amount.
+    /// @param id Account ID.
+    /// @param amount Amount to add.
+    /// @param resulting If not null, receives the balance after the credit.
+    /// @return Ok or UnknownAccount.
+    LedgerStatus credit(AccountId id, Money amount, Money* resulting = nullptr);
+    /// Serves accounts 1..N straight from a mapped snapshot; new accounts get IDs after N.
+    /// Must be called before any account is opened. The snapshot must outlive the ledger.
+    /// @param snapshot Mapped snapshot whose balances become the live balances.
+    /// @return false if the ledger already has accounts.
+    bool attachSnapshot(SnapshotView& snapshot);
+    /// Calls fn(id, name, balance) for every account (snapshot accounts first, then by shard).
+    /// @param fn Visitor.
+    void forEachAccount(const std::function<void(AccountId, std::string_view, Money)>& fn) const;
+    /// Returns the highest account ID handed out so far.
+    /// @return Highest ID (0 if none).
+    AccountId maxAccountId() const;
+    /// Returns the number of open accounts.
+    /// @return Number of accounts across all shards.
+    std::size_t size() const;
+    /// Returns the number of shards.
+    /// @return Shard count.
+    std::size_t shardCount() const { return shardCount_; }
+
+    /// Default shard count; a power of two well above typical core counts.
+    static constexpr std::size_t kDefaultShardCount = 64;
+
+private:
+    struct Entry {
+        Entry(std::string accountName, std::int64_t cents)
+            : name(std::move(accountName)), balanceCents(cents) {}
+        std::string name;
+        /// Only accessed through std::atomic_ref.
+        alignas(8) mutable std::int64_t balanceCents;
+    };
+
+    /// Where an account's balance and name live (map entry or snapshot record).
+    struct Cell {
+        std::int64_t* balance = nullptr;
+        std::string_view name;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<AccountId, Entry> accounts;
+    };
+
+    Shard& shardFor(AccountId id) { return shards_[id % shardCount_]; }
+    const Shard& shardFor(AccountId id) const { return shards_[id % shardCount_]; }
+    /// Locates the account; addresses are stable (map nodes never move or get erased).
+    Cell find(AccountId id) const;
+
+    std::size_t shardCount_;
+    std::unique_ptr<Shard[]> shards_;
+    SnapshotView* snapshot_ = nullptr;
+    AccountId snapshotAccounts_ = 0;
+    std::atomic<AccountId> nextId_{1};
+};
+
+}  // namespace atm
@@ -0,0 +1,93 @@
+#pragma once
+// RequestDedupe.h - Request ids for mutating bank calls and the bounded table that answers repeats.
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace atm {
+
+/// Identifies one withdrawal or deposit end to end. A retry of the same operation reuses it, so the
+/// bank can answer the retry instead of running it again. Not the per-connection id in protocol frames.
+using RequestId = std::uint64_t;
+
+/// Request id of calls that are not deduplicated (tests, tools).
+inline constexpr RequestId kNoRequest = 0;
+
+/// Returns a fresh request id: unique within the process, random across processes, never kNoRequest.
+/// Thread-safe.
+/// @return New id.
+RequestId newRequestId();
+
+/// Outcome of RequestDedupe::begin.
+enum class DedupeOutcome : std::uint8_t {
+    New,       ///< First time the id is seen; run the operation, then call finish().
+    Repeat,    ///< Seen before; the stored result is returned, do not run it again.
+    Mismatch,  ///< Id already used for a different operation; refuse.
+    TableFull, ///< No room for the id (or its entry was evicted while waiting); refuse (fail closed).
+};
+
+/// Remembers the outcome of recent mutating requests so a retried request gets the first answer
+/// instead of moving money twice. Each shard is an open-addressed table of fixed 32-byte slots;
+/// an id is looked up within kMaxProbe slots of its home slot, so begin() and finish() are O(1)
+/// and memory is fixed at construction. A new id takes an empty slot in its probe window, else the
+/// one finished longest ago (each shard stamps slots with an insertion counter), so the table keeps
+/// roughly the last capacity() requests: size it for the retry window times the request rate.
+/// A repeat that arrives while the first attempt is still running waits for its result.
+/// Thread-safe; one lock per shard.
+class RequestDedupe {
+public:
+    /// Slots searched for an id, starting at its home slot.
+    static constexpr std::size_t kMaxProbe = 8;
+    /// Default shard count (same as Ledger).
+    static constexpr std::size_t kDefaultShardCount = 64;
+
+    /// Constructs an empty table.
+    /// @param capacity Requests to remember; rounded up so each shard has a power of two slots.
+    /// @param shardCount Number of shards (each has its own lock); 0 is treated as 1.
+    explicit RequestDedupe(std::size_t capacity, std::size_t shardCount = kDefaultShardCount);
+    ~RequestDedupe();
+
+    RequestDedupe(const RequestDedupe&) = delete;
+    RequestDedupe& operator=(const RequestDedupe&) = delete;
+
+    /// Claims the id for an operation, or finds the result of an earlier attempt.
+    /// @param id Request id (not kNoRequest).
+    /// @param fingerprint Hash of the operation and its arguments; a repeat must match it.
+    /// @param result Receives the stored result on Repeat (may be null).
+    /// @return New, Repeat, Mismatch or TableFull.
+    DedupeOutcome begin(RequestId id, std::uint64_t fingerprint, bool* result);
+    /// Stores the result of an operation begin() returned New for, and wakes waiting repeats.
+    /// @param id Request id passed to begin().
+    /// @param result Result to hand to repeats.
+    void finish(RequestId id, bool result);
+    /// @return Number of slots (the most requests remembered at once).
+    std::size_t capacity() const { return shardCount_ * shardSlots_; }
+
+private:
+    struct Slot {
+        RequestId id = kNoRequest;  ///< kNoRequest = never used.
+        std::uint64_t fingerprint = 0;
+        std::uint64_t stamp = 0;    ///< Shard insertion counter when the id was claimed.
+        bool done = false;
+        bool result = false;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::vector<Slot> slots;
+        std::uint64_t clock = 0;
+    };
+
+    Shard& shardFor(std::uint64_t hash) { return shards_[(hash >> 32) % shardCount_]; }
+
+    std::size_t shardCount_;
+    std::size_t shardSlots_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace atm
@@ -0,0 +1,107 @@
+#pragma once
+// RollingLimiter.h - Per-key rolling-window spending limit in a fixed-size sharded table of time buckets.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace atm {
+
+/// Outcome of RollingLimiter::tryAdd.
+enum class LimitVerdict : std::uint8_t {
+    Allowed,    ///< Within the limit; the amount was added.
+    OverLimit,  ///< Would exceed the limit; nothing was added.
+    TableFull,  ///< No room for a new key; nothing was added (fail closed).
+};
+
+/// Caps what each key (a card, a terminal) may spend in any rolling window, 24 hours by default.
+/// The window is cut into kWindowBuckets buckets; each key keeps at most kSlotBuckets of them
+/// (bucket number and cents) in one fixed 40-byte slot. When a key needs a fifth bucket its
+/// oldest is folded into the next one, which only makes the amount expire later, never sooner.
+/// Amounts count until one bucket after the window has passed, so the limit is never exceeded
+/// over any window. Expired buckets are dropped lazily when their key is next touched, and a
+/// slot whose buckets have all expired is reused by the next key that lands on it.
+/// Memory is fixed at construction: keys hash into shards of open-addressed slots and are
+/// looked up within kMaxProbe slots, so every call is O(1). Thread-safe; one lock per shard.
+class RollingLimiter {
+public:
+    /// Buckets per window.
+    static constexpr std::size_t kWindowBuckets = 24;
+    /// Buckets one key can hold.
+    static constexpr std::size_t kSlotBuckets = 4;
+    /// Slots searched for a key, starting at its home slot.
+    static constexpr std::size_t kMaxProbe = 8;
+    /// Default window length in seconds.
+    static constexpr std::int64_t kDaySeconds = 24 * 60 * 60;
+    /// Default shard count (same as Ledger).
+    static constexpr std::size_t kDefaultShardCount = 64;
+
+    /// Constructs an empty limiter.
+    /// @param limitCents Most a key may spend per window (capped at 2^32 - 1 cents).
+    /// @param capacity Keys to hold; leave headroom, since a new key that finds no free slot among
+    ///        its kMaxProbe is refused. Rounded up so each shard has a power of two slots.
+    /// @param windowSeconds Window length; at least kWindowBuckets seconds.
+    /// @param shardCount Number of shards (each has its own lock); 0 is treated as 1.
+    RollingLimiter(std::int64_t limitCents, std::size_t capacity, std::int64_t windowSeconds = kDaySeconds,
+                   std::size_t shardCount = kDefaultShardCount);
+    ~RollingLimiter();
+
+    RollingLimiter(const RollingLimiter&) = delete;
+    RollingLimiter& operator=(const RollingLimiter&) = delete;
+
+    /// Adds cents to the key's window if the total stays within the limit.
+    /// @param key Card or terminal key; 0 is not tracked and always allowed.
+    /// @param cents Amount (non-positive amounts are allowed and not recorded).
+    /// @param nowSeconds Current time in seconds (nowSeconds()).
+    /// @return Allowed, OverLimit or TableFull.
+    LimitVerdict tryAdd(std::uint64_t key, std::int64_t cents, std::int64_t nowSeconds);
+    /// Takes back an amount added by tryAdd (e.g. the withdrawal failed afterwards).
+    /// @param key Key passed to tryAdd.
+    /// @param cents Amount passed to tryAdd.
+    /// @param whenSeconds Time passed to tryAdd.
+    void refund(std::uint64_t key, std::int64_t cents, std::int64_t whenSeconds);
+    /// Returns what the key has spent in the current window.
+    /// @param key Key to query.
+    /// @param nowSeconds Current time in seconds.
+    /// @return Cents counted against the limit.
+    std::int64_t used(std::uint64_t key, std::int64_t nowSeconds) const;
+    /// @return Limit per key and window, in cents.
+    std::int64_t limitCents() const { return limitCents_; }
+    /// @return Number of slots (the most keys the table can hold).
+    std::size_t capacity() const { return shardCount_ * shardSlots_; }
+
+    /// @return Current wall-clock time in seconds since the Unix epoch.
+    static std::int64_t nowSeconds();
+
+private:
+    struct Slot {
+        std::uint64_t key = 0;  ///< 0 = never used.
+        std::array<std::uint32_t, kSlotBuckets> bucket{};
+        std::array<std::uint32_t, kSlotBuckets> cents{};  ///< 0 = bucket unused.
+    };
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::vector<Slot> slots;
+    };
+
+    std::uint32_t bucketAt(std::int64_t seconds) const;
+    bool live(const Slot& slot, std::size_t i, std::uint32_t now) const;
+    /// Drops expired buckets; returns the cents still counted.
+    std::int64_t prune(Slot& slot, std::uint32_t now) const;
+    Shard& shardFor(std::uint64_t hash) { return shards_[(hash >> 32) % shardCount_]; }
+    const Shard& shardFor(std::uint64_t hash) const { return shards_[(hash >> 32) % shardCount_]; }
+    /// Returns the index of the key's slot, or shardSlots_ if the key is not in the table.
+    std::size_t find(const Shard& shard, std::uint64_t hash, std::uint64_t key) const;
+
+    std::int64_t limitCents_;
+    std::int64_t bucketSeconds_;
+    std::size_t shardCount_;
+    std::size_t shardSlots_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace atm
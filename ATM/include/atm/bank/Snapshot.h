@@ -0,0 +1,146 @@
+#pragma once
+// Snapshot.h - Versioned, checksummed binary snapshot of cards and accounts, queried in place via mmap.
+//
+// Layout (little-endian, every section 8-byte aligned):
+//   SnapshotHeader
+//   SnapshotCard[cardSlotCount]      open-addressing table (linear probing, power-of-two size)
+//   SnapshotAccount[accountCount]    account ID N is at index N-1
+//   AccountId[cardAccountCount]      account IDs referenced by card slots
+//   char[nameBytes]                  account names (not NUL-terminated)
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "atm/bank/AccountHandle.h"
+
+namespace atm {
+
+class AuthService;
+class Ledger;
+
+inline constexpr char kSnapshotMagic[8] = {'A', 'T', 'M', 'S', 'N', 'A', 'P', '\0'};
+inline constexpr std::uint32_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    /// CRC-32 of the header with this field set to 0.
+    std::uint32_t headerChecksum;
+    std::uint64_t cardSlotCount;
+    std::uint64_t cardCount;
+    std::uint64_t accountCount;
+    std::uint64_t cardAccountCount;
+    std::uint64_t nameBytes;
+    /// Last journal sequence already reflected in the balances (replay starts after it).
+    std::uint64_t journalSequence;
+    /// CRC-32 of everything after the header (checked by verify(), not on open).
+    std::uint32_t payloadChecksum;
+    std::uint32_t reserved0;
+    std::uint64_t reserved[7];
+};
+static_assert(sizeof(SnapshotHeader) == 128, "snapshot header must stay 128 bytes");
+
+struct SnapshotCard {
+    static constexpr std::size_t kCardSize = 24;
+    static constexpr std::uint8_t kUsed = 1;
+    static constexpr std::uint8_t kBlocked = 2;
+    static constexpr std::uint8_t kHasPin = 4;
+
+    char card[kCardSize];
+    std::uint64_t pinDigest;
+    std::uint32_t accountBegin;
+    std::uint16_t accountCount;
+    std::uint8_t flags;
+    std::uint8_t reserved;
+
+    /// Returns the card number (NUL padding stripped).
+    std::string_view number() const;
+};
+static_assert(sizeof(SnapshotCard) == 40, "snapshot card slots must stay 40 bytes");
+
+struct SnapshotAccount {
+    /// Account ID, or 0 for an unused ID.
+    AccountId id;
+    /// Balance in cents; updated in place (copy-on-write mapping) by the ledger via atomic_ref.
+    std::int64_t balanceCents;
+    std::uint32_t nameOffset;
+    std::uint32_t nameLength;
+};
+static_assert(sizeof(SnapshotAccount) == 24, "snapshot account records must stay 24 bytes");
+
+/// Read-mostly view of a snapshot file mapped into memory. Opening costs O(1) regardless of size.
+/// The mapping is private (copy-on-write), so balance updates never reach the file.
+class SnapshotView {
+public:
+    /// Maps the file and validates the header (magic, version, header CRC, size).
+    /// @param path Snapshot file path.
+    /// @param error If not null, receives the reason on failure.
+    /// @return View, or nullptr if the file is missing or invalid.
+    static std::unique_ptr<SnapshotView> open(const std::string& path, std::string* error = nullptr);
+    ~SnapshotView();
+
+    SnapshotView(const SnapshotView&) = delete;
+    SnapshotView& operator=(const SnapshotView&) = delete;
+
+    /// Checks the payload CRC (reads the whole file; O(size)).
+    /// @return true if the payload matches the checksum written.
+    bool verify() const;
+    /// Returns the header.
+    /// @return Header of the mapped file.
+    const SnapshotHeader& header() const { return *header_; }
+    /// Looks a card up in the mapped hash table.
+    /// @param card Card number.
+    /// @return Card slot, or nullptr if not present.
+    const SnapshotCard* findCard(std::string_view card) const;
+    /// Returns the IDs of the accounts linked to a card.
+    /// @param card Card slot from findCard.
+    /// @return Account IDs (points into the mapping).
+    std::span<const AccountId> accountsOf(const SnapshotCard& card) const;
+    /// Returns the account record for an ID.
+    /// @param id Account ID.
+    /// @return Account record, or nullptr if the ID is not in the snapshot.
+    SnapshotAccount* findAccount(AccountId id);
+    const SnapshotAccount* findAccount(AccountId id) const;
+    /// Returns the account name.
+    /// @param account Account record from findAccount.
+    /// @return Name (points into the mapping).
+    std::string_view accountName(const SnapshotAccount& account) const;
+    /// Returns all card slots (used and unused), for iteration.
+    /// @return Card slot table.
+    std::span<const SnapshotCard> cardSlots() const;
+
+private:
+    SnapshotView() = default;
+
+    void* mapping_ = nullptr;
+    std::size_t size_ = 0;
+#if defined(_WIN32)
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+    const SnapshotHeader* header_ = nullptr;
+    const SnapshotCard* cards_ = nullptr;
+    SnapshotAccount* accounts_ = nullptr;
+    const AccountId* cardAccounts_ = nullptr;
+    const char* names_ = nullptr;
+};
+
+/// Writes the current cards and accounts to a snapshot file (via a temp file + rename).
+class SnapshotWriter {
+public:
+    /// @param path Destination file.
+    /// @param auth Cards, PINs, blocked set and card-to-account links.
+    /// @param ledger Accounts and balances.
+    /// @param journalSequence Last journal record included in the balances (take the snapshot
+    ///        while no transactions are in flight so this is exact).
+    /// @param error If not null, receives the reason on failure.
+    /// @return true on success.
+    static bool write(const std::string& path, const AuthService& auth, const Ledger& ledger,
+                      std::uint64_t journalSequence = 0, std::string* error = nullptr);
+};
+
+}  // namespace atm
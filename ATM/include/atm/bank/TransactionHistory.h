@@ -0,0 +1,98 @@
+#pragma once
+// TransactionHistory.h - Append-only per-account transaction history in columnar chunks, sharded by account.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/HistoryEntry.h"
+
+namespace atm {
+
+/// Every successful withdrawal and deposit, kept for mini-statements. Rows go to the shard of
+/// their account (account % shardCount) and are stored column by column in fixed-size chunks
+/// that are never moved or rewritten. Each shard also keeps, per account, the row numbers of
+/// that account's rows in time order, so the last N rows are a slice of that list and a time
+/// range is a binary search in it: no scan, however many rows the store holds.
+/// Thread-safe; appends lock one shard exclusively, queries share it.
+class TransactionHistory {
+public:
+    /// Rows per chunk.
+    static constexpr std::size_t kChunkRows = 4096;
+    /// Default shard count (same as Ledger).
+    static constexpr std::size_t kDefaultShardCount = 64;
+    /// Limit for range() that returns every matching row.
+    static constexpr std::size_t kNoLimit = std::numeric_limits<std::size_t>::max();
+
+    /// Constructs an empty history.
+    /// @param shardCount Number of shards (each has its own lock); 0 is treated as 1.
+    explicit TransactionHistory(std::size_t shardCount = kDefaultShardCount);
+    ~TransactionHistory();
+
+    TransactionHistory(const TransactionHistory&) = delete;
+    TransactionHistory& operator=(const TransactionHistory&) = delete;
+
+    /// Appends a row. Rows of one account keep time order: a timestamp older than the
+    /// account's last row is raised to it.
+    /// @param account Account the transaction belongs to.
+    /// @param entry Time, type, amount, resulting balance and terminal.
+    void append(AccountId account, const HistoryEntry& entry);
+    /// Returns the account's most recent rows, newest first.
+    /// @param account Account to query.
+    /// @param count Maximum number of rows.
+    /// @return Up to count rows.
+    std::vector<HistoryEntry> last(AccountId account, std::size_t count) const;
+    /// Returns the account's rows with fromUs <= timeUs < toUs, oldest first.
+    /// @param account Account to query.
+    /// @param fromUs Start of the range (inclusive), microseconds since the Unix epoch.
+    /// @param toUs End of the range (exclusive).
+    /// @param limit Maximum number of rows (the oldest ones are returned).
+    /// @return Matching rows.
+    std::vector<HistoryEntry> range(AccountId account, std::int64_t fromUs, std::int64_t toUs,
+                                    std::size_t limit = kNoLimit) const;
+    /// Returns the number of rows recorded for the account.
+    /// @param account Account to query.
+    /// @return Row count.
+    std::size_t count(AccountId account) const;
+    /// Returns the number of rows across all accounts.
+    /// @return Row count.
+    std::size_t size() const;
+
+    /// @return Current wall-clock time in microseconds since the Unix epoch.
+    static std::int64_t nowUs();
+
+private:
+    /// kChunkRows rows, one array per column.
+    struct Chunk {
+        std::array<std::int64_t, kChunkRows> timeUs;
+        std::array<std::int64_t, kChunkRows> amountCents;
+        std::array<std::int64_t, kChunkRows> balanceCents;
+        std::array<TerminalId, kChunkRows> terminal;
+        std::array<HistoryType, kChunkRows> type;
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::uint64_t rows = 0;
+        /// Shard row numbers of each account, ascending (and so in time order).
+        std::unordered_map<AccountId, std::vector<std::uint64_t>> index;
+
+        std::int64_t timeAt(std::uint64_t row) const { return chunks[row / kChunkRows]->timeUs[row % kChunkRows]; }
+        HistoryEntry entryAt(std::uint64_t row) const;
+    };
+
+    Shard& shardFor(AccountId id) { return shards_[id % shardCount_]; }
+    const Shard& shardFor(AccountId id) const { return shards_[id % shardCount_]; }
+
+    std::size_t shardCount_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace atm
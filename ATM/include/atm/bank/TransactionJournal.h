@@ -0,0 +1,172 @@
+#pragma once
+// TransactionJournal.h - Append-only write-ahead journal of balance changes, withdrawal holds and card blocks.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/RequestDedupe.h"
+
+namespace atm {
+
+class AuthService;
+class Ledger;
+
+/// Kind of change a journal record describes.
+enum class JournalRecordType : std::uint8_t {
+    Withdraw = 1,
+    Deposit = 2,
+    CardBlock = 3,
+    /// Funds taken for a withdrawal hold (a debit, like Withdraw).
+    HoldReserve = 4,
+    /// Hold made final; no balance change.
+    HoldCommit = 5,
+    /// Hold funds given back (a credit, like Deposit).
+    HoldRelease = 6
+};
+
+/// When append() returns relative to the record reaching stable storage.
+enum class Durability {
+    /// Caller writes and fdatasyncs (together with anything else pending) before returning.
+    Sync,
+    /// Caller waits for the background flusher, which batches many records per fdatasync.
+    Group,
+    /// Caller returns immediately; the background flusher makes the record durable later.
+    Async
+};
+
+/// Fixed-size (64-byte) on-disk record; written as raw bytes, little-endian host layout.
+struct JournalRecord {
+    static constexpr std::size_t kCardSize = 24;
+
+    std::uint64_t sequence = 0;
+    std::int64_t timestampUs = 0;
+    AccountId accountId = kInvalidAccountId;
+    std::int64_t amountCents = 0;
+    /// Card number for CardBlock records, NUL-padded (longer numbers are not journaled); the
+    /// hold's request id in the first 8 bytes for Hold records.
+    char card[kCardSize] = {};
+    JournalRecordType type = JournalRecordType::Withdraw;
+    std::uint8_t reserved[3] = {};
+    /// CRC-32 of all preceding bytes of the record.
+    std::uint32_t checksum = 0;
+
+    /// Returns the card number stored in the record.
+    /// @return Card number (empty for balance records).
+    std::string cardNumber() const;
+    /// Returns the request id stored in a Hold record.
+    /// @return Hold id (kNoRequest for other records).
+    RequestId holdId() const;
+};
+static_assert(sizeof(JournalRecord) == 64, "journal records must stay 64 bytes");
+
+/// Journal tuning.
+struct JournalConfig {
+    /// Default durability for the appendXxx helpers.
+    Durability durability = Durability::Group;
+    /// How long the flusher lets a batch fill before writing it.
+    std::chrono::microseconds groupCommitWindow{200};
+    /// Batch size that triggers a flush before the window ends.
+    std::size_t maxBatchRecords = 4096;
+};
+
+class TransactionJournal {
+public:
+    /// Opens (or creates) the journal; a torn tail from a crash is truncated away.
+    /// @param path Journal file path.
+    /// @param config Durability and group-commit tuning.
+    explicit TransactionJournal(const std::string& path, JournalConfig config = JournalConfig{});
+    /// Flushes everything appended so far, stops the flusher and closes the file.
+    ~TransactionJournal();
+
+    TransactionJournal(const TransactionJournal&) = delete;
+    TransactionJournal& operator=(const TransactionJournal&) = delete;
+
+    /// Returns true if the file was opened and no write has failed.
+    /// @return true if the journal is usable.
+    bool isHealthy() const;
+    /// Records a successful withdrawal with the configured durability.
+    /// @param account Debited account.
+    /// @param amount Amount in cents.
+    /// @return Sequence number, or 0 if the record could not be written.
+    std::uint64_t appendWithdraw(AccountId account, Money amount);
+    /// Records a successful deposit with the configured durability.
+    /// @param account Credited account.
+    /// @param amount Amount in cents.
+    /// @return Sequence number, or 0 if the record could not be written.
+    std::uint64_t appendDeposit(AccountId account, Money amount);
+    /// Records a card block with the configured durability.
+    /// @param card Blocked card number.
+    /// @return Sequence number, or 0 if the record could not be written or the number is longer
+    ///         than JournalRecord::kCardSize (a cut number would block the wrong card on replay).
+    std::uint64_t appendCardBlock(const std::string& card);
+    /// Records a step of a withdrawal hold with the configured durability.
+    /// @param type HoldReserve, HoldCommit or HoldRelease.
+    /// @param hold Request id of the hold.
+    /// @param account Account the hold is on.
+    /// @param amount Held amount in cents.
+    /// @return Sequence number, or 0 if the record could not be written.
+    std::uint64_t appendHold(JournalRecordType type, RequestId hold, AccountId account, Money amount);
+    /// Appends a record; sequence, timestamp and checksum are filled in here.
+    /// @param record Record to append.
+    /// @param durability When to return relative to the fdatasync.
+    /// @return Sequence number, or 0 if the record could not be written.
+    std::uint64_t append(JournalRecord record, Durability durability);
+    /// Blocks until every record appended so far is durable.
+    /// @return false if a write failed.
+    bool flush();
+    /// Returns the highest sequence number known to be on stable storage.
+    /// @return Durable sequence (0 if none).
+    std::uint64_t durableSequence() const;
+
+    /// Reads every valid record in order, stopping at the first torn or corrupt one.
+    /// @param path Journal file path.
+    /// @param apply Called once per valid record.
+    /// @return Number of records read.
+    static std::size_t replay(const std::string& path,
+                              const std::function<void(const JournalRecord&)>& apply);
+    /// Replays the journal into a freshly loaded ledger and auth service.
+    /// @param path Journal file path.
+    /// @param ledger Ledger to apply withdrawals and deposits to.
+    /// @param auth Auth service to apply card blocks to.
+    /// @param afterSequence Skip records up to this sequence (already in a loaded snapshot).
+    /// @param openHolds If not null, receives the HoldReserve record of every hold that was neither
+    ///        committed nor released (its funds are still debited); pass them to
+    ///        TransactionManager::releaseRecoveredHolds once the journal is reopened. Holds are
+    ///        tracked across the whole file, including records the snapshot already covers.
+    /// @return Number of records applied.
+    static std::size_t recover(const std::string& path, Ledger& ledger, AuthService& auth,
+                               std::uint64_t afterSequence = 0, std::vector<JournalRecord>* openHolds = nullptr);
+
+private:
+    /// Writes pending records (if no one else is) until target is durable; lock is held on entry/exit.
+    void flushUpTo(std::uint64_t target, std::unique_lock<std::mutex>& lock);
+    void waitDurable(std::uint64_t sequence, std::unique_lock<std::mutex>& lock);
+    void flusherLoop();
+    bool writeAndSync(const std::vector<JournalRecord>& batch);
+
+    JournalConfig config_;
+    int fd_ = -1;
+    mutable std::mutex mutex_;
+    std::condition_variable flusherCv_;
+    std::condition_variable durableCv_;
+    std::vector<JournalRecord> pending_;
+    /// Batch currently being written by the leader; swapped with pending_ to reuse capacity.
+    std::vector<JournalRecord> writing_;
+    std::uint64_t nextSequence_ = 1;
+    std::uint64_t durableSequence_ = 0;
+    bool flushing_ = false;
+    bool failed_ = false;
+    bool stopping_ = false;
+    std::thread flusher_;
+};
+
+}  // namespace atm
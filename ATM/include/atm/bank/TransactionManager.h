@@ -1,41 +1,135 @@
 #pragma once
-// TransactionManager.h - Balance, withdraw, deposit with configurable limits.
+// TransactionManager.h - Balance, withdraw (direct or reserve/commit/release), deposit with configurable limits;
+// optional history and daily limits.
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
-#include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/HistoryEntry.h"
+#include "atm/bank/Ledger.h"
 #include "atm/bank/Money.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/bank/WithdrawHolds.h"
 
 namespace atm {
 
 struct AtmConfig;
+class RollingLimiter;
+class TransactionHistory;
+class TransactionJournal;
+struct JournalRecord;
 
 class TransactionManager {
 public:
     /// Constructs with default limits from AtmConstants.
-    TransactionManager();
+    /// @param ledger Ledger whose balances are read and updated in place.
+    explicit TransactionManager(Ledger& ledger);
     /// Constructs with limits from config (e.g. for tests or per-ATM).
+    /// @param ledger Ledger whose balances are read and updated in place.
     /// @param config Limits (min/max withdraw) and any future config.
-    explicit TransactionManager(const AtmConfig& config);
+    TransactionManager(Ledger& ledger, const AtmConfig& config);
 
     /// Returns the current balance of the account.
     /// @param account Account to query.
-    /// @return Current balance.
-    Money showBalance(const Account* account) const;
+    /// @return Current balance (zero if the account does not exist).
+    Money showBalance(AccountId account) const;
     /// Withdraws the amount from the account if valid and sufficient funds.
     /// @param account Account to debit.
     /// @param amount Amount in cents.
-    /// @return false if amount invalid, insufficient funds, or account null.
-    bool withdrawCash(Account* account, Money amount);
+    /// @param terminal ATM the withdrawal is made at (recorded in the history, checked against its daily limit).
+    /// @param card Card used, checked against its daily limit; kNoCard skips that check.
+    /// @return false if amount invalid, over a daily limit, insufficient funds, or account unknown.
+    bool withdrawCash(AccountId account, Money amount, TerminalId terminal = kNoTerminal, CardHash card = kNoCard);
     /// Deposits the amount into the account if non-negative.
     /// @param account Account to credit.
     /// @param amount Amount in cents.
-    /// @return false if amount negative or account null.
-    bool depositCash(Account* account, Money amount);
+    /// @param terminal ATM the deposit is made at (recorded in the history).
+    /// @return false if amount negative or account unknown.
+    bool depositCash(AccountId account, Money amount, TerminalId terminal = kNoTerminal);
+    /// Reserves funds for a withdrawal: runs every withdrawCash check, takes the amount from the
+    /// balance (journaled as HoldReserve) and opens a hold that waits for commit or release.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used, checked against its daily limit; kNoCard skips that check.
+    /// @param hold Request id of the withdrawal; names the hold in commit and release.
+    /// @return false if withdrawCash would refuse, or the id is kNoRequest or already has a hold.
+    bool reserveWithdrawal(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold);
+    /// Makes a held withdrawal final (after the notes were presented): journals HoldCommit, then
+    /// records it in the history and metrics. Committing again is a no-op.
+    /// @param hold Request id passed to reserveWithdrawal.
+    /// @return true if the hold is committed; false if it was released, expired or never made, or
+    ///         the commit could not be journaled (the hold then stays open and expires).
+    bool commitWithdrawal(RequestId hold);
+    /// Gives the funds of a held withdrawal back (dispensing failed) and refunds the daily limits.
+    /// Releasing again is a no-op.
+    /// @param hold Request id passed to reserveWithdrawal.
+    /// @return true if the funds are back (now or before); false if the hold was committed, never
+    ///         made, or its reserve is still running.
+    bool releaseWithdrawal(RequestId hold);
+    /// Releases every hold past its ttl (HoldSweeper calls this periodically).
+    /// @return Number of holds released.
+    std::size_t releaseExpiredHolds();
+    /// Gives back the funds of holds a restart left open (TransactionJournal::recover's openHolds)
+    /// and journals each release, so the next recovery sees them closed. Call after setJournal().
+    /// Their ATMs can no longer commit them; each is logged like an expired hold.
+    /// @param openHolds HoldReserve records of the open holds.
+    /// @return Number of holds released.
+    std::size_t releaseRecoveredHolds(const std::vector<JournalRecord>& openHolds);
+    /// @return Open and recently finished holds.
+    WithdrawHolds& holds() { return holds_; }
+    /// Returns the account's most recent transactions, newest first.
+    /// @param account Account to query.
+    /// @param count Maximum number of entries.
+    /// @return Entries (empty if no history is attached).
+    std::vector<HistoryEntry> miniStatement(AccountId account, std::size_t count) const;
+    /// Attaches a journal; every successful withdraw/deposit is appended before returning.
+    /// @param journal Journal to write to, or nullptr to stop journaling.
+    void setJournal(TransactionJournal* journal);
+    /// Returns the attached journal.
+    /// @return Attached journal or nullptr.
+    TransactionJournal* getJournal() const;
+    /// Attaches a history; every successful withdraw/deposit is appended to it.
+    /// @param history History to write to, or nullptr to stop recording.
+    void setHistory(TransactionHistory* history);
+    /// Returns the attached history.
+    /// @return Attached history or nullptr.
+    TransactionHistory* getHistory() const;
+    /// Attaches rolling limits on withdrawals; a withdrawal is refused if it would take its card
+    /// or its terminal over the limit. Withdrawals with kNoCard / kNoTerminal skip that limit.
+    /// @param perCard Limiter keyed by CardHash, or nullptr for no card limit.
+    /// @param perTerminal Limiter keyed by TerminalId, or nullptr for no terminal limit.
+    void setWithdrawalLimits(RollingLimiter* perCard, RollingLimiter* perTerminal);
+    /// Returns the attached per-card limiter.
+    /// @return Limiter or nullptr.
+    RollingLimiter* getCardLimiter() const;
+    /// Returns the attached per-terminal limiter.
+    /// @return Limiter or nullptr.
+    RollingLimiter* getTerminalLimiter() const;
 
 private:
+    void record(AccountId account, HistoryType type, Money amount, Money balance, TerminalId terminal);
+    /// Counts the withdrawal against the card and terminal limits; logs and returns false if refused.
+    bool chargeLimits(AccountId account, std::int64_t cents, TerminalId terminal, CardHash card, std::int64_t now);
+    void refundLimits(std::int64_t cents, TerminalId terminal, CardHash card, std::int64_t now);
+    /// Checks the amount and limits, debits and journals (as HoldReserve if hold is set); logs and
+    /// returns false if refused.
+    bool debitWithdrawal(AccountId account, Money amount, TerminalId terminal, CardHash card, std::int64_t now,
+                         RequestId hold, Money* balance);
+    /// Puts the funds of a hold back, refunds its limits and journals HoldRelease.
+    void returnHold(RequestId id, const WithdrawHold& hold);
+
+    Ledger& ledger_;
+    TransactionJournal* journal_ = nullptr;
+    TransactionHistory* history_ = nullptr;
+    RollingLimiter* cardLimiter_ = nullptr;
+    RollingLimiter* terminalLimiter_ = nullptr;
     std::int64_t minWithdrawCents_;
     std::int64_t maxWithdrawPerTransactionCents_;
+    WithdrawHolds holds_;
 };
 
 }  // namespace atm
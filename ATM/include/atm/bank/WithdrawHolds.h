@@ -0,0 +1,145 @@
+#pragma once
+// WithdrawHolds.h - Funds reserved for a withdrawal until the ATM commits or releases them; expiry sweeper.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/HistoryEntry.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/RequestDedupe.h"
+
+namespace atm {
+
+class TransactionManager;
+
+/// Where a hold is in its life.
+enum class HoldState : std::uint8_t {
+    None,       ///< No such hold (never made, or forgotten after it finished).
+    Pending,    ///< Opened, but the debit has not finished; commit, release and expiry leave it alone.
+    Held,       ///< Funds are taken from the balance and wait for commit or release.
+    Committed,  ///< The withdrawal is final.
+    Released,   ///< The funds went back to the account.
+    Expired,    ///< Nobody committed in time; the funds went back to the account.
+};
+
+/// Funds reserved for one withdrawal, keyed by the withdrawal's request id.
+struct WithdrawHold {
+    AccountId account = kInvalidAccountId;
+    Money amount;
+    TerminalId terminal = kNoTerminal;
+    CardHash card = kNoCard;
+    /// Time the amount was charged against the daily limits (RollingLimiter::nowSeconds()).
+    std::int64_t limitSeconds = 0;
+    /// Balance right after the debit; the history entry written on commit shows it.
+    Money balance{};
+    /// Held: when the sweeper releases it. Finished: when the record is forgotten. Unused while Pending.
+    std::chrono::steady_clock::time_point deadline{};
+    HoldState state = HoldState::Held;
+};
+
+/// Table of open holds. Finished holds are kept for one more ttl, so a repeated commit or release
+/// gets the same answer as the first. Sharded by request id; every call locks one shard, except
+/// takeExpired(), which visits each shard in turn. Thread-safe.
+class WithdrawHolds {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Default time the ATM has to dispense and commit.
+    static constexpr std::chrono::milliseconds kDefaultTtl{60'000};
+    /// Number of shards.
+    static constexpr std::size_t kShardCount = 16;
+
+    /// @param ttl How long a hold waits for commit before it expires.
+    explicit WithdrawHolds(std::chrono::milliseconds ttl = kDefaultTtl);
+    ~WithdrawHolds();
+
+    WithdrawHolds(const WithdrawHolds&) = delete;
+    WithdrawHolds& operator=(const WithdrawHolds&) = delete;
+
+    /// Opens a Pending hold, which claims the id before the debit runs.
+    /// @param id Request id of the withdrawal (not kNoRequest).
+    /// @param hold Account, amount, terminal, card and limit time.
+    /// @return false if the id already has a hold.
+    bool add(RequestId id, WithdrawHold hold);
+    /// Stores the post-debit balance of a Pending hold and makes it Held; its ttl starts now.
+    /// Call only once the debit is journaled.
+    /// @param id Request id passed to add().
+    /// @param balance Balance the debit left.
+    void setBalance(RequestId id, Money balance);
+    /// Drops a hold that add() opened but whose debit then failed.
+    /// @param id Request id passed to add().
+    void erase(RequestId id);
+    /// Moves a held hold to Committed or Released.
+    /// @param id Request id of the hold.
+    /// @param to HoldState::Committed or HoldState::Released.
+    /// @param hold Receives the hold (in any state) if there is one; may be null.
+    /// @return The state before the call; the hold only changed if that was Held (a Pending hold
+    ///         is left alone).
+    HoldState finish(RequestId id, HoldState to, WithdrawHold* hold);
+    /// Marks every Held hold past its deadline Expired and forgets finished ones past theirs.
+    /// @param now Current time.
+    /// @return Id and hold of each hold that just expired (their funds still need to go back).
+    std::vector<std::pair<RequestId, WithdrawHold>> takeExpired(Clock::time_point now);
+    /// Returns the state of a hold.
+    /// @param id Request id of the hold.
+    /// @param hold Receives the hold if there is one; may be null.
+    /// @return State, or None if there is no such hold.
+    HoldState state(RequestId id, WithdrawHold* hold = nullptr) const;
+    /// @return Number of holds still waiting for commit or release.
+    std::size_t held() const { return held_.load(std::memory_order_relaxed); }
+    /// @return Time a hold waits for commit.
+    std::chrono::milliseconds ttl() const { return ttl_; }
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<RequestId, WithdrawHold> holds;
+    };
+
+    Shard& shardFor(RequestId id) { return shards_[mix64(id) % kShardCount]; }
+    const Shard& shardFor(RequestId id) const { return shards_[mix64(id) % kShardCount]; }
+
+    std::chrono::milliseconds ttl_;
+    std::atomic<std::size_t> held_{0};
+    std::unique_ptr<Shard[]> shards_;
+};
+
+/// Background thread that returns the funds of expired holds (TransactionManager::releaseExpiredHolds)
+/// every interval, and once more when destroyed.
+class HoldSweeper {
+public:
+    /// @param transactions Transaction manager whose holds to sweep; must outlive the sweeper.
+    /// @param interval Time between sweeps.
+    explicit HoldSweeper(TransactionManager& transactions,
+                         std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    ~HoldSweeper();
+    HoldSweeper(const HoldSweeper&) = delete;
+    HoldSweeper& operator=(const HoldSweeper&) = delete;
+
+    /// @return Holds released because they expired, so far.
+    std::uint64_t expired() const { return expired_.load(std::memory_order_relaxed); }
+
+private:
+    void sweepOnce();
+
+    TransactionManager& transactions_;
+    std::chrono::milliseconds interval_;
+    std::atomic<std::uint64_t> expired_{0};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+}  // namespace atm
@@ -1,14 +1,22 @@
 #pragma once
 // ATM.h - Main ATM controller (UI, hardware, gateway, state machine).
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "atm/machine/AtmConstants.h"
 #include "atm/machine/Gateway.h"
 #include "atm/machine/Hardware.h"
 #include "atm/machine/IATMState.h"
 #include "atm/machine/IUserInterface.h"
+#include "atm/machine/StateTimings.h"
+#include "atm/machine/StateTransitions.h"
 #include "atm/machine/UserSession.h"
 
 namespace atm {
@@ -26,10 +34,21 @@ public:
         std::shared_ptr<DepositSlot> ds,
         std::shared_ptr<Gateway> gw,
         AtmConfig config = AtmConfig{});
+    ~ATM();
 
-    /// Sets the current state (used by state handlers to transition).
-    /// @param newState Next state instance.
-    void setState(std::unique_ptr<IATMState> newState);
+    ATM(const ATM&) = delete;
+    ATM& operator=(const ATM&) = delete;
+
+    /// Switches to another state without consulting the transition table (startup, tests).
+    /// The ATM owns one instance of each state, so this never allocates.
+    /// @param next State to enter.
+    void setState(StateId next);
+    /// Moves along a kTransitions edge; used by state handlers. The target is resolved at
+    /// compile time and a (From, Event) pair missing from the table does not compile.
+    template <StateId From, StateEvent Event>
+    void transition() {
+        setState(kNextState<From, Event>);
+    }
     /// Creates a new session for the given card number.
     /// @param cardNumber Card read by the user.
     void createSession(const std::string& cardNumber);
@@ -47,33 +66,83 @@ public:
     const AtmConfig& getConfig() const;
     /// Returns the user interface.
     /// @return User interface.
-    std::shared_ptr<IUserInterface> getUI();
+    const std::shared_ptr<IUserInterface>& getUI();
     /// Returns the cash dispenser.
     /// @return Cash dispenser.
-    std::shared_ptr<CashDispenser> getDispenser();
+    const std::shared_ptr<CashDispenser>& getDispenser();
     /// Returns the deposit slot.
     /// @return Deposit slot.
-    std::shared_ptr<DepositSlot> getDepositSlot();
+    const std::shared_ptr<DepositSlot>& getDepositSlot();
     /// Returns the gateway to the bank.
     /// @return Gateway to the bank.
-    std::shared_ptr<Gateway> getGateway();
+    const std::shared_ptr<Gateway>& getGateway();
+
+    /// Sets what happens when a bank request this ATM is parked on completes (e.g. requeue
+    /// the terminal in a loop driving many ATMs). Runs on the thread completing the request.
+    /// @param handler Called with this ATM; must not block.
+    void setBankReadyHandler(std::function<void(ATM&)> handler);
+    /// Returns a callback that forwards a bank completion to the bank-ready handler; it is
+    /// safe to run after the ATM is gone (it then does nothing).
+    /// @return Callback for BankCall::onReady.
+    std::function<void()> bankReadyCallback() const;
+    /// Tells the ATM that its user interface has input (e.g. a simulated customer arrived);
+    /// runs the bank-ready handler so a scheduler that parked the terminal requeues it.
+    void notifyInput();
+    /// Returns true if the ATM is between sessions and its UI has no input waiting.
+    /// @return true if stepping now would do nothing.
+    bool isAwaitingInput() const;
+    /// Returns true while the current state waits for the bank.
+    /// @return true if a bank request is in flight.
+    bool isWaitingForBank() const;
+
+    /// Times every handle() from now on into per-state histograms, split into the state's own
+    /// time, time in UI calls and time waiting for the bank. Wraps the UI in a
+    /// TimedUserInterface (getUI() returns the wrapper). Several ATMs may share one instance.
+    /// @param timings Histograms to record into; nullptr stops timing.
+    void setStateTimings(std::shared_ptr<StateTimings> timings);
+    /// Returns the histograms this ATM records into.
+    /// @return Timings, or nullptr if timing is off.
+    const std::shared_ptr<StateTimings>& getStateTimings() const { return timings_; }
 
-    /// Runs one state-machine step (for tests).
-    void runOnce();
+    /// Runs one state-machine step, unless the current state is waiting for the bank.
+    /// @return true if a step ran; false if the ATM is waiting for the bank.
+    bool runOnce();
+    /// Returns the current state.
+    /// @return Current state id.
+    StateId getCurrentState() const { return currentId_; }
     /// Returns the current state name (for tests).
     /// @return Current state name (e.g. "IdleState").
-    std::string getCurrentStateName() const;
+    std::string_view getCurrentStateName() const;
     /// Main loop: runs the state machine until process exits.
     void run();
 
 private:
+    void runTimedStep();
+
     std::shared_ptr<IUserInterface> ui_;
     std::shared_ptr<CashDispenser> dispenser_;
     std::shared_ptr<DepositSlot> depositSlot_;
     std::shared_ptr<Gateway> gateway_;
     AtmConfig config_;
-    std::unique_ptr<IATMState> currentState_;
-    std::unique_ptr<UserSession> session_;
+    StateSet states_;
+    IATMState* currentState_ = nullptr;
+    StateId currentId_ = StateId::Idle;
+    std::optional<UserSession> session_;
+    std::shared_ptr<StateTimings> timings_;
+    // Bank time of the current visit: Gateway calls so far, plus the parked interval.
+    std::int64_t parkedSinceNs_ = 0;
+    std::uint64_t visitBankNs_ = 0;
+    bool visitUsedBank_ = false;
+
+    // Shared with in-flight bank callbacks, which may outlive the ATM.
+    struct BankReadySignal {
+        std::mutex mutex;
+        ATM* atm = nullptr;
+        std::function<void(ATM&)> handler;
+        // When the last parked request completed (steady clock, ns); for bank timings.
+        std::atomic<std::int64_t> completedAtNs{0};
+    };
+    std::shared_ptr<BankReadySignal> bankReady_;
 };
 
 }  // namespace atm
@@ -2,16 +2,25 @@
 // AtmComposition.h - Composition root: creates and wires all ATM dependencies.
 
 #include <memory>
+#include <string>
 
 #include "atm/bank/AuthService.h"
 #include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/bank/RollingLimiter.h"
+#include "atm/bank/Snapshot.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionJournal.h"
 #include "atm/bank/TransactionManager.h"
+#include "atm/bank/WithdrawHolds.h"
 #include "atm/machine/ATM.h"
 #include "atm/machine/AtmConstants.h"
 #include "atm/machine/ConsoleUserInterface.h"
 #include "atm/machine/Gateway.h"
 #include "atm/machine/Hardware.h"
 #include "atm/machine/IUserInterface.h"
+#include "atm/machine/StateTimings.h"
 
 namespace atm {
 
@@ -23,12 +32,52 @@ public:
 
     /// Loads demo card and accounts (e.g. pera123 / 1234).
     void seedDemoData();
-    /// Builds and returns a fully wired ATM instance.
+    /// Loads cards and accounts from a snapshot instead of seedDemoData. The file is mapped
+    /// and queried in place, so this takes the same time for ten cards or ten million.
+    /// @param path Snapshot file path.
+    /// @param error If not null, receives the reason on failure.
+    /// @return false if the file is missing/invalid or state was already loaded.
+    bool loadSnapshot(const std::string& path, std::string* error = nullptr);
+    /// Writes the current cards and accounts (including live balances) to a snapshot.
+    /// @param path Destination file.
+    /// @param error If not null, receives the reason on failure.
+    /// @return true on success.
+    bool saveSnapshot(const std::string& path, std::string* error = nullptr) const;
+    /// Replays the journal into the loaded state, then journals every change from now on.
+    /// Call after the accounts have been loaded (e.g. seedDemoData) so account IDs match.
+    /// @param path Journal file path (created if missing).
+    /// @param config Durability and group-commit tuning.
+    /// @return Number of records replayed.
+    std::size_t enableJournal(const std::string& path, JournalConfig config = JournalConfig{});
+    /// Sends every bank call to a remote atm_bank_server instead of the in-process bank.
+    /// ATMs created afterwards use it; the local demo data and journal are not consulted.
+    /// Only available where ATM_HAS_REMOTE_BANK is defined (Linux).
+    /// @param address Server address ("unix:/path" or "tcp:host:port").
+    /// @param error If not null, receives the reason on failure.
+    /// @return true if connected.
+    bool connectRemoteBank(const std::string& address, std::string* error = nullptr);
+    /// Returns the in-process bank (e.g. to serve it with BankServer).
+    /// @return Bank backed by this composition's ledger and card registry.
+    IBankService& bank() { return bank_; }
+    /// Builds and returns a fully wired ATM instance. It records per-state timings into
+    /// stateTimings().
     /// @return Fully wired ATM instance ready to run.
     std::unique_ptr<ATM> createAtm();
+    /// Returns the per-state latency histograms shared by the ATMs built here.
+    /// @return Timings (never null).
+    const std::shared_ptr<StateTimings>& stateTimings() const { return stateTimings_; }
 
 private:
+    std::unique_ptr<SnapshotView> snapshot_;
+    Ledger ledger_;
+    std::unique_ptr<TransactionJournal> journal_;
+    TransactionHistory history_;
+    std::unique_ptr<RollingLimiter> cardLimits_;
+    std::unique_ptr<RollingLimiter> terminalLimits_;
+    std::unique_ptr<RequestDedupe> requestDedupe_;
     TransactionManager transactionManager_;
+    /// Declared after transactionManager_ so it stops first.
+    HoldSweeper holdSweeper_;
     AuthService authService_;
     Bank bank_;
     Keyboard keyboard_;
@@ -37,7 +86,9 @@ private:
     std::shared_ptr<CashDispenser> cashDispenser_;
     std::shared_ptr<DepositSlot> depositSlot_;
     std::shared_ptr<ConsoleUserInterface> ui_;
+    std::shared_ptr<IAsyncBankService> remoteBank_;
     std::shared_ptr<Gateway> gateway_;
+    std::shared_ptr<StateTimings> stateTimings_ = std::make_shared<StateTimings>();
     AtmConfig config_;
 };
 
@@ -1,7 +1,12 @@
 #pragma once
 // AtmConstants.h - Named limits and AtmConfig.
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
+
+#include "atm/bank/HistoryEntry.h"
+#include "atm/machine/DispensePlanner.h"
 
 namespace atm {
 
@@ -16,14 +21,53 @@ inline constexpr std::int64_t kMinWithdrawCents = 1;
 /// Maximum withdrawal amount per transaction, in cents.
 inline constexpr std::int64_t kMaxWithdrawPerTransactionCents = 1'000'000;
 
+/// Most one card may withdraw in any 24 hours, in cents.
+inline constexpr std::int64_t kCardDailyWithdrawLimitCents = 2'000'000;
+/// Most one terminal may pay out in any 24 hours, in cents.
+inline constexpr std::int64_t kTerminalDailyWithdrawLimitCents = 50'000'000;
+/// Cards the per-card limit table is sized for (40 bytes each).
+inline constexpr std::size_t kDefaultWithdrawLimitCards = 65536;
+/// Terminals the per-terminal limit table is sized for.
+inline constexpr std::size_t kDefaultWithdrawLimitTerminals = 4096;
+/// Recent withdrawals and deposits the bank remembers to answer retries (32 bytes each).
+inline constexpr std::size_t kDefaultDedupeRequests = 65536;
+/// How long reserved withdrawal funds wait for the ATM to commit before they go back, in ms.
+inline constexpr std::int64_t kDefaultWithdrawHoldTtlMs = 60'000;
+/// Time between sweeps for expired holds, in ms.
+inline constexpr std::int64_t kDefaultHoldSweepIntervalMs = 1000;
+/// Wait before an unanswered withdrawal commit is sent again, in ms.
+inline constexpr std::int64_t kCommitRetryDelayMs = 100;
+
+/// Transactions shown on a mini-statement.
+inline constexpr std::size_t kMiniStatementEntries = 10;
+
+/// Entries per Gateway cache table (balances, account lists) when the cache is on.
+inline constexpr std::size_t kDefaultGatewayCacheMaxEntries = 4096;
+
 }  // namespace constants
 
 /// Configuration for an ATM instance (limits and initial cash).
 struct AtmConfig {
     int maxPinAttempts = constants::kMaxPinAttempts;
     std::int64_t initialCashCents = constants::kDefaultInitialCashCents;
+    /// Note cassettes loaded into the dispenser; empty means initialCashCents without notes.
+    std::vector<Cassette> cassettes;
     std::int64_t minWithdrawCents = constants::kMinWithdrawCents;
     std::int64_t maxWithdrawPerTransactionCents = constants::kMaxWithdrawPerTransactionCents;
+    /// Rolling 24-hour withdrawal limits (AtmComposition); 0 turns a limit off.
+    std::int64_t cardDailyWithdrawLimitCents = constants::kCardDailyWithdrawLimitCents;
+    std::int64_t terminalDailyWithdrawLimitCents = constants::kTerminalDailyWithdrawLimitCents;
+    std::size_t withdrawLimitCards = constants::kDefaultWithdrawLimitCards;
+    /// Size of the bank's request dedupe table (AtmComposition); 0 turns deduplication off.
+    std::size_t dedupeRequests = constants::kDefaultDedupeRequests;
+    /// How long a withdrawal hold waits for commit before AtmComposition's sweeper releases it.
+    std::int64_t withdrawHoldTtlMs = constants::kDefaultWithdrawHoldTtlMs;
+    /// How long the Gateway may reuse balances and account lists; 0 turns the cache off.
+    std::int64_t gatewayCacheTtlMs = 0;
+    std::size_t gatewayCacheMaxEntries = constants::kDefaultGatewayCacheMaxEntries;
+    /// Sent with withdrawals and deposits; shows up in the account's transaction history.
+    TerminalId terminalId = kNoTerminal;
+    std::size_t miniStatementEntries = constants::kMiniStatementEntries;
 };
 
 }  // namespace atm
@@ -27,12 +27,14 @@ public:
     MenuOption promptMenuOption() override;
     void showOptionSelected(MenuOption option) override;
     void showBalance(Money balance) override;
+    void showMiniStatement(const std::vector<HistoryEntry>& entries) override;
     Money promptWithdrawAmount() override;
     void showWithdrawAmount(Money amount) override;
     Money promptDepositAmount() override;
     void showDepositAmount(Money amount) override;
     void promptTakeCard() override;
     void showInsufficientAtmFunds() override;
+    void showDispensableAmounts(Money lower, Money higher) override;
     void showInsufficientAccountFunds() override;
     void promptInsertEnvelope() override;
     void showDepositSuccess() override;
@@ -0,0 +1,100 @@
+#pragma once
+// DispensePlanner.h - Cassettes of notes and the note mix for an amount (precomputed table plus search).
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "atm/bank/Money.h"
+
+namespace atm {
+
+/// Most cassettes a dispenser holds.
+inline constexpr std::size_t kMaxCassettes = 8;
+
+/// One cassette: the value of its notes and how many are left.
+struct Cassette {
+    Money denomination;
+    std::uint32_t notes = 0;
+};
+
+/// Notes to take from each cassette, indexed like the cassettes.
+using DispensePlan = std::array<std::uint32_t, kMaxCassettes>;
+
+/// Parses a cassette list such as "5000x200,2000x500" (denomination in cents x note count).
+/// @param text List to parse.
+/// @param cassettes Receives the cassettes on success.
+/// @param error If not null, receives the reason on failure.
+/// @return false if the text is malformed or lists more than kMaxCassettes cassettes.
+bool parseCassettes(std::string_view text, std::vector<Cassette>* cassettes, std::string* error = nullptr);
+
+/// Finds which notes make up an amount, given what the cassettes hold. build() works in units of
+/// the largest amount every denomination is a multiple of, and fills a table for every amount up
+/// to kTableUnits units: whether it can be paid, how many notes of each cassette to take (larger
+/// notes first), and the nearest payable amounts below and above. Queries on the table are
+/// O(cassettes); build() is O(cassettes x kTableUnits). The notes left out of a plan for a pay
+/// total - a, so the table also answers the last kTableUnits units below the total. plan() for an
+/// amount between the two ranges falls back to a bounded depth-first search. A single cassette
+/// needs no table. Not thread-safe.
+class DispensePlanner {
+public:
+    /// Amounts covered by the table, in units (e.g. 4096 x 10.00 with 10.00 and 20.00 notes).
+    static constexpr std::size_t kTableUnits = 4096;
+
+    /// Rebuilds the tables for the given cassettes (call again whenever the note counts change).
+    /// @param cassettes Up to kMaxCassettes cassettes; extra ones and empty ones are ignored.
+    void build(std::span<const Cassette> cassettes);
+    /// Returns the notes to take from each cassette to pay the amount exactly.
+    /// @param amount Amount to pay.
+    /// @return Plan, or nullopt if the notes cannot make up the amount.
+    std::optional<DispensePlan> plan(Money amount) const;
+    /// Returns true if the notes can make up the amount exactly.
+    /// @param amount Amount to check.
+    /// @return true if plan() would succeed.
+    bool canDispense(Money amount) const;
+    /// Returns the largest payable amount not above the given one. Between the table and its
+    /// mirror only the amount itself is searched; otherwise the answer is the table's top.
+    /// @param amount Requested amount.
+    /// @return Payable amount (zero if nothing smaller can be paid).
+    Money nearestBelow(Money amount) const;
+    /// Returns the smallest payable amount not below the given one. Between the table and its
+    /// mirror only the amount itself is searched; otherwise the answer is the mirror's bottom.
+    /// @param amount Requested amount.
+    /// @return Payable amount, or zero if nothing that large can be paid.
+    Money nearestAbove(Money amount) const;
+    /// @return Total value of the notes.
+    Money total() const { return Money(totalUnits_ * unitCents_); }
+
+private:
+    static constexpr std::uint16_t kUnreachable = 0xFFFF;
+
+    /// Cassette data in planning order (largest denomination first).
+    struct Column {
+        std::size_t cassette = 0;
+        std::int64_t units = 0;
+        std::int64_t notes = 0;
+    };
+
+    std::optional<std::int64_t> toUnits(Money amount) const;
+    bool reachable(std::int64_t units) const;
+    bool search(std::size_t column, std::int64_t units, DispensePlan& plan, std::size_t& budget) const;
+
+    std::array<Column, kMaxCassettes> columns_{};
+    std::size_t columnCount_ = 0;
+    std::int64_t unitCents_ = 1;
+    std::int64_t totalUnits_ = 0;
+    std::int64_t tableUnits_ = 0;
+    /// take_[c * (tableUnits_ + 1) + a]: notes of column c in the plan for a, or kUnreachable if
+    /// a cannot be paid with columns 0..c.
+    std::vector<std::uint16_t> take_;
+    /// Nearest payable amount at or below / at or above each table amount (kUnreachable if none).
+    std::vector<std::uint16_t> below_;
+    std::vector<std::uint16_t> above_;
+};
+
+}  // namespace atm
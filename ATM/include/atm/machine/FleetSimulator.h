@@ -0,0 +1,102 @@
+#pragma once
+// FleetSimulator.h - Runs N simulated ATMs against one shared bank on a thread pool.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "atm/bank/IBankService.h"
+#include "atm/bank/Money.h"
+#include "atm/machine/AtmConstants.h"
+#include "atm/machine/LatencyHistogram.h"
+#include "atm/machine/ScriptedUserInterface.h"
+#include "atm/machine/StateTimings.h"
+
+namespace atm {
+
+class AuthService;
+
+/// Fleet size, workload and the cards the simulated customers use.
+struct FleetConfig {
+    /// Number of ATMs; each has its own dispenser, deposit slot and simulated customer.
+    std::size_t terminals = 100;
+    /// Scheduler worker threads stepping the ATMs (0 = hardware concurrency).
+    unsigned threads = 0;
+    /// Sessions (card in to card out) each ATM runs before it goes idle.
+    std::size_t sessionsPerTerminal = 10;
+    /// Customers use cards <cardPrefix>0 .. <cardPrefix><cards-1>, all with this PIN.
+    std::string cardPrefix = "fleet";
+    std::size_t cards = 1000;
+    std::string pin = "1234";
+    /// Seed for the customers' choices; the same seed gives the same sessions.
+    std::uint64_t seed = 1;
+    /// Sessions to replay instead of random ones (e.g. SessionScript::loadFile). Terminal i
+    /// starts at script session i * sessionsPerTerminal and wraps around.
+    std::shared_ptr<const SessionScript> script;
+    /// Records per-state timings (shared by all terminals) into FleetReport::stateTimings.
+    bool stateTimings = false;
+    /// Per-ATM configuration; the fleet default loads enough cash that no ATM runs dry.
+    AtmConfig atm = [] {
+        AtmConfig config;
+        config.initialCashCents = 1'000'000'000;
+        return config;
+    }();
+};
+
+/// Aggregate results of one fleet run.
+struct FleetReport {
+    std::size_t terminals = 0;
+    unsigned threads = 0;
+    std::uint64_t sessions = 0;
+    double seconds = 0;
+    /// Terminals moved between worker threads by the scheduler.
+    std::uint64_t steals = 0;
+    /// Card read to card ejected.
+    LatencySummary session;
+    /// Bank round trips as seen by the ATMs.
+    LatencySummary login;
+    LatencySummary balance;
+    LatencySummary withdraw;
+    LatencySummary deposit;
+    /// Per-state timings of all terminals (null unless FleetConfig::stateTimings).
+    std::shared_ptr<const StateTimings> stateTimings;
+    /// Net money moved, for checking the ledger afterwards.
+    Money withdrawn;
+    Money deposited;
+
+    /// Returns completed sessions per second.
+    /// @return Sessions per second.
+    double sessionsPerSecond() const { return seconds > 0 ? static_cast<double>(sessions) / seconds : 0; }
+};
+
+/// Capacity-planning driver: builds config.terminals ATMs that share one bank and one
+/// Gateway, gives each a ScriptedUserInterface customer (by default replaying randomScript())
+/// and steps them on a TerminalScheduler; finished terminals park until the run ends.
+class FleetSimulator {
+public:
+    /// @param bank Shared bank; must be safe to call from several threads (e.g. Bank).
+    /// @param config Fleet size and workload.
+    FleetSimulator(IBankService& bank, FleetConfig config);
+
+    /// Registers the cards the fleet's customers use, each with one well-funded account.
+    /// @param auth Card registry behind the bank.
+    /// @param config Fleet whose cards to create.
+    static void provisionCards(AuthService& auth, const FleetConfig& config);
+    /// Generates the default workload: valid card and PIN, one to three random operations
+    /// (half balance checks, a quarter each withdrawals and deposits), then exit.
+    /// @param config Cards, PIN and seed to use.
+    /// @param sessions Number of sessions to generate.
+    /// @return Script usable as FleetConfig::script.
+    static SessionScript randomScript(const FleetConfig& config, std::size_t sessions);
+
+    /// Runs every terminal's sessions to completion.
+    /// @return Throughput and latency report.
+    FleetReport run();
+
+private:
+    IBankService& bank_;
+    FleetConfig config_;
+};
+
+}  // namespace atm
@@ -1,19 +1,43 @@
 #pragma once
-// Gateway.h - ATM-side gateway that forwards calls to the bank.
+// Gateway.h - ATM-side gateway that forwards calls to the bank (blocking or asynchronous).
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <memory>
 #include <string>
 #include <vector>
 
-#include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
+#include "atm/bank/BankCall.h"
+#include "atm/bank/HistoryEntry.h"
+#include "atm/bank/IAsyncBankService.h"
 #include "atm/bank/IBankService.h"
 #include "atm/bank/Money.h"
+#include "atm/machine/GatewayCache.h"
 
 namespace atm {
 
 class Gateway {
 public:
     /// Constructs the gateway with the bank service to forward to.
+    /// Asynchronous calls are answered inline through an AsyncBankAdapter.
     /// @param service Bank service to forward all calls to.
     explicit Gateway(IBankService& service);
+    /// Constructs the gateway on an asynchronous bank service.
+    /// Blocking calls wait for the asynchronous result.
+    /// @param service Asynchronous bank service to forward all calls to.
+    explicit Gateway(IAsyncBankService& service);
+    ~Gateway();
+
+    /// Turns on the response cache for showBalance and getAccountListForCard. Withdrawals and
+    /// deposits made through this gateway drop the account's cached balance at once.
+    /// @param ttl How long an answer may be reused.
+    /// @param maxEntries Capacity of each cache table.
+    void enableCache(std::chrono::milliseconds ttl, std::size_t maxEntries);
+    /// Returns cache hit/miss counters (all zero when the cache is off).
+    /// @return Counters.
+    GatewayCacheStats cacheStats() const;
 
     /// Returns true if the card exists and is not blocked.
     /// @param card Card number.
@@ -24,30 +48,104 @@ public:
     /// @param card Card number.
     /// @return true if PIN is correct.
     bool checkPIN(const std::string& pin, const std::string& card) const;
+    /// Checks card and PIN and fetches the linked accounts in one bank call.
+    /// @param card Card number.
+    /// @param pin PIN to verify.
+    /// @return Card status, PIN verdict, remaining attempts and accounts.
+    AuthResult authenticate(const std::string& card, const std::string& pin);
     /// Blocks the card.
     /// @param card Card number to block.
     void blockCard(const std::string& card);
     /// Returns the current balance of the account.
     /// @param account Account to query.
     /// @return Current balance.
-    Money showBalance(Account* account) const;
+    Money showBalance(AccountId account) const;
     /// Withdraws the amount from the account.
     /// @param account Account to debit.
     /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param request Id shared by every attempt of this withdrawal (newRequestId()); kNoRequest is not deduplicated.
     /// @return true if withdrawal succeeded.
-    bool withdrawCash(Account* account, Money amount);
+    bool withdrawCash(AccountId account, Money amount, TerminalId terminal = kNoTerminal, CardHash card = kNoCard,
+                      RequestId request = kNoRequest);
     /// Deposits the amount into the account.
     /// @param account Account to credit.
     /// @param amount Amount in cents.
+    /// @param terminal ATM taking the deposit.
+    /// @param request Id shared by every attempt of this deposit (newRequestId()); kNoRequest is not deduplicated.
     /// @return true if deposit succeeded.
-    bool depositCash(Account* account, Money amount);
+    bool depositCash(AccountId account, Money amount, TerminalId terminal = kNoTerminal,
+                     RequestId request = kNoRequest);
+    /// Returns the account's most recent transactions (never cached).
+    /// @param account Account to query.
+    /// @param count Maximum number of entries.
+    /// @return Entries, newest first.
+    std::vector<HistoryEntry> getMiniStatement(AccountId account, std::size_t count) const;
     /// Returns the accounts linked to the card.
     /// @param card Card number.
-    /// @return Accounts linked to the card.
-    std::vector<Account> getAccountListForCard(const std::string& card) const;
+    /// @return Handles of the accounts linked to the card.
+    std::vector<AccountHandle> getAccountListForCard(const std::string& card) const;
+
+    /// Starts authenticate without blocking.
+    /// @param card Card number.
+    /// @param pin PIN to verify.
+    /// @return Pending card status, PIN verdict, remaining attempts and accounts.
+    BankCall<AuthResult> authenticateAsync(const std::string& card, const std::string& pin);
+    /// Starts blocking the card without blocking the caller.
+    /// @param card Card number to block.
+    /// @return Pending true once the block is recorded.
+    BankCall<bool> blockCardAsync(const std::string& card);
+    /// Starts a balance query without blocking.
+    /// @param account Account to query.
+    /// @return Pending balance.
+    BankCall<Money> showBalanceAsync(AccountId account);
+    /// Starts a withdrawal without blocking.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param request Id shared by every attempt of this withdrawal (newRequestId()); kNoRequest is not deduplicated.
+    /// @return Pending true if the withdrawal succeeded.
+    BankCall<bool> withdrawCashAsync(AccountId account, Money amount, TerminalId terminal = kNoTerminal,
+                                     CardHash card = kNoCard, RequestId request = kNoRequest);
+    /// Starts a deposit without blocking.
+    /// @param account Account to credit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM taking the deposit.
+    /// @param request Id shared by every attempt of this deposit (newRequestId()); kNoRequest is not deduplicated.
+    /// @return Pending true if the deposit succeeded.
+    BankCall<bool> depositCashAsync(AccountId account, Money amount, TerminalId terminal = kNoTerminal,
+                                    RequestId request = kNoRequest);
+    /// Starts reserving funds for a withdrawal without blocking; see IBankService::reserveCash.
+    /// @param account Account to debit.
+    /// @param amount Amount in cents.
+    /// @param terminal ATM making the withdrawal.
+    /// @param card Card used (cardHash()), for the per-card daily limit; kNoCard skips it.
+    /// @param hold Id of the withdrawal (newRequestId()); names the hold.
+    /// @return Pending true if the funds are held.
+    BankCall<bool> reserveCashAsync(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                    RequestId hold);
+    /// Starts committing a held withdrawal without blocking.
+    /// @param hold Id passed to reserveCashAsync.
+    /// @return Pending true if committed, false if refused, nullopt if no answer came back.
+    BankCall<std::optional<bool>> commitCashAsync(RequestId hold);
+    /// Starts releasing a held withdrawal without blocking.
+    /// @param account Account the hold is on (its cached balance is dropped).
+    /// @param hold Id passed to reserveCashAsync.
+    /// @return Pending true if the funds are back in the account.
+    BankCall<bool> releaseCashAsync(AccountId account, RequestId hold);
+    /// Starts a mini-statement query without blocking.
+    /// @param account Account to query.
+    /// @param count Maximum number of entries.
+    /// @return Pending entries, newest first.
+    BankCall<std::vector<HistoryEntry>> getMiniStatementAsync(AccountId account, std::size_t count);
 
 private:
-    IBankService& bankService_;
+    IBankService* bankService_ = nullptr;
+    std::unique_ptr<IAsyncBankService> ownedAsync_;
+    IAsyncBankService* asyncService_;
+    std::shared_ptr<GatewayCache> cache_;
 };
 
 }  // namespace atm
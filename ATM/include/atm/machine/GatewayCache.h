@@ -0,0 +1,151 @@
+#pragma once
+// GatewayCache.h - TTL + size-bounded cache of balances and account lists kept by the Gateway.
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/Money.h"
+
+namespace atm {
+
+/// Cache counters; misses are bank round trips the cache could not save.
+struct GatewayCacheStats {
+    std::uint64_t balanceHits = 0;
+    std::uint64_t balanceMisses = 0;
+    std::uint64_t accountListHits = 0;
+    std::uint64_t accountListMisses = 0;
+    std::uint64_t evictions = 0;
+};
+
+/// Least-recently-used map whose entries also expire after a fixed time.
+template <typename Key, typename Value>
+class TtlCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// @param ttl Entry lifetime.
+    /// @param maxEntries Capacity; the least recently used entry is evicted beyond it.
+    TtlCache(Clock::duration ttl, std::size_t maxEntries) : ttl_(ttl), maxEntries_(maxEntries) {}
+
+    /// Returns a live entry and marks it recently used; drops it if expired.
+    std::optional<Value> get(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return std::nullopt;
+        if (Clock::now() >= it->second->expires) {
+            order_.erase(it->second);
+            index_.erase(it);
+            return std::nullopt;
+        }
+        order_.splice(order_.begin(), order_, it->second);
+        return it->second->value;
+    }
+    /// Inserts or replaces an entry.
+    /// @return Number of entries evicted to make room (0 or 1).
+    std::size_t put(const Key& key, Value value) {
+        const Clock::time_point expires = Clock::now() + ttl_;
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->value = std::move(value);
+            it->second->expires = expires;
+            order_.splice(order_.begin(), order_, it->second);
+            return 0;
+        }
+        std::size_t evicted = 0;
+        if (index_.size() >= maxEntries_ && !order_.empty()) {
+            index_.erase(order_.back().key);
+            order_.pop_back();
+            evicted = 1;
+        }
+        order_.push_front(Entry{key, std::move(value), expires});
+        index_.emplace(key, order_.begin());
+        return evicted;
+    }
+    /// Removes an entry if present.
+    void erase(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) return;
+        order_.erase(it->second);
+        index_.erase(it);
+    }
+    std::size_t size() const { return index_.size(); }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        Clock::time_point expires;
+    };
+
+    Clock::duration ttl_;
+    std::size_t maxEntries_;
+    std::list<Entry> order_;  // most recently used first
+    std::unordered_map<Key, typename std::list<Entry>::iterator> index_;
+};
+
+/// Balances by account and account lists by card, shared by the terminals on one Gateway.
+/// Thread-safe: asynchronous bank completions fill it from worker threads.
+class GatewayCache {
+public:
+    /// @param ttl How long an answer may be reused (bounds staleness from other terminals).
+    /// @param maxEntries Capacity of each of the two tables.
+    GatewayCache(std::chrono::milliseconds ttl, std::size_t maxEntries);
+
+    /// Returns a cached balance, counting a hit or miss.
+    /// @param account Account ID.
+    /// @return Balance, or nullopt on a miss.
+    std::optional<Money> findBalance(AccountId account);
+    /// Returns a token to take before asking the bank for a balance; see storeBalance.
+    /// @param account Account ID.
+    /// @return Current invalidation count of the account's version stripe.
+    std::uint64_t balanceToken(AccountId account) const;
+    /// Stores a balance answered by the bank, unless the account's balance was invalidated since
+    /// the token was taken (the answer may predate this terminal's own withdrawal or deposit).
+    /// Only invalidations of this account (or one sharing its stripe) make the answer unstorable.
+    /// @param account Account ID.
+    /// @param balance Balance.
+    /// @param token Value of balanceToken() from before the request.
+    void storeBalance(AccountId account, Money balance, std::uint64_t token);
+    /// Drops a balance (e.g. this terminal just withdrew or deposited).
+    /// @param account Account ID.
+    void invalidateBalance(AccountId account);
+    /// Returns a cached account list, counting a hit or miss.
+    /// @param card Card number.
+    /// @return Account handles, or nullopt on a miss.
+    std::optional<std::vector<AccountHandle>> findAccountList(const std::string& card);
+    /// Stores an account list answered by the bank.
+    /// @param card Card number.
+    /// @param accounts Account handles.
+    void storeAccountList(const std::string& card, std::vector<AccountHandle> accounts);
+    /// Drops a card's account list (e.g. the card was blocked).
+    /// @param card Card number.
+    void invalidateAccountList(const std::string& card);
+    /// Returns the hit/miss counters.
+    /// @return Snapshot of the counters.
+    GatewayCacheStats stats() const;
+
+private:
+    /// Stripes of balance versions, indexed by the account's hash. Bounded memory; two accounts
+    /// sharing a stripe only cost each other an occasional unstored answer.
+    static constexpr std::size_t kVersionStripes = 1024;
+
+    std::uint64_t& versionOf(AccountId account);
+    const std::uint64_t& versionOf(AccountId account) const;
+
+    mutable std::mutex mutex_;
+    TtlCache<AccountId, Money> balances_;
+    TtlCache<std::string, std::vector<AccountHandle>> accountLists_;
+    GatewayCacheStats stats_;
+    std::array<std::uint64_t, kVersionStripes> balanceVersions_{};
+};
+
+}  // namespace atm
@@ -3,11 +3,15 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "atm/bank/Money.h"
+#include "atm/machine/DispensePlanner.h"
 
 namespace atm {
 
+class Gauge;
+
 class Keyboard {
 public:
     /// Reads one line of text from the user.
@@ -32,27 +36,68 @@ public:
     std::string readCardNumber();
 };
 
+/// Cash held in cassettes of notes. An amount can be paid only if some mix of the notes left
+/// adds up to it exactly; a DispensePlanner, rebuilt whenever the counts change, answers that
+/// and picks the notes. Deposited cash is put back into cassettes of matching notes where it
+/// can be; the rest goes to a deposit bin that is never paid out.
 class CashDispenser {
 public:
-    /// Constructs the dispenser with the given initial cash.
+    /// Constructs a dispenser that can pay any amount up to initialCash (one cassette of
+    /// 1-cent notes), for tests and setups that do not model notes.
     /// @param initialCash Starting cash in cents.
     explicit CashDispenser(Money initialCash = Money(10000));
-    /// Returns true if the dispenser has at least the given amount.
+    /// Constructs the dispenser with the given cassettes.
+    /// @param cassettes Up to kMaxCassettes cassettes.
+    explicit CashDispenser(std::vector<Cassette> cassettes);
+    /// Replaces all cassettes (e.g. a refill).
+    /// @param cassettes Up to kMaxCassettes cassettes.
+    void loadCassettes(std::vector<Cassette> cassettes);
+    /// Returns the cassettes and their remaining notes.
+    /// @return Cassettes in load order.
+    const std::vector<Cassette>& getCassettes() const;
+    /// Returns true if the notes left can make up exactly the given amount.
     /// @param amount Amount to dispense.
-    /// @return true if dispenser has at least that amount.
+    /// @return true if the amount can be dispensed.
     bool hasEnoughCash(Money amount) const;
-    /// Dispenses the amount (reduces available cash).
+    /// Returns the notes dispense() would take from each cassette.
+    /// @param amount Amount to dispense.
+    /// @return Plan, or nullopt if the amount cannot be made up.
+    std::optional<DispensePlan> planDispense(Money amount) const;
+    /// Returns the largest amount not above the given one that can be dispensed.
+    /// @param amount Requested amount.
+    /// @return Nearest lower amount (zero if none).
+    Money nearestDispensableBelow(Money amount) const;
+    /// Returns the smallest amount not below the given one that can be dispensed.
+    /// @param amount Requested amount.
+    /// @return Nearest higher amount, or zero if none.
+    Money nearestDispensableAbove(Money amount) const;
+    /// Dispenses the amount, taking notes as planDispense() says.
     /// @param amount Amount to dispense.
-    void dispense(Money amount);
-    /// Adds cash (e.g. from a deposit).
+    /// @return false (nothing dispensed) if the amount cannot be made up.
+    bool dispense(Money amount);
+    /// Adds cash (e.g. from a deposit): whole notes of loaded denominations go back into their
+    /// cassettes, largest first, and the rest into the deposit bin.
     /// @param amount Amount to add.
     void addCash(Money amount);
-    /// Returns the current available cash.
+    /// Returns the cash in the cassettes (what can be dispensed).
     /// @return Current available cash in cents.
     Money getAvailableCash() const;
+    /// Returns the deposited cash that could not go into a cassette.
+    /// @return Deposit bin total.
+    Money getDepositBinCash() const;
+    /// Mirrors the available cash into a gauge (e.g. AtmMetrics::cashAvailable) from now on.
+    /// @param gauge Gauge to update, or nullptr to stop; must outlive the dispenser.
+    void setCashGauge(Gauge* gauge);
 
 private:
-    Money available_;
+    /// Rebuilds the planner and publishes the new total after the note counts change.
+    void update();
+    void publish() const;
+
+    std::vector<Cassette> cassettes_;
+    DispensePlanner planner_;
+    Money depositBin_;
+    Gauge* cashGauge_ = nullptr;
 };
 
 class DepositSlot {
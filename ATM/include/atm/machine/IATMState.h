@@ -1,16 +1,31 @@
 #pragma once
 // IATMState.h - ATM state machine base and concrete states.
 
-#include <memory>
-#include <string>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string_view>
 #include <vector>
 
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
+#include "atm/bank/BankCall.h"
+#include "atm/bank/HistoryEntry.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/machine/StateTransitions.h"
+
 namespace atm {
 
 class ATM;
-class Account;
 
-/// Base class for all ATM states. Each state implements handle() and transitions via setState.
+/// Base class for all ATM states. Each state implements handle() and moves on with
+/// ATM::transition<kId, Event>(), which only compiles for edges listed in kTransitions.
+/// States that call the bank start the request, park on it with awaitBank() and finish in a
+/// later handle() once it has completed, so the thread driving the ATM is never blocked.
+/// Every ATM owns one instance of each state (see StateSet), so transitions never allocate;
+/// per-visit data is cleared in onEnter().
 class IATMState {
 public:
     /// Constructs the state with the ATM context.
@@ -20,122 +35,273 @@ public:
     /// Run one step: read input, perform action, optionally set next state.
     virtual void handle() = 0;
     /// @return State name for tests, e.g. "IdleState".
-    virtual std::string name() const = 0;
+    virtual std::string_view name() const = 0;
+    /// Called by ATM::setState each time the state becomes current.
+    void enter();
+    /// Returns true for states that wait for a customer to start a session (Idle).
+    /// @return true if the terminal is between sessions.
+    virtual bool waitsForCustomer() const { return false; }
+    /// Returns true while the state is parked on a bank request (handle() has nothing to do).
+    /// @return true if a bank request is in flight.
+    bool isWaitingForBank() const;
+    /// Blocks until the pending bank request completes (for loops driving a single ATM).
+    void waitForBank() const;
 
 protected:
+    /// Clears data left from the previous visit (pending bank calls, amounts).
+    virtual void onEnter() {}
+    /// Parks the state on a bank request; the ATM's bank-ready handler runs when it completes.
+    /// @param call Request just started (or already parked on).
+    /// @return true if the result is available now.
+    bool awaitBank(const BankCallBase& call);
+
     ATM* atm_;
+
+private:
+    BankCallBase pendingCall_;
 };
 
-class IdleState : public IATMState {
+class IdleState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::Idle;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+    bool waitsForCustomer() const override { return true; }
 };
 
-class CardInsertedState : public IATMState {
+class CardInsertedState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::CardInserted;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class CardNotExistInSystemState : public IATMState {
+class CardNotExistInSystemState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::CardNotExistInSystem;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class AskForPINState : public IATMState {
+class AskForPINState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::AskForPIN;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+
+protected:
+    void onEnter() override;
+
+private:
+    BankCall<AuthResult> authCall_;
 };
 
-class SuccessfulPinState : public IATMState {
+class SuccessfulPinState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::SuccessfulPin;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class UnsuccessfulPinState : public IATMState {
+class UnsuccessfulPinState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::UnsuccessfulPin;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class BlockCardState : public IATMState {
+class BlockCardState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::BlockCard;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+
+protected:
+    void onEnter() override;
+
+private:
+    BankCall<bool> blockCall_;
 };
 
-class ChooseAccountState : public IATMState {
+class ChooseAccountState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::ChooseAccount;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class ShowOptionsState : public IATMState {
+class ShowOptionsState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::ShowOptions;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class DecideOptionState : public IATMState {
+class DecideOptionState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::DecideOption;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class CheckBalanceState : public IATMState {
+class CheckBalanceState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::CheckBalance;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+
+protected:
+    void onEnter() override;
+
+private:
+    BankCall<Money> balanceCall_;
 };
 
-class WithdrawFundsState : public IATMState {
+class WithdrawFundsState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::WithdrawFunds;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+
+protected:
+    void onEnter() override;
+
+private:
+    Money amount_;
+    AccountId account_ = kInvalidAccountId;
+    /// Names the funds the bank holds for this withdrawal until commit or release.
+    RequestId hold_ = kNoRequest;
+    BankCall<bool> reserveCall_;
+    /// Commit once the notes are out; sent again while unanswered, until commitDeadline_.
+    BankCall<std::optional<bool>> commitCall_;
+    std::chrono::steady_clock::time_point commitDeadline_{};
+    /// Release if dispensing failed.
+    BankCall<bool> releaseCall_;
 };
 
-class DepositFundsState : public IATMState {
+class DepositFundsState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::DepositFunds;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+
+protected:
+    void onEnter() override;
+
+private:
+    Money amount_;
+    BankCall<bool> depositCall_;
 };
 
-class ExitState : public IATMState {
+class MiniStatementState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::MiniStatement;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+
+protected:
+    void onEnter() override;
+
+private:
+    BankCall<std::vector<HistoryEntry>> statementCall_;
 };
 
-class EjectCardState : public IATMState {
+class ExitState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::Exit;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
 };
 
-class ResetState : public IATMState {
+class EjectCardState final : public IATMState {
 public:
+    static constexpr StateId kId = StateId::EjectCard;
     using IATMState::IATMState;
     void handle() override;
-    std::string name() const override;
+    std::string_view name() const override;
+};
+
+class ResetState final : public IATMState {
+public:
+    static constexpr StateId kId = StateId::Reset;
+    using IATMState::IATMState;
+    void handle() override;
+    std::string_view name() const override;
+};
+
+/// One instance of every state, created with the ATM; get() is an array lookup and visit()
+/// a switch over StateId that calls the concrete (final) state without a virtual call.
+class StateSet {
+public:
+    /// @param context ATM the states act on.
+    explicit StateSet(ATM* context);
+    StateSet(const StateSet&) = delete;
+    StateSet& operator=(const StateSet&) = delete;
+
+    /// Returns the state with the given id.
+    /// @param id State to look up.
+    /// @return That state.
+    IATMState& get(StateId id) { return *table_[static_cast<std::size_t>(id)]; }
+    /// Calls fn with the concrete state for id (a jump table over StateId).
+    /// @param id State to visit.
+    /// @param fn Callable taking any state type by reference.
+    template <typename Fn>
+    void visit(StateId id, Fn&& fn) {
+        switch (id) {
+            case StateId::Idle: fn(idle_); return;
+            case StateId::CardInserted: fn(cardInserted_); return;
+            case StateId::CardNotExistInSystem: fn(cardNotExistInSystem_); return;
+            case StateId::AskForPIN: fn(askForPin_); return;
+            case StateId::SuccessfulPin: fn(successfulPin_); return;
+            case StateId::UnsuccessfulPin: fn(unsuccessfulPin_); return;
+            case StateId::BlockCard: fn(blockCard_); return;
+            case StateId::ChooseAccount: fn(chooseAccount_); return;
+            case StateId::ShowOptions: fn(showOptions_); return;
+            case StateId::DecideOption: fn(decideOption_); return;
+            case StateId::CheckBalance: fn(checkBalance_); return;
+            case StateId::WithdrawFunds: fn(withdrawFunds_); return;
+            case StateId::DepositFunds: fn(depositFunds_); return;
+            case StateId::MiniStatement: fn(miniStatement_); return;
+            case StateId::Exit: fn(exit_); return;
+            case StateId::EjectCard: fn(ejectCard_); return;
+            case StateId::Reset: fn(reset_); return;
+        }
+    }
+
+private:
+    IdleState idle_;
+    CardInsertedState cardInserted_;
+    CardNotExistInSystemState cardNotExistInSystem_;
+    AskForPINState askForPin_;
+    SuccessfulPinState successfulPin_;
+    UnsuccessfulPinState unsuccessfulPin_;
+    BlockCardState blockCard_;
+    ChooseAccountState chooseAccount_;
+    ShowOptionsState showOptions_;
+    DecideOptionState decideOption_;
+    CheckBalanceState checkBalance_;
+    WithdrawFundsState withdrawFunds_;
+    DepositFundsState depositFunds_;
+    MiniStatementState miniStatement_;
+    ExitState exit_;
+    EjectCardState ejectCard_;
+    ResetState reset_;
+    std::array<IATMState*, kStateCount> table_;
 };
 
 }  // namespace atm
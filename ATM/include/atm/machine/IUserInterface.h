@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "atm/bank/HistoryEntry.h"
 #include "atm/bank/Money.h"
 #include "atm/machine/MenuOption.h"
 
@@ -13,6 +14,12 @@ class IUserInterface {
 public:
     virtual ~IUserInterface() = default;
 
+    /// Returns true if readCard() would start a session now. Interactive UIs block in readCard
+    /// and keep the default; simulated ones return false while no customer is waiting, which
+    /// lets a scheduler park the terminal until ATM::notifyInput().
+    /// @return true if a card is (or may be) waiting.
+    virtual bool hasPendingInput() const { return true; }
+
     /// Reads the card number from the user.
     /// @return Card number (empty if none).
     virtual std::string readCard() = 0;
@@ -50,6 +57,9 @@ public:
     /// Shows the current account balance.
     /// @param balance Current account balance to display.
     virtual void showBalance(Money balance) = 0;
+    /// Shows the account's recent transactions.
+    /// @param entries Transactions, newest first (may be empty).
+    virtual void showMiniStatement(const std::vector<HistoryEntry>& entries) = 0;
     /// Prompts the user for the amount to withdraw.
     /// @return Amount to withdraw in cents.
     virtual Money promptWithdrawAmount() = 0;
@@ -66,6 +76,10 @@ public:
     virtual void promptTakeCard() = 0;
     /// Shows that the ATM has insufficient cash.
     virtual void showInsufficientAtmFunds() = 0;
+    /// Shows that the notes in the ATM cannot make up the amount, and the nearest ones they can.
+    /// @param lower Nearest lower amount (zero if none).
+    /// @param higher Nearest higher amount (zero if none).
+    virtual void showDispensableAmounts(Money lower, Money higher) = 0;
     /// Shows that the account has insufficient funds.
     virtual void showInsufficientAccountFunds() = 0;
     /// Prompts the user to insert the deposit envelope.
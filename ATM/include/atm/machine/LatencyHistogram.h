@@ -0,0 +1,69 @@
+#pragma once
+// LatencyHistogram.h - Lock-free log-linear histogram of latencies (ns) with percentile queries.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace atm {
+
+/// Percentiles in microseconds, as printed by reports.
+struct LatencySummary {
+    std::uint64_t count = 0;
+    double meanUs = 0;
+    double p50Us = 0;
+    double p90Us = 0;
+    double p99Us = 0;
+    double p999Us = 0;
+    double maxUs = 0;
+};
+
+/// Records nanosecond values into buckets that keep about 6% relative precision over the
+/// whole 64-bit range (16 linear sub-buckets per power of two). record() is a few relaxed
+/// atomic adds, so any number of threads can share one histogram.
+class LatencyHistogram {
+public:
+    /// Sub-buckets per power of two (the precision knob).
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::size_t kBucketCount = (65 - kSubBucketBits) << kSubBucketBits;
+
+    /// Adds one value.
+    /// @param nanoseconds Latency in ns.
+    void record(std::uint64_t nanoseconds);
+    /// Adds one duration.
+    /// @param duration Latency.
+    void record(std::chrono::nanoseconds duration) {
+        record(static_cast<std::uint64_t>(duration.count() < 0 ? 0 : duration.count()));
+    }
+    /// Adds every value recorded in other.
+    /// @param other Histogram to merge in.
+    void merge(const LatencyHistogram& other);
+    /// Clears all counts.
+    void reset();
+
+    /// Returns the number of values recorded.
+    /// @return Count.
+    std::uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    /// Returns the value below which the given fraction of values fall.
+    /// @param fraction Between 0 and 1 (e.g. 0.99).
+    /// @return Upper bound of the bucket holding that rank, in ns (0 if empty).
+    std::uint64_t percentile(double fraction) const;
+    /// Returns count, mean, p50/p90/p99/p99.9 and max in microseconds.
+    /// @return Summary.
+    LatencySummary summary() const;
+
+    /// Bucket holding a value (exposed for tests and exporters).
+    static std::size_t bucketOf(std::uint64_t value);
+    /// Smallest value that falls in a bucket.
+    static std::uint64_t bucketLowerBound(std::size_t bucket);
+
+private:
+    std::array<std::atomic<std::uint64_t>, kBucketCount> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+}  // namespace atm
@@ -0,0 +1,316 @@
+#pragma once
+// LogEvents.h - Structured log events: compile-time catalog of formats, binary encoding, decoding for atm_logcat.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "atm/bank/Hashing.h"
+#include "atm/bank/Money.h"
+#include "atm/machine/StateTransitions.h"
+
+namespace atm {
+
+/// Identifies a structured event; Logger::event<Id>(args...) records one.
+enum class LogEventId : std::uint16_t {
+    CardBlocked,
+    AtmCashShort,
+    AtmAmountNotDispensable,
+    WithdrawNotPositive,
+    WithdrawBelowMinimum,
+    WithdrawOverLimit,
+    WithdrawUnknownAccount,
+    WithdrawInsufficientFunds,
+    WithdrawJournalFailed,
+    WithdrawOverCardDailyLimit,
+    WithdrawOverTerminalDailyLimit,
+    WithdrawLimitTableFull,
+    DepositNegative,
+    DepositUnknownAccount,
+    DepositJournalFailed,
+    BankRequestIdReused,
+    BankRequestTableFull,
+    WithdrawHoldRefused,
+    WithdrawCommitRefused,
+    WithdrawHoldExpired,
+    DepositRollbackFailed,
+    CardBlockJournalFailed,
+    AtmCommitRefusedAfterDispense,
+    AtmCommitUnanswered,
+    WithdrawReleaseJournalFailed,
+};
+
+/// Number of LogEventId values.
+inline constexpr std::size_t kLogEventCount = static_cast<std::size_t>(LogEventId::WithdrawReleaseJournalFailed) + 1;
+
+/// How an event argument is passed, stored and printed.
+enum class LogArg : std::uint8_t {
+    None,   ///< Unused slot.
+    Int,    ///< Integer or Money (stored as cents); printed in decimal.
+    Card,   ///< Card number, stored as its fnv1a64 hash (never the number); printed as hex.
+    State,  ///< StateId; printed by name.
+    UInt,   ///< Unsigned 64-bit value such as a RequestId; printed in decimal without a sign.
+};
+
+/// Most arguments one event can have.
+inline constexpr std::size_t kMaxLogArgs = 4;
+
+/// One catalog entry. Each "{name}" in format is replaced by the next argument; the name is
+/// the argument's key in JSON output.
+struct LogEventFormat {
+    LogEventId id;
+    std::string_view name;
+    std::string_view format;
+    std::array<LogArg, kMaxLogArgs> args{};
+};
+
+/// Every event, indexed by LogEventId.
+inline constexpr LogEventFormat kLogEvents[] = {
+    {LogEventId::CardBlocked, "CardBlocked", "Card blocked: {card}", {LogArg::Card}},
+    {LogEventId::AtmCashShort, "AtmCashShort", "Withdraw failed: insufficient ATM cash in {state} for {cents} cents",
+     {LogArg::State, LogArg::Int}},
+    {LogEventId::AtmAmountNotDispensable, "AtmAmountNotDispensable",
+     "Withdraw failed: ATM notes cannot make up {cents} cents in {state}", {LogArg::Int, LogArg::State}},
+    {LogEventId::WithdrawNotPositive, "WithdrawNotPositive",
+     "Withdraw rejected: amount must be positive (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawBelowMinimum, "WithdrawBelowMinimum",
+     "Withdraw rejected: amount below minimum (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawOverLimit, "WithdrawOverLimit",
+     "Withdraw rejected: amount exceeds per-transaction limit (account {account}, {cents} cents)",
+     {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawUnknownAccount, "WithdrawUnknownAccount",
+     "Withdraw rejected: unknown account (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawInsufficientFunds, "WithdrawInsufficientFunds",
+     "Withdraw failed: insufficient account funds (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawJournalFailed, "WithdrawJournalFailed",
+     "Withdraw failed: journal write failed (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawOverCardDailyLimit, "WithdrawOverCardDailyLimit",
+     "Withdraw rejected: card daily limit reached (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawOverTerminalDailyLimit, "WithdrawOverTerminalDailyLimit",
+     "Withdraw rejected: terminal {terminal} daily limit reached (account {account}, {cents} cents)",
+     {LogArg::Int, LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawLimitTableFull, "WithdrawLimitTableFull",
+     "Withdraw rejected: no room in the withdrawal limit table (account {account}, {cents} cents)",
+     {LogArg::Int, LogArg::Int}},
+    {LogEventId::DepositNegative, "DepositNegative", "Deposit rejected: negative amount (account {account}, {cents} cents)",
+     {LogArg::Int, LogArg::Int}},
+    {LogEventId::DepositUnknownAccount, "DepositUnknownAccount",
+     "Deposit rejected: unknown account (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::DepositJournalFailed, "DepositJournalFailed",
+     "Deposit failed: journal write failed (account {account}, {cents} cents)", {LogArg::Int, LogArg::Int}},
+    {LogEventId::BankRequestIdReused, "BankRequestIdReused",
+     "Request {request} rejected: id already used for another operation (account {account}, {cents} cents)",
+     {LogArg::UInt, LogArg::Int, LogArg::Int}},
+    {LogEventId::BankRequestTableFull, "BankRequestTableFull",
+     "Request {request} rejected: no room in the request dedupe table (account {account}, {cents} cents)",
+     {LogArg::UInt, LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawHoldRefused, "WithdrawHoldRefused",
+     "Withdraw hold {request} refused: no request id, or the id already has a hold", {LogArg::UInt}},
+    {LogEventId::WithdrawCommitRefused, "WithdrawCommitRefused",
+     "Withdraw commit refused: hold {request} was released, expired or never made", {LogArg::UInt}},
+    {LogEventId::WithdrawHoldExpired, "WithdrawHoldExpired",
+     "Withdraw hold expired before commit; funds returned (account {account}, {cents} cents)",
+     {LogArg::Int, LogArg::Int}},
+    {LogEventId::DepositRollbackFailed, "DepositRollbackFailed",
+     "Deposit not journaled and already spent; credit kept, needs reconciliation (account {account}, {cents} cents)",
+     {LogArg::Int, LogArg::Int}},
+    {LogEventId::CardBlockJournalFailed, "CardBlockJournalFailed",
+     "Card block not journaled (journal failed or number too long); it is lost on restart: {card}", {LogArg::Card}},
+    {LogEventId::AtmCommitRefusedAfterDispense, "AtmCommitRefusedAfterDispense",
+     "Withdraw commit refused after the notes were dispensed; needs reconciliation (hold {request}, account {account}, {cents} cents)",
+     {LogArg::UInt, LogArg::Int, LogArg::Int}},
+    {LogEventId::AtmCommitUnanswered, "AtmCommitUnanswered",
+     "Withdraw commit got no answer before the hold ttl ran out; needs reconciliation (hold {request}, account {account}, {cents} cents)",
+     {LogArg::UInt, LogArg::Int, LogArg::Int}},
+    {LogEventId::WithdrawReleaseJournalFailed, "WithdrawReleaseJournalFailed",
+     "Withdraw hold released but not journaled; recovery releases it again (hold {request}, account {account}, {cents} cents)",
+     {LogArg::UInt, LogArg::Int, LogArg::Int}},
+};
+
+namespace detail {
+
+/// Number of well-formed "{name}" placeholders, or -1 if a brace is unmatched or a name is empty.
+constexpr int countPlaceholders(std::string_view format) {
+    int count = 0;
+    for (std::size_t i = 0; i < format.size(); ++i) {
+        if (format[i] == '}') return -1;
+        if (format[i] != '{') continue;
+        const std::size_t close = format.find('}', i);
+        if (close == std::string_view::npos || close == i + 1) return -1;
+        if (format.substr(i + 1, close - i - 1).find('{') != std::string_view::npos) return -1;
+        ++count;
+        i = close;
+    }
+    return count;
+}
+
+constexpr int countArgs(const std::array<LogArg, kMaxLogArgs>& args) {
+    int count = 0;
+    for (LogArg arg : args) {
+        if (arg == LogArg::None) break;
+        ++count;
+    }
+    for (std::size_t i = static_cast<std::size_t>(count); i < args.size(); ++i) {
+        if (args[i] != LogArg::None) return -1;  // gap in the argument list
+    }
+    return count;
+}
+
+constexpr bool catalogIsValid() {
+    if (std::size(kLogEvents) != kLogEventCount) return false;
+    for (std::size_t i = 0; i < kLogEventCount; ++i) {
+        const LogEventFormat& event = kLogEvents[i];
+        if (static_cast<std::size_t>(event.id) != i) return false;
+        const int args = countArgs(event.args);
+        if (args < 0 || countPlaceholders(event.format) != args) return false;
+    }
+    return true;
+}
+
+}  // namespace detail
+
+static_assert(detail::catalogIsValid(),
+              "kLogEvents must list every LogEventId in order, with one {placeholder} per argument");
+
+/// Catalog entry of an event.
+constexpr const LogEventFormat& logEventFormat(LogEventId id) {
+    return kLogEvents[static_cast<std::size_t>(id)];
+}
+
+namespace detail {
+
+template <LogArg Kind, typename T>
+constexpr bool logArgAccepts() {
+    using U = std::remove_cvref_t<T>;
+    if constexpr (Kind == LogArg::Int) {
+        return (std::is_integral_v<U> && !std::is_same_v<U, bool>) || std::is_same_v<U, Money>;
+    }
+    else if constexpr (Kind == LogArg::UInt) {
+        return std::is_integral_v<U> && std::is_unsigned_v<U> && !std::is_same_v<U, bool>;
+    }
+    else if constexpr (Kind == LogArg::Card) {
+        return std::is_convertible_v<const U&, std::string_view>;
+    }
+    else if constexpr (Kind == LogArg::State) {
+        return std::is_same_v<U, StateId>;
+    }
+    else {
+        return false;
+    }
+}
+
+template <typename T>
+std::uint64_t logArgBits(const T& value) {
+    if constexpr (std::is_same_v<T, Money>) {
+        return static_cast<std::uint64_t>(value.getCents());
+    }
+    else if constexpr (std::is_same_v<T, StateId>) {
+        return static_cast<std::uint64_t>(value);
+    }
+    else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        return fnv1a64(std::string_view(value));
+    }
+    else {
+        return static_cast<std::uint64_t>(static_cast<std::int64_t>(value));
+    }
+}
+
+/// Zigzag maps small negative numbers to small varints.
+constexpr std::uint64_t zigzag(std::uint64_t bits) {
+    return (bits << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(bits) >> 63);
+}
+constexpr std::uint64_t unzigzag(std::uint64_t value) {
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+inline char* putVarint(char* out, std::uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+    return out;
+}
+
+}  // namespace detail
+
+/// Largest encoded event record.
+inline constexpr std::size_t kMaxLogEventBytes = 10 * (2 + kMaxLogArgs);
+
+/// Encodes one event record: varint(id + 1), varint(steady-clock ns), then one zigzag varint
+/// per argument. Argument count and types are checked against kLogEvents at compile time.
+/// @param out Buffer of at least kMaxLogEventBytes.
+/// @param steadyNs steady_clock time of the event.
+/// @return Bytes written.
+template <LogEventId Id, typename... Args>
+std::size_t encodeLogEvent(char* out, std::uint64_t steadyNs, const Args&... args) {
+    constexpr std::size_t index = static_cast<std::size_t>(Id);
+    static_assert(sizeof...(Args) == static_cast<std::size_t>(detail::countArgs(kLogEvents[index].args)),
+                  "wrong number of arguments for this event (see kLogEvents)");
+    constexpr bool accepts = []<std::size_t... I>(std::index_sequence<I...>) {
+        return (detail::logArgAccepts<kLogEvents[index].args[I], Args>() && ...);
+    }(std::index_sequence_for<Args...>{});
+    static_assert(accepts, "argument type does not match the event's LogArg kind (see kLogEvents)");
+    char* p = detail::putVarint(out, static_cast<std::uint64_t>(Id) + 1);
+    p = detail::putVarint(p, steadyNs);
+    ((p = detail::putVarint(p, detail::zigzag(detail::logArgBits(args)))), ...);
+    return static_cast<std::size_t>(p - out);
+}
+
+/// Event kinds as read back from a log file's header.
+struct LogEventInfo {
+    std::string name;
+    std::string format;
+    std::array<LogArg, kMaxLogArgs> args{};
+    std::size_t argCount = 0;
+};
+
+/// One event read back from a log file.
+struct DecodedLogEvent {
+    const LogEventInfo* info = nullptr;
+    /// Wall-clock time, ns since the Unix epoch.
+    std::int64_t unixNs = 0;
+    /// Argument values; a UInt argument holds its bits (cast back to std::uint64_t).
+    std::array<std::int64_t, kMaxLogArgs> args{};
+};
+
+/// Magic bytes at the start of a binary event log.
+inline constexpr std::string_view kLogEventMagic = "ATMEVT1\n";
+
+/// Writes the segment header written whenever Logger opens the event file: varint 0, then the
+/// clock bases and the catalog, so older files decode even after kLogEvents changes.
+/// @param steadyNs steady_clock now.
+/// @param unixNs Wall clock now, ns since the Unix epoch.
+/// @return Header bytes.
+std::string logEventSegmentHeader(std::uint64_t steadyNs, std::int64_t unixNs);
+
+/// Replaces the placeholders of the event's format with its arguments.
+/// @param event Decoded event.
+/// @return e.g. "Withdraw rejected: amount below minimum (account 3, 500 cents)".
+std::string formatLogEvent(const DecodedLogEvent& event);
+/// Formats an event as one JSON object: time, event name and one key per placeholder.
+/// @param event Decoded event.
+/// @return JSON text without a trailing newline.
+std::string logEventJson(const DecodedLogEvent& event);
+/// Formats a record straight from the compiled-in catalog (what Logger writes to the text sink
+/// when no event file is set).
+/// @param record Bytes from encodeLogEvent.
+/// @param out The message is appended to it (nothing if the record is malformed).
+/// @return false if the record is malformed.
+bool formatLogEventRecord(std::string_view record, std::string& out);
+
+/// Reads a binary event log and calls fn for every event, in file order. A torn record at the
+/// end (the process died mid-write) ends the file.
+/// @param path Event log written by Logger (LoggerConfig::eventPath).
+/// @param fn Called for each event; the event is only valid during the call.
+/// @param error If not null, receives the reason on failure.
+/// @return false if the file cannot be read or is not an event log.
+bool replayLogEvents(const std::string& path, const std::function<void(const DecodedLogEvent&)>& fn,
+                     std::string* error = nullptr);
+
+}  // namespace atm
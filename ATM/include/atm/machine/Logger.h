@@ -1,29 +1,147 @@
 #pragma once
-// Logger.h - Logging for ATM events. Output goes to stderr.
+// Logger.h - Logging for ATM events. Lines and structured events are queued per thread and written by a background thread.
 
-#include <iostream>
+#include <chrono>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "atm/machine/LogEvents.h"
 
 namespace atm {
 
-class Logger {
+/// What a thread does when its log ring is full.
+enum class LogOverflow {
+    /// Discard the line and count it; the writer reports the count. Never blocks the caller.
+    Drop,
+    /// Wait for the writer to make room (backpressure). Nothing is lost.
+    Block,
+};
+
+/// Logger settings; see Logger::configure.
+struct LoggerConfig {
+    /// File to append to; empty = stderr.
+    std::string path;
+    /// Binary file to append Logger::event records to (decode with atm_logcat); empty = events
+    /// are written as text lines like log().
+    std::string eventPath;
+    /// false writes each line on the calling thread (no background thread).
+    bool async = true;
+    /// Lines each thread can queue before overflow applies; rounded up to a power of two.
+    /// Applies to threads that log for the first time after configure.
+    std::size_t ringCapacity = 256;
+    LogOverflow overflow = LogOverflow::Drop;
+    /// Longest a queued line waits before the writer wakes on its own.
+    std::chrono::milliseconds flushInterval{5};
+};
+
+/// Lines written and dropped since the process started.
+struct LoggerStats {
+    std::uint64_t written = 0;
+    std::uint64_t dropped = 0;
+};
+
+/// Bytes of text per queued record. log(message) spreads longer messages over several records;
+/// log(event, detail) cuts its line at this length and ends it in "...".
+inline constexpr std::size_t kLogLineMax = 240;
+
+namespace detail {
+
+/// Fixed-size line buffer the log(event, detail) template formats into, so a log call does not
+/// allocate for strings and numbers.
+class LogLine {
 public:
-    /// Writes a single line to stderr with "[ATM] " prefix.
-    /// @param message Full message to log.
-    static void log(const std::string& message) {
-        std::cerr << "[ATM] " << message << std::endl;
+    void append(std::string_view text) {
+        const std::size_t room = kLogLineMax - size_;
+        if (text.size() > room) {
+            text = text.substr(0, room);
+            truncated_ = true;
+        }
+        text.copy(buffer_ + size_, text.size());
+        size_ += text.size();
     }
 
-    /// Writes "event: detail" to stderr.
-    /// @param event Event name (e.g. "Card blocked").
-    /// @param detail Detail (e.g. card number).
     template <typename T>
-    static void log(const std::string& event, const T& detail) {
-        std::ostringstream os;
-        os << event << ": " << detail;
-        log(os.str());
+    void appendValue(const T& value) {
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            append(std::string_view(value));
+        }
+        else if constexpr (std::is_same_v<T, char>) {
+            append(std::string_view(&value, 1));
+        }
+        else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+            char digits[24];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            append(std::string_view(digits, static_cast<std::size_t>(result.ptr - digits)));
+        }
+        else {
+            std::ostringstream os;
+            os << value;
+            append(os.str());
+        }
     }
+
+    std::string_view view() const { return std::string_view(buffer_, size_); }
+    bool truncated() const { return truncated_; }
+
+private:
+    char buffer_[kLogLineMax];
+    std::size_t size_ = 0;
+    bool truncated_ = false;
+};
+
+}  // namespace detail
+
+/// Process-wide logger. log() copies the line into the calling thread's lock-free ring (one
+/// producer, one consumer) and returns; a background thread drains all rings and writes in
+/// batches with one flush per batch. Lines from one thread keep their order. Pending lines are
+/// written by flush(), shutdown() and at process exit.
+class Logger {
+public:
+    /// Writes a single line with "[ATM] " prefix. The message may span several lines.
+    static void log(std::string_view message) { write(message, false); }
+    /// Writes "event: detail".
+    template <typename T>
+    static void log(std::string_view event, const T& detail) {
+        detail::LogLine line;
+        line.append(event);
+        line.append(": ");
+        line.appendValue(detail);
+        write(line.view(), line.truncated());
+    }
+
+    /// Records a structured event: only the id, a timestamp and the raw arguments are queued;
+    /// the text is built later by the writer thread, or offline by atm_logcat if an event file
+    /// is set. Argument count and types are checked against kLogEvents at compile time.
+    template <LogEventId Id, typename... Args>
+    static void event(const Args&... args) {
+        char record[kMaxLogEventBytes];
+        const auto steadyNs = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+        writeEvent(std::string_view(record, encodeLogEvent<Id>(record, steadyNs, args...)));
+    }
+
+    /// Writes what is queued, then applies the settings.
+    /// @param config New settings.
+    /// @param error If not null, receives the reason on failure.
+    /// @return false if a file could not be opened (the previous sinks stay).
+    static bool configure(const LoggerConfig& config, std::string* error = nullptr);
+    /// Blocks until every line logged before the call has been written and flushed.
+    static void flush();
+    /// Writes what is queued and stops the background thread; later lines are written
+    /// synchronously. Runs at process exit; configure() with async = true starts it again.
+    static void shutdown();
+    /// @return Lines written and dropped so far.
+    static LoggerStats stats();
+
+private:
+    static void write(std::string_view line, bool truncated);
+    static void writeEvent(std::string_view record);
 };
 
 }  // namespace atm
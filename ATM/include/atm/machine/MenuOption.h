@@ -12,6 +12,7 @@ enum class MenuOption {
     CheckBalance,
     Withdraw,
     Deposit,
+    MiniStatement,
     Exit
 };
 
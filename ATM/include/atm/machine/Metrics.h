@@ -0,0 +1,179 @@
+#pragma once
+// Metrics.h - Sharded counters, gauges, the registry that names them, Prometheus text export.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "atm/machine/LogEvents.h"
+
+namespace atm {
+
+/// Shards per counter; threads are spread over them round-robin.
+inline constexpr std::size_t kMetricShards = 16;
+
+namespace detail {
+
+/// Hands out shard indices round-robin (once per thread).
+std::size_t nextMetricShard();
+
+/// Shard of the calling thread (fixed for the thread's lifetime).
+inline std::size_t metricShard() {
+    thread_local const std::size_t shard = nextMetricShard();
+    return shard;
+}
+
+}  // namespace detail
+
+/// Monotonic counter. Each thread adds to its own cache line, so inc() is one uncontended
+/// relaxed add; value() sums the shards.
+class Counter {
+public:
+    /// Adds n.
+    void inc(std::uint64_t n = 1) { shards_[detail::metricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+    /// @return Sum of all increments so far.
+    std::uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> value{0};
+    };
+    std::array<Shard, kMetricShards> shards_;
+};
+
+/// Value that goes up and down (e.g. cash in a dispenser).
+class Gauge {
+public:
+    void set(std::int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(std::int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    std::int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> value_{0};
+};
+
+/// Label name/value pairs of one series, e.g. {{"reason", "WithdrawBelowMinimum"}}.
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/// Names counters and gauges and renders them in the Prometheus text format. Registration
+/// takes a lock; keep the returned reference and update it lock-free. Metrics live as long
+/// as the registry.
+class MetricsRegistry {
+public:
+    /// Returns the counter with this name and labels, creating it on first use.
+    /// @param name Metric name; by convention counters end in "_total".
+    /// @param help One-line description (used when the name is first registered).
+    /// @param labels Labels of the series.
+    /// @return Counter (stable address).
+    Counter& counter(std::string_view name, std::string_view help, MetricLabels labels = {});
+    /// Returns the gauge with this name and labels, creating it on first use.
+    /// @param name Metric name (must not also be used for a counter).
+    /// @param help One-line description.
+    /// @param labels Labels of the series.
+    /// @return Gauge (stable address).
+    Gauge& gauge(std::string_view name, std::string_view help, MetricLabels labels = {});
+
+    /// Formats every metric: "# HELP", "# TYPE", then one line per series.
+    /// @return Prometheus text exposition format.
+    std::string renderPrometheus() const;
+    /// Writes renderPrometheus() to path + ".tmp" and renames it over path, so a reader (the
+    /// node_exporter textfile collector) never sees a partial file.
+    /// @param path Destination, e.g. /var/lib/node_exporter/textfile/atm.prom.
+    /// @param error If not null, receives the reason on failure.
+    /// @return true on success.
+    bool writeTextFile(const std::string& path, std::string* error = nullptr) const;
+
+    /// @return The process-wide registry the ATM's own metrics (atmMetrics()) live in.
+    static MetricsRegistry& global();
+
+private:
+    enum class Kind { Counter, Gauge };
+    struct Series {
+        MetricLabels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+    };
+    struct Family {
+        std::string name;
+        std::string help;
+        Kind kind;
+        std::vector<Series> series;
+    };
+
+    /// Caller holds mutex_: the returned reference points into family->series, which the next
+    /// registration may reallocate, so only the Counter/Gauge it owns may outlive the lock.
+    Series& find(std::string_view name, std::string_view help, Kind kind, MetricLabels&& labels);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;
+};
+
+/// The ATM's counters and gauges, resolved once so call sites skip the registry lookup.
+class AtmMetrics {
+public:
+    /// Registers every metric in registry.
+    explicit AtmMetrics(MetricsRegistry& registry);
+
+    Counter& sessions;        ///< atm_sessions_total: cards accepted by the reader.
+    Counter& pinFailures;     ///< atm_pin_failures_total
+    Counter& cardsBlocked;    ///< atm_cards_blocked_total
+    Counter& withdrawals;     ///< atm_withdrawals_total: successful withdrawals.
+    Counter& withdrawnCents;  ///< atm_withdrawn_cents_total
+    Counter& deposits;        ///< atm_deposits_total: successful deposits.
+    Counter& depositedCents;  ///< atm_deposited_cents_total
+    Counter& requestRepeats;  ///< atm_request_repeats_total: retried bank requests answered from the dedupe table.
+    Counter& holdsExpired;    ///< atm_withdraw_holds_expired_total: holds released for want of a commit.
+    Gauge& cashAvailable;     ///< atm_cash_available_cents: CashDispenser::getAvailableCash.
+
+    /// atm_rejections_total{reason="<event name>"}; reason is a rejection event (not CardBlocked
+    /// or WithdrawHoldExpired, which have their own counters).
+    Counter& rejected(LogEventId reason) { return *rejections_[static_cast<std::size_t>(reason)]; }
+
+private:
+    std::array<Counter*, kLogEventCount> rejections_{};
+};
+
+/// @return The ATM's metrics in MetricsRegistry::global().
+AtmMetrics& atmMetrics();
+
+/// Writes the registry to a node_exporter text file every interval and once more when
+/// destroyed. Failures are logged once until a write succeeds again.
+class MetricsTextFileExporter {
+public:
+    /// @param registry Metrics to export; must outlive the exporter.
+    /// @param path Destination .prom file.
+    /// @param interval Time between writes.
+    MetricsTextFileExporter(const MetricsRegistry& registry, std::string path,
+                            std::chrono::milliseconds interval = std::chrono::seconds(10));
+    ~MetricsTextFileExporter();
+    MetricsTextFileExporter(const MetricsTextFileExporter&) = delete;
+    MetricsTextFileExporter& operator=(const MetricsTextFileExporter&) = delete;
+
+    /// @return Successful writes so far.
+    std::uint64_t writes() const { return writes_.load(std::memory_order_relaxed); }
+
+private:
+    void exportOnce();
+
+    const MetricsRegistry& registry_;
+    std::string path_;
+    std::chrono::milliseconds interval_;
+    bool failing_ = false;
+    std::atomic<std::uint64_t> writes_{0};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+}  // namespace atm
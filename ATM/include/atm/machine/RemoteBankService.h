@@ -0,0 +1,79 @@
+#pragma once
+// RemoteBankService.h - IAsyncBankService that talks to atm_bank_server over a socket.
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "atm/bank/BankProtocol.h"
+#include "atm/bank/IAsyncBankService.h"
+
+namespace atm {
+
+/// Client side of the bank protocol. Requests from any number of threads share one
+/// connection; each gets a request id and its BankCall completes when the matching
+/// response arrives (a reader thread decodes responses). Wrap it in a Gateway to use it
+/// from an ATM. If the connection drops, outstanding and later calls complete with the
+/// fail-safe answer (card unknown, PIN rejected, balance 0, transaction refused, no history).
+class RemoteBankService : public IAsyncBankService {
+public:
+    RemoteBankService() = default;
+    /// Disconnects; calls still pending complete with the fail-safe answer.
+    ~RemoteBankService() override;
+
+    RemoteBankService(const RemoteBankService&) = delete;
+    RemoteBankService& operator=(const RemoteBankService&) = delete;
+
+    /// Connects to the server and starts the reader thread.
+    /// @param address Server address ("unix:/path" or "tcp:host:port").
+    /// @param error If not null, receives the reason on failure.
+    /// @return true if connected.
+    bool connect(const std::string& address, std::string* error = nullptr);
+    /// Closes the connection and fails the calls still pending.
+    void disconnect();
+    /// Returns true while the connection is up.
+    /// @return true if connected.
+    bool connected() const { return connected_.load(); }
+
+    BankCall<bool> checkIfCardExist(const std::string& card) override;
+    BankCall<bool> checkPIN(const std::string& pin, const std::string& card) override;
+    BankCall<AuthResult> authenticate(const std::string& card, const std::string& pin) override;
+    BankCall<bool> blockCard(const std::string& card) override;
+    BankCall<Money> showBalance(AccountId account) override;
+    BankCall<bool> withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                RequestId request) override;
+    BankCall<bool> depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) override;
+    BankCall<bool> reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                               RequestId hold) override;
+    BankCall<std::optional<bool>> commitCash(RequestId hold) override;
+    BankCall<bool> releaseCash(RequestId hold) override;
+    BankCall<std::vector<HistoryEntry>> getMiniStatement(AccountId account, std::size_t count) override;
+    BankCall<std::vector<AccountHandle>> getAccountListForCard(const std::string& card) override;
+
+private:
+    /// Completes the call from a response body, or with the fail-safe value if null.
+    using Completion = std::function<void(protocol::FrameReader*)>;
+
+    /// Registers the completion, encodes the request with encode and sends it.
+    /// @param decode Reads the result from a response (not called on failure).
+    /// @param failSafe Result used if the connection is lost.
+    template <typename T, typename Encode, typename Decode>
+    BankCall<T> send(BankOpcode opcode, Encode encode, Decode decode, T failSafe);
+    void readLoop();
+    void failPending();
+
+    int fd_ = -1;
+    std::atomic<bool> connected_{false};
+    std::thread reader_;
+    std::mutex sendMutex_;
+    std::mutex pendingMutex_;
+    std::uint32_t nextRequestId_ = 1;
+    std::unordered_map<std::uint32_t, Completion> pending_;
+};
+
+}  // namespace atm
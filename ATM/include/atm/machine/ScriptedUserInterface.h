@@ -0,0 +1,224 @@
+#pragma once
+// ScriptedUserInterface.h - Headless UI that replays customer sessions from a script and records outputs.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "atm/bank/Money.h"
+#include "atm/machine/IUserInterface.h"
+#include "atm/machine/MenuOption.h"
+
+namespace atm {
+
+/// One menu choice in a scripted session; cents is used by Withdraw and Deposit.
+struct ScriptedStep {
+    MenuOption option = MenuOption::Exit;
+    std::int64_t cents = 0;
+};
+
+/// Immutable-once-built list of customer sessions, stored flat (one text buffer for cards and
+/// PINs, one array of steps) so millions of sessions cost a few dozen bytes each.
+///
+/// Text format, one session per line:
+///     <card> <pin>[,<pin>...] <account> [B | W<cents> | D<cents> | S | X]...
+/// PINs are tried in order (the last one repeats); account is the 1-based choice; B checks the
+/// balance, W withdraws, D deposits, S shows the mini-statement, X exits (implied after the last
+/// step). '#' starts a comment.
+///     pera123 1234 1 B W2000 D5000
+///     mika7 0000,1111,2222 1
+class SessionScript {
+public:
+    /// Parses sessions from text and appends them.
+    /// @param text Script in the format above.
+    /// @param error If not null, receives "line N: reason" on failure.
+    /// @return true on success; on failure nothing is appended.
+    bool append(std::string_view text, std::string* error = nullptr);
+    /// Reads a script file and appends its sessions.
+    /// @param path Script file.
+    /// @param error If not null, receives the reason on failure.
+    /// @return true on success; on failure nothing is appended.
+    bool loadFile(const std::string& path, std::string* error = nullptr);
+    /// Appends one session.
+    /// @param card Card number.
+    /// @param pins PINs entered in order (at least one).
+    /// @param account 1-based account choice.
+    /// @param steps Menu choices; Exit is implied after the last one.
+    void addSession(std::string_view card, std::initializer_list<std::string_view> pins, int account,
+                    std::span<const ScriptedStep> steps);
+    /// Pre-sizes the tables.
+    /// @param sessions Expected number of sessions.
+    /// @param textBytes Expected bytes of card and PIN text.
+    void reserve(std::size_t sessions, std::size_t textBytes);
+    /// Writes the sessions back in the text format.
+    /// @return Script text (parses to the same sessions).
+    std::string toText() const;
+
+    /// @return Number of sessions.
+    std::size_t size() const { return sessions_.size(); }
+    /// @return true if there are no sessions.
+    bool empty() const { return sessions_.empty(); }
+
+    /// @return Card number of the session.
+    std::string_view card(std::size_t session) const;
+    /// @return Number of PINs scripted for the session (at least one).
+    std::size_t pinCount(std::size_t session) const { return sessions_[session].pinCount; }
+    /// @return The attempt-th PIN of the session (the last one if attempt is past the end).
+    std::string_view pin(std::size_t session, std::size_t attempt) const;
+    /// @return 1-based account choice of the session.
+    int account(std::size_t session) const { return sessions_[session].account; }
+    /// @return Menu choices of the session, without the implied Exit.
+    std::span<const ScriptedStep> steps(std::size_t session) const;
+
+private:
+    struct TextRef {
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+    };
+    struct Session {
+        TextRef card;
+        std::uint32_t firstPin = 0;
+        std::uint32_t firstStep = 0;
+        std::uint16_t pinCount = 0;
+        std::uint16_t stepCount = 0;
+        std::int32_t account = 1;
+    };
+
+    TextRef storeText(std::string_view text);
+    std::string_view textOf(TextRef ref) const { return std::string_view(text_).substr(ref.offset, ref.length); }
+
+    std::string text_;
+    std::vector<TextRef> pins_;
+    std::vector<ScriptedStep> steps_;
+    std::vector<Session> sessions_;
+};
+
+/// Everything the ATM can show a customer, for recording.
+enum class UiOutput : std::uint8_t {
+    CardInsertedSuccess,
+    CardInsertedFailure,
+    PinAccepted,
+    PinRejected,
+    CardBlocked,
+    CardEjected,
+    OptionSelected,
+    Balance,
+    MiniStatement,
+    WithdrawAmount,
+    DepositAmount,
+    TakeCard,
+    InsufficientAtmFunds,
+    DispensableAmounts,
+    InsufficientAccountFunds,
+    InsertEnvelope,
+    DepositSuccess,
+    DepositRejected,
+    InvalidAccountSelection,
+    InvalidNumericInput,
+};
+
+/// Number of UiOutput values.
+inline constexpr std::size_t kUiOutputCount = static_cast<std::size_t>(UiOutput::InvalidNumericInput) + 1;
+
+/// @return Name of the output, e.g. "Balance".
+std::string_view uiOutputName(UiOutput output);
+
+/// One recorded output: which session showed it and its value (cents, the MenuOption, or the
+/// number of mini-statement entries; for DispensableAmounts the nearest lower amount).
+struct UiOutputRecord {
+    std::uint64_t session = 0;
+    UiOutput output = UiOutput::CardEjected;
+    std::int64_t value = 0;
+};
+
+/// Replays sessions from a shared SessionScript: session k of this UI is script session
+/// (firstSession + k) % script size, for sessionCount sessions. Inputs come straight from the
+/// script and outputs are counted (and optionally recorded) into storage sized up front, so a
+/// steady-state session does not allocate here. Cards and PINs are returned as std::string as
+/// IUserInterface requires; up to 15 characters that fits the small-string buffer.
+/// Not thread-safe: one UI per ATM.
+class ScriptedUserInterface : public IUserInterface {
+public:
+    /// Runs for ever (until the ATM is dropped).
+    static constexpr std::uint64_t kUnlimited = ~0ull;
+
+    /// @param script Sessions to replay; must not be empty.
+    /// @param firstSession Script index of the first session.
+    /// @param sessionCount Sessions to run before the card slot stays empty.
+    /// @param recordLimit Outputs to keep in records() (storage reserved now; 0 = counts only).
+    ScriptedUserInterface(std::shared_ptr<const SessionScript> script, std::size_t firstSession = 0,
+                          std::uint64_t sessionCount = kUnlimited, std::size_t recordLimit = 0);
+
+    bool hasPendingInput() const override { return sessionsStarted_ < sessionCount_; }
+    std::string readCard() override;
+    std::string readPin() override;
+    int promptAccountChoice(const std::vector<std::string>& accountNames) override;
+    MenuOption promptMenuOption() override;
+    Money promptWithdrawAmount() override;
+    Money promptDepositAmount() override;
+
+    void showCardInsertedSuccess(const std::string&) override { record(UiOutput::CardInsertedSuccess); }
+    void showCardInsertedFailure(const std::string&) override { record(UiOutput::CardInsertedFailure); }
+    void showPinAccepted(const std::string&) override { record(UiOutput::PinAccepted); }
+    void showPinRejected(const std::string&) override { record(UiOutput::PinRejected); }
+    void showCardBlocked(const std::string&) override { record(UiOutput::CardBlocked); }
+    void showCardEjected(const std::string&) override;
+    void showOptionSelected(MenuOption option) override {
+        record(UiOutput::OptionSelected, static_cast<std::int64_t>(option));
+    }
+    void showBalance(Money balance) override { record(UiOutput::Balance, balance.getCents()); }
+    void showMiniStatement(const std::vector<HistoryEntry>& entries) override {
+        record(UiOutput::MiniStatement, static_cast<std::int64_t>(entries.size()));
+    }
+    void showWithdrawAmount(Money amount) override;
+    void showDepositAmount(Money amount) override { record(UiOutput::DepositAmount, amount.getCents()); }
+    void promptTakeCard() override { record(UiOutput::TakeCard); }
+    void showInsufficientAtmFunds() override { record(UiOutput::InsufficientAtmFunds); }
+    void showDispensableAmounts(Money lower, Money) override { record(UiOutput::DispensableAmounts, lower.getCents()); }
+    void showInsufficientAccountFunds() override { record(UiOutput::InsufficientAccountFunds); }
+    void promptInsertEnvelope() override { record(UiOutput::InsertEnvelope); }
+    void showDepositSuccess() override;
+    void showDepositRejected() override { record(UiOutput::DepositRejected); }
+    void showInvalidAccountSelection() override;
+    void showInvalidNumericInput() override { record(UiOutput::InvalidNumericInput); }
+
+    /// @return Sessions that reached card eject.
+    std::uint64_t sessionsDone() const { return sessionsDone_; }
+    /// @return How often the output was shown.
+    std::uint64_t count(UiOutput output) const { return counts_[static_cast<std::size_t>(output)]; }
+    /// @return Sum of amounts shown by successful withdrawals.
+    std::int64_t withdrawnCents() const { return withdrawnCents_; }
+    /// @return Sum of amounts of accepted deposits.
+    std::int64_t depositedCents() const { return depositedCents_; }
+    /// @return The first recordLimit outputs, in order.
+    std::span<const UiOutputRecord> records() const { return records_; }
+
+private:
+    void record(UiOutput output, std::int64_t value = 0);
+
+    std::shared_ptr<const SessionScript> script_;
+    std::size_t firstSession_;
+    std::uint64_t sessionCount_;
+    std::size_t recordLimit_;
+
+    std::uint64_t sessionsStarted_ = 0;
+    std::uint64_t sessionsDone_ = 0;
+    std::size_t current_ = 0;
+    std::size_t pinAttempt_ = 0;
+    std::size_t stepIndex_ = 0;
+    std::int64_t stepCents_ = 0;
+    bool accountRejected_ = false;
+
+    std::array<std::uint64_t, kUiOutputCount> counts_{};
+    std::int64_t withdrawnCents_ = 0;
+    std::int64_t depositedCents_ = 0;
+    std::vector<UiOutputRecord> records_;
+};
+
+}  // namespace atm
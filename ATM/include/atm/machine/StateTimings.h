@@ -0,0 +1,172 @@
+#pragma once
+// StateTimings.h - Per-state latency histograms (own time, UI time, bank time) and the helpers that feed them.
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "atm/machine/IUserInterface.h"
+#include "atm/machine/LatencyHistogram.h"
+#include "atm/machine/StateTransitions.h"
+
+namespace atm {
+
+/// Where one state spends its time, in microseconds.
+struct StateLatency {
+    /// Per handle() call, excluding time blocked on the UI or the bank.
+    LatencySummary handle;
+    /// Per handle() call that used the UI: time inside UI calls.
+    LatencySummary ui;
+    /// Per visit that used the bank: time inside Gateway calls plus time parked on the result.
+    LatencySummary bank;
+};
+
+/// Lock-free latency histograms for every state; one instance can be shared by many ATMs
+/// and read while they run. Attach with ATM::setStateTimings.
+class StateTimings {
+public:
+    /// Records the time handle() spent on its own work.
+    void recordHandle(StateId state, std::uint64_t nanoseconds) { at(state).handle.record(nanoseconds); }
+    /// Records the time one handle() call spent in UI calls.
+    void recordUi(StateId state, std::uint64_t nanoseconds) { at(state).ui.record(nanoseconds); }
+    /// Records the time one visit waited for the bank.
+    void recordBank(StateId state, std::uint64_t nanoseconds) { at(state).bank.record(nanoseconds); }
+
+    /// Returns p50/p90/p99/max of the three histograms of a state.
+    /// @param state State to query.
+    /// @return Summaries (count 0 where nothing was recorded).
+    StateLatency latency(StateId state) const;
+    /// Formats one line per state that has samples: count and p50/p90/p99/max for each part.
+    /// @return Multi-line table.
+    std::string report() const;
+    /// Clears every histogram.
+    void reset();
+
+private:
+    struct PerState {
+        LatencyHistogram handle;
+        LatencyHistogram ui;
+        LatencyHistogram bank;
+    };
+    PerState& at(StateId state) { return states_[static_cast<std::size_t>(state)]; }
+    const PerState& at(StateId state) const { return states_[static_cast<std::size_t>(state)]; }
+
+    std::array<PerState, kStateCount> states_;
+};
+
+/// Time the running step spent blocked, by cause. ATM::runOnce installs one for the duration
+/// of handle(); BlockedScope adds to it.
+struct StepBlockedTime {
+    std::uint64_t uiNs = 0;
+    std::uint64_t bankNs = 0;
+    std::uint32_t uiCalls = 0;
+    std::uint32_t bankCalls = 0;
+};
+
+/// Adds its lifetime to the UI or bank time of the step being timed on this thread. Costs a
+/// thread-local load when no step is timed (timings off).
+class BlockedScope {
+public:
+    enum class On { Ui, Bank };
+
+    explicit BlockedScope(On on) : step_(current()), on_(on) {
+        if (step_) start_ = std::chrono::steady_clock::now();
+    }
+    ~BlockedScope() {
+        if (!step_) return;
+        const auto elapsed = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+        if (on_ == On::Ui) {
+            step_->uiNs += elapsed;
+            ++step_->uiCalls;
+        }
+        else {
+            step_->bankNs += elapsed;
+            ++step_->bankCalls;
+        }
+    }
+    BlockedScope(const BlockedScope&) = delete;
+    BlockedScope& operator=(const BlockedScope&) = delete;
+
+    /// Step being timed on this thread (nullptr if none).
+    static StepBlockedTime*& current() {
+        thread_local StepBlockedTime* step = nullptr;
+        return step;
+    }
+
+private:
+    StepBlockedTime* step_;
+    On on_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/// Forwards every call to another UI inside a BlockedScope(Ui). ATM::setStateTimings wraps
+/// the ATM's UI in one.
+class TimedUserInterface : public IUserInterface {
+public:
+    /// @param inner UI that does the work.
+    explicit TimedUserInterface(std::shared_ptr<IUserInterface> inner) : inner_(std::move(inner)) {}
+
+    /// @return The wrapped UI.
+    const std::shared_ptr<IUserInterface>& inner() const { return inner_; }
+
+    bool hasPendingInput() const override { return inner_->hasPendingInput(); }
+    std::string readCard() override;
+    void showCardInsertedSuccess(const std::string& cardNumber) override;
+    void showCardInsertedFailure(const std::string& cardNumber) override;
+    std::string readPin() override;
+    void showPinAccepted(const std::string& pin) override;
+    void showPinRejected(const std::string& pin) override;
+    void showCardBlocked(const std::string& cardNumber) override;
+    void showCardEjected(const std::string& cardNumber) override;
+    int promptAccountChoice(const std::vector<std::string>& accountNames) override;
+    MenuOption promptMenuOption() override;
+    void showOptionSelected(MenuOption option) override;
+    void showBalance(Money balance) override;
+    void showMiniStatement(const std::vector<HistoryEntry>& entries) override;
+    Money promptWithdrawAmount() override;
+    void showWithdrawAmount(Money amount) override;
+    Money promptDepositAmount() override;
+    void showDepositAmount(Money amount) override;
+    void promptTakeCard() override;
+    void showInsufficientAtmFunds() override;
+    void showDispensableAmounts(Money lower, Money higher) override;
+    void showInsufficientAccountFunds() override;
+    void promptInsertEnvelope() override;
+    void showDepositSuccess() override;
+    void showDepositRejected() override;
+    void showInvalidAccountSelection() override;
+    void showInvalidNumericInput() override;
+
+private:
+    std::shared_ptr<IUserInterface> inner_;
+};
+
+/// While alive, prints timings.report() to stderr each time the process receives the signal
+/// (e.g. SIGUSR1). The handler only sets a flag; a background thread notices it within
+/// 100 ms and prints, so nothing unsafe runs in signal context. One instance per process.
+class StateTimingsDumper {
+public:
+    /// @param timings Histograms to print.
+    /// @param signal Signal number to dump on.
+    StateTimingsDumper(std::shared_ptr<const StateTimings> timings, int signal);
+    ~StateTimingsDumper();
+    StateTimingsDumper(const StateTimingsDumper&) = delete;
+    StateTimingsDumper& operator=(const StateTimingsDumper&) = delete;
+
+private:
+    std::shared_ptr<const StateTimings> timings_;
+    int signal_;
+    void (*previous_)(int) = nullptr;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+}  // namespace atm
@@ -0,0 +1,191 @@
+#pragma once
+// StateTransitions.h - State and event ids and the compile-time checked transition table.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace atm {
+
+/// Identifies a state; ATM::setState takes one of these instead of a new state object.
+enum class StateId : std::uint8_t {
+    Idle,
+    CardInserted,
+    CardNotExistInSystem,
+    AskForPIN,
+    SuccessfulPin,
+    UnsuccessfulPin,
+    BlockCard,
+    ChooseAccount,
+    ShowOptions,
+    DecideOption,
+    CheckBalance,
+    WithdrawFunds,
+    DepositFunds,
+    MiniStatement,
+    Exit,
+    EjectCard,
+    Reset,
+};
+
+/// Number of StateId values.
+inline constexpr std::size_t kStateCount = static_cast<std::size_t>(StateId::Reset) + 1;
+
+/// What a state reports when it is done; the table maps (state, event) to the next state.
+enum class StateEvent : std::uint8_t {
+    Next,               ///< The state finished its only job.
+    CardRead,           ///< A card was inserted.
+    CardRejected,       ///< The bank does not know the card or it is blocked.
+    PinAccepted,
+    PinRejected,
+    Retry,              ///< Wrong PIN, attempts left.
+    AttemptsExhausted,  ///< Wrong PIN, no attempts left.
+    AccountChosen,
+    OptionChosen,
+    BalanceChosen,
+    WithdrawChosen,
+    DepositChosen,
+    MiniStatementChosen,
+    ExitChosen,
+    Done,               ///< Operation finished (or was refused); back to the menu.
+};
+
+/// Number of StateEvent values.
+inline constexpr std::size_t kEventCount = static_cast<std::size_t>(StateEvent::Done) + 1;
+
+/// One edge of the state graph.
+struct Transition {
+    StateId from;
+    StateEvent event;
+    StateId to;
+};
+
+/// Every allowed transition. Handlers can only move along these (see ATM::transition).
+inline constexpr Transition kTransitions[] = {
+    {StateId::Idle, StateEvent::CardRead, StateId::CardInserted},
+    {StateId::CardInserted, StateEvent::Next, StateId::AskForPIN},
+    {StateId::CardNotExistInSystem, StateEvent::Next, StateId::EjectCard},
+    {StateId::AskForPIN, StateEvent::CardRejected, StateId::CardNotExistInSystem},
+    {StateId::AskForPIN, StateEvent::PinAccepted, StateId::SuccessfulPin},
+    {StateId::AskForPIN, StateEvent::PinRejected, StateId::UnsuccessfulPin},
+    {StateId::SuccessfulPin, StateEvent::Next, StateId::ChooseAccount},
+    {StateId::UnsuccessfulPin, StateEvent::Retry, StateId::AskForPIN},
+    {StateId::UnsuccessfulPin, StateEvent::AttemptsExhausted, StateId::BlockCard},
+    {StateId::BlockCard, StateEvent::Next, StateId::EjectCard},
+    {StateId::ChooseAccount, StateEvent::AccountChosen, StateId::ShowOptions},
+    {StateId::ShowOptions, StateEvent::OptionChosen, StateId::DecideOption},
+    {StateId::DecideOption, StateEvent::BalanceChosen, StateId::CheckBalance},
+    {StateId::DecideOption, StateEvent::WithdrawChosen, StateId::WithdrawFunds},
+    {StateId::DecideOption, StateEvent::DepositChosen, StateId::DepositFunds},
+    {StateId::DecideOption, StateEvent::MiniStatementChosen, StateId::MiniStatement},
+    {StateId::DecideOption, StateEvent::ExitChosen, StateId::Exit},
+    {StateId::CheckBalance, StateEvent::Done, StateId::ShowOptions},
+    {StateId::WithdrawFunds, StateEvent::Done, StateId::ShowOptions},
+    {StateId::DepositFunds, StateEvent::Done, StateId::ShowOptions},
+    {StateId::MiniStatement, StateEvent::Done, StateId::ShowOptions},
+    {StateId::Exit, StateEvent::Next, StateId::EjectCard},
+    {StateId::EjectCard, StateEvent::Next, StateId::Reset},
+    {StateId::Reset, StateEvent::Next, StateId::Idle},
+};
+
+namespace detail {
+
+inline constexpr std::uint8_t kNoTransition = 0xFF;
+
+using TransitionMatrix = std::array<std::array<std::uint8_t, kEventCount>, kStateCount>;
+
+constexpr std::size_t index(StateId id) { return static_cast<std::size_t>(id); }
+constexpr std::size_t index(StateEvent event) { return static_cast<std::size_t>(event); }
+
+// Dense [state][event] form of kTransitions; kNoTransition where there is no edge.
+// A duplicate (state, event) pair makes the build fail here.
+constexpr TransitionMatrix buildMatrix() {
+    TransitionMatrix matrix{};
+    for (auto& row : matrix) {
+        row.fill(kNoTransition);
+    }
+    for (const Transition& t : kTransitions) {
+        std::uint8_t& cell = matrix[index(t.from)][index(t.event)];
+        if (cell != kNoTransition) {
+            throw "duplicate (state, event) pair in kTransitions";
+        }
+        cell = static_cast<std::uint8_t>(t.to);
+    }
+    return matrix;
+}
+
+inline constexpr TransitionMatrix kMatrix = buildMatrix();
+
+constexpr bool everyStateReachableFromIdle() {
+    std::array<bool, kStateCount> seen{};
+    std::array<std::size_t, kStateCount> queue{};
+    std::size_t head = 0;
+    std::size_t tail = 0;
+    seen[index(StateId::Idle)] = true;
+    queue[tail++] = index(StateId::Idle);
+    while (head < tail) {
+        const std::size_t state = queue[head++];
+        for (std::uint8_t next : kMatrix[state]) {
+            if (next != kNoTransition && !seen[next]) {
+                seen[next] = true;
+                queue[tail++] = next;
+            }
+        }
+    }
+    return tail == kStateCount;
+}
+
+constexpr bool everyStateHasAWayOut() {
+    for (const auto& row : kMatrix) {
+        bool any = false;
+        for (std::uint8_t next : row) {
+            any = any || next != kNoTransition;
+        }
+        if (!any) return false;
+    }
+    return true;
+}
+
+}  // namespace detail
+
+static_assert(detail::everyStateReachableFromIdle(), "kTransitions: a state cannot be reached from Idle");
+static_assert(detail::everyStateHasAWayOut(), "kTransitions: a state has no outgoing transition");
+
+/// Returns true if the table has an edge for the event in the given state.
+/// @param from Current state.
+/// @param event Event the state reports.
+/// @return true if the transition is allowed.
+constexpr bool isValidTransition(StateId from, StateEvent event) {
+    return detail::kMatrix[detail::index(from)][detail::index(event)] != detail::kNoTransition;
+}
+
+/// Looks up the state an event leads to.
+/// @param from Current state.
+/// @param event Event the state reports.
+/// @return Next state, or nullopt if the table has no such edge.
+constexpr std::optional<StateId> nextState(StateId from, StateEvent event) {
+    if (!isValidTransition(from, event)) {
+        return std::nullopt;
+    }
+    return static_cast<StateId>(detail::kMatrix[detail::index(from)][detail::index(event)]);
+}
+
+/// Next state for a transition known at compile time; does not compile if the edge is missing.
+template <StateId From, StateEvent Event>
+inline constexpr StateId kNextState = [] {
+    static_assert(isValidTransition(From, Event), "transition not in kTransitions");
+    return *nextState(From, Event);
+}();
+
+/// @return Short state name as used in the graph, e.g. "AskForPIN".
+std::string_view stateIdName(StateId id);
+/// @return Event name, e.g. "PinAccepted".
+std::string_view stateEventName(StateEvent event);
+/// Renders kTransitions as a Graphviz DOT digraph (one edge per transition, labelled with the event).
+/// @return DOT source.
+std::string transitionGraphDot();
+
+}  // namespace atm
@@ -0,0 +1,52 @@
+#pragma once
+// TerminalLoop.h - Drives many ATMs from one thread; terminals waiting on the bank are parked.
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace atm {
+
+class ATM;
+
+/// Round-robins state-machine steps over its terminals. A terminal whose state is waiting for
+/// a bank request leaves the run queue and is requeued by the request's completion, so one
+/// thread can drive hundreds of ATMs as long as their user interfaces do not block.
+class TerminalLoop {
+public:
+    TerminalLoop() = default;
+    /// Detaches from the terminals' bank-ready handlers.
+    ~TerminalLoop();
+    TerminalLoop(const TerminalLoop&) = delete;
+    TerminalLoop& operator=(const TerminalLoop&) = delete;
+
+    /// Adds a terminal; it must outlive the loop.
+    /// @param atm ATM to drive; its bank-ready handler is taken over by the loop.
+    void add(ATM& atm);
+    /// Runs one step of the next runnable terminal.
+    /// @return false if every terminal is waiting for the bank.
+    bool runStep();
+    /// Blocks until a terminal becomes runnable or the timeout passes.
+    /// @param timeout Longest wait.
+    /// @return true if a terminal is runnable.
+    bool waitForWork(std::chrono::milliseconds timeout);
+    /// Steps terminals (waiting whenever all are parked) until done() returns true.
+    /// @param done Checked between steps.
+    void runUntil(const std::function<bool()>& done);
+    /// Returns the number of terminals.
+    /// @return Terminal count.
+    std::size_t size() const;
+
+private:
+    void makeRunnable(ATM& atm);
+
+    mutable std::mutex mutex_;
+    std::condition_variable runnable_;
+    std::deque<ATM*> runQueue_;
+    std::unordered_map<ATM*, bool> queued_;
+};
+
+}  // namespace atm
@@ -0,0 +1,92 @@
+#pragma once
+// TerminalScheduler.h - Work-stealing pool that steps many ATMs; idle and bank-bound terminals park.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace atm {
+
+class ATM;
+
+/// Scheduler counters.
+struct TerminalSchedulerStats {
+    /// runOnce calls made.
+    std::uint64_t steps = 0;
+    /// Terminals taken from another worker's queue.
+    std::uint64_t steals = 0;
+    /// Times a worker found no runnable terminal anywhere and went to sleep.
+    std::uint64_t sleeps = 0;
+};
+
+/// Treats each terminal's ATM::runOnce() as a task. Every worker has its own run queue and
+/// steps the terminals in it round-robin; a worker whose queue is empty steals half of
+/// another worker's queue. A terminal leaves the queues while it waits for the bank or
+/// while it is idle with no input (ATM::isAwaitingInput), and comes back when the bank
+/// answers or someone calls ATM::notifyInput(), so parked terminals cost nothing.
+class TerminalScheduler {
+public:
+    /// @param workers Worker threads (0 = hardware concurrency).
+    explicit TerminalScheduler(unsigned workers = 0);
+    /// Stops the workers and detaches from the terminals' handlers.
+    ~TerminalScheduler();
+    TerminalScheduler(const TerminalScheduler&) = delete;
+    TerminalScheduler& operator=(const TerminalScheduler&) = delete;
+
+    /// Adds a terminal (before or after start); it must outlive the scheduler.
+    /// @param atm ATM to drive; its bank-ready handler is taken over by the scheduler.
+    void add(ATM& atm);
+    /// Starts the worker threads.
+    void start();
+    /// Stops and joins the worker threads; terminals keep their state and can be resumed.
+    void stop();
+    /// Returns the number of worker threads.
+    /// @return Worker count.
+    unsigned workerCount() const { return static_cast<unsigned>(workers_.size()); }
+    /// Returns the counters.
+    /// @return Steps, steals and sleeps so far.
+    TerminalSchedulerStats stats() const;
+
+private:
+    struct Terminal {
+        /// state bits: in a run queue, being stepped by a worker, scheduled during that step.
+        static constexpr std::uint8_t kQueued = 1;
+        static constexpr std::uint8_t kRunning = 2;
+        static constexpr std::uint8_t kPending = 4;
+
+        ATM* atm = nullptr;
+        unsigned home = 0;
+        /// Never both queued and running, so one ATM is never stepped by two workers at once.
+        std::atomic<std::uint8_t> state{0};
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Terminal*> queue;
+        std::thread thread;
+        std::atomic<std::uint64_t> steps{0};
+        std::atomic<std::uint64_t> steals{0};
+        std::atomic<std::uint64_t> sleeps{0};
+    };
+
+    void schedule(Terminal& terminal);
+    void workerLoop(unsigned index);
+    Terminal* popLocal(Worker& worker);
+    Terminal* steal(unsigned thief);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex terminalsMutex_;
+    std::vector<std::unique_ptr<Terminal>> terminals_;
+    std::atomic<bool> running_{false};
+    // Runnable terminals across all queues; workers sleep only when it is zero.
+    std::atomic<std::size_t> runnable_{0};
+    std::atomic<unsigned> sleepers_{0};
+    std::mutex sleepMutex_;
+    std::condition_variable wakeup_;
+};
+
+}  // namespace atm
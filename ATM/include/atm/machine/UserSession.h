@@ -6,7 +6,7 @@
 #include <string>
 #include <vector>
 
-#include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
 #include "atm/machine/MenuOption.h"
 
 namespace atm {
@@ -18,15 +18,12 @@ public:
     /// @param initialUnsuccessfulPinCount For tests (default 0).
     explicit UserSession(std::string card, int initialUnsuccessfulPinCount = 0);
 
-    /// Sets the accounts linked to the card (from bank).
-    /// @param accountsList Accounts linked to the card.
-    void setAccounts(const std::vector<Account>& accountsList);
-    /// Returns the mutable account list.
-    /// @return Mutable account list.
-    std::vector<Account>& getAccounts();
-    /// Returns the account list.
-    /// @return Account list.
-    const std::vector<Account>& getAccounts() const;
+    /// Sets the handles of the accounts linked to the card (from bank).
+    /// @param accountsList Account handles linked to the card.
+    void setAccounts(std::vector<AccountHandle> accountsList);
+    /// Returns the account handle list.
+    /// @return Account handle list.
+    const std::vector<AccountHandle>& getAccounts() const;
     /// Sets the selected account by index.
     /// @param index 0-based index into account list.
     void setSelectedAccount(size_t index);
@@ -38,27 +35,30 @@ public:
     void setPin(const std::string& pin);
     /// Returns the PIN stored for this session.
     /// @return PIN stored for this session.
-    std::string getStoredPin() const;
+    const std::string& getStoredPin() const;
     /// Sets whether the user has been authenticated.
     /// @param auth true after successful PIN verification.
     void setUserAuthenticated(bool auth);
     /// Returns true if the user has entered the correct PIN.
     /// @return true if authenticated.
     bool getUserAuthenticated() const;
-    /// Returns the selected account.
+    /// Returns the handle of the selected account.
     /// @return Selected account or nullptr if none or invalid index.
-    Account* getSelectedAccount();
-    /// Returns the selected account.
-    /// @return Selected account or nullptr if none or invalid index.
-    const Account* getSelectedAccount() const;
+    const AccountHandle* getSelectedAccount() const;
     /// Returns the card number for this session.
     /// @return Card number.
-    std::string getCardNumber() const;
+    const std::string& getCardNumber() const;
     /// Increments the failed PIN attempt count.
     void incrementUnsuccessfulPinCount();
     /// Returns the number of failed PIN attempts this session.
     /// @return Number of failed PIN attempts.
     int getUnsuccessfulPinCount() const;
+    /// Records how many wrong PINs the bank still allows (from authenticate).
+    /// @param remaining Remaining attempts reported by the bank.
+    void setRemainingPinAttempts(int remaining);
+    /// Returns the remaining attempts last reported by the bank.
+    /// @return Remaining attempts, or nullopt before the first PIN check.
+    std::optional<int> getRemainingPinAttempts() const;
     /// Sets the menu option chosen by the user.
     /// @param opt Menu option chosen by user.
     void setSelectedOption(MenuOption opt);
@@ -69,10 +69,11 @@ public:
 private:
     std::string cardNumber_;
     std::string storedPin_;
-    std::vector<Account> accounts_;
+    std::vector<AccountHandle> accounts_;
     std::optional<size_t> selectedAccountIndex_;
     bool userAuthenticated_ = false;
     int unsuccessfulPinCount_ = 0;
+    std::optional<int> remainingPinAttempts_;
     MenuOption selectedOption_ = MenuOption::CheckBalance;
 };
 
@@ -0,0 +1,117 @@
+// AsyncBankAdapter.cpp - Inline or thread-pool execution of blocking bank calls.
+
+#include "atm/bank/AsyncBankAdapter.h"
+
+namespace atm {
+
+AsyncBankAdapter::AsyncBankAdapter(IBankService& service, unsigned workers) : service_(service) {
+    workers_.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+AsyncBankAdapter::~AsyncBankAdapter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+template <typename T, typename Fn>
+BankCall<T> AsyncBankAdapter::submit(Fn fn) {
+    if (workers_.empty()) {
+        return BankCall<T>::completed(fn());
+    }
+    BankPromise<T> promise;
+    BankCall<T> call = promise.call();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back([promise, fn = std::move(fn)]() mutable { promise.complete(fn()); });
+    }
+    workAvailable_.notify_one();
+    return call;
+}
+
+void AsyncBankAdapter::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        task();
+    }
+}
+
+BankCall<bool> AsyncBankAdapter::checkIfCardExist(const std::string& card) {
+    return submit<bool>([this, card] { return service_.checkIfCardExist(card); });
+}
+
+BankCall<bool> AsyncBankAdapter::checkPIN(const std::string& pin, const std::string& card) {
+    return submit<bool>([this, pin, card] { return service_.checkPIN(pin, card); });
+}
+
+BankCall<AuthResult> AsyncBankAdapter::authenticate(const std::string& card, const std::string& pin) {
+    return submit<AuthResult>([this, card, pin] { return service_.authenticate(card, pin); });
+}
+
+BankCall<bool> AsyncBankAdapter::blockCard(const std::string& card) {
+    return submit<bool>([this, card] {
+        service_.blockCard(card);
+        return true;
+    });
+}
+
+BankCall<Money> AsyncBankAdapter::showBalance(AccountId account) {
+    return submit<Money>([this, account] { return service_.showBalance(account); });
+}
+
+BankCall<bool> AsyncBankAdapter::withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                              RequestId request) {
+    return submit<bool>(
+        [this, account, amount, terminal, card, request] {
+            return service_.withdrawCash(account, amount, terminal, card, request);
+        });
+}
+
+BankCall<bool> AsyncBankAdapter::depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) {
+    return submit<bool>(
+        [this, account, amount, terminal, request] { return service_.depositCash(account, amount, terminal, request); });
+}
+
+BankCall<bool> AsyncBankAdapter::reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                             RequestId hold) {
+    return submit<bool>(
+        [this, account, amount, terminal, card, hold] {
+            return service_.reserveCash(account, amount, terminal, card, hold);
+        });
+}
+
+BankCall<std::optional<bool>> AsyncBankAdapter::commitCash(RequestId hold) {
+    return submit<std::optional<bool>>([this, hold] { return std::optional<bool>(service_.commitCash(hold)); });
+}
+
+BankCall<bool> AsyncBankAdapter::releaseCash(RequestId hold) {
+    return submit<bool>([this, hold] { return service_.releaseCash(hold); });
+}
+
+BankCall<std::vector<HistoryEntry>> AsyncBankAdapter::getMiniStatement(AccountId account, std::size_t count) {
+    return submit<std::vector<HistoryEntry>>(
+        [this, account, count] { return service_.getMiniStatement(account, count); });
+}
+
+BankCall<std::vector<AccountHandle>> AsyncBankAdapter::getAccountListForCard(const std::string& card) {
+    return submit<std::vector<AccountHandle>>([this, card] { return service_.getAccountListForCard(card); });
+}
+
+}  // namespace atm
@@ -1,44 +1,216 @@
-// AuthService.cpp - Card and PIN validation; account list per card.
+// AuthService.cpp - Card and PIN validation; account list per card (in memory, then snapshot).
 
 #include "atm/bank/AuthService.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/Snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 namespace atm {
 
+AuthService::AuthService(Ledger& ledger, int maxPinAttempts)
+    : ledger_(ledger), maxPinAttempts_(maxPinAttempts) {}
+
+const SnapshotCard* AuthService::findSnapshotCard(std::string_view card) const {
+    return snapshot_ ? snapshot_->findCard(card) : nullptr;
+}
+
+bool AuthService::isBlocked(const CardRecord* record, const SnapshotCard* snapshotCard) {
+    if (record && record->blocked()) return true;
+    return snapshotCard && (snapshotCard->flags & SnapshotCard::kBlocked);
+}
+
+std::span<const AccountId> AuthService::accountIdsOf(const CardRecord* record,
+                                                     const SnapshotCard* snapshotCard) const {
+    if (record && record->accountCount != 0) {
+        return cards_.accountsOf(*record);
+    }
+    if (snapshotCard) {
+        return snapshot_->accountsOf(*snapshotCard);
+    }
+    return {};
+}
+
+std::vector<AccountHandle> AuthService::handlesFor(std::span<const AccountId> ids) const {
+    std::vector<AccountHandle> handles;
+    handles.reserve(ids.size());
+    for (AccountId id : ids) {
+        AccountHandle handle = ledger_.getHandle(id);
+        if (handle.id != kInvalidAccountId) {
+            handles.push_back(std::move(handle));
+        }
+    }
+    return handles;
+}
+
 bool AuthService::checkIfCardExist(const std::string& card) const {
-    if (blockedCards_.find(card) != blockedCards_.end()) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const CardRecord* record = cards_.find(card);
+    const SnapshotCard* snapshotCard = findSnapshotCard(card);
+    if (isBlocked(record, snapshotCard)) {
         return false;
     }
-    return cardToPIN_.find(card) != cardToPIN_.end() ||
-           cardAccount_.find(card) != cardAccount_.end();
+    return record != nullptr || snapshotCard != nullptr;
 }
 
 bool AuthService::checkPIN(const std::string& pin, const std::string& card) const {
-    if (blockedCards_.find(card) != blockedCards_.end()) {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const CardRecord* record = cards_.find(card);
+    const SnapshotCard* snapshotCard = findSnapshotCard(card);
+    if (isBlocked(record, snapshotCard)) {
         return false;
     }
-    auto it = cardToPIN_.find(card);
-    if (it == cardToPIN_.end()) {
-        return false;
+    if (record && record->hasPin()) {
+        return record->pinDigest == pinDigest(card, pin);
     }
-    return it->second == pin;
+    return snapshotCard && (snapshotCard->flags & SnapshotCard::kHasPin) &&
+           snapshotCard->pinDigest == pinDigest(card, pin);
+}
+
+AuthResult AuthService::authenticate(const std::string& card, const std::string& pin) {
+    AuthResult result;
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    CardRecord* record = cards_.find(card);
+    const SnapshotCard* snapshotCard = findSnapshotCard(card);
+    if (!record && !snapshotCard) {
+        return result;
+    }
+    if (isBlocked(record, snapshotCard)) {
+        result.cardStatus = CardStatus::Blocked;
+        return result;
+    }
+    result.cardStatus = CardStatus::Active;
+
+    bool accepted;
+    if (record && record->hasPin()) {
+        accepted = record->pinDigest == pinDigest(card, pin);
+    }
+    else {
+        accepted = snapshotCard && (snapshotCard->flags & SnapshotCard::kHasPin) &&
+                   snapshotCard->pinDigest == pinDigest(card, pin);
+    }
+
+    // The attempt counter is updated atomically so logins only need the shared lock.
+    if (accepted) {
+        if (record) {
+            std::atomic_ref<std::uint8_t>(record->failedAttempts).store(0, std::memory_order_relaxed);
+        }
+        result.pinVerdict = PinVerdict::Accepted;
+        result.remainingAttempts = maxPinAttempts_;
+        result.accounts = handlesFor(accountIdsOf(record, snapshotCard));
+        return result;
+    }
+    result.pinVerdict = PinVerdict::Rejected;
+    std::unique_lock<std::shared_mutex> insertLock;
+    if (!record) {
+        // Snapshot-only cards get an in-memory record to carry the counter.
+        lock.unlock();
+        insertLock = std::unique_lock<std::shared_mutex>(mutex_);
+        record = &cards_.findOrInsert(card);
+    }
+    std::atomic_ref<std::uint8_t> failed(record->failedAttempts);
+    std::uint8_t current = failed.load(std::memory_order_relaxed);
+    while (current < 0xFF && !failed.compare_exchange_weak(current, static_cast<std::uint8_t>(current + 1),
+                                                           std::memory_order_relaxed)) {
+    }
+    const int failedCount = current < 0xFF ? current + 1 : current;
+    result.remainingAttempts = std::max(0, maxPinAttempts_ - failedCount);
+    return result;
 }
 
 void AuthService::blockCard(const std::string& card) {
-    blockedCards_.insert(card);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    cards_.findOrInsert(card).flags |= CardRecord::kBlocked;
 }
 
-std::vector<Account> AuthService::getAccountListForCard(const std::string& card) const {
-    auto it = cardAccount_.find(card);
-    if (it == cardAccount_.end()) return {};
-    return it->second;
+std::vector<AccountHandle> AuthService::getAccountListForCard(const std::string& card) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const CardRecord* record = cards_.find(card);
+    const SnapshotCard* snapshotCard = record && record->accountCount != 0 ? nullptr : findSnapshotCard(card);
+    return handlesFor(accountIdsOf(record, snapshotCard));
 }
 
-void AuthService::addAccountToCard(const std::string& card, const Account& account) {
-    cardAccount_[card].push_back(account);
+AccountId AuthService::addAccountToCard(const std::string& card, const Account& account) {
+    const AccountId id = ledger_.openAccount(account);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    cards_.appendAccounts(cards_.findOrInsert(card), std::span<const AccountId>(&id, 1));
+    return id;
+}
+
+void AuthService::linkAccountToCard(const std::string& card, AccountId id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    cards_.appendAccounts(cards_.findOrInsert(card), std::span<const AccountId>(&id, 1));
 }
 
 void AuthService::setPinForCard(const std::string& card, const std::string& pin) {
-    cardToPIN_[card] = pin;
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    CardRecord& record = cards_.findOrInsert(card);
+    record.pinDigest = pinDigest(card, pin);
+    record.flags |= CardRecord::kHasPin;
+}
+
+void AuthService::importCard(std::string_view card, std::string_view pin,
+                             std::span<const AccountId> accounts, bool blocked) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    CardRecord& record = cards_.findOrInsert(card);
+    if (!pin.empty()) {
+        record.pinDigest = pinDigest(card, pin);
+        record.flags |= CardRecord::kHasPin;
+    }
+    if (blocked) {
+        record.flags |= CardRecord::kBlocked;
+    }
+    cards_.appendAccounts(record, accounts);
+}
+
+void AuthService::reserve(std::size_t cards) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    cards_.reserve(cards_.size() + cards);
+}
+
+void AuthService::attachSnapshot(const SnapshotView* snapshot) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    snapshot_ = snapshot;
+}
+
+void AuthService::forEachCard(const std::function<void(const CardRecordView&)>& fn) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto fillFromMemory = [&](const CardRecord& record, CardRecordView& view) {
+        if (record.hasPin()) {
+            view.hasPin = true;
+            view.pinDigest = record.pinDigest;
+        }
+        if (record.accountCount != 0) {
+            view.accounts = cards_.accountsOf(record);
+        }
+        view.blocked = view.blocked || record.blocked();
+    };
+
+    if (snapshot_) {
+        for (const SnapshotCard& slot : snapshot_->cardSlots()) {
+            if (!(slot.flags & SnapshotCard::kUsed)) continue;
+            CardRecordView view;
+            view.card = slot.number();
+            view.hasPin = (slot.flags & SnapshotCard::kHasPin) != 0;
+            view.pinDigest = slot.pinDigest;
+            view.blocked = (slot.flags & SnapshotCard::kBlocked) != 0;
+            view.accounts = snapshot_->accountsOf(slot);
+            if (const CardRecord* record = cards_.find(view.card)) {
+                fillFromMemory(*record, view);
+            }
+            fn(view);
+        }
+    }
+    // Cards the snapshot already covered above were merged there.
+    cards_.forEach([&](std::string_view card, const CardRecord& record) {
+        if (findSnapshotCard(card)) return;
+        CardRecordView view;
+        view.card = card;
+        fillFromMemory(record, view);
+        fn(view);
+    });
 }
 
 }  // namespace atm
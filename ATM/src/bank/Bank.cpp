@@ -1,9 +1,26 @@
-// Bank.cpp - IBankService implementation; delegates to AuthService and TransactionManager.
+// Bank.cpp - IBankService implementation; delegates to AuthService and TransactionManager, answering
+// repeated withdraw/deposit/reserve requests from the dedupe table if one is attached.
 
 #include "atm/bank/Bank.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/TransactionJournal.h"
+#include "atm/machine/Logger.h"
+#include "atm/machine/Metrics.h"
 
 namespace atm {
 
+namespace {
+
+enum class Operation : std::uint64_t { Withdraw = 1, Deposit = 2, Reserve = 3 };
+
+// What a repeat must match: the same operation on the same account for the same amount.
+std::uint64_t fingerprint(Operation operation, AccountId account, Money amount) {
+    const std::uint64_t h = mix64((static_cast<std::uint64_t>(account) << 8) ^ static_cast<std::uint64_t>(operation));
+    return mix64(h ^ static_cast<std::uint64_t>(amount.getCents()));
+}
+
+}  // namespace
+
 Bank::Bank(TransactionManager& transaction, AuthService& auth)
     : transactionManager_(transaction), authService_(auth) {}
 
@@ -15,24 +32,78 @@ bool Bank::checkPIN(const std::string& pin, const std::string& card) {
     return authService_.checkPIN(pin, card);
 }
 
-std::vector<Account> Bank::getAccountListForCard(const std::string& card) {
+AuthResult Bank::authenticate(const std::string& card, const std::string& pin) {
+    return authService_.authenticate(card, pin);
+}
+
+std::vector<AccountHandle> Bank::getAccountListForCard(const std::string& card) {
     return authService_.getAccountListForCard(card);
 }
 
 void Bank::blockCard(const std::string& card) {
     authService_.blockCard(card);
+    if (TransactionJournal* journal = transactionManager_.getJournal()) {
+        if (journal->appendCardBlock(card) == 0) {
+            Logger::event<LogEventId::CardBlockJournalFailed>(card);
+        }
+    }
 }
 
-Money Bank::showBalance(Account* account) {
+Money Bank::showBalance(AccountId account) {
     return transactionManager_.showBalance(account);
 }
 
-bool Bank::withdrawCash(Account* account, Money amount) {
-    return transactionManager_.withdrawCash(account, amount);
+template <typename Op>
+bool Bank::runOnce(RequestId request, std::uint64_t fingerprint, AccountId account, Money amount, Op op) {
+    if (!dedupe_ || request == kNoRequest) {
+        return op();
+    }
+    bool result = false;
+    switch (dedupe_->begin(request, fingerprint, &result)) {
+        case DedupeOutcome::New:
+            break;
+        case DedupeOutcome::Repeat:
+            atmMetrics().requestRepeats.inc();
+            return result;
+        case DedupeOutcome::Mismatch:
+            Logger::event<LogEventId::BankRequestIdReused>(request, account, amount);
+            atmMetrics().rejected(LogEventId::BankRequestIdReused).inc();
+            return false;
+        case DedupeOutcome::TableFull:
+            Logger::event<LogEventId::BankRequestTableFull>(request, account, amount);
+            atmMetrics().rejected(LogEventId::BankRequestTableFull).inc();
+            return false;
+    }
+    result = op();
+    dedupe_->finish(request, result);
+    return result;
+}
+
+bool Bank::withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId request) {
+    return runOnce(request, fingerprint(Operation::Withdraw, account, amount), account, amount,
+                   [&] { return transactionManager_.withdrawCash(account, amount, terminal, card); });
+}
+
+bool Bank::depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) {
+    return runOnce(request, fingerprint(Operation::Deposit, account, amount), account, amount,
+                   [&] { return transactionManager_.depositCash(account, amount, terminal); });
+}
+
+bool Bank::reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) {
+    return runOnce(hold, fingerprint(Operation::Reserve, account, amount), account, amount,
+                   [&] { return transactionManager_.reserveWithdrawal(account, amount, terminal, card, hold); });
+}
+
+bool Bank::commitCash(RequestId hold) {
+    return transactionManager_.commitWithdrawal(hold);
+}
+
+bool Bank::releaseCash(RequestId hold) {
+    return transactionManager_.releaseWithdrawal(hold);
 }
 
-bool Bank::depositCash(Account* account, Money amount) {
-    return transactionManager_.depositCash(account, amount);
+std::vector<HistoryEntry> Bank::getMiniStatement(AccountId account, std::size_t count) {
+    return transactionManager_.miniStatement(account, count);
 }
 
 }  // namespace atm
@@ -0,0 +1,225 @@
+// BankProtocol.cpp - Frame encoding/decoding and server-side request dispatch.
+
+#include "atm/bank/BankProtocol.h"
+#include "atm/bank/IBankService.h"
+
+#include <algorithm>
+
+namespace atm {
+
+namespace protocol {
+
+FrameWriter::FrameWriter(std::string& out, std::uint32_t requestId, BankOpcode opcode)
+    : out_(out), start_(out.size()) {
+    put<std::uint32_t>(0);
+    put(requestId);
+    put(static_cast<std::uint8_t>(opcode));
+}
+
+void FrameWriter::finish() {
+    const auto length = static_cast<std::uint32_t>(out_.size() - start_ - kLengthPrefix);
+    std::memcpy(out_.data() + start_, &length, sizeof(length));
+}
+
+void FrameWriter::putString(std::string_view value) {
+    const auto length = static_cast<std::uint16_t>(std::min<std::size_t>(value.size(), 0xFFFF));
+    put(length);
+    out_.append(value.data(), length);
+}
+
+void FrameWriter::putAccounts(const std::vector<AccountHandle>& accounts) {
+    put(static_cast<std::uint16_t>(accounts.size()));
+    for (const AccountHandle& account : accounts) {
+        put(account.id);
+        putString(account.name);
+    }
+}
+
+void FrameWriter::putAuthResult(const AuthResult& result) {
+    put(static_cast<std::uint8_t>(result.cardStatus));
+    put(static_cast<std::uint8_t>(result.pinVerdict));
+    put(static_cast<std::int32_t>(result.remainingAttempts));
+    putAccounts(result.accounts);
+}
+
+void FrameWriter::putHistory(const std::vector<HistoryEntry>& entries) {
+    const std::size_t count = std::min<std::size_t>(entries.size(), kMaxStatementEntries);
+    put(static_cast<std::uint16_t>(count));
+    for (std::size_t i = 0; i < count; ++i) {
+        const HistoryEntry& entry = entries[i];
+        put(entry.timeUs);
+        put(static_cast<std::uint8_t>(entry.type));
+        put<std::int64_t>(entry.amount.getCents());
+        put<std::int64_t>(entry.balance.getCents());
+        put(entry.terminal);
+    }
+}
+
+FrameReader::FrameReader(std::string_view body) : data_(body) {
+    requestId_ = get<std::uint32_t>();
+    opcode_ = static_cast<BankOpcode>(get<std::uint8_t>());
+}
+
+std::string FrameReader::getString() {
+    const auto length = get<std::uint16_t>();
+    if (!ok_ || data_.size() - pos_ < length) {
+        ok_ = false;
+        return {};
+    }
+    std::string value(data_.substr(pos_, length));
+    pos_ += length;
+    return value;
+}
+
+std::vector<AccountHandle> FrameReader::getAccounts() {
+    const auto count = get<std::uint16_t>();
+    std::vector<AccountHandle> accounts;
+    accounts.reserve(ok_ ? count : 0);
+    for (std::uint16_t i = 0; ok_ && i < count; ++i) {
+        AccountHandle account;
+        account.id = get<AccountId>();
+        account.name = getString();
+        accounts.push_back(std::move(account));
+    }
+    return accounts;
+}
+
+AuthResult FrameReader::getAuthResult() {
+    AuthResult result;
+    result.cardStatus = static_cast<CardStatus>(get<std::uint8_t>());
+    result.pinVerdict = static_cast<PinVerdict>(get<std::uint8_t>());
+    result.remainingAttempts = get<std::int32_t>();
+    result.accounts = getAccounts();
+    return result;
+}
+
+std::vector<HistoryEntry> FrameReader::getHistory() {
+    const auto count = get<std::uint16_t>();
+    std::vector<HistoryEntry> entries;
+    entries.reserve(ok_ ? count : 0);
+    for (std::uint16_t i = 0; ok_ && i < count; ++i) {
+        HistoryEntry entry;
+        entry.timeUs = get<std::int64_t>();
+        entry.type = static_cast<HistoryType>(get<std::uint8_t>());
+        entry.amount = Money(get<std::int64_t>());
+        entry.balance = Money(get<std::int64_t>());
+        entry.terminal = get<TerminalId>();
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+std::optional<std::size_t> completeFrame(std::string_view buffer) {
+    if (buffer.size() < kLengthPrefix) {
+        return 0;
+    }
+    std::uint32_t length;
+    std::memcpy(&length, buffer.data(), sizeof(length));
+    if (length < kBodyHeader || length > kMaxBody) {
+        return std::nullopt;
+    }
+    const std::size_t total = kLengthPrefix + length;
+    return buffer.size() >= total ? total : 0;
+}
+
+bool handleRequest(IBankService& bank, std::string_view body, std::string& out) {
+    FrameReader in(body);
+    if (!in.ok()) {
+        return false;
+    }
+    const std::size_t rollback = out.size();
+    bool known = true;
+    FrameWriter response(out, in.requestId(), in.opcode());
+    switch (in.opcode()) {
+        case BankOpcode::CheckIfCardExist: {
+            std::string card = in.getString();
+            if (in.ok()) response.put<std::uint8_t>(bank.checkIfCardExist(card));
+            break;
+        }
+        case BankOpcode::CheckPin: {
+            std::string card = in.getString();
+            std::string pin = in.getString();
+            if (in.ok()) response.put<std::uint8_t>(bank.checkPIN(pin, card));
+            break;
+        }
+        case BankOpcode::Authenticate: {
+            std::string card = in.getString();
+            std::string pin = in.getString();
+            if (in.ok()) response.putAuthResult(bank.authenticate(card, pin));
+            break;
+        }
+        case BankOpcode::BlockCard: {
+            std::string card = in.getString();
+            if (in.ok()) {
+                bank.blockCard(card);
+                response.put<std::uint8_t>(1);
+            }
+            break;
+        }
+        case BankOpcode::ShowBalance: {
+            const auto account = in.get<AccountId>();
+            if (in.ok()) response.put<std::int64_t>(bank.showBalance(account).getCents());
+            break;
+        }
+        case BankOpcode::Withdraw: {
+            const auto account = in.get<AccountId>();
+            const Money amount(in.get<std::int64_t>());
+            const auto terminal = in.get<TerminalId>();
+            const auto card = in.get<CardHash>();
+            const auto request = in.get<RequestId>();
+            if (in.ok()) response.put<std::uint8_t>(bank.withdrawCash(account, amount, terminal, card, request));
+            break;
+        }
+        case BankOpcode::Deposit: {
+            const auto account = in.get<AccountId>();
+            const Money amount(in.get<std::int64_t>());
+            const auto terminal = in.get<TerminalId>();
+            const auto request = in.get<RequestId>();
+            if (in.ok()) response.put<std::uint8_t>(bank.depositCash(account, amount, terminal, request));
+            break;
+        }
+        case BankOpcode::Reserve: {
+            const auto account = in.get<AccountId>();
+            const Money amount(in.get<std::int64_t>());
+            const auto terminal = in.get<TerminalId>();
+            const auto card = in.get<CardHash>();
+            const auto hold = in.get<RequestId>();
+            if (in.ok()) response.put<std::uint8_t>(bank.reserveCash(account, amount, terminal, card, hold));
+            break;
+        }
+        case BankOpcode::Commit: {
+            const auto hold = in.get<RequestId>();
+            if (in.ok()) response.put<std::uint8_t>(bank.commitCash(hold));
+            break;
+        }
+        case BankOpcode::Release: {
+            const auto hold = in.get<RequestId>();
+            if (in.ok()) response.put<std::uint8_t>(bank.releaseCash(hold));
+            break;
+        }
+        case BankOpcode::GetAccountList: {
+            std::string card = in.getString();
+            if (in.ok()) response.putAccounts(bank.getAccountListForCard(card));
+            break;
+        }
+        case BankOpcode::MiniStatement: {
+            const auto account = in.get<AccountId>();
+            const auto count = std::min(in.get<std::uint16_t>(), kMaxStatementEntries);
+            if (in.ok()) response.putHistory(bank.getMiniStatement(account, count));
+            break;
+        }
+        default:
+            known = false;
+            break;
+    }
+    if (!known || !in.ok()) {
+        out.resize(rollback);
+        return false;
+    }
+    response.finish();
+    return true;
+}
+
+}  // namespace protocol
+
+}  // namespace atm
@@ -0,0 +1,293 @@
+// BankServer.cpp - epoll event loop, worker pool, per-connection buffers.
+
+#include "atm/bank/BankServer.h"
+#include "atm/bank/BankProtocol.h"
+#include "atm/bank/IBankService.h"
+#include "atm/machine/Logger.h"
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace atm {
+
+struct BankServer::Connection {
+    int fd = -1;
+    bool closed = false;      // loop thread only
+    bool wantsWrite = false;  // loop thread only: EPOLLOUT registered
+    std::string in;           // loop thread only
+    std::size_t inOffset = 0;
+    std::mutex outMutex;
+    std::string out;          // appended by workers, drained by the loop
+    bool queuedForWrite = false;
+    bool broken = false;      // set by workers under outMutex: a request got no answer, so close
+};
+
+namespace {
+
+constexpr int kMaxEvents = 256;
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+}  // namespace
+
+BankServer::BankServer(IBankService& bank, BankServerConfig config) : bank_(bank), config_(std::move(config)) {}
+
+BankServer::~BankServer() {
+    stop();
+}
+
+bool BankServer::start(std::string* error) {
+    std::optional<BankAddress> address = BankAddress::parse(config_.address);
+    if (!address) {
+        if (error) *error = "bad address " + config_.address;
+        return false;
+    }
+    net::raiseFileLimit();
+    listenFd_ = net::listenOn(*address, error);
+    if (listenFd_ < 0) return false;
+    bound_ = net::localAddress(listenFd_, *address);
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.fd = wakeFd_;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    running_ = true;
+    stopping_ = false;
+    const unsigned workers = config_.workers != 0 ? config_.workers : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < workers; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+    loop_ = std::thread([this] { eventLoop(); });
+    Logger::log("Bank server listening", bound_.toString());
+    return true;
+}
+
+void BankServer::stop() {
+    if (!running_.exchange(false)) return;
+    const std::uint64_t one = 1;
+    [[maybe_unused]] ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+    loop_.join();
+    {
+        std::lock_guard<std::mutex> lock(taskMutex_);
+        stopping_ = true;
+    }
+    taskAvailable_.notify_all();
+    for (auto& worker : workers_) worker.join();
+    workers_.clear();
+    tasks_.clear();
+    readyToWrite_.clear();
+    for (auto& entry : connections_) ::close(entry.first);
+    connections_.clear();
+    ::close(listenFd_);
+    ::close(epollFd_);
+    ::close(wakeFd_);
+    if (bound_.kind == BankAddress::Kind::Unix) ::unlink(bound_.path.c_str());
+}
+
+BankServerStats BankServer::stats() const {
+    BankServerStats stats;
+    stats.connectionsAccepted = accepted_.load();
+    stats.connectionsOpen = open_.load();
+    stats.requests = requests_.load();
+    stats.malformed = malformed_.load();
+    return stats;
+}
+
+void BankServer::eventLoop() {
+    epoll_event events[kMaxEvents];
+    while (running_) {
+        const int count = ::epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            Logger::log("Bank server epoll_wait failed", errno);
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listenFd_) {
+                accept();
+                continue;
+            }
+            if (fd == wakeFd_) {
+                std::uint64_t drained;
+                [[maybe_unused]] ssize_t ignored = ::read(wakeFd_, &drained, sizeof(drained));
+                std::vector<std::shared_ptr<Connection>> ready;
+                {
+                    std::lock_guard<std::mutex> lock(readyMutex_);
+                    ready.swap(readyToWrite_);
+                }
+                for (auto& connection : ready) flush(connection);
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) continue;
+            std::shared_ptr<Connection> connection = it->second;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                close(connection);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) readFrom(connection);
+            if (!connection->closed && (events[i].events & EPOLLOUT)) flush(connection);
+        }
+    }
+}
+
+void BankServer::accept() {
+    while (true) {
+        const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Logger::log("Bank server accept failed", errno);
+            }
+            return;
+        }
+        auto connection = std::make_shared<Connection>();
+        connection->fd = fd;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+        connections_[fd] = std::move(connection);
+        ++accepted_;
+        ++open_;
+    }
+}
+
+void BankServer::readFrom(const std::shared_ptr<Connection>& connection) {
+    Connection& c = *connection;
+    while (true) {
+        const std::size_t used = c.in.size();
+        c.in.resize(used + kReadChunk);
+        const ssize_t received = ::recv(c.fd, c.in.data() + used, kReadChunk, 0);
+        if (received <= 0) {
+            c.in.resize(used);
+            if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (received < 0 && errno == EINTR) continue;
+            close(connection);
+            return;
+        }
+        c.in.resize(used + static_cast<std::size_t>(received));
+        if (static_cast<std::size_t>(received) < kReadChunk) break;
+    }
+
+    std::vector<Task> batch;
+    while (true) {
+        const std::string_view pending(c.in.data() + c.inOffset, c.in.size() - c.inOffset);
+        const std::optional<std::size_t> frame = protocol::completeFrame(pending);
+        if (!frame) {
+            ++malformed_;
+            close(connection);
+            return;
+        }
+        if (*frame == 0) break;
+        batch.push_back(Task{connection, std::string(pending.substr(protocol::kLengthPrefix,
+                                                                    *frame - protocol::kLengthPrefix))});
+        c.inOffset += *frame;
+    }
+    if (c.inOffset == c.in.size()) {
+        c.in.clear();
+        c.inOffset = 0;
+    }
+    else if (c.inOffset > kReadChunk) {
+        c.in.erase(0, c.inOffset);
+        c.inOffset = 0;
+    }
+    if (batch.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(taskMutex_);
+        for (auto& task : batch) tasks_.push_back(std::move(task));
+    }
+    if (batch.size() == 1) taskAvailable_.notify_one();
+    else taskAvailable_.notify_all();
+}
+
+void BankServer::workerLoop() {
+    std::string response;
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(taskMutex_);
+            taskAvailable_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        response.clear();
+        ++requests_;
+        // A request that cannot be answered (unknown opcode, short arguments) would leave the
+        // caller's call pending forever; closing makes the client fail its pending calls instead.
+        const bool answered = protocol::handleRequest(bank_, task.body, response);
+        if (!answered) ++malformed_;
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(task.connection->outMutex);
+            if (answered) task.connection->out += response;
+            else task.connection->broken = true;
+            if (!task.connection->queuedForWrite) {
+                task.connection->queuedForWrite = true;
+                wake = true;
+            }
+        }
+        if (wake) {
+            {
+                std::lock_guard<std::mutex> lock(readyMutex_);
+                readyToWrite_.push_back(task.connection);
+            }
+            const std::uint64_t one = 1;
+            [[maybe_unused]] ssize_t ignored = ::write(wakeFd_, &one, sizeof(one));
+        }
+    }
+}
+
+void BankServer::flush(const std::shared_ptr<Connection>& connection) {
+    Connection& c = *connection;
+    std::lock_guard<std::mutex> lock(c.outMutex);
+    c.queuedForWrite = false;
+    if (c.closed) return;
+    std::size_t sent = 0;
+    while (sent < c.out.size()) {
+        const ssize_t written = ::send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            c.out.clear();
+            setWriteInterest(c, false);
+            // Closing needs the loop's map; do it on the next readiness event (EPOLLHUP/ERR).
+            return;
+        }
+        sent += static_cast<std::size_t>(written);
+    }
+    c.out.erase(0, sent);
+    if (c.broken) {
+        close(connection);
+        return;
+    }
+    setWriteInterest(c, !c.out.empty());
+}
+
+void BankServer::setWriteInterest(Connection& connection, bool enabled) {
+    if (connection.wantsWrite == enabled) return;
+    connection.wantsWrite = enabled;
+    epoll_event event{};
+    event.events = enabled ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.fd = connection.fd;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void BankServer::close(const std::shared_ptr<Connection>& connection) {
+    if (connection->closed) return;
+    connection->closed = true;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    connections_.erase(connection->fd);
+    --open_;
+}
+
+}  // namespace atm
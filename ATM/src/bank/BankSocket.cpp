@@ -0,0 +1,180 @@
+// BankSocket.cpp - Address parsing and POSIX listen/connect helpers.
+
+#include "atm/bank/BankSocket.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <charconv>
+
+namespace atm {
+
+std::optional<BankAddress> BankAddress::parse(std::string_view text) {
+    BankAddress address;
+    if (text.substr(0, 5) == "unix:") {
+        address.kind = Kind::Unix;
+        address.path = std::string(text.substr(5));
+        return address.path.empty() || address.path.size() >= sizeof(sockaddr_un::sun_path)
+                   ? std::nullopt
+                   : std::optional<BankAddress>(address);
+    }
+    if (text.substr(0, 4) == "tcp:") {
+        text.remove_prefix(4);
+    }
+    const std::size_t colon = text.rfind(':');
+    if (colon == std::string_view::npos) {
+        return std::nullopt;
+    }
+    if (colon != 0) {
+        address.host = std::string(text.substr(0, colon));
+    }
+    const std::string_view port = text.substr(colon + 1);
+    auto [ptr, ec] = std::from_chars(port.data(), port.data() + port.size(), address.port);
+    if (port.empty() || ec != std::errc() || ptr != port.data() + port.size()) {
+        return std::nullopt;
+    }
+    return address;
+}
+
+std::string BankAddress::toString() const {
+    if (kind == Kind::Unix) {
+        return "unix:" + path;
+    }
+    return "tcp:" + host + ":" + std::to_string(port);
+}
+
+namespace net {
+
+namespace {
+
+int fail(std::string* error, const std::string& what, int fd = -1) {
+    if (error) *error = what + ": " + std::strerror(errno);
+    if (fd >= 0) ::close(fd);
+    return -1;
+}
+
+bool resolve(const BankAddress& address, sockaddr_in& out, std::string* error) {
+    std::memset(&out, 0, sizeof(out));
+    out.sin_family = AF_INET;
+    out.sin_port = htons(address.port);
+    if (::inet_pton(AF_INET, address.host.c_str(), &out.sin_addr) == 1) {
+        return true;
+    }
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    addrinfo* result = nullptr;
+    if (::getaddrinfo(address.host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+        if (error) *error = "cannot resolve " + address.host;
+        return false;
+    }
+    out.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+    ::freeaddrinfo(result);
+    return true;
+}
+
+sockaddr_un unixAddress(const BankAddress& address) {
+    sockaddr_un out{};
+    out.sun_family = AF_UNIX;
+    std::strncpy(out.sun_path, address.path.c_str(), sizeof(out.sun_path) - 1);
+    return out;
+}
+
+}  // namespace
+
+int listenOn(const BankAddress& address, std::string* error) {
+    if (address.kind == BankAddress::Kind::Unix) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return fail(error, "socket");
+        ::unlink(address.path.c_str());
+        const sockaddr_un addr = unixAddress(address);
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            return fail(error, "bind " + address.path, fd);
+        }
+        if (::listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) return fail(error, "listen", fd);
+        return fd;
+    }
+    sockaddr_in addr;
+    if (!resolve(address, addr, error)) return -1;
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return fail(error, "socket");
+    const int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        return fail(error, "bind " + address.toString(), fd);
+    }
+    if (::listen(fd, SOMAXCONN) != 0 || !setNonBlocking(fd)) return fail(error, "listen", fd);
+    return fd;
+}
+
+BankAddress localAddress(int fd, const BankAddress& address) {
+    BankAddress bound = address;
+    if (address.kind == BankAddress::Kind::Tcp) {
+        sockaddr_in addr{};
+        socklen_t length = sizeof(addr);
+        if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length) == 0) {
+            bound.port = ntohs(addr.sin_port);
+        }
+    }
+    return bound;
+}
+
+int connectTo(const BankAddress& address, std::string* error) {
+    if (address.kind == BankAddress::Kind::Unix) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return fail(error, "socket");
+        const sockaddr_un addr = unixAddress(address);
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            return fail(error, "connect " + address.path, fd);
+        }
+        return fd;
+    }
+    sockaddr_in addr;
+    if (!resolve(address, addr, error)) return -1;
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return fail(error, "socket");
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        return fail(error, "connect " + address.toString(), fd);
+    }
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool setNonBlocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+void raiseFileLimit() {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+}  // namespace net
+
+}  // namespace atm
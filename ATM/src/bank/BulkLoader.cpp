@@ -0,0 +1,351 @@
+// BulkLoader.cpp - Parallel CSV/binary parsing into views, then one reserved-ID ledger pass.
+
+#include "atm/bank/BulkLoader.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/Snapshot.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace atm {
+
+namespace {
+
+constexpr std::size_t kMaxCardLength = SnapshotCard::kCardSize;
+constexpr std::size_t kMaxPinLength = 12;
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool readFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    out.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0);
+    return static_cast<bool>(in.read(out.data(), static_cast<std::streamsize>(out.size())));
+}
+
+/// Checks one row's fields; returns an error message or nullptr.
+const char* validateRow(const BulkRow& row) {
+    if (row.card.empty() || row.card.size() > kMaxCardLength) return "card must be 1-24 characters";
+    if (row.pin.empty() || row.pin.size() > kMaxPinLength) return "PIN must be 1-12 digits";
+    for (char c : row.pin) {
+        if (c < '0' || c > '9') return "PIN must be 1-12 digits";
+    }
+    if (row.accountName.empty() || row.accountName.size() > 0xFFFF) return "account name must be 1-65535 bytes";
+    if (row.balanceCents < 0) return "balance must not be negative";
+    return nullptr;
+}
+
+/// Reads the next comma-separated field of a line; false on malformed quoting.
+bool nextField(std::string_view line, std::size_t& pos, std::string_view& field) {
+    if (pos < line.size() && line[pos] == '"') {
+        const std::size_t close = line.find('"', pos + 1);
+        if (close == std::string_view::npos) return false;
+        field = line.substr(pos + 1, close - pos - 1);
+        pos = close + 1;
+        if (pos < line.size() && line[pos] != ',') return false;
+    }
+    else {
+        const std::size_t comma = std::min(line.find(',', pos), line.size());
+        field = line.substr(pos, comma - pos);
+        pos = comma;
+    }
+    if (pos < line.size()) ++pos;  // skip the comma
+    else pos = line.size() + 1;    // mark "no more fields"
+    return true;
+}
+
+struct CsvChunk {
+    std::vector<BulkRow> rows;
+    std::size_t lines = 0;
+    std::size_t errorLine = 0;  // 1-based within the chunk
+    const char* error = nullptr;
+};
+
+void parseCsvChunk(std::string_view text, bool allowHeader, CsvChunk& out) {
+    out.rows.reserve(text.size() / 32);
+    std::size_t start = 0;
+    while (start < text.size()) {
+        std::size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(start, end - start);
+        start = end + 1;
+        ++out.lines;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty()) continue;
+        if (allowHeader && out.lines == 1 && line.substr(0, 5) == "card,") continue;
+
+        BulkRow row;
+        std::string_view balance;
+        std::string_view blocked;
+        std::size_t pos = 0;
+        if (!nextField(line, pos, row.card) || !nextField(line, pos, row.pin) ||
+            !nextField(line, pos, row.accountName) || pos > line.size() ||
+            !nextField(line, pos, balance)) {
+            out.errorLine = out.lines;
+            out.error = "expected card,pin,account_name,balance_cents[,blocked]";
+            return;
+        }
+        if (pos <= line.size() && (!nextField(line, pos, blocked) || pos <= line.size())) {
+            out.errorLine = out.lines;
+            out.error = "too many fields";
+            return;
+        }
+        auto [ptr, ec] = std::from_chars(balance.data(), balance.data() + balance.size(), row.balanceCents);
+        if (balance.empty() || ec != std::errc() || ptr != balance.data() + balance.size()) {
+            out.errorLine = out.lines;
+            out.error = "balance_cents is not an integer";
+            return;
+        }
+        if (blocked == "1") row.blocked = true;
+        else if (!blocked.empty() && blocked != "0") {
+            out.errorLine = out.lines;
+            out.error = "blocked must be 0 or 1";
+            return;
+        }
+        if (const char* error = validateRow(row)) {
+            out.errorLine = out.lines;
+            out.error = error;
+            return;
+        }
+        out.rows.push_back(row);
+    }
+}
+
+/// Splits CSV text at line boundaries and parses the pieces in parallel.
+BulkLoadReport parseCsv(std::string_view csv, unsigned threads, std::vector<std::vector<BulkRow>>& chunks) {
+    const std::size_t pieces = std::max<std::size_t>(1, std::min<std::size_t>(threads, csv.size() / 4096 + 1));
+    std::vector<std::string_view> texts;
+    std::size_t start = 0;
+    for (std::size_t i = 1; i <= pieces && start < csv.size(); ++i) {
+        std::size_t end = i == pieces ? csv.size() : std::max(start, csv.size() * i / pieces);
+        if (end < csv.size()) {
+            const std::size_t newline = csv.find('\n', end);
+            end = newline == std::string_view::npos ? csv.size() : newline + 1;
+        }
+        texts.push_back(csv.substr(start, end - start));
+        start = end;
+    }
+
+    std::vector<CsvChunk> parsed(texts.size());
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < texts.size(); ++i) {
+        workers.emplace_back([&, i] { parseCsvChunk(texts[i], false, parsed[i]); });
+    }
+    if (!texts.empty()) parseCsvChunk(texts[0], true, parsed[0]);
+    for (auto& worker : workers) worker.join();
+
+    BulkLoadReport report;
+    std::size_t lineOffset = 0;
+    for (CsvChunk& chunk : parsed) {
+        if (chunk.error) {
+            report.errorRow = lineOffset + chunk.errorLine;
+            report.error = chunk.error;
+            return report;
+        }
+        lineOffset += chunk.lines;
+        report.rows += chunk.rows.size();
+        chunks.push_back(std::move(chunk.rows));
+    }
+    report.ok = true;
+    return report;
+}
+
+template <typename T>
+bool readValue(std::string_view data, std::size_t& pos, T& value) {
+    if (data.size() - pos < sizeof(T)) return false;
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+bool readBytes(std::string_view data, std::size_t& pos, std::size_t length, std::string_view& out) {
+    if (data.size() - pos < length) return false;
+    out = data.substr(pos, length);
+    pos += length;
+    return true;
+}
+
+BulkLoadReport parseBinary(std::string_view data, std::vector<BulkRow>& rows) {
+    BulkLoadReport report;
+    if (data.substr(0, BulkLoader::kBinaryMagic.size()) != BulkLoader::kBinaryMagic) {
+        report.error = "missing ATMBULK1 magic";
+        return report;
+    }
+    std::size_t pos = BulkLoader::kBinaryMagic.size();
+    while (pos < data.size()) {
+        BulkRow row;
+        std::uint8_t cardLength = 0;
+        std::uint8_t pinLength = 0;
+        std::uint16_t nameLength = 0;
+        std::uint8_t blocked = 0;
+        const bool complete = readValue(data, pos, cardLength) && readBytes(data, pos, cardLength, row.card) &&
+                              readValue(data, pos, pinLength) && readBytes(data, pos, pinLength, row.pin) &&
+                              readValue(data, pos, nameLength) &&
+                              readBytes(data, pos, nameLength, row.accountName) &&
+                              readValue(data, pos, row.balanceCents) && readValue(data, pos, blocked);
+        const char* error = complete ? validateRow(row) : "truncated row";
+        if (!error && blocked > 1) error = "blocked must be 0 or 1";
+        if (error) {
+            report.errorRow = rows.size() + 1;
+            report.error = error;
+            return report;
+        }
+        row.blocked = blocked != 0;
+        rows.push_back(row);
+    }
+    report.rows = rows.size();
+    report.ok = true;
+    return report;
+}
+
+template <typename T>
+void appendValue(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+}  // namespace
+
+BulkLoader::BulkLoader(AuthService& auth, Ledger& ledger, BulkLoadOptions options)
+    : auth_(auth), ledger_(ledger), options_(options) {}
+
+unsigned BulkLoader::threadCount() const {
+    if (options_.threads != 0) return options_.threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+BulkLoadReport BulkLoader::loadCsvFile(const std::string& path) {
+    const Clock::time_point start = Clock::now();
+    std::string data;
+    if (!readFile(path, data)) {
+        BulkLoadReport report;
+        report.error = "cannot read " + path;
+        return report;
+    }
+    BulkLoadReport report = loadCsv(data);
+    report.seconds = secondsSince(start);
+    return report;
+}
+
+BulkLoadReport BulkLoader::loadCsv(std::string_view csv) {
+    const Clock::time_point start = Clock::now();
+    std::vector<std::vector<BulkRow>> chunks;
+    BulkLoadReport report = parseCsv(csv, threadCount(), chunks);
+    if (report.ok) report = import(chunks, report);
+    report.seconds = secondsSince(start);
+    return report;
+}
+
+BulkLoadReport BulkLoader::loadBinaryFile(const std::string& path) {
+    const Clock::time_point start = Clock::now();
+    std::string data;
+    if (!readFile(path, data)) {
+        BulkLoadReport report;
+        report.error = "cannot read " + path;
+        return report;
+    }
+    BulkLoadReport report = loadBinary(data);
+    report.seconds = secondsSince(start);
+    return report;
+}
+
+BulkLoadReport BulkLoader::loadBinary(std::string_view data) {
+    const Clock::time_point start = Clock::now();
+    std::vector<std::vector<BulkRow>> chunks(1);
+    BulkLoadReport report = parseBinary(data, chunks[0]);
+    if (report.ok) report = import(chunks, report);
+    report.seconds = secondsSince(start);
+    return report;
+}
+
+BulkLoadReport BulkLoader::csvToBinary(std::string_view csv, std::string& out) {
+    std::vector<std::vector<BulkRow>> chunks;
+    BulkLoadReport report = parseCsv(csv, std::max(1u, std::thread::hardware_concurrency()), chunks);
+    if (!report.ok) return report;
+    out.assign(kBinaryMagic);
+    for (const auto& chunk : chunks) {
+        for (const BulkRow& row : chunk) {
+            appendValue(out, static_cast<std::uint8_t>(row.card.size()));
+            out.append(row.card);
+            appendValue(out, static_cast<std::uint8_t>(row.pin.size()));
+            out.append(row.pin);
+            appendValue(out, static_cast<std::uint16_t>(row.accountName.size()));
+            out.append(row.accountName);
+            appendValue(out, row.balanceCents);
+            appendValue(out, static_cast<std::uint8_t>(row.blocked ? 1 : 0));
+        }
+    }
+    return report;
+}
+
+BulkLoadReport BulkLoader::import(const std::vector<std::vector<BulkRow>>& chunks, BulkLoadReport report) {
+    // Flatten chunk boundaries into global row offsets so IDs follow input order.
+    std::vector<std::size_t> offsets;
+    std::size_t total = 0;
+    for (const auto& chunk : chunks) {
+        offsets.push_back(total);
+        total += chunk.size();
+    }
+    if (total == 0) return report;
+
+    // Accounts: IDs reserved up front, then opened from several threads (shards lock independently).
+    const AccountId firstId = ledger_.reserveAccountIds(total);
+    ledger_.reserve(total);
+    const std::size_t workers = std::max<std::size_t>(1, std::min<std::size_t>(threadCount(), total / 1024 + 1));
+    auto openRange = [&](std::size_t begin, std::size_t end) {
+        std::size_t c = static_cast<std::size_t>(
+            std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1);
+        for (std::size_t i = begin; i < end; ++i) {
+            while (i >= offsets[c] + chunks[c].size()) ++c;
+            const BulkRow& row = chunks[c][i - offsets[c]];
+            ledger_.openAccountWithId(firstId + i, row.accountName, Money(row.balanceCents));
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t w = 1; w < workers; ++w) {
+        threads.emplace_back(openRange, total * w / workers, total * (w + 1) / workers);
+    }
+    openRange(0, total / workers);
+    for (auto& thread : threads) thread.join();
+
+    // Cards: consecutive rows of the same card become one importCard call.
+    auth_.reserve(total);
+    std::vector<AccountId> linked;
+    const BulkRow* first = nullptr;
+    bool blocked = false;
+    auto flush = [&] {
+        if (!first) return;
+        auth_.importCard(first->card, first->pin, linked, blocked);
+        ++report.cards;
+    };
+    std::size_t index = 0;
+    for (const auto& chunk : chunks) {
+        for (const BulkRow& row : chunk) {
+            if (!first || row.card != first->card) {
+                flush();
+                first = &row;
+                linked.clear();
+                blocked = false;
+            }
+            linked.push_back(firstId + index++);
+            blocked = blocked || row.blocked;
+        }
+    }
+    flush();
+    return report;
+}
+
+}  // namespace atm
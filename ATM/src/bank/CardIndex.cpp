@@ -0,0 +1,152 @@
+// CardIndex.cpp - Packed card keys, linear-probing lookup, account ranges.
+
+#include "atm/bank/CardIndex.h"
+#include "atm/bank/Hashing.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace atm {
+
+namespace {
+
+constexpr std::size_t kMaxPackedLength = 20;
+constexpr std::size_t kCharsPerWord = 10;
+constexpr std::size_t kMinSlots = 16;
+constexpr std::string_view kAlphabet = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz-";
+
+// 0 marks "no character", so codes start at 1.
+constexpr std::array<std::uint8_t, 256> makeCodes() {
+    std::array<std::uint8_t, 256> codes{};
+    for (std::size_t i = 0; i < kAlphabet.size(); ++i) {
+        codes[static_cast<unsigned char>(kAlphabet[i])] = static_cast<std::uint8_t>(i + 1);
+    }
+    return codes;
+}
+constexpr std::array<std::uint8_t, 256> kCodes = makeCodes();
+
+}  // namespace
+
+std::optional<CardKey> CardIndex::pack(std::string_view card) {
+    if (card.empty() || card.size() > kMaxPackedLength) return std::nullopt;
+    // Straight-line loops (no per-character early exit) so the compiler can unroll them.
+    CardKey key;
+    std::uint64_t invalid = 0;
+    const std::size_t loCount = std::min(card.size(), kCharsPerWord);
+    for (std::size_t i = 0; i < loCount; ++i) {
+        const std::uint64_t code = kCodes[static_cast<unsigned char>(card[i])];
+        invalid |= code == 0;
+        key.lo |= code << (6 * i);
+    }
+    for (std::size_t i = loCount; i < card.size(); ++i) {
+        const std::uint64_t code = kCodes[static_cast<unsigned char>(card[i])];
+        invalid |= code == 0;
+        key.hi |= code << (6 * (i - kCharsPerWord));
+    }
+    if (invalid) return std::nullopt;
+    return key;
+}
+
+std::string CardIndex::unpack(const CardKey& key) {
+    std::string card;
+    for (std::uint64_t word : {key.lo, key.hi}) {
+        for (std::size_t i = 0; i < kCharsPerWord; ++i) {
+            const std::uint64_t code = (word >> (6 * i)) & 0x3F;
+            if (code == 0) return card;
+            card.push_back(kAlphabet[code - 1]);
+        }
+    }
+    return card;
+}
+
+std::size_t CardIndex::slotFor(const CardKey& key) const {
+    return static_cast<std::size_t>(mix64(key.lo ^ std::rotl(key.hi, 31))) & (slots_.size() - 1);
+}
+
+const CardRecord* CardIndex::find(std::string_view card) const {
+    const std::optional<CardKey> key = pack(card);
+    if (!key) {
+        auto it = overflow_.find(std::string(card));
+        return it != overflow_.end() ? &it->second : nullptr;
+    }
+    if (slots_.empty()) return nullptr;
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = slotFor(*key);; i = (i + 1) & mask) {
+        const CardRecord& slot = slots_[i];
+        if (!(slot.flags & CardRecord::kUsed)) return nullptr;
+        if (slot.key == *key) return &slot;
+    }
+}
+
+CardRecord* CardIndex::find(std::string_view card) {
+    return const_cast<CardRecord*>(static_cast<const CardIndex*>(this)->find(card));
+}
+
+CardRecord& CardIndex::findOrInsert(std::string_view card) {
+    const std::optional<CardKey> key = pack(card);
+    if (!key) {
+        CardRecord& record = overflow_[std::string(card)];
+        record.flags |= CardRecord::kUsed;
+        return record;
+    }
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+        rehash(std::max(kMinSlots, slots_.size() * 2));
+    }
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = slotFor(*key);; i = (i + 1) & mask) {
+        CardRecord& slot = slots_[i];
+        if (!(slot.flags & CardRecord::kUsed)) {
+            slot.key = *key;
+            slot.flags = CardRecord::kUsed;
+            ++size_;
+            return slot;
+        }
+        if (slot.key == *key) return slot;
+    }
+}
+
+void CardIndex::appendAccounts(CardRecord& record, std::span<const AccountId> accounts) {
+    if (accounts.empty()) return;
+    // Only the most recently extended card sits at the end of the storage; any other card
+    // moves its range to the end first (linking to an existing card is rare).
+    if (record.accountCount != 0 && record.accountBegin + record.accountCount != accountIds_.size()) {
+        const std::size_t begin = accountIds_.size();
+        accountIds_.insert(accountIds_.end(), accountIds_.begin() + record.accountBegin,
+                           accountIds_.begin() + record.accountBegin + record.accountCount);
+        record.accountBegin = static_cast<std::uint32_t>(begin);
+    }
+    if (record.accountCount == 0) {
+        record.accountBegin = static_cast<std::uint32_t>(accountIds_.size());
+    }
+    accountIds_.insert(accountIds_.end(), accounts.begin(), accounts.end());
+    record.accountCount = static_cast<std::uint16_t>(record.accountCount + accounts.size());
+}
+
+std::span<const AccountId> CardIndex::accountsOf(const CardRecord& record) const {
+    return std::span<const AccountId>(accountIds_.data() + record.accountBegin, record.accountCount);
+}
+
+void CardIndex::reserve(std::size_t cards) {
+    std::size_t slots = kMinSlots;
+    while (cards * 4 > slots * 3) slots *= 2;
+    if (slots > slots_.size()) rehash(slots);
+}
+
+std::size_t CardIndex::memoryBytes() const {
+    return slots_.capacity() * sizeof(CardRecord) + accountIds_.capacity() * sizeof(AccountId);
+}
+
+void CardIndex::rehash(std::size_t slotCount) {
+    std::vector<CardRecord> old(slotCount);
+    old.swap(slots_);
+    const std::size_t mask = slots_.size() - 1;
+    for (const CardRecord& record : old) {
+        if (!(record.flags & CardRecord::kUsed)) continue;
+        std::size_t i = slotFor(record.key);
+        while (slots_[i].flags & CardRecord::kUsed) i = (i + 1) & mask;
+        slots_[i] = record;
+    }
+}
+
+}  // namespace atm
@@ -0,0 +1,139 @@
+// Ledger.cpp - Sharded account store; shard locks guard the index, balances change via atomic_ref.
+
+#include "atm/bank/Ledger.h"
+#include "atm/bank/Snapshot.h"
+
+#include <mutex>
+
+namespace atm {
+
+Ledger::Ledger(std::size_t shardCount)
+    : shardCount_(shardCount == 0 ? 1 : shardCount),
+      shards_(std::make_unique<Shard[]>(shardCount_)) {}
+
+AccountId Ledger::openAccount(const Account& account) {
+    const AccountId id = nextId_.fetch_add(1, std::memory_order_relaxed);
+    Shard& shard = shardFor(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    shard.accounts.try_emplace(id, account.getName(), account.getAmount().getCents());
+    return id;
+}
+
+AccountId Ledger::reserveAccountIds(std::size_t count) {
+    return nextId_.fetch_add(count, std::memory_order_relaxed);
+}
+
+bool Ledger::openAccountWithId(AccountId id, std::string_view name, Money balance) {
+    if (id == kInvalidAccountId || id <= snapshotAccounts_ || id > maxAccountId()) return false;
+    Shard& shard = shardFor(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    return shard.accounts.try_emplace(id, std::string(name), balance.getCents()).second;
+}
+
+void Ledger::reserve(std::size_t accounts) {
+    const std::size_t perShard = accounts / shardCount_ + 1;
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::unique_lock<std::shared_mutex> lock(shards_[i].mutex);
+        shards_[i].accounts.reserve(shards_[i].accounts.size() + perShard);
+    }
+}
+
+bool Ledger::attachSnapshot(SnapshotView& snapshot) {
+    if (snapshot_ || maxAccountId() != 0) return false;
+    snapshot_ = &snapshot;
+    snapshotAccounts_ = snapshot.header().accountCount;
+    nextId_.store(snapshotAccounts_ + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Ledger::Cell Ledger::find(AccountId id) const {
+    if (id != kInvalidAccountId && id <= snapshotAccounts_) {
+        SnapshotAccount* record = snapshot_->findAccount(id);
+        if (!record) return {};
+        return Cell{&record->balanceCents, snapshot_->accountName(*record)};
+    }
+    const Shard& shard = shardFor(id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.accounts.find(id);
+    if (it == shard.accounts.end()) return {};
+    return Cell{&it->second.balanceCents, it->second.name};
+}
+
+bool Ledger::contains(AccountId id) const {
+    return find(id).balance != nullptr;
+}
+
+std::optional<Money> Ledger::getBalance(AccountId id) const {
+    const Cell cell = find(id);
+    if (!cell.balance) return std::nullopt;
+    return Money(std::atomic_ref<std::int64_t>(*cell.balance).load(std::memory_order_acquire));
+}
+
+std::string Ledger::getName(AccountId id) const {
+    return std::string(find(id).name);
+}
+
+AccountHandle Ledger::getHandle(AccountId id) const {
+    const Cell cell = find(id);
+    if (!cell.balance) return {};
+    return AccountHandle{id, std::string(cell.name)};
+}
+
+LedgerStatus Ledger::debit(AccountId id, Money amount, Money* resulting) {
+    const Cell cell = find(id);
+    if (!cell.balance) return LedgerStatus::UnknownAccount;
+    std::atomic_ref<std::int64_t> balance(*cell.balance);
+    const std::int64_t cents = amount.getCents();
+    std::int64_t current = balance.load(std::memory_order_relaxed);
+    do {
+        if (current < cents) return LedgerStatus::InsufficientFunds;
+    } while (!balance.compare_exchange_weak(current, current - cents, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed));
+    if (resulting) *resulting = Money(current - cents);
+    return LedgerStatus::Ok;
+}
+
+LedgerStatus Ledger::credit(AccountId id, Money amount, Money* resulting) {
+    const Cell cell = find(id);
+    if (!cell.balance) return LedgerStatus::UnknownAccount;
+    const std::int64_t cents = amount.getCents();
+    const std::int64_t before =
+        std::atomic_ref<std::int64_t>(*cell.balance).fetch_add(cents, std::memory_order_acq_rel);
+    if (resulting) *resulting = Money(before + cents);
+    return LedgerStatus::Ok;
+}
+
+void Ledger::forEachAccount(const std::function<void(AccountId, std::string_view, Money)>& fn) const {
+    for (AccountId id = 1; id <= snapshotAccounts_; ++id) {
+        const Cell cell = find(id);
+        if (cell.balance) {
+            fn(id, cell.name,
+               Money(std::atomic_ref<std::int64_t>(*cell.balance).load(std::memory_order_acquire)));
+        }
+    }
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        for (const auto& [id, entry] : shards_[i].accounts) {
+            fn(id, entry.name,
+               Money(std::atomic_ref<std::int64_t>(entry.balanceCents).load(std::memory_order_acquire)));
+        }
+    }
+}
+
+AccountId Ledger::maxAccountId() const {
+    return nextId_.load(std::memory_order_relaxed) - 1;
+}
+
+std::size_t Ledger::size() const {
+    std::size_t total = 0;
+    for (AccountId id = 1; id <= snapshotAccounts_; ++id) {
+        if (snapshot_->findAccount(id)) ++total;
+    }
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        total += shards_[i].accounts.size();
+    }
+    return total;
+}
+
+}  // namespace atm
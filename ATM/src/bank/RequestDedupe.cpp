@@ -0,0 +1,80 @@
+// RequestDedupe.cpp - Request id generation, slot lookup and eviction, waiting on running repeats.
+
+#include "atm/bank/RequestDedupe.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <random>
+
+#include "atm/bank/Hashing.h"
+
+namespace atm {
+
+RequestId newRequestId() {
+    // mix64 is a bijection, so distinct counter values give distinct ids; the random start keeps
+    // ids of different processes (ATMs, restarts) apart.
+    static const std::uint64_t start = [] {
+        std::random_device random;
+        return (static_cast<std::uint64_t>(random()) << 32) ^ random();
+    }();
+    static std::atomic<std::uint64_t> counter{0};
+    RequestId id = kNoRequest;
+    while (id == kNoRequest) {
+        id = mix64(start + counter.fetch_add(1, std::memory_order_relaxed));
+    }
+    return id;
+}
+
+RequestDedupe::RequestDedupe(std::size_t capacity, std::size_t shardCount)
+    : shardCount_(shardCount == 0 ? 1 : shardCount),
+      shardSlots_(std::bit_ceil(std::max(capacity / shardCount_ + 1, kMaxProbe))),
+      shards_(std::make_unique<Shard[]>(shardCount_)) {
+    for (std::size_t i = 0; i < shardCount_; ++i) shards_[i].slots.resize(shardSlots_);
+}
+
+RequestDedupe::~RequestDedupe() = default;
+
+DedupeOutcome RequestDedupe::begin(RequestId id, std::uint64_t fingerprint, bool* result) {
+    const std::uint64_t hash = mix64(id);
+    Shard& shard = shardFor(hash);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    const std::size_t mask = shardSlots_ - 1;
+    Slot* victim = nullptr;
+    for (std::size_t p = 0; p < kMaxProbe; ++p) {
+        Slot& slot = shard.slots[(hash + p) & mask];
+        if (slot.id == id) {
+            if (slot.fingerprint != fingerprint) return DedupeOutcome::Mismatch;
+            // Running slots are never evicted, but once done this one may be before we wake.
+            shard.finished.wait(lock, [&] { return slot.done || slot.id != id; });
+            if (slot.id != id) return DedupeOutcome::TableFull;
+            if (result) *result = slot.result;
+            return DedupeOutcome::Repeat;
+        }
+        if (victim && victim->id == kNoRequest) continue;
+        if (slot.id == kNoRequest || (slot.done && (!victim || slot.stamp < victim->stamp))) victim = &slot;
+    }
+    if (!victim) return DedupeOutcome::TableFull;
+    *victim = Slot{id, fingerprint, ++shard.clock, false, false};
+    return DedupeOutcome::New;
+}
+
+void RequestDedupe::finish(RequestId id, bool result) {
+    const std::uint64_t hash = mix64(id);
+    Shard& shard = shardFor(hash);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const std::size_t mask = shardSlots_ - 1;
+        for (std::size_t p = 0; p < kMaxProbe; ++p) {
+            Slot& slot = shard.slots[(hash + p) & mask];
+            if (slot.id == id) {
+                slot.done = true;
+                slot.result = result;
+                break;
+            }
+        }
+    }
+    shard.finished.notify_all();
+}
+
+}  // namespace atm
@@ -0,0 +1,159 @@
+// RollingLimiter.cpp - Slot lookup, lazy bucket expiry, bucket folding and refunds.
+
+#include "atm/bank/RollingLimiter.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <limits>
+
+#include "atm/bank/Hashing.h"
+
+namespace atm {
+
+RollingLimiter::RollingLimiter(std::int64_t limitCents, std::size_t capacity, std::int64_t windowSeconds,
+                               std::size_t shardCount)
+    : limitCents_(std::clamp<std::int64_t>(limitCents, 0, std::numeric_limits<std::uint32_t>::max())),
+      bucketSeconds_(std::max<std::int64_t>(windowSeconds / static_cast<std::int64_t>(kWindowBuckets), 1)),
+      shardCount_(shardCount == 0 ? 1 : shardCount),
+      shardSlots_(std::bit_ceil(std::max(capacity / shardCount_ + 1, kMaxProbe))),
+      shards_(std::make_unique<Shard[]>(shardCount_)) {
+    for (std::size_t i = 0; i < shardCount_; ++i) shards_[i].slots.resize(shardSlots_);
+}
+
+RollingLimiter::~RollingLimiter() = default;
+
+std::int64_t RollingLimiter::nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+std::uint32_t RollingLimiter::bucketAt(std::int64_t seconds) const {
+    return static_cast<std::uint32_t>(std::max<std::int64_t>(seconds, 0) / bucketSeconds_);
+}
+
+bool RollingLimiter::live(const Slot& slot, std::size_t i, std::uint32_t now) const {
+    // A bucket from the future (clock stepped back) still counts.
+    const std::int64_t age = static_cast<std::int64_t>(now) - slot.bucket[i];
+    return slot.cents[i] != 0 && age <= static_cast<std::int64_t>(kWindowBuckets);
+}
+
+std::int64_t RollingLimiter::prune(Slot& slot, std::uint32_t now) const {
+    std::int64_t total = 0;
+    for (std::size_t i = 0; i < kSlotBuckets; ++i) {
+        if (live(slot, i, now)) {
+            total += slot.cents[i];
+        }
+        else {
+            slot.cents[i] = 0;
+        }
+    }
+    return total;
+}
+
+std::size_t RollingLimiter::find(const Shard& shard, std::uint64_t hash, std::uint64_t key) const {
+    const std::size_t mask = shardSlots_ - 1;
+    for (std::size_t p = 0; p < kMaxProbe; ++p) {
+        const std::size_t i = (hash + p) & mask;
+        if (shard.slots[i].key == key) return i;
+    }
+    return shardSlots_;
+}
+
+LimitVerdict RollingLimiter::tryAdd(std::uint64_t key, std::int64_t cents, std::int64_t nowSeconds) {
+    if (key == 0 || cents <= 0) return LimitVerdict::Allowed;
+    if (cents > limitCents_) return LimitVerdict::OverLimit;
+    const std::uint64_t hash = mix64(key);
+    const std::uint32_t now = bucketAt(nowSeconds);
+    Shard& shard = shardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // The key's own slot if it has one, else the first slot that is empty or fully expired.
+    const std::size_t index = find(shard, hash, key);
+    Slot* slot = index != shardSlots_ ? &shard.slots[index] : nullptr;
+    std::int64_t used = 0;
+    if (slot) {
+        used = prune(*slot, now);
+    }
+    else {
+        const std::size_t mask = shardSlots_ - 1;
+        for (std::size_t p = 0; p < kMaxProbe && !slot; ++p) {
+            Slot& candidate = shard.slots[(hash + p) & mask];
+            if (candidate.key == 0 || prune(candidate, now) == 0) slot = &candidate;
+        }
+        if (!slot) return LimitVerdict::TableFull;
+    }
+    if (used + cents > limitCents_) return LimitVerdict::OverLimit;
+
+    slot->key = key;
+    std::size_t target = kSlotBuckets;
+    std::size_t oldest = 0;
+    for (std::size_t i = 0; i < kSlotBuckets; ++i) {
+        if (slot->cents[i] != 0 && slot->bucket[i] == now) {
+            target = i;
+            break;
+        }
+        if (slot->cents[i] == 0) {
+            target = i;
+        }
+        else if (slot->cents[oldest] != 0 && slot->bucket[i] < slot->bucket[oldest]) {
+            oldest = i;
+        }
+    }
+    if (target != kSlotBuckets && slot->cents[target] != 0) {
+        slot->cents[target] += static_cast<std::uint32_t>(cents);
+        return LimitVerdict::Allowed;
+    }
+    if (target == kSlotBuckets) {
+        // Every bucket is live: fold the oldest into the next oldest, which expires later.
+        std::size_t next = kSlotBuckets;
+        for (std::size_t i = 0; i < kSlotBuckets; ++i) {
+            if (i != oldest && (next == kSlotBuckets || slot->bucket[i] < slot->bucket[next])) next = i;
+        }
+        slot->cents[next] += slot->cents[oldest];
+        target = oldest;
+    }
+    slot->bucket[target] = now;
+    slot->cents[target] = static_cast<std::uint32_t>(cents);
+    return LimitVerdict::Allowed;
+}
+
+void RollingLimiter::refund(std::uint64_t key, std::int64_t cents, std::int64_t whenSeconds) {
+    if (key == 0 || cents <= 0) return;
+    const std::uint64_t hash = mix64(key);
+    const std::uint32_t when = bucketAt(whenSeconds);
+    Shard& shard = shardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const std::size_t index = find(shard, hash, key);
+    if (index == shardSlots_) return;
+    Slot* slot = &shard.slots[index];
+    // The amount sits in its own bucket, or in a later one it was folded into.
+    while (cents > 0) {
+        std::size_t best = kSlotBuckets;
+        for (std::size_t i = 0; i < kSlotBuckets; ++i) {
+            if (slot->cents[i] == 0 || slot->bucket[i] < when) continue;
+            if (best == kSlotBuckets || slot->bucket[i] < slot->bucket[best]) best = i;
+        }
+        if (best == kSlotBuckets) return;
+        const std::uint32_t taken = static_cast<std::uint32_t>(std::min<std::int64_t>(cents, slot->cents[best]));
+        slot->cents[best] -= taken;
+        cents -= taken;
+    }
+}
+
+std::int64_t RollingLimiter::used(std::uint64_t key, std::int64_t nowSeconds) const {
+    if (key == 0) return 0;
+    const std::uint64_t hash = mix64(key);
+    const std::uint32_t now = bucketAt(nowSeconds);
+    const Shard& shard = shardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const std::size_t index = find(shard, hash, key);
+    if (index == shardSlots_) return 0;
+    std::int64_t total = 0;
+    for (std::size_t i = 0; i < kSlotBuckets; ++i) {
+        if (live(shard.slots[index], i, now)) total += shard.slots[index].cents[i];
+    }
+    return total;
+}
+
+}  // namespace atm
@@ -0,0 +1,346 @@
+// Snapshot.cpp - Snapshot writer and the mmap-backed reader that answers lookups in place.
+
+#include "atm/bank/Snapshot.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Checksum.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/Ledger.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace atm {
+
+namespace {
+
+struct Layout {
+    std::size_t cards = 0;
+    std::size_t accounts = 0;
+    std::size_t cardAccounts = 0;
+    std::size_t names = 0;
+    std::size_t total = 0;
+};
+
+/// Computes section offsets; false if the counts cannot fit in fileSize (also guards overflow).
+bool computeLayout(const SnapshotHeader& header, std::size_t fileSize, Layout& layout) {
+    std::size_t offset = sizeof(SnapshotHeader);
+    auto take = [&](std::uint64_t count, std::size_t elementSize, std::size_t& sectionOffset) {
+        sectionOffset = offset;
+        if (count > (fileSize - offset) / elementSize) return false;
+        offset += static_cast<std::size_t>(count) * elementSize;
+        return true;
+    };
+    if (fileSize < offset) return false;
+    if (!take(header.cardSlotCount, sizeof(SnapshotCard), layout.cards)) return false;
+    if (!take(header.accountCount, sizeof(SnapshotAccount), layout.accounts)) return false;
+    if (!take(header.cardAccountCount, sizeof(AccountId), layout.cardAccounts)) return false;
+    if (!take(header.nameBytes, 1, layout.names)) return false;
+    layout.total = offset;
+    return true;
+}
+
+std::uint32_t headerChecksum(SnapshotHeader header) {
+    header.headerChecksum = 0;
+    return crc32(&header, sizeof(header));
+}
+
+void setError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+/// Flushes a written file to disk; false if it cannot be opened or synced.
+bool syncFile(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    const bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ok;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+/// Makes a rename in the directory durable (no-op on Windows, where directories cannot be synced).
+bool syncDirectory(const std::filesystem::path& directory) {
+#if defined(_WIN32)
+    (void)directory;
+    return true;
+#else
+    const int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+}  // namespace
+
+std::string_view SnapshotCard::number() const {
+    return std::string_view(card, strnlen(card, kCardSize));
+}
+
+std::unique_ptr<SnapshotView> SnapshotView::open(const std::string& path, std::string* error) {
+    std::unique_ptr<SnapshotView> view(new SnapshotView());
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        setError(error, "cannot open " + path);
+        return nullptr;
+    }
+    view->fileHandle_ = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(SnapshotHeader))) {
+        setError(error, "snapshot too small");
+        return nullptr;
+    }
+    view->size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    view->mappingHandle_ = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!view->mappingHandle_) {
+        setError(error, "cannot map " + path);
+        return nullptr;
+    }
+    view->mapping_ = MapViewOfFile(view->mappingHandle_, FILE_MAP_COPY, 0, 0, 0);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        setError(error, "cannot open " + path);
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+        ::close(fd);
+        setError(error, "snapshot too small");
+        return nullptr;
+    }
+    view->size_ = static_cast<std::size_t>(st.st_size);
+    // Private + writable: balances are updated in place, copy-on-write, never written back.
+    void* mapping = ::mmap(nullptr, view->size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    view->mapping_ = mapping == MAP_FAILED ? nullptr : mapping;
+#endif
+    if (!view->mapping_) {
+        setError(error, "cannot map " + path);
+        return nullptr;
+    }
+
+    auto* base = static_cast<char*>(view->mapping_);
+    view->header_ = reinterpret_cast<const SnapshotHeader*>(base);
+    const SnapshotHeader& header = *view->header_;
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        setError(error, "not a snapshot file");
+        return nullptr;
+    }
+    if (header.version != kSnapshotVersion) {
+        setError(error, "unsupported snapshot version " + std::to_string(header.version));
+        return nullptr;
+    }
+    if (header.headerChecksum != headerChecksum(header)) {
+        setError(error, "snapshot header checksum mismatch");
+        return nullptr;
+    }
+    Layout layout;
+    if (!computeLayout(header, view->size_, layout) || layout.total != view->size_ ||
+        header.cardSlotCount == 0 || (header.cardSlotCount & (header.cardSlotCount - 1)) != 0) {
+        setError(error, "snapshot size does not match header");
+        return nullptr;
+    }
+    // A probe for a missing card stops at a free slot, so the table must keep at least one.
+    if (header.cardCount >= header.cardSlotCount) {
+        setError(error, "snapshot card table has no free slot");
+        return nullptr;
+    }
+    view->cards_ = reinterpret_cast<const SnapshotCard*>(base + layout.cards);
+    view->accounts_ = reinterpret_cast<SnapshotAccount*>(base + layout.accounts);
+    view->cardAccounts_ = reinterpret_cast<const AccountId*>(base + layout.cardAccounts);
+    view->names_ = base + layout.names;
+    return view;
+}
+
+SnapshotView::~SnapshotView() {
+#if defined(_WIN32)
+    if (mapping_) UnmapViewOfFile(mapping_);
+    if (mappingHandle_) CloseHandle(mappingHandle_);
+    if (fileHandle_) CloseHandle(fileHandle_);
+#else
+    if (mapping_) ::munmap(mapping_, size_);
+#endif
+}
+
+bool SnapshotView::verify() const {
+    const auto* base = static_cast<const char*>(mapping_);
+    return crc32(base + sizeof(SnapshotHeader), size_ - sizeof(SnapshotHeader)) ==
+           header_->payloadChecksum;
+}
+
+const SnapshotCard* SnapshotView::findCard(std::string_view card) const {
+    const std::uint64_t mask = header_->cardSlotCount - 1;
+    // Bounded even if a corrupt table (verify() is not run on open) has no free slot.
+    std::uint64_t i = fnv1a64(card) & mask;
+    for (std::uint64_t probes = 0; probes < header_->cardSlotCount; ++probes, i = (i + 1) & mask) {
+        const SnapshotCard& slot = cards_[i];
+        if (!(slot.flags & SnapshotCard::kUsed)) return nullptr;
+        if (slot.number() == card) return &slot;
+    }
+    return nullptr;
+}
+
+std::span<const AccountId> SnapshotView::accountsOf(const SnapshotCard& card) const {
+    if (static_cast<std::uint64_t>(card.accountBegin) + card.accountCount > header_->cardAccountCount) {
+        return {};
+    }
+    return std::span<const AccountId>(cardAccounts_ + card.accountBegin, card.accountCount);
+}
+
+SnapshotAccount* SnapshotView::findAccount(AccountId id) {
+    if (id == kInvalidAccountId || id > header_->accountCount) return nullptr;
+    SnapshotAccount& record = accounts_[id - 1];
+    return record.id == id ? &record : nullptr;
+}
+
+const SnapshotAccount* SnapshotView::findAccount(AccountId id) const {
+    return const_cast<SnapshotView*>(this)->findAccount(id);
+}
+
+std::string_view SnapshotView::accountName(const SnapshotAccount& account) const {
+    if (static_cast<std::uint64_t>(account.nameOffset) + account.nameLength > header_->nameBytes) {
+        return {};
+    }
+    return std::string_view(names_ + account.nameOffset, account.nameLength);
+}
+
+std::span<const SnapshotCard> SnapshotView::cardSlots() const {
+    return std::span<const SnapshotCard>(cards_, header_->cardSlotCount);
+}
+
+bool SnapshotWriter::write(const std::string& path, const AuthService& auth, const Ledger& ledger,
+                           std::uint64_t journalSequence, std::string* error) {
+    // Accounts: dense by ID so the reader can index instead of search.
+    std::vector<SnapshotAccount> accounts(ledger.maxAccountId(), SnapshotAccount{});
+    std::string names;
+    bool ok = true;
+    ledger.forEachAccount([&](AccountId id, std::string_view name, Money balance) {
+        if (names.size() + name.size() > std::numeric_limits<std::uint32_t>::max()) {
+            ok = false;
+            return;
+        }
+        SnapshotAccount& record = accounts[id - 1];
+        record.id = id;
+        record.balanceCents = balance.getCents();
+        record.nameOffset = static_cast<std::uint32_t>(names.size());
+        record.nameLength = static_cast<std::uint32_t>(name.size());
+        names.append(name);
+    });
+    if (!ok) {
+        setError(error, "account names exceed 4 GiB");
+        return false;
+    }
+
+    std::vector<SnapshotCard> cards;
+    std::vector<AccountId> cardAccounts;
+    auth.forEachCard([&](const CardRecordView& view) {
+        if (view.card.size() > SnapshotCard::kCardSize ||
+            view.accounts.size() > std::numeric_limits<std::uint16_t>::max() ||
+            cardAccounts.size() + view.accounts.size() > std::numeric_limits<std::uint32_t>::max()) {
+            ok = false;
+            return;
+        }
+        SnapshotCard slot{};
+        std::memcpy(slot.card, view.card.data(), view.card.size());
+        slot.pinDigest = view.pinDigest;
+        slot.accountBegin = static_cast<std::uint32_t>(cardAccounts.size());
+        slot.accountCount = static_cast<std::uint16_t>(view.accounts.size());
+        slot.flags = SnapshotCard::kUsed;
+        if (view.hasPin) slot.flags |= SnapshotCard::kHasPin;
+        if (view.blocked) slot.flags |= SnapshotCard::kBlocked;
+        cards.push_back(slot);
+        cardAccounts.insert(cardAccounts.end(), view.accounts.begin(), view.accounts.end());
+    });
+    if (!ok) {
+        setError(error, "card number longer than 24 characters or too many accounts");
+        return false;
+    }
+
+    // Load factor <= 0.5 keeps linear-probing chains short.
+    std::uint64_t slotCount = 16;
+    while (slotCount < cards.size() * 2) slotCount <<= 1;
+    std::vector<SnapshotCard> table(slotCount, SnapshotCard{});
+    for (const SnapshotCard& card : cards) {
+        std::uint64_t i = fnv1a64(card.number()) & (slotCount - 1);
+        while (table[i].flags & SnapshotCard::kUsed) i = (i + 1) & (slotCount - 1);
+        table[i] = card;
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.cardSlotCount = slotCount;
+    header.cardCount = cards.size();
+    header.accountCount = accounts.size();
+    header.cardAccountCount = cardAccounts.size();
+    header.nameBytes = names.size();
+    header.journalSequence = journalSequence;
+    std::uint32_t crc = crc32(table.data(), table.size() * sizeof(SnapshotCard));
+    crc = crc32(accounts.data(), accounts.size() * sizeof(SnapshotAccount), crc);
+    crc = crc32(cardAccounts.data(), cardAccounts.size() * sizeof(AccountId), crc);
+    crc = crc32(names.data(), names.size(), crc);
+    header.payloadChecksum = crc;
+    header.headerChecksum = headerChecksum(header);
+
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()),
+                  static_cast<std::streamsize>(table.size() * sizeof(SnapshotCard)));
+        out.write(reinterpret_cast<const char*>(accounts.data()),
+                  static_cast<std::streamsize>(accounts.size() * sizeof(SnapshotAccount)));
+        out.write(reinterpret_cast<const char*>(cardAccounts.data()),
+                  static_cast<std::streamsize>(cardAccounts.size() * sizeof(AccountId)));
+        out.write(names.data(), static_cast<std::streamsize>(names.size()));
+        if (!out.flush()) {
+            setError(error, "cannot write " + tempPath);
+            return false;
+        }
+    }
+    // The data must be on disk before the rename is, or a crash could leave a renamed but torn
+    // snapshot whose journalSequence makes recovery skip records.
+    if (!syncFile(tempPath)) {
+        setError(error, "cannot sync " + tempPath);
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        setError(error, "cannot rename " + tempPath + ": " + ec.message());
+        return false;
+    }
+    if (!syncDirectory(std::filesystem::path(path).parent_path())) {
+        setError(error, "cannot sync the directory of " + path);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace atm
@@ -0,0 +1,100 @@
+// TransactionHistory.cpp - Columnar chunk appends, per-account row index, last-N and time-range queries.
+
+#include "atm/bank/TransactionHistory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+namespace atm {
+
+TransactionHistory::TransactionHistory(std::size_t shardCount)
+    : shardCount_(shardCount == 0 ? 1 : shardCount),
+      shards_(std::make_unique<Shard[]>(shardCount_)) {}
+
+TransactionHistory::~TransactionHistory() = default;
+
+std::int64_t TransactionHistory::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+HistoryEntry TransactionHistory::Shard::entryAt(std::uint64_t row) const {
+    const Chunk& chunk = *chunks[row / kChunkRows];
+    const std::size_t i = row % kChunkRows;
+    HistoryEntry entry;
+    entry.timeUs = chunk.timeUs[i];
+    entry.type = chunk.type[i];
+    entry.amount = Money(chunk.amountCents[i]);
+    entry.balance = Money(chunk.balanceCents[i]);
+    entry.terminal = chunk.terminal[i];
+    return entry;
+}
+
+void TransactionHistory::append(AccountId account, const HistoryEntry& entry) {
+    Shard& shard = shardFor(account);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    std::vector<std::uint64_t>& rows = shard.index[account];
+    const std::uint64_t row = shard.rows;
+    if (row % kChunkRows == 0) {
+        shard.chunks.push_back(std::unique_ptr<Chunk>(new Chunk));  // columns filled as rows arrive
+    }
+    Chunk& chunk = *shard.chunks.back();
+    const std::size_t i = row % kChunkRows;
+    // Callers read the clock before taking the lock; keep the account's rows sorted anyway.
+    chunk.timeUs[i] = rows.empty() ? entry.timeUs : std::max(entry.timeUs, shard.timeAt(rows.back()));
+    chunk.type[i] = entry.type;
+    chunk.amountCents[i] = entry.amount.getCents();
+    chunk.balanceCents[i] = entry.balance.getCents();
+    chunk.terminal[i] = entry.terminal;
+    rows.push_back(row);
+    ++shard.rows;
+}
+
+std::vector<HistoryEntry> TransactionHistory::last(AccountId account, std::size_t count) const {
+    const Shard& shard = shardFor(account);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    std::vector<HistoryEntry> entries;
+    auto it = shard.index.find(account);
+    if (it == shard.index.end()) return entries;
+    const std::vector<std::uint64_t>& rows = it->second;
+    const std::size_t n = std::min(count, rows.size());
+    entries.reserve(n);
+    for (std::size_t k = 0; k < n; ++k) entries.push_back(shard.entryAt(rows[rows.size() - 1 - k]));
+    return entries;
+}
+
+std::vector<HistoryEntry> TransactionHistory::range(AccountId account, std::int64_t fromUs, std::int64_t toUs,
+                                                    std::size_t limit) const {
+    const Shard& shard = shardFor(account);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    std::vector<HistoryEntry> entries;
+    auto it = shard.index.find(account);
+    if (it == shard.index.end() || fromUs >= toUs) return entries;
+    const std::vector<std::uint64_t>& rows = it->second;
+    auto first = std::partition_point(rows.begin(), rows.end(),
+                                      [&](std::uint64_t row) { return shard.timeAt(row) < fromUs; });
+    for (; first != rows.end() && entries.size() < limit && shard.timeAt(*first) < toUs; ++first) {
+        entries.push_back(shard.entryAt(*first));
+    }
+    return entries;
+}
+
+std::size_t TransactionHistory::count(AccountId account) const {
+    const Shard& shard = shardFor(account);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.index.find(account);
+    return it == shard.index.end() ? 0 : it->second.size();
+}
+
+std::size_t TransactionHistory::size() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        total += static_cast<std::size_t>(shards_[i].rows);
+    }
+    return total;
+}
+
+}  // namespace atm
@@ -0,0 +1,336 @@
+// TransactionJournal.cpp - Group-commit journal: one write + fdatasync per batch of records.
+
+#include "atm/bank/TransactionJournal.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Checksum.h"
+#include "atm/bank/Ledger.h"
+#include "atm/machine/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace atm {
+
+namespace {
+
+int openForAppend(const std::string& path) {
+#if defined(_WIN32)
+    int fd = -1;
+    _sopen_s(&fd, path.c_str(), _O_RDWR | _O_CREAT | _O_APPEND | _O_BINARY, _SH_DENYNO,
+             _S_IREAD | _S_IWRITE);
+    return fd;
+#else
+    return ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+}
+
+void closeFile(int fd) {
+#if defined(_WIN32)
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+bool truncateFile(int fd, std::uint64_t size) {
+#if defined(_WIN32)
+    return _chsize_s(fd, static_cast<__int64>(size)) == 0;
+#else
+    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+#if defined(_WIN32)
+        const int chunk = static_cast<int>(std::min<std::size_t>(size, 1u << 30));
+        const int written = _write(fd, data, static_cast<unsigned>(chunk));
+#else
+        const ssize_t written = ::write(fd, data, size);
+#endif
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool syncData(int fd) {
+#if defined(_WIN32)
+    return _commit(fd) == 0;
+#elif defined(__APPLE__)
+    return ::fsync(fd) == 0;
+#else
+    return ::fdatasync(fd) == 0;
+#endif
+}
+
+constexpr std::size_t kChecksummedBytes = offsetof(JournalRecord, checksum);
+
+std::uint32_t recordChecksum(const JournalRecord& record) {
+    return crc32(&record, kChecksummedBytes);
+}
+
+std::int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+std::string JournalRecord::cardNumber() const {
+    return std::string(card, strnlen(card, kCardSize));
+}
+
+RequestId JournalRecord::holdId() const {
+    if (type != JournalRecordType::HoldReserve && type != JournalRecordType::HoldCommit &&
+        type != JournalRecordType::HoldRelease) {
+        return kNoRequest;
+    }
+    RequestId id = kNoRequest;
+    std::memcpy(&id, card, sizeof(id));
+    return id;
+}
+
+TransactionJournal::TransactionJournal(const std::string& path, JournalConfig config)
+    : config_(config) {
+    std::uint64_t lastSequence = 0;
+    const std::size_t validRecords =
+        replay(path, [&](const JournalRecord& record) { lastSequence = record.sequence; });
+    fd_ = openForAppend(path);
+    if (fd_ < 0 || !truncateFile(fd_, validRecords * sizeof(JournalRecord))) {
+        Logger::log("Journal unavailable", path);
+        failed_ = true;
+        return;
+    }
+    nextSequence_ = lastSequence + 1;
+    durableSequence_ = lastSequence;
+    pending_.reserve(config_.maxBatchRecords);
+    writing_.reserve(config_.maxBatchRecords);
+    flusher_ = std::thread([this] { flusherLoop(); });
+}
+
+TransactionJournal::~TransactionJournal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    flusherCv_.notify_all();
+    if (flusher_.joinable()) flusher_.join();
+    if (fd_ >= 0) closeFile(fd_);
+}
+
+bool TransactionJournal::isHealthy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !failed_;
+}
+
+std::uint64_t TransactionJournal::appendWithdraw(AccountId account, Money amount) {
+    JournalRecord record;
+    record.type = JournalRecordType::Withdraw;
+    record.accountId = account;
+    record.amountCents = amount.getCents();
+    return append(record, config_.durability);
+}
+
+std::uint64_t TransactionJournal::appendDeposit(AccountId account, Money amount) {
+    JournalRecord record;
+    record.type = JournalRecordType::Deposit;
+    record.accountId = account;
+    record.amountCents = amount.getCents();
+    return append(record, config_.durability);
+}
+
+std::uint64_t TransactionJournal::appendCardBlock(const std::string& card) {
+    if (card.size() > JournalRecord::kCardSize) {
+        return 0;
+    }
+    JournalRecord record;
+    record.type = JournalRecordType::CardBlock;
+    std::memcpy(record.card, card.data(), card.size());
+    return append(record, config_.durability);
+}
+
+std::uint64_t TransactionJournal::appendHold(JournalRecordType type, RequestId hold, AccountId account,
+                                             Money amount) {
+    JournalRecord record;
+    record.type = type;
+    record.accountId = account;
+    record.amountCents = amount.getCents();
+    std::memcpy(record.card, &hold, sizeof(hold));
+    return append(record, config_.durability);
+}
+
+std::uint64_t TransactionJournal::append(JournalRecord record, Durability durability) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (failed_) return 0;
+    const std::uint64_t sequence = nextSequence_++;
+    record.sequence = sequence;
+    record.timestampUs = nowMicros();
+    record.checksum = recordChecksum(record);
+    pending_.push_back(record);
+
+    switch (durability) {
+        case Durability::Sync:
+            flushUpTo(sequence, lock);
+            break;
+        case Durability::Group:
+            if (pending_.size() == 1 || pending_.size() >= config_.maxBatchRecords) {
+                flusherCv_.notify_one();
+            }
+            waitDurable(sequence, lock);
+            break;
+        case Durability::Async:
+            if (pending_.size() == 1 || pending_.size() >= config_.maxBatchRecords) {
+                flusherCv_.notify_one();
+            }
+            return sequence;
+    }
+    return durableSequence_ >= sequence ? sequence : 0;
+}
+
+bool TransactionJournal::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushUpTo(nextSequence_ - 1, lock);
+    return !failed_;
+}
+
+std::uint64_t TransactionJournal::durableSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return durableSequence_;
+}
+
+void TransactionJournal::flushUpTo(std::uint64_t target, std::unique_lock<std::mutex>& lock) {
+    while (durableSequence_ < target && !failed_) {
+        if (flushing_) {
+            // Another thread is the leader; its batch or the next one will cover us.
+            durableCv_.wait(lock);
+            continue;
+        }
+        if (pending_.empty()) break;
+        writing_.swap(pending_);
+        flushing_ = true;
+        lock.unlock();
+        const bool ok = writeAndSync(writing_);
+        lock.lock();
+        flushing_ = false;
+        if (ok) {
+            durableSequence_ = writing_.back().sequence;
+        }
+        else {
+            failed_ = true;
+            Logger::log("Journal write failed", writing_.size());
+        }
+        writing_.clear();
+        durableCv_.notify_all();
+    }
+}
+
+void TransactionJournal::waitDurable(std::uint64_t sequence, std::unique_lock<std::mutex>& lock) {
+    durableCv_.wait(lock, [&] { return durableSequence_ >= sequence || failed_; });
+}
+
+void TransactionJournal::flusherLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        flusherCv_.wait(lock, [&] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            if (stopping_) return;
+            continue;
+        }
+        if (!stopping_) {
+            // Let the batch fill for up to one window so one fdatasync covers many records.
+            flusherCv_.wait_for(lock, config_.groupCommitWindow, [&] {
+                return stopping_ || pending_.size() >= config_.maxBatchRecords;
+            });
+        }
+        flushUpTo(nextSequence_ - 1, lock);
+        if (failed_) {
+            pending_.clear();
+            if (stopping_) return;
+        }
+    }
+}
+
+bool TransactionJournal::writeAndSync(const std::vector<JournalRecord>& batch) {
+    const auto* bytes = reinterpret_cast<const char*>(batch.data());
+    return writeAll(fd_, bytes, batch.size() * sizeof(JournalRecord)) && syncData(fd_);
+}
+
+std::size_t TransactionJournal::replay(const std::string& path,
+                                       const std::function<void(const JournalRecord&)>& apply) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+    std::size_t count = 0;
+    std::uint64_t expectedSequence = 0;
+    JournalRecord record;
+    while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        if (record.checksum != recordChecksum(record)) break;
+        if (expectedSequence != 0 && record.sequence != expectedSequence) break;
+        expectedSequence = record.sequence + 1;
+        apply(record);
+        ++count;
+    }
+    return count;
+}
+
+std::size_t TransactionJournal::recover(const std::string& path, Ledger& ledger, AuthService& auth,
+                                       std::uint64_t afterSequence, std::vector<JournalRecord>* openHolds) {
+    std::size_t applied = 0;
+    // Keyed by hold id; a hold reserved before the snapshot can still be open after it.
+    std::unordered_map<RequestId, JournalRecord> holds;
+    replay(path, [&](const JournalRecord& record) {
+        switch (record.type) {
+            case JournalRecordType::HoldReserve:
+                holds.emplace(record.holdId(), record);
+                break;
+            case JournalRecordType::HoldCommit:
+            case JournalRecordType::HoldRelease:
+                holds.erase(record.holdId());
+                break;
+            default:
+                break;
+        }
+        if (record.sequence <= afterSequence) return;
+        ++applied;
+        switch (record.type) {
+            case JournalRecordType::Withdraw:
+            case JournalRecordType::HoldReserve:
+                // Applied unconditionally: journal order can differ from the order concurrent
+                // CAS updates hit the ledger, but the sum of deltas per account is the same.
+                ledger.credit(record.accountId, Money(-record.amountCents));
+                break;
+            case JournalRecordType::Deposit:
+            case JournalRecordType::HoldRelease:
+                ledger.credit(record.accountId, Money(record.amountCents));
+                break;
+            case JournalRecordType::HoldCommit:
+                break;
+            case JournalRecordType::CardBlock:
+                auth.blockCard(record.cardNumber());
+                break;
+        }
+    });
+    if (openHolds) {
+        openHolds->clear();
+        for (const auto& [id, record] : holds) openHolds->push_back(record);
+        std::sort(openHolds->begin(), openHolds->end(),
+                  [](const JournalRecord& a, const JournalRecord& b) { return a.sequence < b.sequence; });
+    }
+    return applied;
+}
+
+}  // namespace atm
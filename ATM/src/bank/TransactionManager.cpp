@@ -1,54 +1,276 @@
-// TransactionManager.cpp - Balance, withdraw, deposit; rejections logged to stderr.
+// TransactionManager.cpp - Balance, withdraw (direct or through holds), deposit on the shared ledger (journaled and recorded in the history if attached, withdrawals checked against daily limits); rejections logged as structured events and counted in AtmMetrics.
 #include "atm/bank/TransactionManager.h"
+#include "atm/bank/RollingLimiter.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionJournal.h"
 #include "atm/machine/AtmConstants.h"
 #include "atm/machine/Logger.h"
+#include "atm/machine/Metrics.h"
 #include <cstdint>
 
 namespace atm {
 
-TransactionManager::TransactionManager()
-    : minWithdrawCents_(constants::kMinWithdrawCents),
-      maxWithdrawPerTransactionCents_(constants::kMaxWithdrawPerTransactionCents) {}
+namespace {
 
-TransactionManager::TransactionManager(const AtmConfig& config)
-    : minWithdrawCents_(config.minWithdrawCents),
-      maxWithdrawPerTransactionCents_(config.maxWithdrawPerTransactionCents) {}
+// Logs the rejection event, counts it under atm_rejections_total{reason=...}; always false.
+template <LogEventId Id, typename... Args>
+bool reject(const Args&... args) {
+    Logger::event<Id>(args...);
+    atmMetrics().rejected(Id).inc();
+    return false;
+}
+
+}  // namespace
+
+TransactionManager::TransactionManager(Ledger& ledger)
+    : ledger_(ledger),
+      minWithdrawCents_(constants::kMinWithdrawCents),
+      maxWithdrawPerTransactionCents_(constants::kMaxWithdrawPerTransactionCents),
+      holds_(std::chrono::milliseconds(constants::kDefaultWithdrawHoldTtlMs)) {}
+
+TransactionManager::TransactionManager(Ledger& ledger, const AtmConfig& config)
+    : ledger_(ledger),
+      minWithdrawCents_(config.minWithdrawCents),
+      maxWithdrawPerTransactionCents_(config.maxWithdrawPerTransactionCents),
+      holds_(std::chrono::milliseconds(config.withdrawHoldTtlMs)) {}
 
-Money TransactionManager::showBalance(const Account* account) const {
-    return account->getAmount();
+Money TransactionManager::showBalance(AccountId account) const {
+    return ledger_.getBalance(account).value_or(Money());
+}
+
+bool TransactionManager::withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card) {
+    const std::int64_t now = cardLimiter_ || terminalLimiter_ ? RollingLimiter::nowSeconds() : 0;
+    Money balance;
+    if (!debitWithdrawal(account, amount, terminal, card, now, kNoRequest, &balance)) {
+        return false;
+    }
+    record(account, HistoryType::Withdraw, amount, balance, terminal);
+    atmMetrics().withdrawals.inc();
+    atmMetrics().withdrawnCents.inc(static_cast<std::uint64_t>(amount.getCents()));
+    return true;
 }
 
-bool TransactionManager::withdrawCash(Account* account, Money amount) {
-    if (!account) return false;
+bool TransactionManager::debitWithdrawal(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                         std::int64_t now, RequestId hold, Money* balance) {
     const std::int64_t cents = amount.getCents();
     if (cents <= 0) {
-        Logger::log("Withdraw rejected", "amount must be positive");
-        return false;
+        return reject<LogEventId::WithdrawNotPositive>(account, cents);
     }
     if (cents < minWithdrawCents_) {
-        Logger::log("Withdraw rejected", "amount below minimum");
-        return false;
+        return reject<LogEventId::WithdrawBelowMinimum>(account, cents);
     }
     if (cents > maxWithdrawPerTransactionCents_) {
-        Logger::log("Withdraw rejected", "amount exceeds per-transaction limit");
+        return reject<LogEventId::WithdrawOverLimit>(account, cents);
+    }
+    if (!chargeLimits(account, cents, terminal, card, now)) {
         return false;
     }
-    if (account->getAmount() < amount) {
-        Logger::log("Withdraw failed", "insufficient account funds");
+    const LedgerStatus status = ledger_.debit(account, amount, balance);
+    if (status != LedgerStatus::Ok) {
+        refundLimits(cents, terminal, card, now);
+    }
+    switch (status) {
+        case LedgerStatus::Ok:
+            if (journal_ && (hold == kNoRequest ? journal_->appendWithdraw(account, amount)
+                                                : journal_->appendHold(JournalRecordType::HoldReserve, hold,
+                                                                       account, amount)) == 0) {
+                // Not durable, so not acknowledged: put the money back.
+                ledger_.credit(account, amount);
+                refundLimits(cents, terminal, card, now);
+                return reject<LogEventId::WithdrawJournalFailed>(account, cents);
+            }
+            return true;
+        case LedgerStatus::UnknownAccount:
+            return reject<LogEventId::WithdrawUnknownAccount>(account, cents);
+        case LedgerStatus::InsufficientFunds:
+            return reject<LogEventId::WithdrawInsufficientFunds>(account, cents);
+    }
+    return false;
+}
+
+bool TransactionManager::reserveWithdrawal(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                           RequestId hold) {
+    const std::int64_t now = cardLimiter_ || terminalLimiter_ ? RollingLimiter::nowSeconds() : 0;
+    // The hold goes in first, so a second reserve with the same id cannot debit twice. It stays
+    // Pending until the debit is journaled: a release or the sweeper must not credit funds that
+    // were never taken, nor journal a HoldRelease ahead of the HoldReserve.
+    if (hold == kNoRequest || !holds_.add(hold, WithdrawHold{account, amount, terminal, card, now})) {
+        return reject<LogEventId::WithdrawHoldRefused>(hold);
+    }
+    Money balance;
+    if (!debitWithdrawal(account, amount, terminal, card, now, hold, &balance)) {
+        holds_.erase(hold);
         return false;
     }
-    account->setAmount(account->getAmount() - amount);
+    holds_.setBalance(hold, balance);
+    return true;
+}
+
+bool TransactionManager::commitWithdrawal(RequestId hold) {
+    WithdrawHold held;
+    switch (holds_.state(hold, &held)) {
+        case HoldState::Held:
+            break;
+        case HoldState::Committed:
+            return true;
+        default:
+            return reject<LogEventId::WithdrawCommitRefused>(hold);
+    }
+    // Journaled before the hold moves: recovery releases every hold the journal does not show
+    // as finished, so an unjournaled commit must not count as one. The sweeper releases it.
+    if (journal_ && journal_->appendHold(JournalRecordType::HoldCommit, hold, held.account, held.amount) == 0) {
+        return reject<LogEventId::WithdrawJournalFailed>(held.account, held.amount.getCents());
+    }
+    switch (holds_.finish(hold, HoldState::Committed, &held)) {
+        case HoldState::Held:
+            break;
+        case HoldState::Committed:
+            return true;
+        default:
+            return reject<LogEventId::WithdrawCommitRefused>(hold);
+    }
+    // The balance the debit left, not today's: other activity on the account may have moved it since.
+    record(held.account, HistoryType::Withdraw, held.amount, held.balance, held.terminal);
+    atmMetrics().withdrawals.inc();
+    atmMetrics().withdrawnCents.inc(static_cast<std::uint64_t>(held.amount.getCents()));
     return true;
 }
 
-bool TransactionManager::depositCash(Account* account, Money amount) {
-    if (!account) return false;
+bool TransactionManager::releaseWithdrawal(RequestId hold) {
+    WithdrawHold held;
+    switch (holds_.finish(hold, HoldState::Released, &held)) {
+        case HoldState::Held:
+            returnHold(hold, held);
+            return true;
+        case HoldState::Released:
+        case HoldState::Expired:
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::size_t TransactionManager::releaseExpiredHolds() {
+    const std::vector<std::pair<RequestId, WithdrawHold>> expired = holds_.takeExpired(WithdrawHolds::Clock::now());
+    for (const auto& [id, hold] : expired) {
+        returnHold(id, hold);
+        // Routine, not a refused request: counted apart from atm_rejections_total.
+        Logger::event<LogEventId::WithdrawHoldExpired>(hold.account, hold.amount);
+        atmMetrics().holdsExpired.inc();
+    }
+    return expired.size();
+}
+
+std::size_t TransactionManager::releaseRecoveredHolds(const std::vector<JournalRecord>& openHolds) {
+    for (const JournalRecord& record : openHolds) {
+        // The limiters start empty after a restart, so there is nothing to refund.
+        returnHold(record.holdId(), WithdrawHold{record.accountId, Money(record.amountCents)});
+        Logger::event<LogEventId::WithdrawHoldExpired>(record.accountId, Money(record.amountCents));
+        atmMetrics().holdsExpired.inc();
+    }
+    return openHolds.size();
+}
+
+void TransactionManager::returnHold(RequestId id, const WithdrawHold& hold) {
+    ledger_.credit(hold.account, hold.amount);
+    refundLimits(hold.amount.getCents(), hold.terminal, hold.card, hold.limitSeconds);
+    // The debit was journaled at reserve time, so the reversal is too. If that fails the balance
+    // here is still right, and the next recovery finds the hold open and releases it again.
+    if (journal_ && journal_->appendHold(JournalRecordType::HoldRelease, id, hold.account, hold.amount) == 0) {
+        reject<LogEventId::WithdrawReleaseJournalFailed>(id, hold.account, hold.amount);
+    }
+}
+
+bool TransactionManager::depositCash(AccountId account, Money amount, TerminalId terminal) {
     if (amount.getCents() < 0) {
-        Logger::log("Deposit rejected", "negative amount");
-        return false;
+        return reject<LogEventId::DepositNegative>(account, amount);
+    }
+    Money balance;
+    if (ledger_.credit(account, amount, &balance) != LedgerStatus::Ok) {
+        return reject<LogEventId::DepositUnknownAccount>(account, amount);
+    }
+    if (journal_ && journal_->appendDeposit(account, amount) == 0) {
+        // Same checked debit as a withdrawal: if the credited funds were spent meanwhile, the
+        // balance must not go below zero, so the unjournaled credit stays and is flagged.
+        if (ledger_.debit(account, amount) != LedgerStatus::Ok) {
+            reject<LogEventId::DepositRollbackFailed>(account, amount);
+        }
+        return reject<LogEventId::DepositJournalFailed>(account, amount);
+    }
+    record(account, HistoryType::Deposit, amount, balance, terminal);
+    atmMetrics().deposits.inc();
+    atmMetrics().depositedCents.inc(static_cast<std::uint64_t>(amount.getCents()));
+    return true;
+}
+
+void TransactionManager::setJournal(TransactionJournal* journal) {
+    journal_ = journal;
+}
+
+TransactionJournal* TransactionManager::getJournal() const {
+    return journal_;
+}
+
+std::vector<HistoryEntry> TransactionManager::miniStatement(AccountId account, std::size_t count) const {
+    return history_ ? history_->last(account, count) : std::vector<HistoryEntry>{};
+}
+
+void TransactionManager::setHistory(TransactionHistory* history) {
+    history_ = history;
+}
+
+TransactionHistory* TransactionManager::getHistory() const {
+    return history_;
+}
+
+void TransactionManager::setWithdrawalLimits(RollingLimiter* perCard, RollingLimiter* perTerminal) {
+    cardLimiter_ = perCard;
+    terminalLimiter_ = perTerminal;
+}
+
+RollingLimiter* TransactionManager::getCardLimiter() const {
+    return cardLimiter_;
+}
+
+RollingLimiter* TransactionManager::getTerminalLimiter() const {
+    return terminalLimiter_;
+}
+
+bool TransactionManager::chargeLimits(AccountId account, std::int64_t cents, TerminalId terminal, CardHash card,
+                                      std::int64_t now) {
+    if (cardLimiter_) {
+        switch (cardLimiter_->tryAdd(card, cents, now)) {
+            case LimitVerdict::Allowed:
+                break;
+            case LimitVerdict::OverLimit:
+                return reject<LogEventId::WithdrawOverCardDailyLimit>(account, cents);
+            case LimitVerdict::TableFull:
+                return reject<LogEventId::WithdrawLimitTableFull>(account, cents);
+        }
+    }
+    if (terminalLimiter_) {
+        const LimitVerdict verdict = terminalLimiter_->tryAdd(terminal, cents, now);
+        if (verdict != LimitVerdict::Allowed) {
+            if (cardLimiter_) cardLimiter_->refund(card, cents, now);
+            if (verdict == LimitVerdict::OverLimit) {
+                return reject<LogEventId::WithdrawOverTerminalDailyLimit>(terminal, account, cents);
+            }
+            return reject<LogEventId::WithdrawLimitTableFull>(account, cents);
+        }
     }
-    account->setAmount(account->getAmount() + amount);
     return true;
 }
 
+void TransactionManager::refundLimits(std::int64_t cents, TerminalId terminal, CardHash card, std::int64_t now) {
+    if (cardLimiter_) cardLimiter_->refund(card, cents, now);
+    if (terminalLimiter_) terminalLimiter_->refund(terminal, cents, now);
+}
+
+void TransactionManager::record(AccountId account, HistoryType type, Money amount, Money balance,
+                                TerminalId terminal) {
+    if (history_) {
+        history_->append(account, HistoryEntry{TransactionHistory::nowUs(), type, amount, balance, terminal});
+    }
+}
+
 }  // namespace atm
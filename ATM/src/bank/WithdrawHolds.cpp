@@ -0,0 +1,120 @@
+// WithdrawHolds.cpp - Hold table transitions, expiry scan and the sweeper thread.
+
+#include "atm/bank/WithdrawHolds.h"
+#include "atm/bank/TransactionManager.h"
+
+namespace atm {
+
+WithdrawHolds::WithdrawHolds(std::chrono::milliseconds ttl)
+    : ttl_(ttl), shards_(std::make_unique<Shard[]>(kShardCount)) {}
+
+WithdrawHolds::~WithdrawHolds() = default;
+
+bool WithdrawHolds::add(RequestId id, WithdrawHold hold) {
+    hold.state = HoldState::Pending;
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.holds.emplace(id, hold).second;
+}
+
+void WithdrawHolds::setBalance(RequestId id, Money balance) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.holds.find(id);
+    if (it == shard.holds.end() || it->second.state != HoldState::Pending) return;
+    it->second.balance = balance;
+    it->second.state = HoldState::Held;
+    it->second.deadline = Clock::now() + ttl_;
+    held_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WithdrawHolds::erase(RequestId id) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.holds.find(id);
+    if (it == shard.holds.end()) return;
+    if (it->second.state == HoldState::Held) held_.fetch_sub(1, std::memory_order_relaxed);
+    shard.holds.erase(it);
+}
+
+HoldState WithdrawHolds::finish(RequestId id, HoldState to, WithdrawHold* hold) {
+    Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.holds.find(id);
+    if (it == shard.holds.end()) {
+        return HoldState::None;
+    }
+    const HoldState before = it->second.state;
+    if (before == HoldState::Held) {
+        it->second.state = to;
+        it->second.deadline = Clock::now() + ttl_;
+        held_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (hold) *hold = it->second;
+    return before;
+}
+
+std::vector<std::pair<RequestId, WithdrawHold>> WithdrawHolds::takeExpired(Clock::time_point now) {
+    std::vector<std::pair<RequestId, WithdrawHold>> expired;
+    for (std::size_t s = 0; s < kShardCount; ++s) {
+        Shard& shard = shards_[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.holds.begin(); it != shard.holds.end();) {
+            WithdrawHold& hold = it->second;
+            if (hold.state == HoldState::Pending || hold.deadline > now) {
+                ++it;
+                continue;
+            }
+            if (hold.state != HoldState::Held) {
+                it = shard.holds.erase(it);
+                continue;
+            }
+            // Kept as Expired for one more ttl, like any finished hold.
+            hold.state = HoldState::Expired;
+            hold.deadline = now + ttl_;
+            held_.fetch_sub(1, std::memory_order_relaxed);
+            expired.emplace_back(it->first, hold);
+            ++it;
+        }
+    }
+    return expired;
+}
+
+HoldState WithdrawHolds::state(RequestId id, WithdrawHold* hold) const {
+    const Shard& shard = shardFor(id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.holds.find(id);
+    if (it == shard.holds.end()) {
+        return HoldState::None;
+    }
+    if (hold) *hold = it->second;
+    return it->second.state;
+}
+
+HoldSweeper::HoldSweeper(TransactionManager& transactions, std::chrono::milliseconds interval)
+    : transactions_(transactions), interval_(interval) {
+    thread_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this] { return stop_; })) {
+            lock.unlock();
+            sweepOnce();
+            lock.lock();
+        }
+    });
+}
+
+HoldSweeper::~HoldSweeper() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+    sweepOnce();
+}
+
+void HoldSweeper::sweepOnce() {
+    expired_.fetch_add(transactions_.releaseExpiredHolds(), std::memory_order_relaxed);
+}
+
+}  // namespace atm
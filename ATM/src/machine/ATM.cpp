@@ -3,70 +3,181 @@
 #include "atm/machine/ATM.h"
 #include "atm/machine/IATMState.h"
 
+#include <algorithm>
+#include <chrono>
+
 namespace atm {
 
+namespace {
+
+std::int64_t monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
 ATM::ATM(std::shared_ptr<IUserInterface> ui,
          std::shared_ptr<CashDispenser> cd,
          std::shared_ptr<DepositSlot> ds,
          std::shared_ptr<Gateway> gw,
          AtmConfig config)
-    : ui_(ui), dispenser_(cd), depositSlot_(ds), gateway_(gw), config_(config) {
-    setState(std::make_unique<IdleState>(this));
+    : ui_(ui),
+      dispenser_(cd),
+      depositSlot_(ds),
+      gateway_(gw),
+      config_(config),
+      states_(this),
+      bankReady_(std::make_shared<BankReadySignal>()) {
+    bankReady_->atm = this;
+    setState(StateId::Idle);
+}
+
+ATM::~ATM() {
+    std::lock_guard<std::mutex> lock(bankReady_->mutex);
+    bankReady_->atm = nullptr;
 }
 
-void ATM::setState(std::unique_ptr<IATMState> newState) {
-    currentState_ = std::move(newState);
+void ATM::setBankReadyHandler(std::function<void(ATM&)> handler) {
+    std::lock_guard<std::mutex> lock(bankReady_->mutex);
+    bankReady_->handler = std::move(handler);
+}
+
+std::function<void()> ATM::bankReadyCallback() const {
+    return [signal = bankReady_] {
+        signal->completedAtNs.store(monotonicNs(), std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(signal->mutex);
+        if (signal->atm && signal->handler) {
+            signal->handler(*signal->atm);
+        }
+    };
+}
+
+void ATM::notifyInput() {
+    std::lock_guard<std::mutex> lock(bankReady_->mutex);
+    if (bankReady_->handler) {
+        bankReady_->handler(*this);
+    }
+}
+
+bool ATM::isAwaitingInput() const {
+    return currentState_ && currentState_->waitsForCustomer() && !ui_->hasPendingInput();
+}
+
+bool ATM::isWaitingForBank() const {
+    return currentState_ && currentState_->isWaitingForBank();
+}
+
+void ATM::setState(StateId next) {
+    currentId_ = next;
+    currentState_ = &states_.get(next);
+    currentState_->enter();
 }
 
 void ATM::createSession(const std::string& cardNumber) {
-    session_ = std::make_unique<UserSession>(cardNumber);
+    session_.emplace(cardNumber);
 }
 
 void ATM::resetSession() {
     session_.reset();
 }
 
-void ATM::runOnce() {
-    if (currentState_) {
-        currentState_->handle();
+bool ATM::runOnce() {
+    if (!currentState_ || currentState_->isWaitingForBank()) {
+        return false;
+    }
+    if (timings_) {
+        runTimedStep();
+        return true;
+    }
+    states_.visit(currentId_, [](auto& state) { state.handle(); });
+    return true;
+}
+
+void ATM::setStateTimings(std::shared_ptr<StateTimings> timings) {
+    timings_ = std::move(timings);
+    if (timings_ && !dynamic_cast<TimedUserInterface*>(ui_.get())) {
+        ui_ = std::make_shared<TimedUserInterface>(ui_);
+    }
+    parkedSinceNs_ = 0;
+    visitBankNs_ = 0;
+    visitUsedBank_ = false;
+}
+
+void ATM::runTimedStep() {
+    const StateId state = currentId_;
+    StepBlockedTime blocked;
+    StepBlockedTime*& slot = BlockedScope::current();
+    StepBlockedTime* outer = slot;
+    slot = &blocked;
+    const std::int64_t start = monotonicNs();
+    states_.visit(state, [](auto& s) { s.handle(); });
+    const std::int64_t end = monotonicNs();
+    slot = outer;
+
+    const auto total = static_cast<std::uint64_t>(end - start);
+    timings_->recordHandle(state, total - std::min(total, blocked.uiNs + blocked.bankNs));
+    if (blocked.uiCalls != 0) {
+        timings_->recordUi(state, blocked.uiNs);
+    }
+
+    visitBankNs_ += blocked.bankNs;
+    visitUsedBank_ = visitUsedBank_ || blocked.bankCalls != 0;
+    if (parkedSinceNs_ != 0) {
+        // Resumed after parking: count the time until the request completed.
+        const std::int64_t completed = bankReady_->completedAtNs.load(std::memory_order_relaxed);
+        visitBankNs_ += static_cast<std::uint64_t>(std::max(completed, parkedSinceNs_) - parkedSinceNs_);
+        parkedSinceNs_ = 0;
+    }
+    if (currentId_ == state && currentState_->isWaitingForBank()) {
+        parkedSinceNs_ = end;
+        return;
+    }
+    if (visitUsedBank_) {
+        timings_->recordBank(state, visitBankNs_);
     }
+    visitBankNs_ = 0;
+    visitUsedBank_ = false;
 }
 
-std::string ATM::getCurrentStateName() const {
-    return currentState_ ? currentState_->name() : "";
+std::string_view ATM::getCurrentStateName() const {
+    return currentState_ ? currentState_->name() : std::string_view();
 }
 
 UserSession* ATM::getSession() {
-    return session_.get();
+    return session_ ? &*session_ : nullptr;
 }
 
 const UserSession* ATM::getSession() const {
-    return session_.get();
+    return session_ ? &*session_ : nullptr;
 }
 
 const AtmConfig& ATM::getConfig() const {
     return config_;
 }
 
-std::shared_ptr<IUserInterface> ATM::getUI() {
+const std::shared_ptr<IUserInterface>& ATM::getUI() {
     return ui_;
 }
 
-std::shared_ptr<CashDispenser> ATM::getDispenser() {
+const std::shared_ptr<CashDispenser>& ATM::getDispenser() {
     return dispenser_;
 }
 
-std::shared_ptr<DepositSlot> ATM::getDepositSlot() {
+const std::shared_ptr<DepositSlot>& ATM::getDepositSlot() {
     return depositSlot_;
 }
 
-std::shared_ptr<Gateway> ATM::getGateway() {
+const std::shared_ptr<Gateway>& ATM::getGateway() {
     return gateway_;
 }
 
 void ATM::run() {
     while (true) {
-        runOnce();
+        if (!runOnce()) {
+            currentState_->waitForBank();
+        }
     }
 }
 
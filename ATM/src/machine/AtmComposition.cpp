@@ -4,17 +4,45 @@
 #include "atm/bank/CheckingAccount.h"
 #include "atm/bank/Money.h"
 #include "atm/bank/SavingAccount.h"
+#include "atm/machine/Metrics.h"
+
+#include <vector>
+
+#if defined(ATM_HAS_REMOTE_BANK)
+#include "atm/machine/RemoteBankService.h"
+#endif
 
 namespace atm {
 
 AtmComposition::AtmComposition(AtmConfig config)
-    : transactionManager_(config),
+    : transactionManager_(ledger_, config),
+      holdSweeper_(transactionManager_, std::chrono::milliseconds(constants::kDefaultHoldSweepIntervalMs)),
+      authService_(ledger_, config.maxPinAttempts),
       bank_(transactionManager_, authService_),
-      cashDispenser_(std::make_shared<CashDispenser>(Money(config.initialCashCents))),
+      cashDispenser_(config.cassettes.empty() ? std::make_shared<CashDispenser>(Money(config.initialCashCents))
+                                              : std::make_shared<CashDispenser>(config.cassettes)),
       depositSlot_(std::make_shared<DepositSlot>(*cashDispenser_)),
       ui_(std::make_shared<ConsoleUserInterface>(keyboard_, screen_, cardReader_)),
       gateway_(std::make_shared<Gateway>(bank_)),
-      config_(config) {}
+      config_(config) {
+    transactionManager_.setHistory(&history_);
+    if (config.cardDailyWithdrawLimitCents > 0) {
+        cardLimits_ = std::make_unique<RollingLimiter>(config.cardDailyWithdrawLimitCents, config.withdrawLimitCards);
+    }
+    if (config.terminalDailyWithdrawLimitCents > 0) {
+        terminalLimits_ = std::make_unique<RollingLimiter>(config.terminalDailyWithdrawLimitCents,
+                                                           constants::kDefaultWithdrawLimitTerminals);
+    }
+    transactionManager_.setWithdrawalLimits(cardLimits_.get(), terminalLimits_.get());
+    if (config.dedupeRequests > 0) {
+        requestDedupe_ = std::make_unique<RequestDedupe>(config.dedupeRequests);
+        bank_.setRequestDedupe(requestDedupe_.get());
+    }
+    cashDispenser_->setCashGauge(&atmMetrics().cashAvailable);
+    if (config.gatewayCacheTtlMs > 0) {
+        gateway_->enableCache(std::chrono::milliseconds(config.gatewayCacheTtlMs), config.gatewayCacheMaxEntries);
+    }
+}
 
 void AtmComposition::seedDemoData() {
     authService_.setPinForCard("pera123", "1234");
@@ -24,8 +52,61 @@ void AtmComposition::seedDemoData() {
     authService_.addAccountToCard("pera123", checking);
 }
 
+bool AtmComposition::loadSnapshot(const std::string& path, std::string* error) {
+    std::unique_ptr<SnapshotView> snapshot = SnapshotView::open(path, error);
+    if (!snapshot) return false;
+    if (snapshot_ || !ledger_.attachSnapshot(*snapshot)) {
+        if (error) *error = "state already loaded";
+        return false;
+    }
+    authService_.attachSnapshot(snapshot.get());
+    snapshot_ = std::move(snapshot);
+    return true;
+}
+
+bool AtmComposition::saveSnapshot(const std::string& path, std::string* error) const {
+    std::uint64_t journalSequence = 0;
+    if (journal_) {
+        journal_->flush();
+        journalSequence = journal_->durableSequence();
+    }
+    return SnapshotWriter::write(path, authService_, ledger_, journalSequence, error);
+}
+
+std::size_t AtmComposition::enableJournal(const std::string& path, JournalConfig config) {
+    transactionManager_.setJournal(nullptr);
+    journal_.reset();
+    const std::uint64_t snapshotSequence = snapshot_ ? snapshot_->header().journalSequence : 0;
+    std::vector<JournalRecord> openHolds;
+    const std::size_t replayed =
+        TransactionJournal::recover(path, ledger_, authService_, snapshotSequence, &openHolds);
+    journal_ = std::make_unique<TransactionJournal>(path, config);
+    transactionManager_.setJournal(journal_.get());
+    transactionManager_.releaseRecoveredHolds(openHolds);
+    return replayed;
+}
+
+bool AtmComposition::connectRemoteBank(const std::string& address, std::string* error) {
+#if defined(ATM_HAS_REMOTE_BANK)
+    auto remote = std::make_shared<RemoteBankService>();
+    if (!remote->connect(address, error)) return false;
+    remoteBank_ = remote;
+    gateway_ = std::make_shared<Gateway>(*remoteBank_);
+    if (config_.gatewayCacheTtlMs > 0) {
+        gateway_->enableCache(std::chrono::milliseconds(config_.gatewayCacheTtlMs), config_.gatewayCacheMaxEntries);
+    }
+    return true;
+#else
+    (void)address;
+    if (error) *error = "remote bank not supported on this platform";
+    return false;
+#endif
+}
+
 std::unique_ptr<ATM> AtmComposition::createAtm() {
-    return std::make_unique<ATM>(ui_, cashDispenser_, depositSlot_, gateway_, config_);
+    auto atm = std::make_unique<ATM>(ui_, cashDispenser_, depositSlot_, gateway_, config_);
+    atm->setStateTimings(stateTimings_);
+    return atm;
 }
 
 }  // namespace atm
@@ -4,6 +4,9 @@
 #include "atm/machine/MenuOption.h"
 #include "atm/bank/Money.h"
 
+#include <cstdio>
+#include <ctime>
+
 namespace atm {
 
 ConsoleUserInterface::ConsoleUserInterface(Keyboard& key, Screen& scr, CardReader& reader)
@@ -45,7 +48,7 @@ void ConsoleUserInterface::showCardEjected(const std::string& cardNumber) {
 
 MenuOption ConsoleUserInterface::promptMenuOption() {
     for (;;) {
-        screen.printMessage("Choose option: check_balance, withdraw, deposit, exit\n");
+        screen.printMessage("Choose option: check_balance, withdraw, deposit, mini_statement, exit\n");
         std::string input = keyboard.readLine();
         auto option = MenuOptionHelper::parse(input);
         if (option.has_value()) {
@@ -63,6 +66,28 @@ void ConsoleUserInterface::showBalance(Money balance) {
     screen.printMessage("Balance (cents): " + std::to_string(balance.getCents()) + "\n");
 }
 
+void ConsoleUserInterface::showMiniStatement(const std::vector<HistoryEntry>& entries) {
+    if (entries.empty()) {
+        screen.printMessage("No transactions yet.\n");
+        return;
+    }
+    screen.printMessage("Recent transactions (cents):\n");
+    for (const HistoryEntry& entry : entries) {
+        const std::time_t seconds = static_cast<std::time_t>(entry.timeUs / 1'000'000);
+        char when[32] = "?";
+        if (const std::tm* local = std::localtime(&seconds)) {
+            std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", local);
+        }
+        const bool withdraw = entry.type == HistoryType::Withdraw;
+        char line[128];
+        std::snprintf(line, sizeof(line), "  %s  %-8s %12lld  balance %12lld\n", when,
+                      withdraw ? "withdraw" : "deposit",
+                      static_cast<long long>(withdraw ? -entry.amount.getCents() : entry.amount.getCents()),
+                      static_cast<long long>(entry.balance.getCents()));
+        screen.printMessage(line);
+    }
+}
+
 Money ConsoleUserInterface::promptWithdrawAmount() {
     for (;;) {
         screen.printMessage("Enter amount to withdraw (cents, positive): ");
@@ -101,6 +126,13 @@ void ConsoleUserInterface::showInsufficientAtmFunds() {
     screen.printMessage("Error: This ATM does not have enough cash. Try a smaller amount.\n");
 }
 
+void ConsoleUserInterface::showDispensableAmounts(Money lower, Money higher) {
+    std::string message = "Error: This ATM cannot pay that amount in notes.";
+    if (lower.getCents() > 0) message += " Nearest lower amount (cents): " + std::to_string(lower.getCents()) + ".";
+    if (higher.getCents() > 0) message += " Nearest higher amount (cents): " + std::to_string(higher.getCents()) + ".";
+    screen.printMessage(message + "\n");
+}
+
 void ConsoleUserInterface::showInsufficientAccountFunds() {
     screen.printMessage("Error: Insufficient funds in account. Try a smaller amount.\n");
 }
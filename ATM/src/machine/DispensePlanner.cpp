@@ -0,0 +1,206 @@
+// DispensePlanner.cpp - Bounded note-count table per cassette, nearest payable amounts, fallback search.
+
+#include "atm/machine/DispensePlanner.h"
+
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+
+namespace atm {
+
+namespace {
+
+// Search nodes one plan() beyond the table may visit.
+constexpr std::size_t kSearchBudget = 4096;
+
+bool parseInt(std::string_view text, std::int64_t& value) {
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+}  // namespace
+
+bool parseCassettes(std::string_view text, std::vector<Cassette>* cassettes, std::string* error) {
+    std::vector<Cassette> parsed;
+    while (!text.empty()) {
+        const std::size_t comma = text.find(',');
+        const std::string_view item = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+        const std::size_t x = item.find('x');
+        std::int64_t cents = 0;
+        std::int64_t notes = 0;
+        if (x == std::string_view::npos || !parseInt(item.substr(0, x), cents) ||
+            !parseInt(item.substr(x + 1), notes) || cents <= 0 || notes < 0 || notes > UINT32_MAX) {
+            if (error) *error = "bad cassette '" + std::string(item) + "' (expected <cents>x<notes>)";
+            return false;
+        }
+        if (parsed.size() == kMaxCassettes) {
+            if (error) *error = "more than " + std::to_string(kMaxCassettes) + " cassettes";
+            return false;
+        }
+        parsed.push_back(Cassette{Money(cents), static_cast<std::uint32_t>(notes)});
+    }
+    if (cassettes) *cassettes = std::move(parsed);
+    return true;
+}
+
+void DispensePlanner::build(std::span<const Cassette> cassettes) {
+    columnCount_ = 0;
+    unitCents_ = 1;
+    totalUnits_ = 0;
+    tableUnits_ = 0;
+    take_.clear();
+    below_.clear();
+    above_.clear();
+
+    std::int64_t unit = 0;
+    for (std::size_t i = 0; i < cassettes.size() && i < kMaxCassettes; ++i) {
+        const std::int64_t cents = cassettes[i].denomination.getCents();
+        if (cents <= 0 || cassettes[i].notes == 0) continue;
+        columns_[columnCount_++] = Column{i, cents, cassettes[i].notes};
+        unit = std::gcd(unit, cents);
+    }
+    if (columnCount_ == 0) return;
+    unitCents_ = unit;
+    for (std::size_t c = 0; c < columnCount_; ++c) {
+        columns_[c].units /= unit;
+        totalUnits_ += columns_[c].units * columns_[c].notes;
+    }
+    std::sort(columns_.begin(), columns_.begin() + static_cast<std::ptrdiff_t>(columnCount_),
+              [](const Column& a, const Column& b) { return a.units > b.units; });
+    if (columnCount_ == 1) return;
+
+    // Column by column, a is payable if it was payable without this column, or if a - units is
+    // payable using fewer than all of this column's notes. Larger notes go first, so a plan
+    // uses as few small notes as the counts allow.
+    tableUnits_ = std::min<std::int64_t>(totalUnits_, static_cast<std::int64_t>(kTableUnits));
+    const std::size_t width = static_cast<std::size_t>(tableUnits_) + 1;
+    take_.assign(columnCount_ * width, kUnreachable);
+    std::vector<std::uint8_t> reach(width, 0);
+    reach[0] = 1;
+    for (std::size_t c = 0; c < columnCount_; ++c) {
+        const std::size_t units = static_cast<std::size_t>(columns_[c].units);
+        const std::int64_t notes = std::min<std::int64_t>(columns_[c].notes, kUnreachable - 1);
+        std::uint16_t* row = &take_[c * width];
+        for (std::size_t a = 0; a < width; ++a) {
+            if (reach[a]) {
+                row[a] = 0;
+            }
+            else if (a >= units && row[a - units] != kUnreachable && row[a - units] < notes) {
+                row[a] = static_cast<std::uint16_t>(row[a - units] + 1);
+                reach[a] = 1;
+            }
+        }
+    }
+    below_.resize(width);
+    above_.resize(width);
+    for (std::size_t a = 0; a < width; ++a) {
+        below_[a] = reach[a] ? static_cast<std::uint16_t>(a) : below_[a - 1];  // reach[0] is set
+    }
+    for (std::size_t a = width; a-- > 0;) {
+        above_[a] = reach[a] ? static_cast<std::uint16_t>(a) : a + 1 < width ? above_[a + 1] : kUnreachable;
+    }
+}
+
+std::optional<std::int64_t> DispensePlanner::toUnits(Money amount) const {
+    const std::int64_t cents = amount.getCents();
+    if (cents < 0 || cents % unitCents_ != 0) return std::nullopt;
+    return cents / unitCents_;
+}
+
+bool DispensePlanner::reachable(std::int64_t units) const {
+    if (units < 0 || units > totalUnits_) return false;
+    if (columnCount_ > 1 && units <= tableUnits_) return below_[static_cast<std::size_t>(units)] == units;
+    if (columnCount_ > 1 && totalUnits_ - units <= tableUnits_) {
+        return below_[static_cast<std::size_t>(totalUnits_ - units)] == totalUnits_ - units;
+    }
+    DispensePlan plan{};
+    std::size_t budget = kSearchBudget;
+    return search(0, units, plan, budget);
+}
+
+bool DispensePlanner::search(std::size_t column, std::int64_t units, DispensePlan& plan, std::size_t& budget) const {
+    if (units == 0) return true;
+    if (column == columnCount_ || budget == 0) return false;
+    --budget;
+    const Column& col = columns_[column];
+    if (column + 1 == columnCount_) {
+        if (units % col.units != 0 || units / col.units > col.notes) return false;
+        plan[col.cassette] = static_cast<std::uint32_t>(units / col.units);
+        return true;
+    }
+    std::int64_t rest = 0;
+    for (std::size_t c = column; c < columnCount_; ++c) rest += columns_[c].units * columns_[c].notes;
+    if (units > rest) return false;
+    for (std::int64_t k = std::min(col.notes, units / col.units); k >= 0 && budget > 0; --k) {
+        plan[col.cassette] = static_cast<std::uint32_t>(k);
+        if (search(column + 1, units - k * col.units, plan, budget)) return true;
+    }
+    plan[col.cassette] = 0;
+    return false;
+}
+
+std::optional<DispensePlan> DispensePlanner::plan(Money amount) const {
+    const std::optional<std::int64_t> units = toUnits(amount);
+    if (!units || *units > totalUnits_) return std::nullopt;
+    DispensePlan plan{};
+    if (*units <= tableUnits_ && columnCount_ > 1) {
+        const std::size_t width = static_cast<std::size_t>(tableUnits_) + 1;
+        std::size_t a = static_cast<std::size_t>(*units);
+        if (take_[(columnCount_ - 1) * width + a] == kUnreachable) return std::nullopt;
+        for (std::size_t c = columnCount_; c-- > 0;) {
+            const std::uint16_t notes = take_[c * width + a];
+            plan[columns_[c].cassette] = notes;
+            a -= notes * static_cast<std::size_t>(columns_[c].units);
+        }
+        return plan;
+    }
+    std::size_t budget = kSearchBudget;
+    if (!search(0, *units, plan, budget)) return std::nullopt;
+    return plan;
+}
+
+bool DispensePlanner::canDispense(Money amount) const {
+    const std::optional<std::int64_t> units = toUnits(amount);
+    return units && reachable(*units);
+}
+
+Money DispensePlanner::nearestBelow(Money amount) const {
+    if (amount.getCents() <= 0 || columnCount_ == 0) return Money();
+    const std::int64_t units = std::min(amount.getCents() / unitCents_, totalUnits_);
+    if (columnCount_ == 1) {
+        const std::int64_t notes = std::min(units / columns_[0].units, columns_[0].notes);
+        return Money(notes * columns_[0].units * unitCents_);
+    }
+    if (units <= tableUnits_) return Money(below_[static_cast<std::size_t>(units)] * unitCents_);
+    // The notes left out of a plan for a pay total - a, so the top of the range mirrors the table.
+    const std::int64_t mirror = totalUnits_ - units;
+    if (mirror <= tableUnits_ && above_[static_cast<std::size_t>(mirror)] != kUnreachable) {
+        return Money((totalUnits_ - above_[static_cast<std::size_t>(mirror)]) * unitCents_);
+    }
+    // Between the two, try only the whole-unit amount itself (one search, like plan()).
+    if (mirror > tableUnits_ && reachable(units)) return Money(units * unitCents_);
+    return Money(below_[static_cast<std::size_t>(tableUnits_)] * unitCents_);
+}
+
+Money DispensePlanner::nearestAbove(Money amount) const {
+    if (amount.getCents() <= 0 || columnCount_ == 0) return Money();
+    const std::int64_t units = (amount.getCents() + unitCents_ - 1) / unitCents_;
+    if (units > totalUnits_) return Money();
+    if (columnCount_ == 1) {
+        const std::int64_t notes = (units + columns_[0].units - 1) / columns_[0].units;
+        return notes <= columns_[0].notes ? Money(notes * columns_[0].units * unitCents_) : Money();
+    }
+    if (units <= tableUnits_ && above_[static_cast<std::size_t>(units)] != kUnreachable) {
+        return Money(above_[static_cast<std::size_t>(units)] * unitCents_);
+    }
+    if (units > tableUnits_ && totalUnits_ - units > tableUnits_ && reachable(units)) {
+        return Money(units * unitCents_);
+    }
+    // The smallest payable amount in the mirrored top of the range; the full total always is.
+    const std::int64_t mirror = std::min(totalUnits_ - units, tableUnits_);
+    return Money((totalUnits_ - below_[static_cast<std::size_t>(mirror)]) * unitCents_);
+}
+
+}  // namespace atm
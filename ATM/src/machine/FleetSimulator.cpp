@@ -0,0 +1,244 @@
+// FleetSimulator.cpp - Simulated customers, timed bank decorator and the per-thread terminal loops.
+
+#include "atm/machine/FleetSimulator.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/machine/ATM.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/Hardware.h"
+#include "atm/machine/ScriptedUserInterface.h"
+#include "atm/machine/TerminalScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace atm {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Latencies shared by all terminals of a run.
+struct FleetHistograms {
+    LatencyHistogram session;
+    LatencyHistogram login;
+    LatencyHistogram balance;
+    LatencyHistogram withdraw;
+    LatencyHistogram deposit;
+};
+
+/// Counts terminals that have run all their sessions; run() waits for all of them.
+struct FleetProgress {
+    std::mutex mutex;
+    std::condition_variable allDone;
+    std::size_t finished = 0;
+    std::size_t terminals = 0;
+
+    void terminalFinished() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (++finished == terminals) allDone.notify_all();
+    }
+};
+
+/// Forwards to the shared bank and times the calls the fleet makes.
+class TimedBankService : public IBankService {
+public:
+    TimedBankService(IBankService& bank, FleetHistograms& histograms) : bank_(bank), histograms_(histograms) {}
+
+    bool checkIfCardExist(const std::string& card) override { return bank_.checkIfCardExist(card); }
+    bool checkPIN(const std::string& pin, const std::string& card) override { return bank_.checkPIN(pin, card); }
+    AuthResult authenticate(const std::string& card, const std::string& pin) override {
+        const Clock::time_point start = Clock::now();
+        AuthResult result = bank_.authenticate(card, pin);
+        histograms_.login.record(Clock::now() - start);
+        return result;
+    }
+    void blockCard(const std::string& card) override { bank_.blockCard(card); }
+    Money showBalance(AccountId account) override {
+        const Clock::time_point start = Clock::now();
+        const Money balance = bank_.showBalance(account);
+        histograms_.balance.record(Clock::now() - start);
+        return balance;
+    }
+    bool withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId request) override {
+        const Clock::time_point start = Clock::now();
+        const bool ok = bank_.withdrawCash(account, amount, terminal, card, request);
+        histograms_.withdraw.record(Clock::now() - start);
+        return ok;
+    }
+    bool depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) override {
+        const Clock::time_point start = Clock::now();
+        const bool ok = bank_.depositCash(account, amount, terminal, request);
+        histograms_.deposit.record(Clock::now() - start);
+        return ok;
+    }
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override {
+        const Clock::time_point start = Clock::now();
+        const bool ok = bank_.reserveCash(account, amount, terminal, card, hold);
+        histograms_.withdraw.record(Clock::now() - start);
+        return ok;
+    }
+    bool commitCash(RequestId hold) override { return bank_.commitCash(hold); }
+    bool releaseCash(RequestId hold) override { return bank_.releaseCash(hold); }
+    std::vector<HistoryEntry> getMiniStatement(AccountId account, std::size_t count) override {
+        return bank_.getMiniStatement(account, count);
+    }
+    std::vector<AccountHandle> getAccountListForCard(const std::string& card) override {
+        return bank_.getAccountListForCard(card);
+    }
+
+private:
+    IBankService& bank_;
+    FleetHistograms& histograms_;
+};
+
+constexpr std::int64_t kWithdrawCents = 2000;
+constexpr std::int64_t kDepositCents = 5000;
+// Generated scripts are capped; terminals start at different offsets and wrap around.
+constexpr std::size_t kMaxGeneratedSessions = 1 << 16;
+
+/// Scripted customer that also times sessions and reports when its quota is done.
+class FleetCustomer : public ScriptedUserInterface {
+public:
+    FleetCustomer(std::shared_ptr<const SessionScript> script, std::size_t firstSession, std::uint64_t sessions,
+                  FleetHistograms& histograms, FleetProgress& progress)
+        : ScriptedUserInterface(std::move(script), firstSession, sessions),
+          sessions_(sessions),
+          histograms_(histograms),
+          progress_(progress) {}
+
+    std::string readCard() override {
+        std::string card = ScriptedUserInterface::readCard();
+        if (!card.empty()) sessionStart_ = Clock::now();
+        return card;
+    }
+    void showCardEjected(const std::string& cardNumber) override {
+        ScriptedUserInterface::showCardEjected(cardNumber);
+        histograms_.session.record(Clock::now() - sessionStart_);
+        if (sessionsDone() == sessions_) {
+            progress_.terminalFinished();
+        }
+    }
+
+private:
+    std::uint64_t sessions_;
+    FleetHistograms& histograms_;
+    FleetProgress& progress_;
+    Clock::time_point sessionStart_;
+};
+
+struct Terminal {
+    std::shared_ptr<FleetCustomer> customer;
+    std::unique_ptr<ATM> atm;
+};
+
+}  // namespace
+
+FleetSimulator::FleetSimulator(IBankService& bank, FleetConfig config) : bank_(bank), config_(std::move(config)) {}
+
+void FleetSimulator::provisionCards(AuthService& auth, const FleetConfig& config) {
+    auth.reserve(config.cards);
+    for (std::size_t i = 0; i < config.cards; ++i) {
+        const std::string card = config.cardPrefix + std::to_string(i);
+        auth.setPinForCard(card, config.pin);
+        auth.addAccountToCard(card, SavingAccount("Fleet account", Money(1'000'000'000)));
+    }
+}
+
+SessionScript FleetSimulator::randomScript(const FleetConfig& config, std::size_t sessions) {
+    SessionScript script;
+    script.reserve(sessions, sessions * (config.cardPrefix.size() + 8 + config.pin.size()));
+    std::uint64_t rng = config.seed * 0x9E3779B97F4A7C15ull | 1;
+    auto next = [&rng] {
+        // xorshift64: cheap and reproducible for a given seed.
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return rng;
+    };
+    std::string card;
+    ScriptedStep steps[3];
+    for (std::size_t i = 0; i < sessions; ++i) {
+        const int count = 1 + static_cast<int>(next() % 3);
+        for (int k = 0; k < count; ++k) {
+            const std::uint64_t roll = next() % 4;
+            steps[k] = roll < 2    ? ScriptedStep{MenuOption::CheckBalance, 0}
+                       : roll == 2 ? ScriptedStep{MenuOption::Withdraw, kWithdrawCents}
+                                   : ScriptedStep{MenuOption::Deposit, kDepositCents};
+        }
+        card = config.cardPrefix + std::to_string(config.cards ? next() % config.cards : 0);
+        script.addSession(card, {config.pin}, 1, std::span<const ScriptedStep>(steps, static_cast<std::size_t>(count)));
+    }
+    return script;
+}
+
+FleetReport FleetSimulator::run() {
+    FleetHistograms histograms;
+    TimedBankService timedBank(bank_, histograms);
+    auto gateway = std::make_shared<Gateway>(timedBank);
+
+    FleetProgress progress;
+    progress.terminals = config_.terminals;
+    progress.finished = config_.sessionsPerTerminal == 0 ? config_.terminals : 0;
+    std::shared_ptr<const SessionScript> script = config_.script;
+    if (!script || script->empty()) {
+        script = std::make_shared<const SessionScript>(randomScript(
+            config_, std::min(config_.terminals * config_.sessionsPerTerminal, kMaxGeneratedSessions)));
+    }
+    std::shared_ptr<StateTimings> stateTimings = config_.stateTimings ? std::make_shared<StateTimings>() : nullptr;
+    std::vector<Terminal> terminals;
+    terminals.reserve(config_.terminals);
+    for (std::size_t i = 0; i < config_.terminals; ++i) {
+        Terminal terminal;
+        terminal.customer = std::make_shared<FleetCustomer>(script, i * config_.sessionsPerTerminal,
+                                                            config_.sessionsPerTerminal, histograms, progress);
+        auto dispenser = config_.atm.cassettes.empty()
+                             ? std::make_shared<CashDispenser>(Money(config_.atm.initialCashCents))
+                             : std::make_shared<CashDispenser>(config_.atm.cassettes);
+        auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+        AtmConfig atmConfig = config_.atm;
+        atmConfig.terminalId = static_cast<TerminalId>(i + 1);
+        terminal.atm = std::make_unique<ATM>(terminal.customer, dispenser, depositSlot, gateway, atmConfig);
+        if (stateTimings) terminal.atm->setStateTimings(stateTimings);
+        terminals.push_back(std::move(terminal));
+    }
+
+    TerminalScheduler scheduler(config_.threads);
+    for (Terminal& terminal : terminals) scheduler.add(*terminal.atm);
+    const Clock::time_point start = Clock::now();
+    scheduler.start();
+    {
+        std::unique_lock<std::mutex> lock(progress.mutex);
+        progress.allDone.wait(lock, [&] { return progress.finished == progress.terminals; });
+    }
+    const Clock::time_point end = Clock::now();
+    scheduler.stop();
+
+    FleetReport report;
+    report.seconds = std::chrono::duration<double>(end - start).count();
+    report.terminals = config_.terminals;
+    report.threads = scheduler.workerCount();
+    report.steals = scheduler.stats().steals;
+    report.stateTimings = stateTimings;
+    std::int64_t withdrawn = 0;
+    std::int64_t deposited = 0;
+    for (const Terminal& terminal : terminals) {
+        report.sessions += terminal.customer->sessionsDone();
+        withdrawn += terminal.customer->withdrawnCents();
+        deposited += terminal.customer->depositedCents();
+    }
+    report.withdrawn = Money(withdrawn);
+    report.deposited = Money(deposited);
+    report.session = histograms.session.summary();
+    report.login = histograms.login.summary();
+    report.balance = histograms.balance.summary();
+    report.withdraw = histograms.withdraw.summary();
+    report.deposit = histograms.deposit.summary();
+    return report;
+}
+
+}  // namespace atm
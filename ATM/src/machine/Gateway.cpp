@@ -1,37 +1,221 @@
-// Gateway.cpp - Forwards ATM calls to the bank.
+// Gateway.cpp - Forwards ATM calls to the bank; optional cache for balances and account lists.
+// Every call runs in a BlockedScope so per-state timings can tell bank time from the state's own.
 
 #include "atm/machine/Gateway.h"
+#include "atm/bank/AsyncBankAdapter.h"
+#include "atm/machine/StateTimings.h"
 
 namespace atm {
 
-Gateway::Gateway(IBankService& service) : bankService_(service) {}
+Gateway::Gateway(IBankService& service)
+    : bankService_(&service),
+      ownedAsync_(std::make_unique<AsyncBankAdapter>(service)),
+      asyncService_(ownedAsync_.get()) {}
+
+Gateway::Gateway(IAsyncBankService& service) : asyncService_(&service) {}
+
+Gateway::~Gateway() = default;
+
+void Gateway::enableCache(std::chrono::milliseconds ttl, std::size_t maxEntries) {
+    cache_ = std::make_shared<GatewayCache>(ttl, maxEntries);
+}
+
+GatewayCacheStats Gateway::cacheStats() const {
+    return cache_ ? cache_->stats() : GatewayCacheStats{};
+}
 
 bool Gateway::checkIfCardExist(const std::string& card) const {
-    return bankService_.checkIfCardExist(card);
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (bankService_) {
+        return bankService_->checkIfCardExist(card);
+    }
+    return asyncService_->checkIfCardExist(card).get();
 }
 
 bool Gateway::checkPIN(const std::string& pin, const std::string& card) const {
-    return bankService_.checkPIN(pin, card);
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (bankService_) {
+        return bankService_->checkPIN(pin, card);
+    }
+    return asyncService_->checkPIN(pin, card).get();
+}
+
+AuthResult Gateway::authenticate(const std::string& card, const std::string& pin) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    AuthResult result = bankService_ ? bankService_->authenticate(card, pin)
+                                     : asyncService_->authenticate(card, pin).get();
+    if (cache_ && result.pinVerdict == PinVerdict::Accepted) {
+        cache_->storeAccountList(card, result.accounts);
+    }
+    return result;
 }
 
 void Gateway::blockCard(const std::string& card) {
-    bankService_.blockCard(card);
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (cache_) {
+        cache_->invalidateAccountList(card);
+    }
+    if (bankService_) {
+        bankService_->blockCard(card);
+        return;
+    }
+    asyncService_->blockCard(card).wait();
+}
+
+Money Gateway::showBalance(AccountId account) const {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (!cache_) {
+        return bankService_ ? bankService_->showBalance(account) : asyncService_->showBalance(account).get();
+    }
+    if (std::optional<Money> cached = cache_->findBalance(account)) {
+        return *cached;
+    }
+    const std::uint64_t token = cache_->balanceToken(account);
+    const Money balance =
+        bankService_ ? bankService_->showBalance(account) : asyncService_->showBalance(account).get();
+    cache_->storeBalance(account, balance, token);
+    return balance;
+}
+
+bool Gateway::withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId request) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (cache_) {
+        cache_->invalidateBalance(account);
+    }
+    const bool ok = bankService_ ? bankService_->withdrawCash(account, amount, terminal, card, request)
+                                 : asyncService_->withdrawCash(account, amount, terminal, card, request).get();
+    if (cache_) {
+        cache_->invalidateBalance(account);
+    }
+    return ok;
+}
+
+bool Gateway::depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (cache_) {
+        cache_->invalidateBalance(account);
+    }
+    const bool ok = bankService_ ? bankService_->depositCash(account, amount, terminal, request)
+                                 : asyncService_->depositCash(account, amount, terminal, request).get();
+    if (cache_) {
+        cache_->invalidateBalance(account);
+    }
+    return ok;
+}
+
+std::vector<HistoryEntry> Gateway::getMiniStatement(AccountId account, std::size_t count) const {
+    BlockedScope timed(BlockedScope::On::Bank);
+    return bankService_ ? bankService_->getMiniStatement(account, count)
+                        : asyncService_->getMiniStatement(account, count).get();
+}
+
+std::vector<AccountHandle> Gateway::getAccountListForCard(const std::string& card) const {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (cache_) {
+        if (std::optional<std::vector<AccountHandle>> cached = cache_->findAccountList(card)) {
+            return std::move(*cached);
+        }
+    }
+    std::vector<AccountHandle> accounts = bankService_ ? bankService_->getAccountListForCard(card)
+                                                       : asyncService_->getAccountListForCard(card).get();
+    if (cache_) {
+        cache_->storeAccountList(card, accounts);
+    }
+    return accounts;
+}
+
+BankCall<AuthResult> Gateway::authenticateAsync(const std::string& card, const std::string& pin) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    BankCall<AuthResult> call = asyncService_->authenticate(card, pin);
+    if (cache_) {
+        call.then([cache = cache_, card](const AuthResult& result) {
+            if (result.pinVerdict == PinVerdict::Accepted) {
+                cache->storeAccountList(card, result.accounts);
+            }
+        });
+    }
+    return call;
+}
+
+BankCall<bool> Gateway::blockCardAsync(const std::string& card) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (cache_) {
+        cache_->invalidateAccountList(card);
+    }
+    return asyncService_->blockCard(card);
+}
+
+BankCall<Money> Gateway::showBalanceAsync(AccountId account) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (!cache_) {
+        return asyncService_->showBalance(account);
+    }
+    if (std::optional<Money> cached = cache_->findBalance(account)) {
+        return BankCall<Money>::completed(*cached);
+    }
+    const std::uint64_t token = cache_->balanceToken(account);
+    BankCall<Money> call = asyncService_->showBalance(account);
+    call.then([cache = cache_, account, token](const Money& balance) {
+        cache->storeBalance(account, balance, token);
+    });
+    return call;
+}
+
+BankCall<bool> Gateway::withdrawCashAsync(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                          RequestId request) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (!cache_) {
+        return asyncService_->withdrawCash(account, amount, terminal, card, request);
+    }
+    cache_->invalidateBalance(account);
+    BankCall<bool> call = asyncService_->withdrawCash(account, amount, terminal, card, request);
+    call.then([cache = cache_, account](const bool&) { cache->invalidateBalance(account); });
+    return call;
+}
+
+BankCall<bool> Gateway::depositCashAsync(AccountId account, Money amount, TerminalId terminal, RequestId request) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (!cache_) {
+        return asyncService_->depositCash(account, amount, terminal, request);
+    }
+    cache_->invalidateBalance(account);
+    BankCall<bool> call = asyncService_->depositCash(account, amount, terminal, request);
+    call.then([cache = cache_, account](const bool&) { cache->invalidateBalance(account); });
+    return call;
 }
 
-Money Gateway::showBalance(Account* account) const {
-    return bankService_.showBalance(account);
+BankCall<bool> Gateway::reserveCashAsync(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                         RequestId hold) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (!cache_) {
+        return asyncService_->reserveCash(account, amount, terminal, card, hold);
+    }
+    cache_->invalidateBalance(account);
+    BankCall<bool> call = asyncService_->reserveCash(account, amount, terminal, card, hold);
+    call.then([cache = cache_, account](const bool&) { cache->invalidateBalance(account); });
+    return call;
 }
 
-bool Gateway::withdrawCash(Account* account, Money amount) {
-    return bankService_.withdrawCash(account, amount);
+BankCall<std::optional<bool>> Gateway::commitCashAsync(RequestId hold) {
+    // The balance already dropped at reserve time, so there is nothing to invalidate.
+    BlockedScope timed(BlockedScope::On::Bank);
+    return asyncService_->commitCash(hold);
 }
 
-bool Gateway::depositCash(Account* account, Money amount) {
-    return bankService_.depositCash(account, amount);
+BankCall<bool> Gateway::releaseCashAsync(AccountId account, RequestId hold) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    if (!cache_) {
+        return asyncService_->releaseCash(hold);
+    }
+    cache_->invalidateBalance(account);
+    BankCall<bool> call = asyncService_->releaseCash(hold);
+    call.then([cache = cache_, account](const bool&) { cache->invalidateBalance(account); });
+    return call;
 }
 
-std::vector<Account> Gateway::getAccountListForCard(const std::string& card) const {
-    return bankService_.getAccountListForCard(card);
+BankCall<std::vector<HistoryEntry>> Gateway::getMiniStatementAsync(AccountId account, std::size_t count) {
+    BlockedScope timed(BlockedScope::On::Bank);
+    return asyncService_->getMiniStatement(account, count);
 }
 
 }  // namespace atm
@@ -0,0 +1,67 @@
+// GatewayCache.cpp - Locked lookups and counters over the two TTL tables.
+
+#include "atm/machine/GatewayCache.h"
+#include "atm/bank/Hashing.h"
+
+namespace atm {
+
+GatewayCache::GatewayCache(std::chrono::milliseconds ttl, std::size_t maxEntries)
+    : balances_(ttl, maxEntries), accountLists_(ttl, maxEntries) {}
+
+std::optional<Money> GatewayCache::findBalance(AccountId account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::optional<Money> balance = balances_.get(account);
+    ++(balance ? stats_.balanceHits : stats_.balanceMisses);
+    return balance;
+}
+
+std::uint64_t& GatewayCache::versionOf(AccountId account) {
+    return balanceVersions_[mix64(account) % kVersionStripes];
+}
+
+const std::uint64_t& GatewayCache::versionOf(AccountId account) const {
+    return balanceVersions_[mix64(account) % kVersionStripes];
+}
+
+std::uint64_t GatewayCache::balanceToken(AccountId account) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return versionOf(account);
+}
+
+void GatewayCache::storeBalance(AccountId account, Money balance, std::uint64_t token) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (token != versionOf(account)) {
+        return;
+    }
+    stats_.evictions += balances_.put(account, balance);
+}
+
+void GatewayCache::invalidateBalance(AccountId account) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    balances_.erase(account);
+    ++versionOf(account);
+}
+
+std::optional<std::vector<AccountHandle>> GatewayCache::findAccountList(const std::string& card) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::optional<std::vector<AccountHandle>> accounts = accountLists_.get(card);
+    ++(accounts ? stats_.accountListHits : stats_.accountListMisses);
+    return accounts;
+}
+
+void GatewayCache::storeAccountList(const std::string& card, std::vector<AccountHandle> accounts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.evictions += accountLists_.put(card, std::move(accounts));
+}
+
+void GatewayCache::invalidateAccountList(const std::string& card) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accountLists_.erase(card);
+}
+
+GatewayCacheStats GatewayCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+}  // namespace atm
@@ -2,6 +2,9 @@
 
 #include "atm/machine/Hardware.h"
 #include "atm/bank/Money.h"
+#include "atm/machine/Metrics.h"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 
@@ -34,24 +37,95 @@ std::string CardReader::readCardNumber() {
     return cardNumber;
 }
 
-CashDispenser::CashDispenser(Money initialCash) : available_(initialCash) {}
+namespace {
+
+// Cash that does not model notes: one cassette of 1-cent notes.
+std::vector<Cassette> centCassette(Money cash) {
+    const std::int64_t cents = std::clamp<std::int64_t>(cash.getCents(), 0, UINT32_MAX);
+    return {Cassette{Money(1), static_cast<std::uint32_t>(cents)}};
+}
+
+}  // namespace
+
+CashDispenser::CashDispenser(Money initialCash) : CashDispenser(centCassette(initialCash)) {}
+
+CashDispenser::CashDispenser(std::vector<Cassette> cassettes) {
+    loadCassettes(std::move(cassettes));
+}
+
+void CashDispenser::loadCassettes(std::vector<Cassette> cassettes) {
+    if (cassettes.size() > kMaxCassettes) cassettes.resize(kMaxCassettes);
+    cassettes_ = std::move(cassettes);
+    update();
+}
+
+const std::vector<Cassette>& CashDispenser::getCassettes() const {
+    return cassettes_;
+}
 
 bool CashDispenser::hasEnoughCash(Money amount) const {
-    return amount <= available_;
+    return planner_.canDispense(amount);
 }
 
-void CashDispenser::dispense(Money amount) {
-    if (hasEnoughCash(amount)) {
-        available_ = available_ - amount;
-    }
+std::optional<DispensePlan> CashDispenser::planDispense(Money amount) const {
+    return planner_.plan(amount);
+}
+
+Money CashDispenser::nearestDispensableBelow(Money amount) const {
+    return planner_.nearestBelow(amount);
+}
+
+Money CashDispenser::nearestDispensableAbove(Money amount) const {
+    return planner_.nearestAbove(amount);
+}
+
+bool CashDispenser::dispense(Money amount) {
+    const std::optional<DispensePlan> plan = planner_.plan(amount);
+    if (!plan) return false;
+    for (std::size_t i = 0; i < cassettes_.size(); ++i) cassettes_[i].notes -= (*plan)[i];
+    update();
+    return true;
 }
 
 void CashDispenser::addCash(Money amount) {
-    available_ = available_ + amount;
+    std::int64_t rest = amount.getCents();
+    if (rest <= 0) return;
+    std::vector<std::size_t> order(cassettes_.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return cassettes_[a].denomination.getCents() > cassettes_[b].denomination.getCents();
+    });
+    for (std::size_t i : order) {
+        const std::int64_t cents = cassettes_[i].denomination.getCents();
+        if (cents <= 0) continue;
+        const std::int64_t notes = std::min<std::int64_t>(rest / cents, UINT32_MAX - cassettes_[i].notes);
+        cassettes_[i].notes += static_cast<std::uint32_t>(notes);
+        rest -= notes * cents;
+    }
+    depositBin_ = depositBin_ + Money(rest);
+    update();
 }
 
 Money CashDispenser::getAvailableCash() const {
-    return available_;
+    return planner_.total();
+}
+
+Money CashDispenser::getDepositBinCash() const {
+    return depositBin_;
+}
+
+void CashDispenser::setCashGauge(Gauge* gauge) {
+    cashGauge_ = gauge;
+    publish();
+}
+
+void CashDispenser::update() {
+    planner_.build(cassettes_);
+    publish();
+}
+
+void CashDispenser::publish() const {
+    if (cashGauge_) cashGauge_->set(getAvailableCash().getCents());
 }
 
 DepositSlot::DepositSlot(CashDispenser& disp) : dispenser_(disp) {}
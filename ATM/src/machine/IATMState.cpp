@@ -1,92 +1,145 @@
-// IATMState.cpp - State handlers: Idle, CardInserted, AskForPIN, and all other states.
+// IATMState.cpp - State handlers: Idle, CardInserted, AskForPIN, and all other states; StateSet.
 
-#include "atm/bank/Account.h"
+#include "atm/bank/AccountHandle.h"
+#include "atm/bank/AuthResult.h"
 #include "atm/bank/Bank.h"
+#include "atm/bank/Hashing.h"
 #include "atm/bank/Money.h"
 #include "atm/machine/ATM.h"
+#include "atm/machine/Hardware.h"
 #include "atm/machine/IATMState.h"
 #include "atm/machine/Logger.h"
 #include "atm/machine/MenuOption.h"
+#include "atm/machine/Metrics.h"
 #include "atm/machine/UserSession.h"
 
+#include <chrono>
+#include <optional>
+#include <thread>
+
 namespace atm {
 
 IATMState::IATMState(ATM* context) : atm_(context) {}
 
+void IATMState::enter() {
+    pendingCall_ = BankCallBase();
+    onEnter();
+}
+
+bool IATMState::isWaitingForBank() const {
+    return pendingCall_.valid() && !pendingCall_.ready();
+}
+
+void IATMState::waitForBank() const {
+    if (pendingCall_.valid()) {
+        pendingCall_.wait();
+    }
+}
+
+bool IATMState::awaitBank(const BankCallBase& call) {
+    if (call.ready()) {
+        return true;
+    }
+    if (!pendingCall_.sameRequest(call)) {
+        pendingCall_ = call;
+        call.onReady(atm_->bankReadyCallback());
+    }
+    return false;
+}
+
 // Idle and card handling.
 
-std::string IdleState::name() const { return "IdleState"; }
+std::string_view IdleState::name() const { return "IdleState"; }
 void IdleState::handle() {
     std::string cardNumber = atm_->getUI()->readCard();
     if (cardNumber.empty()) {
         return;
     }
     atm_->createSession(cardNumber);
-    atm_->setState(std::make_unique<CardInsertedState>(atm_));
+    atmMetrics().sessions.inc();
+    atm_->transition<kId, StateEvent::CardRead>();
 }
 
-std::string CardInsertedState::name() const { return "CardInsertedState"; }
+std::string_view CardInsertedState::name() const { return "CardInsertedState"; }
 void CardInsertedState::handle() {
-    if (atm_->getGateway()->checkIfCardExist(atm_->getSession()->getCardNumber())) {
-        atm_->setState(std::make_unique<AskForPINState>(atm_));
-    }
-    else {
-        atm_->setState(std::make_unique<CardNotExistInSystemState>(atm_));
-    }
+    // The card is checked together with the PIN (one bank round trip per login).
+    atm_->transition<kId, StateEvent::Next>();
 }
 
-std::string CardNotExistInSystemState::name() const { return "CardNotExistInSystemState"; }
+std::string_view CardNotExistInSystemState::name() const { return "CardNotExistInSystemState"; }
 void CardNotExistInSystemState::handle() {
-    std::string cardNumber = atm_->getSession()->getCardNumber();
+    const std::string& cardNumber = atm_->getSession()->getCardNumber();
     atm_->getUI()->showCardInsertedFailure(cardNumber);
-    atm_->setState(std::make_unique<EjectCardState>(atm_));
+    atm_->transition<kId, StateEvent::Next>();
 }
 
-std::string AskForPINState::name() const { return "AskForPINState"; }
+void AskForPINState::onEnter() { authCall_ = BankCall<AuthResult>(); }
+std::string_view AskForPINState::name() const { return "AskForPINState"; }
 void AskForPINState::handle() {
-    std::string pin = atm_->getUI()->readPin();
-    atm_->getSession()->setPin(pin);
-    if (atm_->getGateway()->checkPIN(pin, atm_->getSession()->getCardNumber())) {
-        atm_->setState(std::make_unique<SuccessfulPinState>(atm_));
+    if (!authCall_.valid()) {
+        std::string pin = atm_->getUI()->readPin();
+        atm_->getSession()->setPin(pin);
+        authCall_ = atm_->getGateway()->authenticateAsync(atm_->getSession()->getCardNumber(), pin);
+    }
+    if (!awaitBank(authCall_)) {
+        return;
+    }
+    AuthResult result = authCall_.get();
+    if (result.cardStatus != CardStatus::Active) {
+        atm_->transition<kId, StateEvent::CardRejected>();
+        return;
+    }
+    atm_->getSession()->setRemainingPinAttempts(result.remainingAttempts);
+    if (result.pinVerdict == PinVerdict::Accepted) {
+        atm_->getSession()->setAccounts(std::move(result.accounts));
+        atm_->transition<kId, StateEvent::PinAccepted>();
     }
     else {
-        atm_->setState(std::make_unique<UnsuccessfulPinState>(atm_));
+        atm_->transition<kId, StateEvent::PinRejected>();
     }
 }
 
-std::string SuccessfulPinState::name() const { return "SuccessfulPinState"; }
+std::string_view SuccessfulPinState::name() const { return "SuccessfulPinState"; }
 void SuccessfulPinState::handle() {
     atm_->getUI()->showPinAccepted(atm_->getSession()->getStoredPin());
     atm_->getSession()->setUserAuthenticated(true);
-    atm_->setState(std::make_unique<ChooseAccountState>(atm_));
+    atm_->transition<kId, StateEvent::Next>();
 }
 
-std::string UnsuccessfulPinState::name() const { return "UnsuccessfulPinState"; }
+std::string_view UnsuccessfulPinState::name() const { return "UnsuccessfulPinState"; }
 void UnsuccessfulPinState::handle() {
     atm_->getUI()->showPinRejected(atm_->getSession()->getStoredPin());
     atm_->getSession()->incrementUnsuccessfulPinCount();
-    if (atm_->getSession()->getUnsuccessfulPinCount() >= atm_->getConfig().maxPinAttempts) {
-        atm_->setState(std::make_unique<BlockCardState>(atm_));
+    atmMetrics().pinFailures.inc();
+    const std::optional<int> bankRemaining = atm_->getSession()->getRemainingPinAttempts();
+    if (atm_->getSession()->getUnsuccessfulPinCount() >= atm_->getConfig().maxPinAttempts ||
+        (bankRemaining && *bankRemaining <= 0)) {
+        atm_->transition<kId, StateEvent::AttemptsExhausted>();
     }
     else {
-        atm_->setState(std::make_unique<AskForPINState>(atm_));
+        atm_->transition<kId, StateEvent::Retry>();
     }
 }
 
-std::string BlockCardState::name() const { return "BlockCardState"; }
+void BlockCardState::onEnter() { blockCall_ = BankCall<bool>(); }
+std::string_view BlockCardState::name() const { return "BlockCardState"; }
 void BlockCardState::handle() {
-    std::string cardNumber = atm_->getSession()->getCardNumber();
-    Logger::log("Card blocked", cardNumber);
-    atm_->getUI()->showCardBlocked(cardNumber);
-    atm_->getGateway()->blockCard(cardNumber);
-    atm_->setState(std::make_unique<EjectCardState>(atm_));
+    const std::string& cardNumber = atm_->getSession()->getCardNumber();
+    if (!blockCall_.valid()) {
+        Logger::event<LogEventId::CardBlocked>(cardNumber);
+        atmMetrics().cardsBlocked.inc();
+        atm_->getUI()->showCardBlocked(cardNumber);
+        blockCall_ = atm_->getGateway()->blockCardAsync(cardNumber);
+    }
+    if (!awaitBank(blockCall_)) {
+        return;
+    }
+    atm_->transition<kId, StateEvent::Next>();
 }
 
-std::string ChooseAccountState::name() const { return "ChooseAccountState"; }
+std::string_view ChooseAccountState::name() const { return "ChooseAccountState"; }
 void ChooseAccountState::handle() {
-    std::string cardNumber = atm_->getSession()->getCardNumber();
-    std::vector<Account> accounts = atm_->getGateway()->getAccountListForCard(cardNumber);
-    atm_->getSession()->setAccounts(accounts);
+    // Accounts arrived with the authenticate response.
     std::vector<std::string> accountNames = atm_->getSession()->getAccountNames();
     const int count = static_cast<int>(accountNames.size());
     int accountIndex;
@@ -97,108 +150,241 @@ void ChooseAccountState::handle() {
         }
     } while (accountIndex < 1 || accountIndex > count);
     atm_->getSession()->setSelectedAccount(static_cast<size_t>(accountIndex - 1));
-    atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    atm_->transition<kId, StateEvent::AccountChosen>();
 }
 
-std::string ShowOptionsState::name() const { return "ShowOptionsState"; }
+std::string_view ShowOptionsState::name() const { return "ShowOptionsState"; }
 void ShowOptionsState::handle() {
     MenuOption option = atm_->getUI()->promptMenuOption();
     atm_->getUI()->showOptionSelected(option);
     atm_->getSession()->setSelectedOption(option);
-    atm_->setState(std::make_unique<DecideOptionState>(atm_));
+    atm_->transition<kId, StateEvent::OptionChosen>();
 }
 
-std::string DecideOptionState::name() const { return "DecideOptionState"; }
+std::string_view DecideOptionState::name() const { return "DecideOptionState"; }
 void DecideOptionState::handle() {
     switch (atm_->getSession()->getSelectedOption()) {
         case MenuOption::CheckBalance:
-            atm_->setState(std::make_unique<CheckBalanceState>(atm_));
+            atm_->transition<kId, StateEvent::BalanceChosen>();
             break;
         case MenuOption::Withdraw:
-            atm_->setState(std::make_unique<WithdrawFundsState>(atm_));
+            atm_->transition<kId, StateEvent::WithdrawChosen>();
             break;
         case MenuOption::Deposit:
-            atm_->setState(std::make_unique<DepositFundsState>(atm_));
+            atm_->transition<kId, StateEvent::DepositChosen>();
+            break;
+        case MenuOption::MiniStatement:
+            atm_->transition<kId, StateEvent::MiniStatementChosen>();
             break;
         case MenuOption::Exit:
-            atm_->setState(std::make_unique<ExitState>(atm_));
+            atm_->transition<kId, StateEvent::ExitChosen>();
             break;
     }
 }
 
-std::string CheckBalanceState::name() const { return "CheckBalanceState"; }
+void CheckBalanceState::onEnter() { balanceCall_ = BankCall<Money>(); }
+std::string_view CheckBalanceState::name() const { return "CheckBalanceState"; }
 void CheckBalanceState::handle() {
-    Account* account = atm_->getSession()->getSelectedAccount();
-    if (!account) {
-        atm_->getUI()->showInvalidAccountSelection();
-        atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    if (!balanceCall_.valid()) {
+        const AccountHandle* account = atm_->getSession()->getSelectedAccount();
+        if (!account) {
+            atm_->getUI()->showInvalidAccountSelection();
+            atm_->transition<kId, StateEvent::Done>();
+            return;
+        }
+        balanceCall_ = atm_->getGateway()->showBalanceAsync(account->id);
+    }
+    if (!awaitBank(balanceCall_)) {
         return;
     }
-    Money balance = atm_->getGateway()->showBalance(account);
-    atm_->getUI()->showBalance(balance);
-    atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    atm_->getUI()->showBalance(balanceCall_.get());
+    atm_->transition<kId, StateEvent::Done>();
 }
 
-std::string WithdrawFundsState::name() const { return "WithdrawFundsState"; }
+void WithdrawFundsState::onEnter() {
+    amount_ = Money();
+    account_ = kInvalidAccountId;
+    hold_ = kNoRequest;
+    reserveCall_ = BankCall<bool>();
+    commitCall_ = BankCall<std::optional<bool>>();
+    commitDeadline_ = {};
+    releaseCall_ = BankCall<bool>();
+}
+std::string_view WithdrawFundsState::name() const { return "WithdrawFundsState"; }
 void WithdrawFundsState::handle() {
-    Account* account = atm_->getSession()->getSelectedAccount();
-    if (!account) {
-        atm_->getUI()->showInvalidAccountSelection();
-        atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    if (!reserveCall_.valid()) {
+        const AccountHandle* account = atm_->getSession()->getSelectedAccount();
+        if (!account) {
+            atm_->getUI()->showInvalidAccountSelection();
+            atm_->transition<kId, StateEvent::Done>();
+            return;
+        }
+        amount_ = atm_->getUI()->promptWithdrawAmount();
+        const CashDispenser& dispenser = *atm_->getDispenser();
+        if (!dispenser.hasEnoughCash(amount_)) {
+            if (amount_.getCents() > 0 && amount_ <= dispenser.getAvailableCash()) {
+                // The cash is there but not in notes that add up to it; offer the nearest amounts.
+                Logger::event<LogEventId::AtmAmountNotDispensable>(amount_, kId);
+                atmMetrics().rejected(LogEventId::AtmAmountNotDispensable).inc();
+                atm_->getUI()->showDispensableAmounts(dispenser.nearestDispensableBelow(amount_),
+                                                      dispenser.nearestDispensableAbove(amount_));
+            }
+            else {
+                Logger::event<LogEventId::AtmCashShort>(kId, amount_);
+                atmMetrics().rejected(LogEventId::AtmCashShort).inc();
+                atm_->getUI()->showInsufficientAtmFunds();
+            }
+            atm_->transition<kId, StateEvent::Done>();
+            return;
+        }
+        // The bank only holds the funds; they are committed once the notes are out, or released
+        // if dispensing fails (and released by the bank anyway if neither arrives in time).
+        account_ = account->id;
+        hold_ = newRequestId();
+        reserveCall_ = atm_->getGateway()->reserveCashAsync(account_, amount_, atm_->getConfig().terminalId,
+                                                            cardHash(atm_->getSession()->getCardNumber()), hold_);
+    }
+    if (!awaitBank(reserveCall_)) {
         return;
     }
-    Money amount = atm_->getUI()->promptWithdrawAmount();
-    if (atm_->getDispenser()->hasEnoughCash(amount)) {
-        if (!atm_->getGateway()->withdrawCash(account, amount)) {
+    if (!commitCall_.valid() && !releaseCall_.valid()) {
+        if (!reserveCall_.get()) {
             atm_->getUI()->showInsufficientAccountFunds();
+            atm_->transition<kId, StateEvent::Done>();
+            return;
+        }
+        if (atm_->getDispenser()->dispense(amount_)) {
+            commitDeadline_ = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(atm_->getConfig().withdrawHoldTtlMs);
+            commitCall_ = atm_->getGateway()->commitCashAsync(hold_);
+            atm_->getUI()->showWithdrawAmount(amount_);
         }
         else {
-            atm_->getDispenser()->dispense(amount);
-            atm_->getUI()->showWithdrawAmount(amount);
+            Logger::event<LogEventId::AtmCashShort>(kId, amount_);
+            atmMetrics().rejected(LogEventId::AtmCashShort).inc();
+            releaseCall_ = atm_->getGateway()->releaseCashAsync(account_, hold_);
+            atm_->getUI()->showInsufficientAtmFunds();
         }
     }
-    else {
-        Logger::log("Withdraw failed", "insufficient ATM cash");
-        atm_->getUI()->showInsufficientAtmFunds();
+    if (releaseCall_.valid()) {
+        if (awaitBank(releaseCall_)) {
+            atm_->transition<kId, StateEvent::Done>();
+        }
+        return;
+    }
+    if (!awaitBank(commitCall_)) {
+        return;
+    }
+    const std::optional<bool> committed = commitCall_.get();
+    if (!committed && std::chrono::steady_clock::now() < commitDeadline_) {
+        // No answer, so the commit may not have reached the bank. The notes are out, so keep
+        // asking: a repeat of a commit that did run is answered true again.
+        std::this_thread::sleep_for(std::chrono::milliseconds(constants::kCommitRetryDelayMs));
+        commitCall_ = atm_->getGateway()->commitCashAsync(hold_);
+        return;
+    }
+    // The customer has the notes; if the bank released the funds (the hold expired) or never
+    // answered, only reconciliation can settle it now.
+    if (!committed) {
+        Logger::event<LogEventId::AtmCommitUnanswered>(hold_, account_, amount_);
+        atmMetrics().rejected(LogEventId::AtmCommitUnanswered).inc();
     }
-    atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    else if (!*committed) {
+        Logger::event<LogEventId::AtmCommitRefusedAfterDispense>(hold_, account_, amount_);
+        atmMetrics().rejected(LogEventId::AtmCommitRefusedAfterDispense).inc();
+    }
+    atm_->transition<kId, StateEvent::Done>();
 }
 
-std::string DepositFundsState::name() const { return "DepositFundsState"; }
+void DepositFundsState::onEnter() {
+    amount_ = Money();
+    depositCall_ = BankCall<bool>();
+}
+std::string_view DepositFundsState::name() const { return "DepositFundsState"; }
 void DepositFundsState::handle() {
-    Account* account = atm_->getSession()->getSelectedAccount();
-    if (!account) {
-        atm_->getUI()->showInvalidAccountSelection();
-        atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    if (!depositCall_.valid()) {
+        const AccountHandle* account = atm_->getSession()->getSelectedAccount();
+        if (!account) {
+            atm_->getUI()->showInvalidAccountSelection();
+            atm_->transition<kId, StateEvent::Done>();
+            return;
+        }
+        amount_ = atm_->getUI()->promptDepositAmount();
+        depositCall_ = atm_->getGateway()->depositCashAsync(account->id, amount_, atm_->getConfig().terminalId,
+                                                            newRequestId());
+    }
+    if (!awaitBank(depositCall_)) {
         return;
     }
-    Money amount = atm_->getUI()->promptDepositAmount();
-    if (!atm_->getGateway()->depositCash(account, amount)) {
+    if (!depositCall_.get()) {
         atm_->getUI()->showDepositRejected();
     }
     else {
-        atm_->getDepositSlot()->processDeposit(amount);
+        atm_->getDepositSlot()->processDeposit(amount_);
         atm_->getUI()->showDepositSuccess();
     }
-    atm_->setState(std::make_unique<ShowOptionsState>(atm_));
+    atm_->transition<kId, StateEvent::Done>();
 }
 
-std::string ExitState::name() const { return "ExitState"; }
+void MiniStatementState::onEnter() { statementCall_ = BankCall<std::vector<HistoryEntry>>(); }
+std::string_view MiniStatementState::name() const { return "MiniStatementState"; }
+void MiniStatementState::handle() {
+    if (!statementCall_.valid()) {
+        const AccountHandle* account = atm_->getSession()->getSelectedAccount();
+        if (!account) {
+            atm_->getUI()->showInvalidAccountSelection();
+            atm_->transition<kId, StateEvent::Done>();
+            return;
+        }
+        statementCall_ = atm_->getGateway()->getMiniStatementAsync(account->id, atm_->getConfig().miniStatementEntries);
+    }
+    if (!awaitBank(statementCall_)) {
+        return;
+    }
+    atm_->getUI()->showMiniStatement(statementCall_.get());
+    atm_->transition<kId, StateEvent::Done>();
+}
+
+std::string_view ExitState::name() const { return "ExitState"; }
 void ExitState::handle() {
-    atm_->setState(std::make_unique<EjectCardState>(atm_));
+    atm_->transition<kId, StateEvent::Next>();
 }
 
-std::string EjectCardState::name() const { return "EjectCardState"; }
+std::string_view EjectCardState::name() const { return "EjectCardState"; }
 void EjectCardState::handle() {
-    std::string cardNumber = atm_->getSession()->getCardNumber();
+    const std::string& cardNumber = atm_->getSession()->getCardNumber();
     atm_->getUI()->showCardEjected(cardNumber);
-    atm_->setState(std::make_unique<ResetState>(atm_));
+    atm_->transition<kId, StateEvent::Next>();
 }
 
-std::string ResetState::name() const { return "ResetState"; }
+std::string_view ResetState::name() const { return "ResetState"; }
 void ResetState::handle() {
     atm_->resetSession();
-    atm_->setState(std::make_unique<IdleState>(atm_));
+    atm_->transition<kId, StateEvent::Next>();
 }
 
+StateSet::StateSet(ATM* context)
+    : idle_(context),
+      cardInserted_(context),
+      cardNotExistInSystem_(context),
+      askForPin_(context),
+      successfulPin_(context),
+      unsuccessfulPin_(context),
+      blockCard_(context),
+      chooseAccount_(context),
+      showOptions_(context),
+      decideOption_(context),
+      checkBalance_(context),
+      withdrawFunds_(context),
+      depositFunds_(context),
+      miniStatement_(context),
+      exit_(context),
+      ejectCard_(context),
+      reset_(context),
+      table_{&idle_,          &cardInserted_,    &cardNotExistInSystem_, &askForPin_,
+             &successfulPin_, &unsuccessfulPin_, &blockCard_,            &chooseAccount_,
+             &showOptions_,   &decideOption_,    &checkBalance_,         &withdrawFunds_,
+             &depositFunds_,  &miniStatement_,   &exit_,                 &ejectCard_,
+             &reset_} {}
+
 }  // namespace atm
@@ -0,0 +1,94 @@
+// LatencyHistogram.cpp - Bucket mapping, merging and percentile queries.
+
+#include "atm/machine/LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace atm {
+
+namespace {
+
+constexpr std::uint64_t kSubBuckets = 1u << LatencyHistogram::kSubBucketBits;
+
+}  // namespace
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t value) {
+    // Values below 2 * kSubBuckets map one to one; above, each power of two [2^m, 2^(m+1))
+    // is split into kSubBuckets equal slices.
+    if (value < 2 * kSubBuckets) {
+        return static_cast<std::size_t>(value);
+    }
+    const unsigned magnitude = static_cast<unsigned>(std::bit_width(value)) - 1;
+    const unsigned shift = magnitude - kSubBucketBits;
+    return static_cast<std::size_t>((shift * kSubBuckets) + (value >> shift));
+}
+
+std::uint64_t LatencyHistogram::bucketLowerBound(std::size_t bucket) {
+    if (bucket < 2 * kSubBuckets) {
+        return bucket;
+    }
+    const std::uint64_t shift = bucket / kSubBuckets - 1;
+    const std::uint64_t subBucket = bucket % kSubBuckets + kSubBuckets;
+    return subBucket << shift;
+}
+
+void LatencyHistogram::record(std::uint64_t nanoseconds) {
+    buckets_[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+    std::uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (seen < nanoseconds && !max_.compare_exchange_weak(seen, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        const std::uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+        if (n != 0) buckets_[i].fetch_add(n, std::memory_order_relaxed);
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    const std::uint64_t otherMax = other.max_.load(std::memory_order_relaxed);
+    std::uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (seen < otherMax && !max_.compare_exchange_weak(seen, otherMax, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    const std::uint64_t total = count();
+    if (total == 0) return 0;
+    const auto rank = static_cast<std::uint64_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // Report the bucket's upper edge, but never more than the largest value seen.
+            const std::uint64_t upper = i + 1 < kBucketCount ? bucketLowerBound(i + 1) - 1 : ~std::uint64_t{0};
+            return std::min(upper, max_.load(std::memory_order_relaxed));
+        }
+    }
+    return max_.load(std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::summary() const {
+    LatencySummary summary;
+    summary.count = count();
+    if (summary.count == 0) return summary;
+    summary.meanUs = static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(summary.count) / 1000.0;
+    summary.p50Us = static_cast<double>(percentile(0.50)) / 1000.0;
+    summary.p90Us = static_cast<double>(percentile(0.90)) / 1000.0;
+    summary.p99Us = static_cast<double>(percentile(0.99)) / 1000.0;
+    summary.p999Us = static_cast<double>(percentile(0.999)) / 1000.0;
+    summary.maxUs = static_cast<double>(max_.load(std::memory_order_relaxed)) / 1000.0;
+    return summary;
+}
+
+}  // namespace atm
@@ -0,0 +1,231 @@
+// LogEvents.cpp - Event log segment headers, record decoding, text/JSON formatting, file replay.
+
+#include "atm/machine/LogEvents.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace atm {
+
+namespace {
+
+bool getVarint(std::string_view& in, std::uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (in.empty()) return false;
+        const auto byte = static_cast<unsigned char>(in.front());
+        in.remove_prefix(1);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool getText(std::string_view& in, std::string& out) {
+    std::uint64_t length = 0;
+    if (!getVarint(in, length) || length > in.size()) return false;
+    out.assign(in.substr(0, static_cast<std::size_t>(length)));
+    in.remove_prefix(static_cast<std::size_t>(length));
+    return true;
+}
+
+void appendVarint(std::string& out, std::uint64_t value) {
+    char buffer[10];
+    out.append(buffer, static_cast<std::size_t>(detail::putVarint(buffer, value) - buffer));
+}
+
+void putText(std::string& out, std::string_view text) {
+    appendVarint(out, text.size());
+    out += text;
+}
+
+void appendArg(std::string& out, LogArg kind, std::int64_t value) {
+    char buffer[32];
+    switch (kind) {
+        case LogArg::Card:
+            std::snprintf(buffer, sizeof(buffer), "%016" PRIx64, static_cast<std::uint64_t>(value));
+            out += buffer;
+            return;
+        case LogArg::State:
+            out += value >= 0 && static_cast<std::uint64_t>(value) < kStateCount
+                       ? stateIdName(static_cast<StateId>(value))
+                       : std::string_view("?");
+            return;
+        case LogArg::UInt:
+            std::snprintf(buffer, sizeof(buffer), "%" PRIu64, static_cast<std::uint64_t>(value));
+            out += buffer;
+            return;
+        case LogArg::Int:
+        case LogArg::None:
+            break;
+    }
+    std::snprintf(buffer, sizeof(buffer), "%" PRId64, value);
+    out += buffer;
+}
+
+// Calls text(literal) for the text between placeholders and arg(name, index) for each placeholder.
+template <typename TextFn, typename ArgFn>
+void expandFormat(std::string_view format, TextFn&& text, ArgFn&& arg) {
+    std::size_t index = 0;
+    while (!format.empty()) {
+        const std::size_t open = format.find('{');
+        text(format.substr(0, open));
+        if (open == std::string_view::npos) return;
+        const std::size_t close = format.find('}', open);
+        arg(format.substr(open + 1, close - open - 1), index++);
+        format.remove_prefix(close + 1);
+    }
+}
+
+// Reads id, time and arguments of one record; the info is looked up by catalog.
+bool decodeRecord(std::string_view& in, std::uint64_t wireId, const std::vector<LogEventInfo>& catalog,
+                  std::uint64_t& steadyNs, DecodedLogEvent& event) {
+    if (wireId == 0 || wireId > catalog.size()) return false;
+    event.info = &catalog[static_cast<std::size_t>(wireId - 1)];
+    if (!getVarint(in, steadyNs)) return false;
+    for (std::size_t i = 0; i < event.info->argCount; ++i) {
+        std::uint64_t value = 0;
+        if (!getVarint(in, value)) return false;
+        event.args[i] = static_cast<std::int64_t>(detail::unzigzag(value));
+    }
+    return true;
+}
+
+const std::vector<LogEventInfo>& compiledCatalog() {
+    // Never destroyed: the logger's writer thread may still format events during static destruction.
+    static const std::vector<LogEventInfo>* catalog = [] {
+        auto* infos = new std::vector<LogEventInfo>();
+        for (const LogEventFormat& format : kLogEvents) {
+            LogEventInfo info;
+            info.name = format.name;
+            info.format = format.format;
+            info.args = format.args;
+            info.argCount = static_cast<std::size_t>(detail::countArgs(format.args));
+            infos->push_back(std::move(info));
+        }
+        return infos;
+    }();
+    return *catalog;
+}
+
+void appendLogEvent(std::string& out, const DecodedLogEvent& event) {
+    expandFormat(
+        event.info->format, [&](std::string_view text) { out += text; },
+        [&](std::string_view, std::size_t arg) {
+            if (arg < event.info->argCount) appendArg(out, event.info->args[arg], event.args[arg]);
+        });
+}
+
+}  // namespace
+
+std::string logEventSegmentHeader(std::uint64_t steadyNs, std::int64_t unixNs) {
+    std::string out;
+    appendVarint(out, 0);
+    appendVarint(out, steadyNs);
+    appendVarint(out, detail::zigzag(static_cast<std::uint64_t>(unixNs)));
+    appendVarint(out, kLogEventCount);
+    for (const LogEventFormat& format : kLogEvents) {
+        putText(out, format.name);
+        putText(out, format.format);
+        const auto argCount = static_cast<std::size_t>(detail::countArgs(format.args));
+        appendVarint(out, argCount);
+        for (std::size_t i = 0; i < argCount; ++i) out += static_cast<char>(format.args[i]);
+    }
+    return out;
+}
+
+std::string formatLogEvent(const DecodedLogEvent& event) {
+    std::string out;
+    appendLogEvent(out, event);
+    return out;
+}
+
+std::string logEventJson(const DecodedLogEvent& event) {
+    std::string out = "{\"unix_ns\":";
+    out += std::to_string(event.unixNs);
+    out += ",\"event\":\"";
+    out += event.info->name;
+    out += '"';
+    expandFormat(
+        event.info->format, [](std::string_view) {},
+        [&](std::string_view name, std::size_t arg) {
+            if (arg >= event.info->argCount) return;
+            out += ",\"";
+            out += name;
+            out += "\":";
+            const bool quoted = event.info->args[arg] != LogArg::Int && event.info->args[arg] != LogArg::UInt;
+            if (quoted) out += '"';
+            appendArg(out, event.info->args[arg], event.args[arg]);
+            if (quoted) out += '"';
+        });
+    out += '}';
+    return out;
+}
+
+bool formatLogEventRecord(std::string_view record, std::string& out) {
+    std::uint64_t wireId = 0;
+    std::uint64_t steadyNs = 0;
+    DecodedLogEvent event;
+    if (!getVarint(record, wireId) || !decodeRecord(record, wireId, compiledCatalog(), steadyNs, event)) {
+        return false;
+    }
+    appendLogEvent(out, event);
+    return true;
+}
+
+bool replayLogEvents(const std::string& path, const std::function<void(const DecodedLogEvent&)>& fn,
+                     std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string_view in(bytes);
+    if (in.substr(0, kLogEventMagic.size()) != kLogEventMagic) {
+        if (error) *error = path + " is not an event log";
+        return false;
+    }
+    in.remove_prefix(kLogEventMagic.size());
+
+    std::vector<LogEventInfo> catalog;
+    std::uint64_t steadyBase = 0;
+    std::int64_t unixBase = 0;
+    while (!in.empty()) {
+        std::uint64_t wireId = 0;
+        if (!getVarint(in, wireId)) break;
+        if (wireId == 0) {
+            // Segment header: the logger was (re)configured; new clock bases and catalog.
+            std::uint64_t unixZigzag = 0;
+            std::uint64_t count = 0;
+            if (!getVarint(in, steadyBase) || !getVarint(in, unixZigzag) || !getVarint(in, count)) break;
+            unixBase = static_cast<std::int64_t>(detail::unzigzag(unixZigzag));
+            catalog.clear();
+            bool ok = true;
+            for (std::uint64_t i = 0; ok && i < count; ++i) {
+                LogEventInfo info;
+                std::uint64_t argCount = 0;
+                ok = getText(in, info.name) && getText(in, info.format) && getVarint(in, argCount) &&
+                     argCount <= kMaxLogArgs && argCount <= in.size();
+                if (!ok) break;
+                info.argCount = static_cast<std::size_t>(argCount);
+                for (std::size_t a = 0; a < info.argCount; ++a) info.args[a] = static_cast<LogArg>(in[a]);
+                in.remove_prefix(info.argCount);
+                catalog.push_back(std::move(info));
+            }
+            if (!ok) break;
+            continue;
+        }
+        DecodedLogEvent event;
+        std::uint64_t steadyNs = 0;
+        if (!decodeRecord(in, wireId, catalog, steadyNs, event)) break;
+        event.unixNs = unixBase + static_cast<std::int64_t>(steadyNs - steadyBase);
+        fn(event);
+    }
+    return true;
+}
+
+}  // namespace atm
@@ -0,0 +1,463 @@
+// Logger.cpp - Per-thread log rings, the background writer that drains them, and the synchronous fallback.
+
+#include "atm/machine/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace atm {
+
+namespace {
+
+constexpr std::string_view kPrefix = "[ATM] ";
+constexpr std::string_view kEllipsis = "...";
+
+// A message longer than kLogLineMax takes several consecutive records; all but the last
+// have continues set. They are pushed together, so the writer always sees the whole message.
+// An event record holds the bytes of encodeLogEvent instead of text.
+struct LogRecord {
+    std::uint16_t length = 0;
+    bool truncated = false;
+    bool continues = false;
+    bool event = false;
+    char text[kLogLineMax];
+};
+
+std::size_t recordsFor(std::string_view text) {
+    return text.empty() ? 1 : (text.size() + kLogLineMax - 1) / kLogLineMax;
+}
+
+// Single-producer single-consumer ring of fixed-size records. The owning thread pushes; the
+// writer thread drains. head_ and tail_ only grow; slot = index & mask_.
+class LogRing {
+public:
+    explicit LogRing(std::size_t capacity) : mask_(capacity - 1), slots_(new LogRecord[capacity]) {}
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // Producer side: queues text as `records` records. Returns false if they do not fit.
+    bool tryPush(std::string_view text, bool truncated, bool event, std::size_t records) {
+        const std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail + records - cachedHead_ > capacity()) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail + records - cachedHead_ > capacity()) return false;
+        }
+        for (std::size_t i = 0; i < records; ++i) {
+            LogRecord& record = slots_[(tail + i) & mask_];
+            record.length = static_cast<std::uint16_t>(text.substr(i * kLogLineMax).copy(record.text, kLogLineMax));
+            record.continues = i + 1 < records;
+            record.truncated = truncated && !record.continues;
+            record.event = event;
+        }
+        tail_.store(tail + records, std::memory_order_release);
+        return true;
+    }
+    // Producer side: lines queued and not yet drained (may be stale).
+    std::size_t pending() const {
+        return static_cast<std::size_t>(tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed));
+    }
+
+    // Consumer side. Calls fn for every queued record, oldest first.
+    template <typename Fn>
+    void drain(Fn&& fn) {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+        for (; head != tail; ++head) fn(slots_[head & mask_]);
+        head_.store(tail, std::memory_order_release);
+    }
+    bool empty() const { return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire); }
+
+    // Set by the owner while it is inside a push, so shutdown can wait for pushes in flight.
+    std::atomic<bool> busy{false};
+    // Set when the owning thread exits; the writer drops the ring once it is empty.
+    std::atomic<bool> orphaned{false};
+
+private:
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    std::uint64_t cachedHead_ = 0;  // producer's last view of head_
+    std::size_t mask_;
+    std::unique_ptr<LogRecord[]> slots_;
+};
+
+// Marks the thread's ring orphaned when the thread exits.
+struct ThreadRing {
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRing() {
+        if (ring) ring->orphaned.store(true, std::memory_order_release);
+    }
+};
+
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 2;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+class LogBackend {
+public:
+    // Never destroyed: threads and static destructors may log during exit.
+    static LogBackend& instance() {
+        static LogBackend* backend = new LogBackend();
+        return *backend;
+    }
+
+    void write(std::string_view text, bool truncated, bool event) {
+        if (!async_.load(std::memory_order_acquire)) {
+            if (!wantAsync_.load(std::memory_order_acquire) || !start()) {
+                writeNow(text, truncated, event);
+                return;
+            }
+        }
+        LogRing& ring = threadRing();
+        const std::size_t records = recordsFor(text);
+        if (records > ring.capacity()) {
+            // Can never fit: write it here, after what this thread has queued.
+            flush();
+            writeNow(text, truncated, event);
+            return;
+        }
+        ring.busy.store(true, std::memory_order_seq_cst);
+        if (!async_.load(std::memory_order_seq_cst)) {
+            // shutdown() began; it no longer waits for this ring.
+            ring.busy.store(false, std::memory_order_release);
+            writeNow(text, truncated, event);
+            return;
+        }
+        while (!ring.tryPush(text, truncated, event, records)) {
+            if (overflow_.load(std::memory_order_relaxed) == LogOverflow::Drop) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            wakeWriter();
+            std::this_thread::yield();
+        }
+        ring.busy.store(false, std::memory_order_release);
+        if (ring.pending() * 2 >= ring.capacity()) wakeWriter();
+    }
+
+    bool configure(const LoggerConfig& config, std::string* error) {
+        std::FILE* file = nullptr;
+        if (!config.path.empty()) {
+            file = std::fopen(config.path.c_str(), "ab");
+            if (!file) {
+                if (error) *error = "cannot open " + config.path;
+                return false;
+            }
+        }
+        std::FILE* eventFile = nullptr;
+        if (!config.eventPath.empty()) {
+            eventFile = std::fopen(config.eventPath.c_str(), "ab");
+            if (!eventFile) {
+                if (file) std::fclose(file);
+                if (error) *error = "cannot open " + config.eventPath;
+                return false;
+            }
+        }
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex_);
+            if (sink_ != stderr) std::fclose(sink_);
+            sink_ = file ? file : stderr;
+            if (eventSink_) std::fclose(eventSink_);
+            eventSink_ = eventFile;
+            if (eventSink_) startEventSegment();
+        }
+        ringCapacity_.store(roundUpToPowerOfTwo(config.ringCapacity), std::memory_order_relaxed);
+        overflow_.store(config.overflow, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            interval_ = std::max(config.flushInterval, std::chrono::milliseconds(1));
+        }
+        wantAsync_.store(config.async, std::memory_order_release);
+        if (!config.async) stopLocked();
+        return true;
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (running_) {
+            const std::uint64_t ticket = ++flushRequested_;
+            wake_.notify_one();
+            flushed_.wait(lock, [&] { return flushDone_ >= ticket || !running_; });
+            return;
+        }
+        lock.unlock();
+        std::lock_guard<std::mutex> sinkLock(sinkMutex_);
+        std::fflush(sink_);
+        if (eventSink_) std::fflush(eventSink_);
+    }
+
+    void shutdown() {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        wantAsync_.store(false, std::memory_order_release);
+        stopLocked();
+    }
+
+    LoggerStats stats() const {
+        return LoggerStats{written_.load(std::memory_order_relaxed), dropped_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    LogBackend() = default;
+
+    LogRing& threadRing() {
+        thread_local ThreadRing local;
+        if (!local.ring) {
+            local.ring = std::make_shared<LogRing>(ringCapacity_.load(std::memory_order_relaxed));
+            std::lock_guard<std::mutex> lock(mutex_);
+            rings_.push_back(local.ring);
+        }
+        return *local.ring;
+    }
+
+    // Starts the writer if it is not running; false if logging went synchronous meanwhile.
+    bool start() {
+        std::lock_guard<std::mutex> lifecycle(lifecycleMutex_);
+        if (!wantAsync_.load(std::memory_order_acquire)) return false;
+        if (async_.load(std::memory_order_relaxed)) return true;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = false;
+            running_ = true;
+        }
+        thread_ = std::thread([this] { run(); });
+        async_.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Stops the writer after it has written everything queued. Caller holds lifecycleMutex_.
+    void stopLocked() {
+        if (!async_.load(std::memory_order_relaxed)) return;
+        async_.store(false, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        thread_.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        flushed_.notify_all();
+    }
+
+    // Writes the magic (new file) and a segment header to eventSink_. Caller holds sinkMutex_.
+    void startEventSegment() {
+        std::fseek(eventSink_, 0, SEEK_END);
+        if (std::ftell(eventSink_) == 0) std::fwrite(kLogEventMagic.data(), 1, kLogEventMagic.size(), eventSink_);
+        // Events carry steady-clock times; the header ties them to the wall clock.
+        const auto sinceEpochNs = [](auto timePoint) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count();
+        };
+        const std::string header =
+            logEventSegmentHeader(static_cast<std::uint64_t>(sinceEpochNs(std::chrono::steady_clock::now())),
+                                  static_cast<std::int64_t>(sinceEpochNs(std::chrono::system_clock::now())));
+        std::fwrite(header.data(), 1, header.size(), eventSink_);
+        std::fflush(eventSink_);
+    }
+
+    void wakeWriter() {
+        if (!wakeRequested_.exchange(true, std::memory_order_acq_rel)) wake_.notify_one();
+    }
+
+    void writeNow(std::string_view text, bool truncated, bool event) {
+        std::string eventText;
+        if (event) {
+            std::lock_guard<std::mutex> lock(sinkMutex_);
+            if (eventSink_) {
+                std::fwrite(text.data(), 1, text.size(), eventSink_);
+                std::fflush(eventSink_);
+                written_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if (event) {
+            if (!formatLogEventRecord(text, eventText)) return;
+            text = eventText;
+        }
+        std::lock_guard<std::mutex> lock(sinkMutex_);
+        std::fwrite(kPrefix.data(), 1, kPrefix.size(), sink_);
+        std::fwrite(text.data(), 1, text.size(), sink_);
+        if (truncated) std::fwrite(kEllipsis.data(), 1, kEllipsis.size(), sink_);
+        std::fputc('\n', sink_);
+        std::fflush(sink_);
+        written_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void run() {
+        Batch batch;
+        batch.text.reserve(64 * 1024);
+        std::vector<std::shared_ptr<LogRing>> rings;
+        while (true) {
+            std::uint64_t ticket = 0;
+            bool stopping = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait_for(lock, interval_, [&] {
+                    return stop_ || flushRequested_ != flushDone_ || wakeRequested_.load(std::memory_order_acquire);
+                });
+                wakeRequested_.store(false, std::memory_order_relaxed);
+                ticket = flushRequested_;
+                stopping = stop_;
+                rings = rings_;
+            }
+            drainAll(rings, batch);
+            if (stopping) {
+                // No new pushes start now; wait for the ones in flight (Block may be waiting on us).
+                while (std::any_of(rings.begin(), rings.end(), [](const auto& ring) {
+                    return ring->busy.load(std::memory_order_acquire) || !ring->empty();
+                })) {
+                    drainAll(rings, batch);
+                    std::this_thread::yield();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                            [](const auto& ring) {
+                                                return ring->orphaned.load(std::memory_order_acquire) &&
+                                                       ring->empty();
+                                            }),
+                             rings_.end());
+                flushDone_ = ticket;
+            }
+            flushed_.notify_all();
+            if (stopping) return;
+        }
+    }
+
+    struct Batch {
+        std::string text;
+        std::string events;
+    };
+
+    // Writes every queued line and event plus a note about drops since the last batch. Events
+    // go to the event file raw, or are formatted into text lines here if there is none.
+    void drainAll(const std::vector<std::shared_ptr<LogRing>>& rings, Batch& batch) {
+        bool binaryEvents = false;
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex_);
+            binaryEvents = eventSink_ != nullptr;
+        }
+        std::size_t lines = 0;
+        for (const auto& ring : rings) {
+            bool startOfLine = true;
+            ring->drain([&](const LogRecord& record) {
+                const std::string_view bytes(record.text, record.length);
+                if (record.event) {
+                    if (binaryEvents) {
+                        batch.events += bytes;
+                        ++lines;
+                        return;
+                    }
+                    batch.text += kPrefix;
+                    if (formatLogEventRecord(bytes, batch.text)) {
+                        batch.text += '\n';
+                        ++lines;
+                    }
+                    else {
+                        batch.text.resize(batch.text.size() - kPrefix.size());
+                    }
+                    return;
+                }
+                if (startOfLine) batch.text += kPrefix;
+                batch.text += bytes;
+                if (record.truncated) batch.text += kEllipsis;
+                startOfLine = !record.continues;
+                if (startOfLine) {
+                    batch.text += '\n';
+                    ++lines;
+                }
+            });
+        }
+        const std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != droppedReported_) {
+            batch.text += kPrefix;
+            batch.text += "Log lines dropped: " + std::to_string(dropped - droppedReported_) + '\n';
+            droppedReported_ = dropped;
+        }
+        if (batch.text.empty() && batch.events.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex_);
+            if (!batch.text.empty()) {
+                std::fwrite(batch.text.data(), 1, batch.text.size(), sink_);
+                std::fflush(sink_);
+            }
+            if (!batch.events.empty() && eventSink_) {
+                std::fwrite(batch.events.data(), 1, batch.events.size(), eventSink_);
+                std::fflush(eventSink_);
+            }
+        }
+        written_.fetch_add(lines, std::memory_order_relaxed);
+        batch.text.clear();
+        batch.events.clear();
+    }
+
+    std::mutex lifecycleMutex_;  // serialises start, configure and shutdown
+    std::thread thread_;
+    std::atomic<bool> async_{false};     // writer running and accepting pushes
+    std::atomic<bool> wantAsync_{true};  // start the writer on the next log()
+
+    std::mutex mutex_;  // guards the members below
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::chrono::milliseconds interval_{5};
+    bool running_ = false;
+    bool stop_ = false;
+    std::uint64_t flushRequested_ = 0;
+    std::uint64_t flushDone_ = 0;
+
+    std::mutex sinkMutex_;
+    std::FILE* sink_ = stderr;
+    std::FILE* eventSink_ = nullptr;
+
+    std::atomic<bool> wakeRequested_{false};
+    std::atomic<std::size_t> ringCapacity_{256};
+    std::atomic<LogOverflow> overflow_{LogOverflow::Drop};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+    std::uint64_t droppedReported_ = 0;  // writer thread only
+};
+
+// Writes what is still queued when the process exits normally.
+struct ShutdownAtExit {
+    ~ShutdownAtExit() { Logger::shutdown(); }
+} shutdownAtExit;
+
+}  // namespace
+
+void Logger::write(std::string_view line, bool truncated) {
+    LogBackend::instance().write(line, truncated, false);
+}
+
+void Logger::writeEvent(std::string_view record) {
+    LogBackend::instance().write(record, false, true);
+}
+
+bool Logger::configure(const LoggerConfig& config, std::string* error) {
+    return LogBackend::instance().configure(config, error);
+}
+
+void Logger::flush() {
+    LogBackend::instance().flush();
+}
+
+void Logger::shutdown() {
+    LogBackend::instance().shutdown();
+}
+
+LoggerStats Logger::stats() {
+    return LogBackend::instance().stats();
+}
+
+}  // namespace atm
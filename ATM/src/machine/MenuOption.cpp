@@ -7,6 +7,7 @@ namespace atm {
 static const char* const LABEL_CHECK_BALANCE = "check_balance";
 static const char* const LABEL_WITHDRAW = "withdraw";
 static const char* const LABEL_DEPOSIT = "deposit";
+static const char* const LABEL_MINI_STATEMENT = "mini_statement";
 static const char* const LABEL_EXIT = "exit";
 
 std::string MenuOptionHelper::toString(MenuOption option) {
@@ -17,6 +18,8 @@ std::string MenuOptionHelper::toString(MenuOption option) {
             return LABEL_WITHDRAW;
         case MenuOption::Deposit:
             return LABEL_DEPOSIT;
+        case MenuOption::MiniStatement:
+            return LABEL_MINI_STATEMENT;
         case MenuOption::Exit:
             return LABEL_EXIT;
     }
@@ -27,6 +30,7 @@ std::optional<MenuOption> MenuOptionHelper::parse(const std::string& input) {
     if (input == LABEL_CHECK_BALANCE) return MenuOption::CheckBalance;
     if (input == LABEL_WITHDRAW) return MenuOption::Withdraw;
     if (input == LABEL_DEPOSIT) return MenuOption::Deposit;
+    if (input == LABEL_MINI_STATEMENT) return MenuOption::MiniStatement;
     if (input == LABEL_EXIT) return MenuOption::Exit;
     return std::nullopt;
 }
@@ -36,6 +40,7 @@ std::vector<std::string> MenuOptionHelper::labels() {
         LABEL_CHECK_BALANCE,
         LABEL_WITHDRAW,
         LABEL_DEPOSIT,
+        LABEL_MINI_STATEMENT,
         LABEL_EXIT
     };
 }
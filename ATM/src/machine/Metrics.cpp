@@ -0,0 +1,192 @@
+// Metrics.cpp - Counter sums, registry lookup, Prometheus rendering, ATM metric names, text-file exporter.
+
+#include "atm/machine/Metrics.h"
+#include "atm/machine/Logger.h"
+
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace atm {
+
+namespace {
+
+void appendEscaped(std::string& out, std::string_view text, bool quotes) {
+    for (char c : text) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else if (c == '"' && quotes) out += "\\\"";
+        else out += c;
+    }
+}
+
+void appendSeries(std::string& out, const std::string& name, const MetricLabels& labels) {
+    out += name;
+    if (labels.empty()) return;
+    out += '{';
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        if (i) out += ',';
+        out += labels[i].first;
+        out += "=\"";
+        appendEscaped(out, labels[i].second, true);
+        out += '"';
+    }
+    out += '}';
+}
+
+}  // namespace
+
+std::size_t detail::nextMetricShard() {
+    static std::atomic<std::size_t> next{0};
+    return next.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+}
+
+std::uint64_t Counter::value() const {
+    std::uint64_t sum = 0;
+    for (const Shard& shard : shards_) sum += shard.value.load(std::memory_order_relaxed);
+    return sum;
+}
+
+MetricsRegistry::Series& MetricsRegistry::find(std::string_view name, std::string_view help, Kind kind,
+                                               MetricLabels&& labels) {
+    Family* family = nullptr;
+    for (const auto& candidate : families_) {
+        if (candidate->name == name) {
+            family = candidate.get();
+            break;
+        }
+    }
+    if (!family) {
+        families_.push_back(std::make_unique<Family>(Family{std::string(name), std::string(help), kind, {}}));
+        family = families_.back().get();
+    }
+    assert(family->kind == kind && "metric name registered as both counter and gauge");
+    for (Series& series : family->series) {
+        if (series.labels == labels) return series;
+    }
+    Series series;
+    series.labels = std::move(labels);
+    if (kind == Kind::Counter) series.counter = std::make_unique<Counter>();
+    else series.gauge = std::make_unique<Gauge>();
+    family->series.push_back(std::move(series));
+    return family->series.back();
+}
+
+Counter& MetricsRegistry::counter(std::string_view name, std::string_view help, MetricLabels labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *find(name, help, Kind::Counter, std::move(labels)).counter;
+}
+
+Gauge& MetricsRegistry::gauge(std::string_view name, std::string_view help, MetricLabels labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *find(name, help, Kind::Gauge, std::move(labels)).gauge;
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    std::string out;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& family : families_) {
+        out += "# HELP ";
+        out += family->name;
+        out += ' ';
+        appendEscaped(out, family->help, false);
+        out += "\n# TYPE ";
+        out += family->name;
+        out += family->kind == Kind::Counter ? " counter\n" : " gauge\n";
+        for (const Series& series : family->series) {
+            appendSeries(out, family->name, series.labels);
+            out += ' ';
+            out += series.counter ? std::to_string(series.counter->value()) : std::to_string(series.gauge->value());
+            out += '\n';
+        }
+    }
+    return out;
+}
+
+bool MetricsRegistry::writeTextFile(const std::string& path, std::string* error) const {
+    const std::string text = renderPrometheus();
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.write(text.data(), static_cast<std::streamsize>(text.size())) || !out.flush()) {
+            if (error) *error = "cannot write " + temp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        if (error) *error = "cannot rename " + temp + " to " + path + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry* registry = new MetricsRegistry();  // never destroyed: used until exit
+    return *registry;
+}
+
+AtmMetrics::AtmMetrics(MetricsRegistry& registry)
+    : sessions(registry.counter("atm_sessions_total", "Cards accepted by the card reader.")),
+      pinFailures(registry.counter("atm_pin_failures_total", "Wrong PINs entered.")),
+      cardsBlocked(registry.counter("atm_cards_blocked_total", "Cards blocked after too many wrong PINs.")),
+      withdrawals(registry.counter("atm_withdrawals_total", "Successful withdrawals.")),
+      withdrawnCents(registry.counter("atm_withdrawn_cents_total", "Cents paid out by successful withdrawals.")),
+      deposits(registry.counter("atm_deposits_total", "Successful deposits.")),
+      depositedCents(registry.counter("atm_deposited_cents_total", "Cents credited by successful deposits.")),
+      requestRepeats(registry.counter("atm_request_repeats_total",
+                                      "Retried withdrawals and deposits answered from the dedupe table.")),
+      holdsExpired(registry.counter("atm_withdraw_holds_expired_total",
+                                    "Withdrawal holds released because no commit came in time or a restart left them open.")),
+      cashAvailable(registry.gauge("atm_cash_available_cents", "Cash left in the dispenser, in cents.")) {
+    for (const LogEventFormat& event : kLogEvents) {
+        if (event.id == LogEventId::CardBlocked || event.id == LogEventId::WithdrawHoldExpired) continue;
+        rejections_[static_cast<std::size_t>(event.id)] = &registry.counter(
+            "atm_rejections_total", "Refused withdrawals and deposits, by reason.",
+            {{"reason", std::string(event.name)}});
+    }
+}
+
+AtmMetrics& atmMetrics() {
+    static AtmMetrics* metrics = new AtmMetrics(MetricsRegistry::global());
+    return *metrics;
+}
+
+MetricsTextFileExporter::MetricsTextFileExporter(const MetricsRegistry& registry, std::string path,
+                                                 std::chrono::milliseconds interval)
+    : registry_(registry), path_(std::move(path)), interval_(interval) {
+    thread_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            lock.unlock();
+            exportOnce();
+            lock.lock();
+            wake_.wait_for(lock, interval_, [this] { return stop_; });
+        }
+    });
+}
+
+MetricsTextFileExporter::~MetricsTextFileExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+    exportOnce();
+}
+
+void MetricsTextFileExporter::exportOnce() {
+    std::string error;
+    if (registry_.writeTextFile(path_, &error)) {
+        failing_ = false;
+        writes_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!failing_) Logger::log("Metrics export failed", error);
+    failing_ = true;
+}
+
+}  // namespace atm
@@ -0,0 +1,259 @@
+// RemoteBankService.cpp - Request ids, pending-call table and the response reader thread.
+
+#include "atm/machine/RemoteBankService.h"
+#include "atm/bank/BankSocket.h"
+#include "atm/machine/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace atm {
+
+RemoteBankService::~RemoteBankService() {
+    disconnect();
+}
+
+bool RemoteBankService::connect(const std::string& address, std::string* error) {
+    disconnect();
+    std::optional<BankAddress> parsed = BankAddress::parse(address);
+    if (!parsed) {
+        if (error) *error = "bad address " + address;
+        return false;
+    }
+    fd_ = net::connectTo(*parsed, error);
+    if (fd_ < 0) return false;
+    connected_ = true;
+    reader_ = std::thread([this] { readLoop(); });
+    return true;
+}
+
+void RemoteBankService::disconnect() {
+    if (fd_ < 0) return;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        connected_ = false;
+    }
+    // Wakes the reader out of recv; it fails whatever is still pending on its way out.
+    ::shutdown(fd_, SHUT_RDWR);
+    if (reader_.joinable()) reader_.join();
+    ::close(fd_);
+    fd_ = -1;
+    failPending();
+}
+
+void RemoteBankService::failPending() {
+    std::unordered_map<std::uint32_t, Completion> pending;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending.swap(pending_);
+    }
+    for (auto& entry : pending) entry.second(nullptr);
+}
+
+template <typename T, typename Encode, typename Decode>
+BankCall<T> RemoteBankService::send(BankOpcode opcode, Encode encode, Decode decode, T failSafe) {
+    BankPromise<T> promise;
+    BankCall<T> call = promise.call();
+    std::uint32_t requestId;
+    {
+        // connected_ only drops under this lock, so nothing is registered after failPending.
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (!connected_) {
+            return BankCall<T>::completed(std::move(failSafe));
+        }
+        requestId = nextRequestId_++;
+        pending_.emplace(requestId, [promise, decode, failSafe](protocol::FrameReader* response) mutable {
+            if (response) {
+                T value = decode(*response);
+                promise.complete(response->ok() ? std::move(value) : std::move(failSafe));
+            }
+            else {
+                promise.complete(std::move(failSafe));
+            }
+        });
+    }
+    std::string frame;
+    protocol::FrameWriter writer(frame, requestId, opcode);
+    encode(writer);
+    writer.finish();
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        sent = net::writeAll(fd_, frame.data(), frame.size());
+    }
+    if (!sent) {
+        Completion completion;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            auto it = pending_.find(requestId);
+            if (it != pending_.end()) {
+                completion = std::move(it->second);
+                pending_.erase(it);
+            }
+        }
+        if (completion) completion(nullptr);
+    }
+    return call;
+}
+
+void RemoteBankService::readLoop() {
+    std::string buffer;
+    std::size_t offset = 0;
+    char chunk[16 * 1024];
+    while (true) {
+        const ssize_t received = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            if (received < 0 && errno == EINTR) continue;
+            break;
+        }
+        buffer.append(chunk, static_cast<std::size_t>(received));
+        bool broken = false;
+        while (true) {
+            const std::string_view rest(buffer.data() + offset, buffer.size() - offset);
+            const std::optional<std::size_t> frame = protocol::completeFrame(rest);
+            if (!frame) {
+                broken = true;
+                break;
+            }
+            if (*frame == 0) break;
+            protocol::FrameReader response(rest.substr(protocol::kLengthPrefix, *frame - protocol::kLengthPrefix));
+            offset += *frame;
+            Completion completion;
+            {
+                std::lock_guard<std::mutex> lock(pendingMutex_);
+                auto it = pending_.find(response.requestId());
+                if (it != pending_.end()) {
+                    completion = std::move(it->second);
+                    pending_.erase(it);
+                }
+            }
+            if (completion) completion(&response);
+        }
+        if (broken) {
+            Logger::log("Bank server sent a malformed frame");
+            break;
+        }
+        buffer.erase(0, offset);
+        offset = 0;
+    }
+    bool wasConnected;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        wasConnected = connected_.exchange(false);
+    }
+    if (wasConnected) {
+        Logger::log("Bank server connection lost");
+    }
+    failPending();
+}
+
+BankCall<bool> RemoteBankService::checkIfCardExist(const std::string& card) {
+    return send<bool>(
+        BankOpcode::CheckIfCardExist, [&](protocol::FrameWriter& out) { out.putString(card); },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<bool> RemoteBankService::checkPIN(const std::string& pin, const std::string& card) {
+    return send<bool>(
+        BankOpcode::CheckPin,
+        [&](protocol::FrameWriter& out) {
+            out.putString(card);
+            out.putString(pin);
+        },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<AuthResult> RemoteBankService::authenticate(const std::string& card, const std::string& pin) {
+    return send<AuthResult>(
+        BankOpcode::Authenticate,
+        [&](protocol::FrameWriter& out) {
+            out.putString(card);
+            out.putString(pin);
+        },
+        [](protocol::FrameReader& in) { return in.getAuthResult(); }, AuthResult{});
+}
+
+BankCall<bool> RemoteBankService::blockCard(const std::string& card) {
+    return send<bool>(
+        BankOpcode::BlockCard, [&](protocol::FrameWriter& out) { out.putString(card); },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<Money> RemoteBankService::showBalance(AccountId account) {
+    return send<Money>(
+        BankOpcode::ShowBalance, [&](protocol::FrameWriter& out) { out.put(account); },
+        [](protocol::FrameReader& in) { return Money(in.get<std::int64_t>()); }, Money(0));
+}
+
+BankCall<bool> RemoteBankService::withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                               RequestId request) {
+    return send<bool>(
+        BankOpcode::Withdraw,
+        [&](protocol::FrameWriter& out) {
+            out.put(account);
+            out.put<std::int64_t>(amount.getCents());
+            out.put(terminal);
+            out.put(card);
+            out.put(request);
+        },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<bool> RemoteBankService::depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) {
+    return send<bool>(
+        BankOpcode::Deposit,
+        [&](protocol::FrameWriter& out) {
+            out.put(account);
+            out.put<std::int64_t>(amount.getCents());
+            out.put(terminal);
+            out.put(request);
+        },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<bool> RemoteBankService::reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card,
+                                              RequestId hold) {
+    return send<bool>(
+        BankOpcode::Reserve,
+        [&](protocol::FrameWriter& out) {
+            out.put(account);
+            out.put<std::int64_t>(amount.getCents());
+            out.put(terminal);
+            out.put(card);
+            out.put(hold);
+        },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<std::optional<bool>> RemoteBankService::commitCash(RequestId hold) {
+    // A lost frame or connection must not read as a refusal: the ATM has paid out and retries.
+    return send<std::optional<bool>>(
+        BankOpcode::Commit, [&](protocol::FrameWriter& out) { out.put(hold); },
+        [](protocol::FrameReader& in) { return std::optional<bool>(in.get<std::uint8_t>() != 0); }, std::nullopt);
+}
+
+BankCall<bool> RemoteBankService::releaseCash(RequestId hold) {
+    return send<bool>(
+        BankOpcode::Release, [&](protocol::FrameWriter& out) { out.put(hold); },
+        [](protocol::FrameReader& in) { return in.get<std::uint8_t>() != 0; }, false);
+}
+
+BankCall<std::vector<HistoryEntry>> RemoteBankService::getMiniStatement(AccountId account, std::size_t count) {
+    return send<std::vector<HistoryEntry>>(
+        BankOpcode::MiniStatement,
+        [&](protocol::FrameWriter& out) {
+            out.put(account);
+            out.put(static_cast<std::uint16_t>(std::min<std::size_t>(count, protocol::kMaxStatementEntries)));
+        },
+        [](protocol::FrameReader& in) { return in.getHistory(); }, std::vector<HistoryEntry>{});
+}
+
+BankCall<std::vector<AccountHandle>> RemoteBankService::getAccountListForCard(const std::string& card) {
+    return send<std::vector<AccountHandle>>(
+        BankOpcode::GetAccountList, [&](protocol::FrameWriter& out) { out.putString(card); },
+        [](protocol::FrameReader& in) { return in.getAccounts(); }, std::vector<AccountHandle>{});
+}
+
+}  // namespace atm
@@ -0,0 +1,286 @@
+// ScriptedUserInterface.cpp - Session script parsing/printing and the replaying UI.
+
+#include "atm/machine/ScriptedUserInterface.h"
+
+#include <charconv>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace atm {
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Splits off the next whitespace-separated token of line.
+std::string_view nextToken(std::string_view& line) {
+    std::size_t begin = 0;
+    while (begin < line.size() && isSpace(line[begin])) ++begin;
+    std::size_t end = begin;
+    while (end < line.size() && !isSpace(line[end])) ++end;
+    const std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return token;
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    const char* last = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), last, value);
+    return ec == std::errc() && ptr == last;
+}
+
+}  // namespace
+
+SessionScript::TextRef SessionScript::storeText(std::string_view text) {
+    TextRef ref{static_cast<std::uint32_t>(text_.size()), static_cast<std::uint32_t>(text.size())};
+    text_.append(text);
+    return ref;
+}
+
+void SessionScript::addSession(std::string_view card, std::initializer_list<std::string_view> pins, int account,
+                               std::span<const ScriptedStep> steps) {
+    Session session;
+    session.card = storeText(card);
+    session.firstPin = static_cast<std::uint32_t>(pins_.size());
+    for (std::string_view pin : pins) pins_.push_back(storeText(pin));
+    session.pinCount = static_cast<std::uint16_t>(pins.size());
+    session.firstStep = static_cast<std::uint32_t>(steps_.size());
+    steps_.insert(steps_.end(), steps.begin(), steps.end());
+    session.stepCount = static_cast<std::uint16_t>(steps.size());
+    session.account = account;
+    sessions_.push_back(session);
+}
+
+bool SessionScript::append(std::string_view text, std::string* error) {
+    const std::size_t textMark = text_.size();
+    const std::size_t pinMark = pins_.size();
+    const std::size_t stepMark = steps_.size();
+    const std::size_t sessionMark = sessions_.size();
+    auto fail = [&](std::size_t lineNumber, const char* reason) {
+        text_.resize(textMark);
+        pins_.resize(pinMark);
+        steps_.resize(stepMark);
+        sessions_.resize(sessionMark);
+        if (error) *error = "line " + std::to_string(lineNumber) + ": " + reason;
+        return false;
+    };
+
+    std::size_t lineNumber = 0;
+    while (!text.empty()) {
+        ++lineNumber;
+        const std::size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        if (const std::size_t hash = line.find('#'); hash != std::string_view::npos) {
+            line = line.substr(0, hash);
+        }
+
+        const std::string_view card = nextToken(line);
+        if (card.empty()) continue;
+        std::string_view pins = nextToken(line);
+        const std::string_view accountText = nextToken(line);
+        int account = 0;
+        if (pins.empty() || accountText.empty()) return fail(lineNumber, "expected <card> <pins> <account>");
+        if (!parseNumber(accountText, account) || account < 1) return fail(lineNumber, "bad account choice");
+
+        Session session;
+        session.card = storeText(card);
+        session.account = account;
+        session.firstPin = static_cast<std::uint32_t>(pins_.size());
+        while (true) {
+            const std::size_t comma = pins.find(',');
+            const std::string_view pin = pins.substr(0, comma);
+            if (pin.empty()) return fail(lineNumber, "empty PIN");
+            pins_.push_back(storeText(pin));
+            if (comma == std::string_view::npos) break;
+            pins.remove_prefix(comma + 1);
+        }
+        session.pinCount = static_cast<std::uint16_t>(pins_.size() - session.firstPin);
+
+        session.firstStep = static_cast<std::uint32_t>(steps_.size());
+        for (std::string_view token = nextToken(line); !token.empty(); token = nextToken(line)) {
+            ScriptedStep step;
+            switch (token[0]) {
+                case 'B': step.option = MenuOption::CheckBalance; break;
+                case 'W': step.option = MenuOption::Withdraw; break;
+                case 'D': step.option = MenuOption::Deposit; break;
+                case 'S': step.option = MenuOption::MiniStatement; break;
+                case 'X': step.option = MenuOption::Exit; break;
+                default: return fail(lineNumber, "unknown step (expected B, W<cents>, D<cents>, S or X)");
+            }
+            const bool takesAmount = step.option == MenuOption::Withdraw || step.option == MenuOption::Deposit;
+            if (takesAmount ? !parseNumber(token.substr(1), step.cents) || step.cents < 0 : token.size() != 1) {
+                return fail(lineNumber, "bad step amount");
+            }
+            if (step.option == MenuOption::Exit) break;
+            steps_.push_back(step);
+        }
+        if (steps_.size() - session.firstStep > std::numeric_limits<std::uint16_t>::max()) {
+            return fail(lineNumber, "too many steps");
+        }
+        session.stepCount = static_cast<std::uint16_t>(steps_.size() - session.firstStep);
+        sessions_.push_back(session);
+    }
+    return true;
+}
+
+bool SessionScript::loadFile(const std::string& path, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return append(text, error);
+}
+
+void SessionScript::reserve(std::size_t sessions, std::size_t textBytes) {
+    sessions_.reserve(sessions);
+    pins_.reserve(sessions);
+    steps_.reserve(sessions * 2);
+    text_.reserve(textBytes);
+}
+
+std::string SessionScript::toText() const {
+    std::string out;
+    for (std::size_t i = 0; i < sessions_.size(); ++i) {
+        out += card(i);
+        for (std::size_t p = 0; p < pinCount(i); ++p) {
+            out += p == 0 ? ' ' : ',';
+            out += pin(i, p);
+        }
+        out += ' ';
+        out += std::to_string(account(i));
+        for (const ScriptedStep& step : steps(i)) {
+            switch (step.option) {
+                case MenuOption::CheckBalance: out += " B"; break;
+                case MenuOption::Withdraw: out += " W" + std::to_string(step.cents); break;
+                case MenuOption::Deposit: out += " D" + std::to_string(step.cents); break;
+                case MenuOption::MiniStatement: out += " S"; break;
+                case MenuOption::Exit: out += " X"; break;
+            }
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+std::string_view SessionScript::card(std::size_t session) const {
+    return textOf(sessions_[session].card);
+}
+
+std::string_view SessionScript::pin(std::size_t session, std::size_t attempt) const {
+    const Session& s = sessions_[session];
+    return textOf(pins_[s.firstPin + (attempt < s.pinCount ? attempt : s.pinCount - 1u)]);
+}
+
+std::span<const ScriptedStep> SessionScript::steps(std::size_t session) const {
+    const Session& s = sessions_[session];
+    return std::span<const ScriptedStep>(steps_).subspan(s.firstStep, s.stepCount);
+}
+
+std::string_view uiOutputName(UiOutput output) {
+    switch (output) {
+        case UiOutput::CardInsertedSuccess: return "CardInsertedSuccess";
+        case UiOutput::CardInsertedFailure: return "CardInsertedFailure";
+        case UiOutput::PinAccepted: return "PinAccepted";
+        case UiOutput::PinRejected: return "PinRejected";
+        case UiOutput::CardBlocked: return "CardBlocked";
+        case UiOutput::CardEjected: return "CardEjected";
+        case UiOutput::OptionSelected: return "OptionSelected";
+        case UiOutput::Balance: return "Balance";
+        case UiOutput::MiniStatement: return "MiniStatement";
+        case UiOutput::WithdrawAmount: return "WithdrawAmount";
+        case UiOutput::DepositAmount: return "DepositAmount";
+        case UiOutput::TakeCard: return "TakeCard";
+        case UiOutput::InsufficientAtmFunds: return "InsufficientAtmFunds";
+        case UiOutput::DispensableAmounts: return "DispensableAmounts";
+        case UiOutput::InsufficientAccountFunds: return "InsufficientAccountFunds";
+        case UiOutput::InsertEnvelope: return "InsertEnvelope";
+        case UiOutput::DepositSuccess: return "DepositSuccess";
+        case UiOutput::DepositRejected: return "DepositRejected";
+        case UiOutput::InvalidAccountSelection: return "InvalidAccountSelection";
+        case UiOutput::InvalidNumericInput: return "InvalidNumericInput";
+    }
+    return "?";
+}
+
+ScriptedUserInterface::ScriptedUserInterface(std::shared_ptr<const SessionScript> script, std::size_t firstSession,
+                                             std::uint64_t sessionCount, std::size_t recordLimit)
+    : script_(std::move(script)),
+      firstSession_(firstSession),
+      sessionCount_(script_->empty() ? 0 : sessionCount),
+      recordLimit_(recordLimit) {
+    records_.reserve(recordLimit_);
+}
+
+std::string ScriptedUserInterface::readCard() {
+    if (sessionsStarted_ >= sessionCount_) {
+        return {};
+    }
+    current_ = static_cast<std::size_t>((firstSession_ + sessionsStarted_) % script_->size());
+    ++sessionsStarted_;
+    pinAttempt_ = 0;
+    stepIndex_ = 0;
+    stepCents_ = 0;
+    accountRejected_ = false;
+    return std::string(script_->card(current_));
+}
+
+std::string ScriptedUserInterface::readPin() {
+    return std::string(script_->pin(current_, pinAttempt_++));
+}
+
+int ScriptedUserInterface::promptAccountChoice(const std::vector<std::string>&) {
+    // The ATM asks again after an invalid choice; fall back to the first account then.
+    return accountRejected_ ? 1 : script_->account(current_);
+}
+
+void ScriptedUserInterface::showInvalidAccountSelection() {
+    accountRejected_ = true;
+    record(UiOutput::InvalidAccountSelection);
+}
+
+MenuOption ScriptedUserInterface::promptMenuOption() {
+    const std::span<const ScriptedStep> steps = script_->steps(current_);
+    if (stepIndex_ >= steps.size()) {
+        return MenuOption::Exit;
+    }
+    const ScriptedStep& step = steps[stepIndex_++];
+    stepCents_ = step.cents;
+    return step.option;
+}
+
+Money ScriptedUserInterface::promptWithdrawAmount() {
+    return Money(stepCents_);
+}
+
+Money ScriptedUserInterface::promptDepositAmount() {
+    return Money(stepCents_);
+}
+
+void ScriptedUserInterface::showWithdrawAmount(Money amount) {
+    withdrawnCents_ += amount.getCents();
+    record(UiOutput::WithdrawAmount, amount.getCents());
+}
+
+void ScriptedUserInterface::showDepositSuccess() {
+    depositedCents_ += stepCents_;
+    record(UiOutput::DepositSuccess, stepCents_);
+}
+
+void ScriptedUserInterface::showCardEjected(const std::string&) {
+    ++sessionsDone_;
+    record(UiOutput::CardEjected);
+}
+
+void ScriptedUserInterface::record(UiOutput output, std::int64_t value) {
+    ++counts_[static_cast<std::size_t>(output)];
+    if (records_.size() < recordLimit_) {
+        records_.push_back(UiOutputRecord{sessionsStarted_ - 1, output, value});
+    }
+}
+
+}  // namespace atm
@@ -0,0 +1,194 @@
+// StateTimings.cpp - Per-state histogram queries and report, timed UI forwarding, dump-on-signal thread.
+
+#include "atm/machine/StateTimings.h"
+#include "atm/machine/Logger.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+
+namespace atm {
+
+namespace {
+
+// Set by the handler, taken by the dumper thread; a lock-free atomic is both signal-safe and race-free.
+std::atomic<int> dumpRequested{0};
+static_assert(std::atomic<int>::is_always_lock_free, "signal handler needs a lock-free flag");
+
+extern "C" void requestDump(int) {
+    dumpRequested.store(1);
+}
+
+void appendPart(std::string& out, const LatencySummary& part) {
+    char buffer[96];
+    std::snprintf(buffer, sizeof(buffer), " | %9llu %8.1f %8.1f %8.1f %9.1f",
+                  static_cast<unsigned long long>(part.count), part.p50Us, part.p90Us, part.p99Us, part.maxUs);
+    out += buffer;
+}
+
+}  // namespace
+
+StateLatency StateTimings::latency(StateId state) const {
+    const PerState& histograms = at(state);
+    return StateLatency{histograms.handle.summary(), histograms.ui.summary(), histograms.bank.summary()};
+}
+
+std::string StateTimings::report() const {
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer), "%-22s | %-45s | %-45s | %s\n", "state (us)",
+                  "handle: count p50 p90 p99 max", "ui: count p50 p90 p99 max", "bank: count p50 p90 p99 max");
+    std::string out = buffer;
+    for (std::size_t i = 0; i < kStateCount; ++i) {
+        const StateId state = static_cast<StateId>(i);
+        const StateLatency timing = latency(state);
+        if (timing.handle.count == 0) continue;
+        std::snprintf(buffer, sizeof(buffer), "%-22.*s", static_cast<int>(stateIdName(state).size()),
+                      stateIdName(state).data());
+        out += buffer;
+        appendPart(out, timing.handle);
+        appendPart(out, timing.ui);
+        appendPart(out, timing.bank);
+        out += '\n';
+    }
+    return out;
+}
+
+void StateTimings::reset() {
+    for (PerState& histograms : states_) {
+        histograms.handle.reset();
+        histograms.ui.reset();
+        histograms.bank.reset();
+    }
+}
+
+std::string TimedUserInterface::readCard() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    return inner_->readCard();
+}
+void TimedUserInterface::showCardInsertedSuccess(const std::string& cardNumber) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showCardInsertedSuccess(cardNumber);
+}
+void TimedUserInterface::showCardInsertedFailure(const std::string& cardNumber) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showCardInsertedFailure(cardNumber);
+}
+std::string TimedUserInterface::readPin() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    return inner_->readPin();
+}
+void TimedUserInterface::showPinAccepted(const std::string& pin) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showPinAccepted(pin);
+}
+void TimedUserInterface::showPinRejected(const std::string& pin) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showPinRejected(pin);
+}
+void TimedUserInterface::showCardBlocked(const std::string& cardNumber) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showCardBlocked(cardNumber);
+}
+void TimedUserInterface::showCardEjected(const std::string& cardNumber) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showCardEjected(cardNumber);
+}
+int TimedUserInterface::promptAccountChoice(const std::vector<std::string>& accountNames) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    return inner_->promptAccountChoice(accountNames);
+}
+MenuOption TimedUserInterface::promptMenuOption() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    return inner_->promptMenuOption();
+}
+void TimedUserInterface::showOptionSelected(MenuOption option) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showOptionSelected(option);
+}
+void TimedUserInterface::showBalance(Money balance) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showBalance(balance);
+}
+void TimedUserInterface::showMiniStatement(const std::vector<HistoryEntry>& entries) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showMiniStatement(entries);
+}
+Money TimedUserInterface::promptWithdrawAmount() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    return inner_->promptWithdrawAmount();
+}
+void TimedUserInterface::showWithdrawAmount(Money amount) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showWithdrawAmount(amount);
+}
+Money TimedUserInterface::promptDepositAmount() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    return inner_->promptDepositAmount();
+}
+void TimedUserInterface::showDepositAmount(Money amount) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showDepositAmount(amount);
+}
+void TimedUserInterface::promptTakeCard() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->promptTakeCard();
+}
+void TimedUserInterface::showInsufficientAtmFunds() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showInsufficientAtmFunds();
+}
+void TimedUserInterface::showDispensableAmounts(Money lower, Money higher) {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showDispensableAmounts(lower, higher);
+}
+void TimedUserInterface::showInsufficientAccountFunds() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showInsufficientAccountFunds();
+}
+void TimedUserInterface::promptInsertEnvelope() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->promptInsertEnvelope();
+}
+void TimedUserInterface::showDepositSuccess() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showDepositSuccess();
+}
+void TimedUserInterface::showDepositRejected() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showDepositRejected();
+}
+void TimedUserInterface::showInvalidAccountSelection() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showInvalidAccountSelection();
+}
+void TimedUserInterface::showInvalidNumericInput() {
+    BlockedScope scope(BlockedScope::On::Ui);
+    inner_->showInvalidNumericInput();
+}
+
+StateTimingsDumper::StateTimingsDumper(std::shared_ptr<const StateTimings> timings, int signal)
+    : timings_(std::move(timings)), signal_(signal) {
+    dumpRequested.store(0);
+    previous_ = std::signal(signal_, requestDump);
+    thread_ = std::thread([this] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            wake_.wait_for(lock, std::chrono::milliseconds(100));
+            if (dumpRequested.exchange(0) != 0) {
+                Logger::log("State timings\n" + timings_->report());
+            }
+        }
+    });
+}
+
+StateTimingsDumper::~StateTimingsDumper() {
+    std::signal(signal_, previous_ == SIG_ERR ? SIG_DFL : previous_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+}  // namespace atm
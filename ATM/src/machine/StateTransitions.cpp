@@ -0,0 +1,66 @@
+// StateTransitions.cpp - State and event names; Graphviz export of the transition table.
+
+#include "atm/machine/StateTransitions.h"
+
+namespace atm {
+
+std::string_view stateIdName(StateId id) {
+    switch (id) {
+        case StateId::Idle: return "Idle";
+        case StateId::CardInserted: return "CardInserted";
+        case StateId::CardNotExistInSystem: return "CardNotExistInSystem";
+        case StateId::AskForPIN: return "AskForPIN";
+        case StateId::SuccessfulPin: return "SuccessfulPin";
+        case StateId::UnsuccessfulPin: return "UnsuccessfulPin";
+        case StateId::BlockCard: return "BlockCard";
+        case StateId::ChooseAccount: return "ChooseAccount";
+        case StateId::ShowOptions: return "ShowOptions";
+        case StateId::DecideOption: return "DecideOption";
+        case StateId::CheckBalance: return "CheckBalance";
+        case StateId::WithdrawFunds: return "WithdrawFunds";
+        case StateId::DepositFunds: return "DepositFunds";
+        case StateId::MiniStatement: return "MiniStatement";
+        case StateId::Exit: return "Exit";
+        case StateId::EjectCard: return "EjectCard";
+        case StateId::Reset: return "Reset";
+    }
+    return "?";
+}
+
+std::string_view stateEventName(StateEvent event) {
+    switch (event) {
+        case StateEvent::Next: return "Next";
+        case StateEvent::CardRead: return "CardRead";
+        case StateEvent::CardRejected: return "CardRejected";
+        case StateEvent::PinAccepted: return "PinAccepted";
+        case StateEvent::PinRejected: return "PinRejected";
+        case StateEvent::Retry: return "Retry";
+        case StateEvent::AttemptsExhausted: return "AttemptsExhausted";
+        case StateEvent::AccountChosen: return "AccountChosen";
+        case StateEvent::OptionChosen: return "OptionChosen";
+        case StateEvent::BalanceChosen: return "BalanceChosen";
+        case StateEvent::WithdrawChosen: return "WithdrawChosen";
+        case StateEvent::DepositChosen: return "DepositChosen";
+        case StateEvent::MiniStatementChosen: return "MiniStatementChosen";
+        case StateEvent::ExitChosen: return "ExitChosen";
+        case StateEvent::Done: return "Done";
+    }
+    return "?";
+}
+
+std::string transitionGraphDot() {
+    std::string dot = "digraph ATM {\n    rankdir=LR;\n    node [shape=box];\n";
+    for (const Transition& t : kTransitions) {
+        dot += "    ";
+        dot += stateIdName(t.from);
+        dot += " -> ";
+        dot += stateIdName(t.to);
+        dot += " [label=\"";
+        dot += stateEventName(t.event);
+        dot += "\"];\n";
+    }
+    dot += "}\n";
+    return dot;
+}
+
+}  // namespace atm
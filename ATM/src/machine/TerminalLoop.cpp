@@ -0,0 +1,73 @@
+// TerminalLoop.cpp - Run queue of ATMs; bank completions requeue parked terminals.
+
+#include "atm/machine/TerminalLoop.h"
+#include "atm/machine/ATM.h"
+
+namespace atm {
+
+TerminalLoop::~TerminalLoop() {
+    for (const auto& entry : queued_) {
+        entry.first->setBankReadyHandler(nullptr);
+    }
+}
+
+void TerminalLoop::add(ATM& atm) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.emplace(&atm, false);
+    }
+    atm.setBankReadyHandler([this](ATM& ready) { makeRunnable(ready); });
+    makeRunnable(atm);
+}
+
+void TerminalLoop::makeRunnable(ATM& atm) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bool& queued = queued_[&atm];
+        if (queued) {
+            return;
+        }
+        queued = true;
+        runQueue_.push_back(&atm);
+    }
+    runnable_.notify_one();
+}
+
+bool TerminalLoop::runStep() {
+    ATM* atm;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (runQueue_.empty()) {
+            return false;
+        }
+        atm = runQueue_.front();
+        runQueue_.pop_front();
+        queued_[atm] = false;
+    }
+    atm->runOnce();
+    // A terminal parked on the bank is requeued by the completion instead.
+    if (!atm->isWaitingForBank()) {
+        makeRunnable(*atm);
+    }
+    return true;
+}
+
+bool TerminalLoop::waitForWork(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return runnable_.wait_for(lock, timeout, [this] { return !runQueue_.empty(); });
+}
+
+void TerminalLoop::runUntil(const std::function<bool()>& done) {
+    while (!done()) {
+        if (!runStep()) {
+            waitForWork(std::chrono::milliseconds(10));
+        }
+    }
+}
+
+std::size_t TerminalLoop::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_.size();
+}
+
+}  // namespace atm
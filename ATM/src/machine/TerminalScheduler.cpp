@@ -0,0 +1,178 @@
+// TerminalScheduler.cpp - Per-worker run queues, stealing, and parking of idle workers.
+
+#include "atm/machine/TerminalScheduler.h"
+#include "atm/machine/ATM.h"
+
+#include <algorithm>
+
+namespace atm {
+
+namespace {
+
+constexpr std::size_t kMaxStealBatch = 64;
+
+// Which scheduler and worker the current thread belongs to (requeues stay local).
+thread_local const void* currentScheduler = nullptr;
+thread_local unsigned currentWorker = 0;
+
+}  // namespace
+
+TerminalScheduler::TerminalScheduler(unsigned workers) {
+    const unsigned count = workers != 0 ? workers : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+TerminalScheduler::~TerminalScheduler() {
+    stop();
+    std::lock_guard<std::mutex> lock(terminalsMutex_);
+    for (const auto& terminal : terminals_) {
+        terminal->atm->setBankReadyHandler(nullptr);
+    }
+}
+
+void TerminalScheduler::add(ATM& atm) {
+    Terminal* terminal;
+    {
+        std::lock_guard<std::mutex> lock(terminalsMutex_);
+        terminals_.push_back(std::make_unique<Terminal>());
+        terminal = terminals_.back().get();
+        terminal->atm = &atm;
+        terminal->home = static_cast<unsigned>((terminals_.size() - 1) % workers_.size());
+    }
+    atm.setBankReadyHandler([this, terminal](ATM&) { schedule(*terminal); });
+    schedule(*terminal);
+}
+
+void TerminalScheduler::start() {
+    if (running_.exchange(true)) return;
+    for (unsigned i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread([this, i] { workerLoop(i); });
+    }
+}
+
+void TerminalScheduler::stop() {
+    if (!running_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+TerminalSchedulerStats TerminalScheduler::stats() const {
+    TerminalSchedulerStats stats;
+    for (const auto& worker : workers_) {
+        stats.steps += worker->steps.load(std::memory_order_relaxed);
+        stats.steals += worker->steals.load(std::memory_order_relaxed);
+        stats.sleeps += worker->sleeps.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void TerminalScheduler::schedule(Terminal& terminal) {
+    std::uint8_t state = terminal.state.load();
+    while (true) {
+        if (state & Terminal::kRunning) {
+            // The worker stepping it requeues it when the step ends.
+            if ((state & Terminal::kPending) ||
+                terminal.state.compare_exchange_weak(state, state | Terminal::kPending)) {
+                return;
+            }
+        }
+        else {
+            if (state & Terminal::kQueued) {
+                return;
+            }
+            if (terminal.state.compare_exchange_weak(state, state | Terminal::kQueued)) {
+                break;
+            }
+        }
+    }
+    const unsigned target = currentScheduler == this ? currentWorker : terminal.home;
+    {
+        std::lock_guard<std::mutex> lock(workers_[target]->mutex);
+        // Counted before it becomes visible, so the count never drops below zero.
+        runnable_.fetch_add(1);
+        workers_[target]->queue.push_back(&terminal);
+    }
+    if (sleepers_.load() != 0) {
+        // Taking the lock orders this notify after a sleeper's predicate check.
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        wakeup_.notify_one();
+    }
+}
+
+TerminalScheduler::Terminal* TerminalScheduler::popLocal(Worker& worker) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.queue.empty()) {
+        return nullptr;
+    }
+    Terminal* terminal = worker.queue.front();
+    worker.queue.pop_front();
+    return terminal;
+}
+
+TerminalScheduler::Terminal* TerminalScheduler::steal(unsigned thief) {
+    const unsigned count = static_cast<unsigned>(workers_.size());
+    std::vector<Terminal*> taken;
+    for (unsigned offset = 1; offset < count && taken.empty(); ++offset) {
+        Worker& victim = *workers_[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        // Take half from the back: the victim keeps the terminals it is about to run.
+        const std::size_t n = std::min(kMaxStealBatch, (victim.queue.size() + 1) / 2);
+        for (std::size_t i = 0; i < n; ++i) {
+            taken.push_back(victim.queue.back());
+            victim.queue.pop_back();
+        }
+    }
+    if (taken.empty()) {
+        return nullptr;
+    }
+    Worker& self = *workers_[thief];
+    self.steals.fetch_add(taken.size(), std::memory_order_relaxed);
+    if (taken.size() > 1) {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        self.queue.insert(self.queue.end(), taken.rbegin() + 1, taken.rend());
+    }
+    return taken.back();
+}
+
+void TerminalScheduler::workerLoop(unsigned index) {
+    currentScheduler = this;
+    currentWorker = index;
+    Worker& self = *workers_[index];
+    while (running_.load(std::memory_order_relaxed)) {
+        Terminal* terminal = popLocal(self);
+        if (!terminal) {
+            terminal = steal(index);
+        }
+        if (!terminal) {
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            sleepers_.fetch_add(1);
+            self.sleeps.fetch_add(1, std::memory_order_relaxed);
+            wakeup_.wait(lock, [this] { return !running_.load() || runnable_.load() != 0; });
+            sleepers_.fetch_sub(1);
+            continue;
+        }
+        runnable_.fetch_sub(1);
+        // Only schedule() touches the state while it is queued, and it leaves a queued terminal alone.
+        terminal->state.store(Terminal::kRunning);
+        ATM& atm = *terminal->atm;
+        atm.runOnce();
+        self.steps.fetch_add(1, std::memory_order_relaxed);
+        const bool ready = !atm.isWaitingForBank() && !atm.isAwaitingInput();
+        // A completion or input during the step only set kPending; requeue for it now that the
+        // step (and the reads above) are over.
+        const std::uint8_t state = terminal->state.exchange(0);
+        if (ready || (state & Terminal::kPending)) {
+            schedule(*terminal);
+        }
+    }
+    currentScheduler = nullptr;
+}
+
+}  // namespace atm
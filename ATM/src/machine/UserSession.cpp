@@ -7,16 +7,12 @@ namespace atm {
 UserSession::UserSession(std::string card, int initialUnsuccessfulPinCount)
     : cardNumber_(std::move(card)), unsuccessfulPinCount_(initialUnsuccessfulPinCount) {}
 
-void UserSession::setAccounts(const std::vector<Account>& accountsList) {
-    accounts_ = accountsList;
+void UserSession::setAccounts(std::vector<AccountHandle> accountsList) {
+    accounts_ = std::move(accountsList);
     selectedAccountIndex_ = std::nullopt;
 }
 
-std::vector<Account>& UserSession::getAccounts() {
-    return accounts_;
-}
-
-const std::vector<Account>& UserSession::getAccounts() const {
+const std::vector<AccountHandle>& UserSession::getAccounts() const {
     return accounts_;
 }
 
@@ -28,8 +24,9 @@ void UserSession::setSelectedAccount(size_t index) {
 
 std::vector<std::string> UserSession::getAccountNames() const {
     std::vector<std::string> result;
+    result.reserve(accounts_.size());
     for (const auto& account : accounts_) {
-        result.push_back(account.getName());
+        result.push_back(account.name);
     }
     return result;
 }
@@ -38,7 +35,7 @@ void UserSession::setPin(const std::string& pin) {
     storedPin_ = pin;
 }
 
-std::string UserSession::getStoredPin() const {
+const std::string& UserSession::getStoredPin() const {
     return storedPin_;
 }
 
@@ -50,21 +47,14 @@ bool UserSession::getUserAuthenticated() const {
     return userAuthenticated_;
 }
 
-Account* UserSession::getSelectedAccount() {
+const AccountHandle* UserSession::getSelectedAccount() const {
     if (!selectedAccountIndex_.has_value() || selectedAccountIndex_.value() >= accounts_.size()) {
         return nullptr;
     }
     return &accounts_[selectedAccountIndex_.value()];
 }
 
-const Account* UserSession::getSelectedAccount() const {
-    if (!selectedAccountIndex_.has_value() || selectedAccountIndex_.value() >= accounts_.size()) {
-        return nullptr;
-    }
-    return &accounts_[selectedAccountIndex_.value()];
-}
-
-std::string UserSession::getCardNumber() const {
+const std::string& UserSession::getCardNumber() const {
     return cardNumber_;
 }
 
@@ -76,6 +66,14 @@ int UserSession::getUnsuccessfulPinCount() const {
     return unsuccessfulPinCount_;
 }
 
+void UserSession::setRemainingPinAttempts(int remaining) {
+    remainingPinAttempts_ = remaining;
+}
+
+std::optional<int> UserSession::getRemainingPinAttempts() const {
+    return remainingPinAttempts_;
+}
+
 void UserSession::setSelectedOption(MenuOption opt) {
     selectedOption_ = opt;
 }
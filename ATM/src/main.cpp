@@ -1,12 +1,107 @@
 // main.cpp - Entry point: build composition, seed demo data, create and run ATM.
+// Usage: ATM [--snapshot <path>] [--journal <path>] [--save-snapshot <path>] [--bank <address>]
+//            [--log-file <path>]   (log lines go to stderr by default)
+//            [--event-log <path>]  (structured events as binary records; decode with atm_logcat)
+//            [--metrics-file <path>]  (Prometheus text file rewritten every 10 s, for node_exporter)
+//            [--cassettes <cents>x<notes>,...]  (note cassettes, e.g. 5000x40,2000x100; default: 100.00 without notes)
+//        ATM --state-graph   (prints the state transition table as Graphviz DOT)
+// kill -USR1 <pid> prints per-state latency histograms to stderr (POSIX).
 
 #include "atm/machine/AtmComposition.h"
+#include "atm/machine/Logger.h"
+#include "atm/machine/Metrics.h"
+#include "atm/machine/StateTimings.h"
+#include "atm/machine/StateTransitions.h"
+
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
 
 using namespace atm;
 
-int main() {
-    AtmComposition composition;
-    composition.seedDemoData();
+int main(int argc, char** argv) {
+    if (argc == 2 && std::string(argv[1]) == "--state-graph") {
+        std::cout << transitionGraphDot();
+        return 0;
+    }
+    std::string snapshotPath;
+    std::string journalPath;
+    std::string saveSnapshotPath;
+    std::string bankAddress;
+    std::string logPath;
+    std::string eventLogPath;
+    std::string metricsPath;
+    AtmConfig config;
+    for (int i = 1; i + 1 < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--snapshot") snapshotPath = argv[++i];
+        else if (option == "--journal") journalPath = argv[++i];
+        else if (option == "--save-snapshot") saveSnapshotPath = argv[++i];
+        else if (option == "--bank") bankAddress = argv[++i];
+        else if (option == "--log-file") logPath = argv[++i];
+        else if (option == "--event-log") eventLogPath = argv[++i];
+        else if (option == "--metrics-file") metricsPath = argv[++i];
+        else if (option == "--cassettes") {
+            std::string error;
+            if (!parseCassettes(argv[++i], &config.cassettes, &error)) {
+                Logger::log("Bad --cassettes", error);
+                return 1;
+            }
+        }
+    }
+    if (!logPath.empty() || !eventLogPath.empty()) {
+        LoggerConfig logConfig;
+        logConfig.path = logPath;
+        logConfig.eventPath = eventLogPath;
+        std::string error;
+        if (!Logger::configure(logConfig, &error)) {
+            Logger::log("Log file unavailable", error);
+            return 1;
+        }
+    }
+
+    AtmComposition composition(config);
+    std::unique_ptr<MetricsTextFileExporter> metricsExport;
+    if (!metricsPath.empty()) {
+        metricsExport = std::make_unique<MetricsTextFileExporter>(MetricsRegistry::global(), metricsPath);
+    }
+#ifdef SIGUSR1
+    StateTimingsDumper timingsDump(composition.stateTimings(), SIGUSR1);
+#endif
+    if (!bankAddress.empty()) {
+        // Accounts live in the bank server; nothing to load locally.
+        std::string error;
+        if (!composition.connectRemoteBank(bankAddress, &error)) {
+            Logger::log("Bank connection failed", error);
+            return 1;
+        }
+        std::unique_ptr<ATM> atm = composition.createAtm();
+        atm->run();
+        return 0;
+    }
+    if (snapshotPath.empty()) {
+        composition.seedDemoData();
+    }
+    else {
+        std::string error;
+        if (!composition.loadSnapshot(snapshotPath, &error)) {
+            Logger::log("Snapshot load failed", error);
+            return 1;
+        }
+    }
+    if (!journalPath.empty()) {
+        const std::size_t replayed = composition.enableJournal(journalPath);
+        Logger::log("Journal records replayed", replayed);
+    }
+    if (!saveSnapshotPath.empty()) {
+        std::string error;
+        if (!composition.saveSnapshot(saveSnapshotPath, &error)) {
+            Logger::log("Snapshot save failed", error);
+            return 1;
+        }
+        return 0;
+    }
 
     std::unique_ptr<ATM> atm = composition.createAtm();
     atm->run();
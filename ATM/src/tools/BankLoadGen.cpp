@@ -0,0 +1,173 @@
+// BankLoadGen.cpp - atm_bank_loadgen: many concurrent clients against atm_bank_server.
+// Usage: atm_bank_loadgen [--connect <address>] [--clients N] [--seconds S] [--cards N]
+// Each client keeps one request in flight: 70% balance queries, 20% deposits, 10% logins,
+// on card load<client % cards> (start the server with --load-cards). Prints requests/sec
+// and latency percentiles over all clients.
+
+#include "atm/bank/BankProtocol.h"
+#include "atm/bank/BankSocket.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace atm;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Client {
+    int fd = -1;
+    std::string card;
+    AccountId account = kInvalidAccountId;
+    std::uint32_t nextId = 1;
+    std::uint32_t step = 0;
+    Clock::time_point sentAt;
+    std::string in;
+    std::string out;
+};
+
+/// Encodes the client's next request (login first, then the 70/20/10 mix).
+void encodeNext(Client& client) {
+    client.out.clear();
+    const std::uint32_t slot = client.step++ % 10;
+    if (client.account == kInvalidAccountId || slot == 0) {
+        protocol::FrameWriter writer(client.out, client.nextId++, BankOpcode::Authenticate);
+        writer.putString(client.card);
+        writer.putString("1234");
+        writer.finish();
+    }
+    else if (slot <= 2) {
+        protocol::FrameWriter writer(client.out, client.nextId++, BankOpcode::Deposit);
+        writer.put(client.account);
+        writer.put<std::int64_t>(1);
+        writer.put(kNoTerminal);
+        writer.finish();
+    }
+    else {
+        protocol::FrameWriter writer(client.out, client.nextId++, BankOpcode::ShowBalance);
+        writer.put(client.account);
+        writer.finish();
+    }
+}
+
+bool sendRequest(Client& client) {
+    encodeNext(client);
+    client.sentAt = Clock::now();
+    // Requests are small, so a fresh socket buffer always takes them in one send.
+    return ::send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL) ==
+           static_cast<ssize_t>(client.out.size());
+}
+
+double percentile(std::vector<std::int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    const auto index = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string addressText = "tcp:127.0.0.1:7070";
+    std::size_t clientCount = 1000;
+    double seconds = 10;
+    std::size_t cards = 1000;
+    for (int i = 1; i + 1 < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--connect") addressText = argv[++i];
+        else if (option == "--clients") clientCount = std::stoul(argv[++i]);
+        else if (option == "--seconds") seconds = std::stod(argv[++i]);
+        else if (option == "--cards") cards = std::max<std::size_t>(1, std::stoul(argv[++i]));
+    }
+    const std::optional<BankAddress> address = BankAddress::parse(addressText);
+    if (!address) {
+        std::cerr << "bad address " << addressText << '\n';
+        return 2;
+    }
+    net::raiseFileLimit();
+
+    const int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Client> clients(clientCount);
+    for (std::size_t i = 0; i < clientCount; ++i) {
+        std::string error;
+        Client& client = clients[i];
+        client.fd = net::connectTo(*address, &error);
+        if (client.fd < 0) {
+            std::cerr << "client " << i << ": " << error << '\n';
+            return 1;
+        }
+        net::setNonBlocking(client.fd);
+        client.card = "load" + std::to_string(i % cards);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+    }
+    std::cout << clientCount << " clients connected to " << address->toString() << std::endl;
+
+    std::vector<std::int64_t> latencies;
+    latencies.reserve(1 << 22);
+    std::size_t failures = 0;
+    for (Client& client : clients) {
+        if (!sendRequest(client)) ++failures;
+    }
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    std::vector<epoll_event> events(1024);
+    char chunk[4096];
+    while (Clock::now() < end) {
+        const int count = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), 100);
+        if (count < 0 && errno != EINTR) break;
+        for (int e = 0; e < count; ++e) {
+            Client& client = clients[events[e].data.u64];
+            const ssize_t received = ::recv(client.fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                if (received < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+                std::cerr << "server closed a connection\n";
+                return 1;
+            }
+            client.in.append(chunk, static_cast<std::size_t>(received));
+            const std::optional<std::size_t> frame = protocol::completeFrame(client.in);
+            if (!frame) {
+                std::cerr << "malformed response\n";
+                return 1;
+            }
+            if (*frame == 0) continue;
+            const Clock::time_point now = Clock::now();
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(now - client.sentAt).count());
+            protocol::FrameReader response(std::string_view(client.in).substr(protocol::kLengthPrefix,
+                                                                              *frame - protocol::kLengthPrefix));
+            if (response.opcode() == BankOpcode::Authenticate) {
+                const AuthResult result = response.getAuthResult();
+                if (result.pinVerdict == PinVerdict::Accepted && !result.accounts.empty()) {
+                    client.account = result.accounts.front().id;
+                }
+                else {
+                    ++failures;
+                }
+            }
+            client.in.erase(0, *frame);
+            if (!sendRequest(client)) ++failures;
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << latencies.size() << " requests in " << elapsed << " s: "
+              << static_cast<long long>(static_cast<double>(latencies.size()) / elapsed) << " req/s\n"
+              << "latency us: p50 " << percentile(latencies, 0.50) << "  p99 " << percentile(latencies, 0.99)
+              << "  p99.9 " << percentile(latencies, 0.999) << "  max " << percentile(latencies, 1.0) << '\n';
+    if (failures != 0) std::cout << failures << " failed requests (unknown card or send error)\n";
+    for (Client& client : clients) ::close(client.fd);
+    ::close(epollFd);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// BankServer.cpp - atm_bank_server: hosts one Bank for many ATM processes over Unix/TCP sockets.
+// Usage: atm_bank_server [--listen <address>] [--workers N] [--snapshot <path>] [--journal <path>]
+//                        [--load-cards N] [--card-daily-limit <cents>] [--terminal-daily-limit <cents>]
+//                        [--limit-cards N] [--dedupe-requests N] [--hold-ttl-ms N]
+// Without --snapshot the demo card is seeded. --load-cards adds cards load0..load<N-1> (PIN 1234,
+// one account each) for atm_bank_loadgen. Daily limits default to AtmConstants; 0 turns one off.
+// --limit-cards sizes the per-card limit table (40 bytes per card). --dedupe-requests sizes the table
+// that answers retried withdrawals and deposits (32 bytes per request); 0 turns it off. --hold-ttl-ms
+// is how long reserved withdrawal funds wait for the ATM to commit before they go back to the account.
+
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/BankServer.h"
+#include "atm/bank/BulkLoader.h"
+#include "atm/bank/CheckingAccount.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/bank/RollingLimiter.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/Snapshot.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionJournal.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/bank/WithdrawHolds.h"
+#include "atm/machine/AtmConstants.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace atm;
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+std::string loadCardsCsv(std::size_t count) {
+    std::string csv;
+    csv.reserve(count * 40);
+    for (std::size_t i = 0; i < count; ++i) {
+        csv += "load" + std::to_string(i) + ",1234,Load account,100000000\n";
+    }
+    return csv;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BankServerConfig config;
+    std::string snapshotPath;
+    std::string journalPath;
+    std::size_t loadCards = 0;
+    std::int64_t cardDailyLimit = constants::kCardDailyWithdrawLimitCents;
+    std::int64_t terminalDailyLimit = constants::kTerminalDailyWithdrawLimitCents;
+    std::size_t limitCards = constants::kDefaultWithdrawLimitCards;
+    std::size_t dedupeRequests = constants::kDefaultDedupeRequests;
+    AtmConfig limits;
+    for (int i = 1; i + 1 < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--listen") config.address = argv[++i];
+        else if (option == "--workers") config.workers = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (option == "--snapshot") snapshotPath = argv[++i];
+        else if (option == "--journal") journalPath = argv[++i];
+        else if (option == "--load-cards") loadCards = std::stoul(argv[++i]);
+        else if (option == "--card-daily-limit") cardDailyLimit = std::stoll(argv[++i]);
+        else if (option == "--terminal-daily-limit") terminalDailyLimit = std::stoll(argv[++i]);
+        else if (option == "--limit-cards") limitCards = std::stoul(argv[++i]);
+        else if (option == "--dedupe-requests") dedupeRequests = std::stoul(argv[++i]);
+        else if (option == "--hold-ttl-ms") limits.withdrawHoldTtlMs = std::stoll(argv[++i]);
+    }
+
+    Ledger ledger;
+    AuthService auth(ledger);
+    TransactionManager transactions(ledger, limits);
+    TransactionHistory history;
+    transactions.setHistory(&history);
+    std::unique_ptr<RollingLimiter> cardLimits;
+    std::unique_ptr<RollingLimiter> terminalLimits;
+    if (cardDailyLimit > 0) {
+        cardLimits = std::make_unique<RollingLimiter>(cardDailyLimit, std::max(limitCards, loadCards));
+    }
+    if (terminalDailyLimit > 0) {
+        terminalLimits =
+            std::make_unique<RollingLimiter>(terminalDailyLimit, constants::kDefaultWithdrawLimitTerminals);
+    }
+    transactions.setWithdrawalLimits(cardLimits.get(), terminalLimits.get());
+    Bank bank(transactions, auth);
+    std::unique_ptr<RequestDedupe> dedupe;
+    if (dedupeRequests > 0) {
+        dedupe = std::make_unique<RequestDedupe>(dedupeRequests);
+        bank.setRequestDedupe(dedupe.get());
+    }
+
+    std::unique_ptr<SnapshotView> snapshot;
+    if (!snapshotPath.empty()) {
+        std::string error;
+        snapshot = SnapshotView::open(snapshotPath, &error);
+        if (!snapshot || !ledger.attachSnapshot(*snapshot)) {
+            std::cerr << "snapshot load failed: " << error << '\n';
+            return 1;
+        }
+        auth.attachSnapshot(snapshot.get());
+    }
+    else {
+        auth.setPinForCard("pera123", "1234");
+        auth.addAccountToCard("pera123", SavingAccount("Pera saving account", Money(200000)));
+        auth.addAccountToCard("pera123", CheckingAccount());
+    }
+    if (loadCards != 0) {
+        BulkLoader loader(auth, ledger);
+        const BulkLoadReport report = loader.loadCsv(loadCardsCsv(loadCards));
+        if (!report.ok) {
+            std::cerr << "load cards failed: " << report.error << '\n';
+            return 1;
+        }
+    }
+
+    std::unique_ptr<TransactionJournal> journal;
+    if (!journalPath.empty()) {
+        const std::uint64_t snapshotSequence = snapshot ? snapshot->header().journalSequence : 0;
+        std::vector<JournalRecord> openHolds;
+        const std::size_t replayed =
+            TransactionJournal::recover(journalPath, ledger, auth, snapshotSequence, &openHolds);
+        std::cout << "journal records replayed: " << replayed << '\n';
+        journal = std::make_unique<TransactionJournal>(journalPath);
+        transactions.setJournal(journal.get());
+        if (!openHolds.empty()) {
+            std::cout << "open withdraw holds released: " << transactions.releaseRecoveredHolds(openHolds) << '\n';
+        }
+    }
+    auto holdSweeper = std::make_unique<HoldSweeper>(
+        transactions, std::chrono::milliseconds(constants::kDefaultHoldSweepIntervalMs));
+
+    BankServer server(bank, config);
+    std::string error;
+    if (!server.start(&error)) {
+        std::cerr << "cannot listen on " << config.address << ": " << error << '\n';
+        return 1;
+    }
+    std::cout << "listening on " << server.address().toString() << std::endl;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    while (!stopRequested) {
+        ::pause();
+    }
+    server.stop();
+    const BankServerStats stats = server.stats();
+    std::cout << "served " << stats.requests << " requests on " << stats.connectionsAccepted << " connections\n";
+    holdSweeper.reset();
+    if (journal) {
+        transactions.setJournal(nullptr);
+        journal->flush();
+    }
+    return 0;
+}
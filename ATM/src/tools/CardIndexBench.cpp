@@ -0,0 +1,129 @@
+// CardIndexBench.cpp - Memory per card and lookup latency: CardIndex vs the former three-map layout.
+// Usage: atm_card_index_bench [cards=10000000] [lookups=2000000]
+
+#include "atm/bank/CardIndex.h"
+#include "atm/bank/Hashing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace atm;
+
+namespace {
+
+std::size_t heapInUse() {
+#if defined(__GLIBC__)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+std::string cardNumber(std::size_t i) {
+    std::string digits = std::to_string(i);
+    return "4000" + std::string(12 - digits.size(), '0') + digits;
+}
+
+/// AuthService's tables before CardIndex: string-keyed PINs, account lists and blocks.
+struct LegacyLayout {
+    std::unordered_map<std::string, std::vector<AccountId>> cardAccount;
+    std::unordered_set<std::string> blockedCards;
+    std::unordered_map<std::string, std::string> cardToPIN;
+
+    /// checkIfCardExist, returning the stored PIN's length so the caller depends on the lookup.
+    std::optional<std::uint64_t> find(const std::string& card) const {
+        if (blockedCards.find(card) != blockedCards.end()) return std::nullopt;
+        auto pin = cardToPIN.find(card);
+        if (pin != cardToPIN.end()) return pin->second.size();
+        if (cardAccount.find(card) != cardAccount.end()) return 0;
+        return std::nullopt;
+    }
+};
+
+/// Times lookups two ways: independent (throughput; misses overlap) and chained, where the
+/// next probe depends on the previous answer (latency of one lookup, as a session sees it).
+/// @param lookup Returns a value derived from the found record, or nullopt on a miss.
+template <typename Fn>
+std::pair<double, double> nanosPerLookup(const std::vector<std::string>& probes, Fn&& lookup) {
+    using Clock = std::chrono::steady_clock;
+    auto perLookup = [&](Clock::duration elapsed) {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(probes.size());
+    };
+    std::size_t missed = 0;
+    auto start = Clock::now();
+    for (const std::string& card : probes) missed += lookup(card) ? 0 : 1;
+    const double independent = perLookup(Clock::now() - start);
+
+    std::size_t next = 0;
+    start = Clock::now();
+    for (std::size_t i = 0; i < probes.size(); ++i) {
+        const std::optional<std::uint64_t> value = lookup(probes[next]);
+        next = (i + 1 + (value.value_or(0) & 1)) % probes.size();
+    }
+    const double chained = perLookup(Clock::now() - start);
+    if (missed != 0) std::fprintf(stderr, "missed %zu lookups\n", missed);
+    return {independent, chained};
+}
+
+void report(const char* name, std::size_t cards, std::size_t bytes, std::pair<double, double> nanos) {
+    std::printf("%-10s %10zu cards  %8.1f bytes/card  %7.1f ns/lookup  %7.1f ns/lookup chained\n", name, cards,
+                static_cast<double>(bytes) / static_cast<double>(cards), nanos.first, nanos.second);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t cards = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000;
+    const std::size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2'000'000;
+
+    std::mt19937_64 random(42);
+    std::vector<std::string> probes;
+    probes.reserve(lookups);
+    for (std::size_t i = 0; i < lookups; ++i) probes.push_back(cardNumber(random() % cards));
+
+    {
+        const std::size_t before = heapInUse();
+        LegacyLayout legacy;
+        for (std::size_t i = 0; i < cards; ++i) {
+            const std::string card = cardNumber(i);
+            legacy.cardToPIN[card] = std::to_string(1000 + i % 9000);
+            legacy.cardAccount[card].push_back(i + 1);
+        }
+        const std::size_t bytes = heapInUse() - before;
+        report("legacy", cards, bytes, nanosPerLookup(probes, [&](const std::string& card) {
+                   return legacy.find(card);
+               }));
+    }
+    {
+        const std::size_t before = heapInUse();
+        CardIndex index;
+        index.reserve(cards);
+        for (std::size_t i = 0; i < cards; ++i) {
+            const std::string card = cardNumber(i);
+            CardRecord& record = index.findOrInsert(card);
+            record.pinDigest = pinDigest(card, std::to_string(1000 + i % 9000));
+            record.flags |= CardRecord::kHasPin;
+            const AccountId id = i + 1;
+            index.appendAccounts(record, std::span<const AccountId>(&id, 1));
+        }
+        const std::size_t bytes = heapInUse() - before;
+        report("CardIndex", cards, bytes, nanosPerLookup(probes, [&](const std::string& card) {
+                   const CardRecord* record = index.find(card);
+                   return record && !record->blocked() ? std::optional<std::uint64_t>(record->pinDigest)
+                                                       : std::nullopt;
+               }));
+    }
+    return 0;
+}
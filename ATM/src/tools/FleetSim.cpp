@@ -0,0 +1,92 @@
+// FleetSim.cpp - atm_fleet_sim: N simulated ATMs against one in-process bank; prints throughput and latency.
+// Usage: atm_fleet_sim [--terminals N] [--threads N] [--sessions N] [--cards N] [--seed N] [--script <path>]
+//                      [--state-timings] [--cassettes <cents>x<notes>,...]
+// A script replaces the random sessions (format in ScriptedUserInterface.h); its cards must be among the
+// provisioned ones (<prefix>0 .. <prefix><cards-1>, PIN 1234).
+
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/FleetSimulator.h"
+
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace atm;
+
+namespace {
+
+void printLatency(const char* label, const LatencySummary& latency) {
+    std::cout << std::left << std::setw(10) << label << std::right << std::setw(10) << latency.count
+              << std::fixed << std::setprecision(2) << std::setw(10) << latency.meanUs << std::setw(10)
+              << latency.p50Us << std::setw(10) << latency.p99Us << std::setw(10) << latency.p999Us
+              << std::setw(12) << latency.maxUs << '\n';
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    FleetConfig config;
+    std::string scriptPath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (option == "--state-timings") {
+            config.stateTimings = true;
+            continue;
+        }
+        if (i + 1 == argc) break;
+        if (option == "--terminals") config.terminals = std::stoul(argv[++i]);
+        else if (option == "--threads") config.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (option == "--sessions") config.sessionsPerTerminal = std::stoul(argv[++i]);
+        else if (option == "--cards") config.cards = std::stoul(argv[++i]);
+        else if (option == "--seed") config.seed = std::stoull(argv[++i]);
+        else if (option == "--script") scriptPath = argv[++i];
+        else if (option == "--cassettes") {
+            std::string error;
+            if (!parseCassettes(argv[++i], &config.atm.cassettes, &error)) {
+                std::cerr << "cassettes: " << error << '\n';
+                return 1;
+            }
+        }
+    }
+    if (!scriptPath.empty()) {
+        auto script = std::make_shared<SessionScript>();
+        std::string error;
+        if (!script->loadFile(scriptPath, &error)) {
+            std::cerr << "script: " << error << '\n';
+            return 1;
+        }
+        config.script = std::move(script);
+    }
+
+    Ledger ledger;
+    AuthService auth(ledger);
+    TransactionManager transactions(ledger);
+    TransactionHistory history;
+    transactions.setHistory(&history);
+    Bank bank(transactions, auth);
+    FleetSimulator::provisionCards(auth, config);
+
+    FleetSimulator fleet(bank, config);
+    const FleetReport report = fleet.run();
+    std::cout << report.terminals << " terminals on " << report.threads << " threads: " << report.sessions
+              << " sessions in " << std::fixed << std::setprecision(3) << report.seconds << " s ("
+              << static_cast<long long>(report.sessionsPerSecond()) << " sessions/s, " << report.steals
+              << " steals)\n\n";
+    std::cout << std::left << std::setw(10) << "latency" << std::right << std::setw(10) << "count" << std::setw(10)
+              << "mean us" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+              << std::setw(12) << "max" << '\n';
+    printLatency("session", report.session);
+    printLatency("login", report.login);
+    printLatency("balance", report.balance);
+    printLatency("withdraw", report.withdraw);
+    printLatency("deposit", report.deposit);
+    if (report.stateTimings) {
+        std::cout << '\n' << report.stateTimings->report();
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// LogCat.cpp - Decodes a binary event log (LoggerConfig::eventPath, ATM --event-log) to text or JSON lines.
+// Usage: atm_logcat [--json] <events.bin>
+// Text: one "<UTC time> <EventName> <message>" line per event. JSON: one object per line.
+
+#include "atm/machine/LogEvents.h"
+
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+
+using namespace atm;
+
+namespace {
+
+std::string utcTime(std::int64_t unixNs) {
+    std::time_t seconds = static_cast<std::time_t>(unixNs / 1'000'000'000);
+    long nanos = static_cast<long>(unixNs % 1'000'000'000);
+    if (nanos < 0) {
+        --seconds;
+        nanos += 1'000'000'000;
+    }
+    const std::tm* tm = std::gmtime(&seconds);
+    char buffer[48];
+    if (!tm) return std::to_string(unixNs);
+    const std::size_t length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", tm);
+    std::snprintf(buffer + length, sizeof(buffer) - length, ".%09ldZ", nanos);
+    return buffer;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    bool json = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--json") json = true;
+        else path = arg;
+    }
+    if (path.empty()) {
+        std::cerr << "usage: atm_logcat [--json] <events.bin>\n";
+        return 2;
+    }
+
+    std::string line;
+    std::string error;
+    const bool ok = replayLogEvents(
+        path,
+        [&](const DecodedLogEvent& event) {
+            if (json) {
+                line = logEventJson(event);
+            }
+            else {
+                line = utcTime(event.unixNs);
+                line += ' ';
+                line += event.info->name;
+                line += ' ';
+                line += formatLogEvent(event);
+            }
+            line += '\n';
+            std::fwrite(line.data(), 1, line.size(), stdout);
+        },
+        &error);
+    if (!ok) {
+        std::cerr << "atm_logcat: " << error << '\n';
+        return 1;
+    }
+    return 0;
+}
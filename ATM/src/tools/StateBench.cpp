@@ -0,0 +1,86 @@
+// StateBench.cpp - State-machine steps per second and heap allocations per step for one ATM.
+// Usage: atm_state_bench [steps=2000000] [--timings]
+// Each session: card, PIN, first account, balance, exit (16 transitions), against an in-process Bank.
+
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/ATM.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/Hardware.h"
+#include "atm/machine/ScriptedUserInterface.h"
+#include "atm/machine/StateTimings.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+using namespace atm;
+
+int main(int argc, char** argv) {
+    std::uint64_t steps = 2'000'000;
+    bool timed = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--timings") timed = true;
+        else steps = std::strtoull(argv[i], nullptr, 10);
+    }
+
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("bench1", "1234");
+    auth.addAccountToCard("bench1", SavingAccount("Savings", Money(100000)));
+    Bank bank(transactions, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto script = std::make_shared<SessionScript>();
+    script->append("bench1 1234 1 B\n");
+    ATM atm(std::make_shared<ScriptedUserInterface>(script), dispenser, std::make_shared<DepositSlot>(*dispenser),
+            gateway);
+    auto timings = std::make_shared<StateTimings>();
+    if (timed) atm.setStateTimings(timings);
+
+    for (int i = 0; i < 1000; ++i) atm.runOnce();  // warm up
+    const std::uint64_t allocationsBefore = allocations.load();
+    const auto start = std::chrono::steady_clock::now();
+    std::uint64_t sessions = 0;
+    for (std::uint64_t i = 0; i < steps; ++i) {
+        atm.runOnce();
+        sessions += atm.getCurrentStateName() == "IdleState" ? 1 : 0;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::uint64_t allocated = allocations.load() - allocationsBefore;
+
+    std::printf("%llu steps (%llu sessions) in %.3f s: %.1f M steps/s, %.1f ns/step\n",
+                static_cast<unsigned long long>(steps), static_cast<unsigned long long>(sessions), seconds,
+                static_cast<double>(steps) / seconds / 1e6, seconds * 1e9 / static_cast<double>(steps));
+    std::printf("heap allocations: %.2f per step, %.1f per session\n",
+                static_cast<double>(allocated) / static_cast<double>(steps),
+                sessions ? static_cast<double>(allocated) / static_cast<double>(sessions) : 0.0);
+    if (timed) std::printf("\n%s", timings->report().c_str());
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include "atm/bank/AsyncBankAdapter.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/BankCall.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/Gateway.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+TEST(BankCall, CallbackRunsOnceWhenPromiseCompletesOnAnotherThread) {
+    BankPromise<int> promise;
+    BankCall<int> call = promise.call();
+    EXPECT_FALSE(call.ready());
+
+    std::atomic<int> seen{0};
+    call.then([&](const int& value) { seen = value; });
+    std::thread completer([&] { promise.complete(42); });
+    call.wait();
+    completer.join();
+
+    EXPECT_TRUE(call.ready());
+    EXPECT_EQ(call.get(), 42);
+    EXPECT_EQ(seen.load(), 42);
+
+    // Registering after completion runs the callback right away.
+    int late = 0;
+    call.then([&](const int& value) { late = value; });
+    EXPECT_EQ(late, 42);
+}
+
+TEST(AsyncBankAdapter, InlineAdapterReturnsCompletedCalls) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    AccountId id = auth.addAccountToCard("card", SavingAccount("Savings", Money(500)));
+    Bank bank(tm, auth);
+    AsyncBankAdapter adapter(bank);
+
+    BankCall<Money> balance = adapter.showBalance(id);
+    EXPECT_TRUE(balance.ready());
+    EXPECT_EQ(balance.get().getCents(), 500);
+}
+
+TEST(AsyncBankAdapter, WorkerPoolAnswersConcurrentRequests) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("card", "1234");
+    AccountId id = auth.addAccountToCard("card", SavingAccount("Savings", Money(100000)));
+    Bank bank(tm, auth);
+    AsyncBankAdapter adapter(bank, 4);
+    Gateway gateway(adapter);
+
+    std::vector<BankCall<bool>> withdrawals;
+    for (int i = 0; i < 500; ++i) {
+        withdrawals.push_back(gateway.withdrawCashAsync(id, Money(100)));
+    }
+    std::vector<BankCall<AuthResult>> logins;
+    for (int i = 0; i < 50; ++i) {
+        logins.push_back(gateway.authenticateAsync("card", "1234"));
+    }
+    for (auto& call : withdrawals) EXPECT_TRUE(call.get());
+    for (auto& call : logins) EXPECT_EQ(call.get().pinVerdict, PinVerdict::Accepted);
+
+    // Blocking calls on an asynchronous gateway wait for the answer.
+    EXPECT_EQ(gateway.showBalance(id).getCents(), 50000);
+}
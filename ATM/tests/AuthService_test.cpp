@@ -1,19 +1,22 @@
 #include "atm/bank/Account.h"
 #include "atm/bank/AuthService.h"
 #include "atm/bank/CheckingAccount.h"
+#include "atm/bank/Ledger.h"
 #include "atm/bank/SavingAccount.h"
 #include <gtest/gtest.h>
 
 using namespace atm;
 
 TEST(AuthService, CardDoesNotExistBeforeRegistration) {
-    AuthService auth;
+    Ledger ledger;
+    AuthService auth(ledger);
     EXPECT_FALSE(auth.checkIfCardExist("unknown"));
     EXPECT_TRUE(auth.getAccountListForCard("unknown").empty());
 }
 
 TEST(AuthService, SetPinAndCheckPin) {
-    AuthService auth;
+    Ledger ledger;
+    AuthService auth(ledger);
     auth.setPinForCard("card1", "1234");
     EXPECT_TRUE(auth.checkIfCardExist("card1"));
     EXPECT_TRUE(auth.checkPIN("1234", "card1"));
@@ -22,23 +25,25 @@ TEST(AuthService, SetPinAndCheckPin) {
 }
 
 TEST(AuthService, GetAccountListForCard) {
-    AuthService auth;
+    Ledger ledger;
+    AuthService auth(ledger);
     auth.setPinForCard("card1", "1234");
     SavingAccount saving("My Savings", Money(5000));
     CheckingAccount checking("My Checking", Money(1000));
     auth.addAccountToCard("card1", saving);
     auth.addAccountToCard("card1", checking);
 
-    std::vector<Account> accounts = auth.getAccountListForCard("card1");
+    std::vector<AccountHandle> accounts = auth.getAccountListForCard("card1");
     ASSERT_EQ(accounts.size(), 2u);
-    EXPECT_EQ(accounts[0].getName(), "My Savings");
-    EXPECT_EQ(accounts[0].getAmount().getCents(), 5000);
-    EXPECT_EQ(accounts[1].getName(), "My Checking");
-    EXPECT_EQ(accounts[1].getAmount().getCents(), 1000);
+    EXPECT_EQ(accounts[0].name, "My Savings");
+    EXPECT_EQ(ledger.getBalance(accounts[0].id)->getCents(), 5000);
+    EXPECT_EQ(accounts[1].name, "My Checking");
+    EXPECT_EQ(ledger.getBalance(accounts[1].id)->getCents(), 1000);
 }
 
 TEST(AuthService, BlockedCardFailsCheckIfCardExistAndCheckPin) {
-    AuthService auth;
+    Ledger ledger;
+    AuthService auth(ledger);
     auth.setPinForCard("card1", "1234");
     EXPECT_TRUE(auth.checkIfCardExist("card1"));
     EXPECT_TRUE(auth.checkPIN("1234", "card1"));
@@ -49,7 +54,8 @@ TEST(AuthService, BlockedCardFailsCheckIfCardExistAndCheckPin) {
 }
 
 TEST(AuthService, DemoFlowMatchesProductionSeed) {
-    AuthService auth;
+    Ledger ledger;
+    AuthService auth(ledger);
     auth.setPinForCard("pera123", "1234");
     SavingAccount saving("Pera saving account", Money(200000));
     CheckingAccount checking;
@@ -58,8 +64,49 @@ TEST(AuthService, DemoFlowMatchesProductionSeed) {
 
     EXPECT_TRUE(auth.checkIfCardExist("pera123"));
     EXPECT_TRUE(auth.checkPIN("1234", "pera123"));
-    std::vector<Account> accounts = auth.getAccountListForCard("pera123");
+    std::vector<AccountHandle> accounts = auth.getAccountListForCard("pera123");
     ASSERT_EQ(accounts.size(), 2u);
-    EXPECT_EQ(accounts[0].getName(), "Pera saving account");
-    EXPECT_EQ(accounts[0].getAmount().getCents(), 200000);
+    EXPECT_EQ(accounts[0].name, "Pera saving account");
+    EXPECT_EQ(ledger.getBalance(accounts[0].id)->getCents(), 200000);
+}
+
+TEST(AuthService, JointAccountLinkedToTwoCardsSharesOneLedgerEntry) {
+    Ledger ledger;
+    AuthService auth(ledger);
+    AccountId joint = auth.addAccountToCard("card1", SavingAccount("Joint", Money(700)));
+    auth.linkAccountToCard("card2", joint);
+
+    std::vector<AccountHandle> first = auth.getAccountListForCard("card1");
+    std::vector<AccountHandle> second = auth.getAccountListForCard("card2");
+    ASSERT_EQ(first.size(), 1u);
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(first[0].id, second[0].id);
+    EXPECT_EQ(ledger.size(), 1u);
+}
+
+TEST(AuthService, AuthenticateReturnsAccountsAndCountsWrongPins) {
+    Ledger ledger;
+    AuthService auth(ledger, 3);
+    auth.setPinForCard("card1", "1234");
+    auth.addAccountToCard("card1", SavingAccount("Savings", Money(100)));
+
+    AuthResult wrong = auth.authenticate("card1", "0000");
+    EXPECT_EQ(wrong.cardStatus, CardStatus::Active);
+    EXPECT_EQ(wrong.pinVerdict, PinVerdict::Rejected);
+    EXPECT_EQ(wrong.remainingAttempts, 2);
+    EXPECT_TRUE(wrong.accounts.empty());
+    EXPECT_EQ(auth.authenticate("card1", "1111").remainingAttempts, 1);
+
+    AuthResult right = auth.authenticate("card1", "1234");
+    EXPECT_EQ(right.pinVerdict, PinVerdict::Accepted);
+    EXPECT_EQ(right.remainingAttempts, 3);
+    ASSERT_EQ(right.accounts.size(), 1u);
+    EXPECT_EQ(right.accounts[0].name, "Savings");
+    EXPECT_EQ(auth.authenticate("card1", "0000").remainingAttempts, 2);  // reset by the success
+
+    EXPECT_EQ(auth.authenticate("nosuchcard", "1234").cardStatus, CardStatus::Unknown);
+    auth.blockCard("card1");
+    AuthResult blocked = auth.authenticate("card1", "1234");
+    EXPECT_EQ(blocked.cardStatus, CardStatus::Blocked);
+    EXPECT_EQ(blocked.pinVerdict, PinVerdict::NotChecked);
 }
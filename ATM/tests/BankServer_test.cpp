@@ -0,0 +1,277 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/BankProtocol.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionManager.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+#if defined(ATM_HAS_REMOTE_BANK)
+#include "atm/bank/BankServer.h"
+#include "atm/bank/BankSocket.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/RemoteBankService.h"
+#include <filesystem>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#endif
+
+using namespace atm;
+
+namespace {
+
+struct TestBank {
+    Ledger ledger;
+    TransactionHistory history;
+    TransactionManager tm{ledger};
+    AuthService auth{ledger};
+    Bank bank{tm, auth};
+    AccountId account;
+
+    TestBank() {
+        tm.setHistory(&history);
+        auth.setPinForCard("card1", "1234");
+        account = auth.addAccountToCard("card1", SavingAccount("Savings", Money(10000)));
+    }
+};
+
+}  // namespace
+
+TEST(BankProtocol, RequestIsDecodedRunAndAnsweredWithTheSameId) {
+    TestBank bank;
+    std::string request;
+    protocol::FrameWriter writer(request, 77, BankOpcode::Authenticate);
+    writer.putString("card1");
+    writer.putString("1234");
+    writer.finish();
+    ASSERT_EQ(protocol::completeFrame(request), request.size());
+    EXPECT_EQ(protocol::completeFrame(std::string_view(request).substr(0, request.size() - 1)), 0u);
+
+    std::string response;
+    ASSERT_TRUE(protocol::handleRequest(bank.bank, std::string_view(request).substr(protocol::kLengthPrefix),
+                                        response));
+    ASSERT_EQ(protocol::completeFrame(response), response.size());
+    protocol::FrameReader reader(std::string_view(response).substr(protocol::kLengthPrefix));
+    EXPECT_EQ(reader.requestId(), 77u);
+    EXPECT_EQ(reader.opcode(), BankOpcode::Authenticate);
+    AuthResult result = reader.getAuthResult();
+    ASSERT_TRUE(reader.ok());
+    EXPECT_EQ(result.pinVerdict, PinVerdict::Accepted);
+    ASSERT_EQ(result.accounts.size(), 1u);
+    EXPECT_EQ(result.accounts[0].id, bank.account);
+    EXPECT_EQ(result.accounts[0].name, "Savings");
+}
+
+TEST(BankProtocol, TruncatedOrUnknownRequestsAreRejectedWithoutOutput) {
+    TestBank bank;
+    std::string request;
+    protocol::FrameWriter writer(request, 1, BankOpcode::Withdraw);
+    writer.put(bank.account);  // amount missing
+    writer.finish();
+    std::string response = "keep";
+    EXPECT_FALSE(protocol::handleRequest(bank.bank, std::string_view(request).substr(protocol::kLengthPrefix),
+                                         response));
+    EXPECT_EQ(response, "keep");
+    EXPECT_EQ(bank.ledger.getBalance(bank.account)->getCents(), 10000);
+
+    std::string unknown;
+    protocol::FrameWriter(unknown, 2, static_cast<BankOpcode>(200)).finish();
+    EXPECT_FALSE(protocol::handleRequest(bank.bank, std::string_view(unknown).substr(protocol::kLengthPrefix),
+                                         response));
+
+    const std::string oversized("\xff\xff\xff\x7f", 4);
+    EXPECT_FALSE(protocol::completeFrame(oversized).has_value());
+}
+
+TEST(BankProtocol, WithdrawCarriesTerminalAndMiniStatementReturnsIt) {
+    TestBank bank;
+    std::string request;
+    protocol::FrameWriter withdraw(request, 5, BankOpcode::Withdraw);
+    withdraw.put(bank.account);
+    withdraw.put<std::int64_t>(2500);
+    withdraw.put<TerminalId>(9);
+    withdraw.put(cardHash("card1"));
+    withdraw.put<RequestId>(kNoRequest);
+    withdraw.finish();
+    std::string response;
+    ASSERT_TRUE(protocol::handleRequest(bank.bank, std::string_view(request).substr(protocol::kLengthPrefix),
+                                        response));
+
+    request.clear();
+    response.clear();
+    protocol::FrameWriter statement(request, 6, BankOpcode::MiniStatement);
+    statement.put(bank.account);
+    statement.put<std::uint16_t>(10);
+    statement.finish();
+    ASSERT_TRUE(protocol::handleRequest(bank.bank, std::string_view(request).substr(protocol::kLengthPrefix),
+                                        response));
+    protocol::FrameReader reader(std::string_view(response).substr(protocol::kLengthPrefix));
+    EXPECT_EQ(reader.requestId(), 6u);
+    std::vector<HistoryEntry> entries = reader.getHistory();
+    ASSERT_TRUE(reader.ok());
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].type, HistoryType::Withdraw);
+    EXPECT_EQ(entries[0].amount.getCents(), 2500);
+    EXPECT_EQ(entries[0].balance.getCents(), 7500);
+    EXPECT_EQ(entries[0].terminal, 9u);
+    EXPECT_EQ(entries[0].timeUs, bank.history.last(bank.account, 1)[0].timeUs);
+}
+
+TEST(BankProtocol, RetriedWithdrawFrameIsDebitedOnce) {
+    TestBank bank;
+    RequestDedupe dedupe(64, 1);
+    bank.bank.setRequestDedupe(&dedupe);
+    const RequestId id = newRequestId();
+    for (std::uint32_t frameId = 1; frameId <= 3; ++frameId) {  // a new connection id per attempt
+        std::string request;
+        protocol::FrameWriter withdraw(request, frameId, BankOpcode::Withdraw);
+        withdraw.put(bank.account);
+        withdraw.put<std::int64_t>(2500);
+        withdraw.put<TerminalId>(9);
+        withdraw.put(cardHash("card1"));
+        withdraw.put(id);
+        withdraw.finish();
+        std::string response;
+        ASSERT_TRUE(protocol::handleRequest(bank.bank, std::string_view(request).substr(protocol::kLengthPrefix),
+                                            response));
+        protocol::FrameReader reader(std::string_view(response).substr(protocol::kLengthPrefix));
+        EXPECT_EQ(reader.requestId(), frameId);
+        EXPECT_EQ(reader.get<std::uint8_t>(), 1u);
+    }
+    EXPECT_EQ(bank.ledger.getBalance(bank.account)->getCents(), 7500);
+    EXPECT_EQ(bank.history.last(bank.account, 10).size(), 1u);
+}
+
+TEST(BankProtocol, HoldFramesReserveCommitAndRelease) {
+    TestBank bank;
+    auto send = [&](BankOpcode opcode, auto&& args) {
+        std::string request;
+        protocol::FrameWriter writer(request, 5, opcode);
+        args(writer);
+        writer.finish();
+        std::string response;
+        EXPECT_TRUE(protocol::handleRequest(bank.bank, std::string_view(request).substr(protocol::kLengthPrefix),
+                                            response));
+        protocol::FrameReader reader(std::string_view(response).substr(protocol::kLengthPrefix));
+        EXPECT_EQ(reader.opcode(), opcode);
+        return reader.get<std::uint8_t>() != 0;
+    };
+    auto reserve = [&](RequestId hold) {
+        return send(BankOpcode::Reserve, [&](protocol::FrameWriter& out) {
+            out.put(bank.account);
+            out.put<std::int64_t>(3000);
+            out.put<TerminalId>(9);
+            out.put(cardHash("card1"));
+            out.put(hold);
+        });
+    };
+    auto settle = [&](BankOpcode opcode, RequestId hold) {
+        return send(opcode, [&](protocol::FrameWriter& out) { out.put(hold); });
+    };
+
+    const RequestId kept = newRequestId();
+    const RequestId returned = newRequestId();
+    EXPECT_TRUE(reserve(kept));
+    EXPECT_TRUE(reserve(returned));
+    EXPECT_EQ(bank.ledger.getBalance(bank.account)->getCents(), 4000);
+    EXPECT_TRUE(settle(BankOpcode::Commit, kept));
+    EXPECT_TRUE(settle(BankOpcode::Release, returned));
+    EXPECT_FALSE(settle(BankOpcode::Release, kept));
+    EXPECT_FALSE(settle(BankOpcode::Commit, returned));
+    EXPECT_EQ(bank.ledger.getBalance(bank.account)->getCents(), 7000);
+    EXPECT_EQ(bank.history.last(bank.account, 10).size(), 1u);
+}
+
+#if defined(ATM_HAS_REMOTE_BANK)
+
+TEST(BankServer, GatewaysInSeveralClientsShareOneLedgerOverUnixSocket) {
+    TestBank bank;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / ("atm_bank_test_" + std::to_string(::getpid()) + ".sock")).string();
+    BankServerConfig config;
+    config.address = "unix:" + path;
+    config.workers = 2;
+    BankServer server(bank.bank, config);
+    std::string error;
+    ASSERT_TRUE(server.start(&error)) << error;
+
+    constexpr int kClients = 4;
+    constexpr int kWithdrawalsPerClient = 25;
+    std::vector<std::thread> clients;
+    for (int c = 0; c < kClients; ++c) {
+        clients.emplace_back([&] {
+            RemoteBankService remote;
+            ASSERT_TRUE(remote.connect(server.address().toString()));
+            Gateway gateway(remote);
+            AuthResult login = gateway.authenticate("card1", "1234");
+            ASSERT_EQ(login.pinVerdict, PinVerdict::Accepted);
+            ASSERT_EQ(login.accounts.size(), 1u);
+            // Several requests in flight on one connection at once.
+            std::vector<BankCall<bool>> calls;
+            for (int i = 0; i < kWithdrawalsPerClient; ++i) {
+                calls.push_back(gateway.withdrawCashAsync(login.accounts[0].id, Money(10)));
+            }
+            for (auto& call : calls) EXPECT_TRUE(call.get());
+        });
+    }
+    for (auto& client : clients) client.join();
+
+    EXPECT_EQ(bank.ledger.getBalance(bank.account)->getCents(), 10000 - kClients * kWithdrawalsPerClient * 10);
+    RemoteBankService remote;
+    ASSERT_TRUE(remote.connect(server.address().toString()));
+    Gateway gateway(remote);
+    EXPECT_EQ(gateway.showBalance(bank.account).getCents(), 9000);
+    EXPECT_FALSE(gateway.checkIfCardExist("nosuchcard"));
+    EXPECT_TRUE(gateway.getAccountListForCard("nosuchcard").empty());
+    server.stop();
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(BankServer, UnanswerableRequestClosesTheConnection) {
+    TestBank bank;
+    BankServerConfig config;
+    config.address = "tcp:127.0.0.1:0";
+    config.workers = 1;
+    BankServer server(bank.bank, config);
+    ASSERT_TRUE(server.start());
+
+    const int fd = net::connectTo(server.address());
+    ASSERT_GE(fd, 0);
+    std::string request;
+    protocol::FrameWriter unknown(request, 1, static_cast<BankOpcode>(99));
+    unknown.finish();
+    ASSERT_TRUE(net::writeAll(fd, request.data(), request.size()));
+    // No answer can come for that request, so the server hangs up instead of leaving it pending.
+    char byte = 0;
+    EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);
+    ::close(fd);
+    EXPECT_EQ(server.stats().malformed, 1u);
+    server.stop();
+}
+
+TEST(BankServer, ClientFailsSafeWhenTheServerGoesAway) {
+    TestBank bank;
+    BankServerConfig config;
+    config.address = "tcp:127.0.0.1:0";
+    config.workers = 1;
+    BankServer server(bank.bank, config);
+    ASSERT_TRUE(server.start());
+    ASSERT_NE(server.address().port, 0);
+
+    RemoteBankService remote;
+    ASSERT_TRUE(remote.connect(server.address().toString()));
+    EXPECT_TRUE(remote.checkIfCardExist("card1").get());
+    server.stop();
+
+    EXPECT_FALSE(remote.withdrawCash(bank.account, Money(1), kNoTerminal, kNoCard, kNoRequest).get());
+    EXPECT_EQ(remote.authenticate("card1", "1234").get().cardStatus, CardStatus::Unknown);
+    EXPECT_FALSE(remote.connected());
+    EXPECT_EQ(bank.ledger.getBalance(bank.account)->getCents(), 10000);
+}
+
+#endif
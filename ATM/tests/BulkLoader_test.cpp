@@ -0,0 +1,72 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/BulkLoader.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/Money.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace atm;
+
+namespace {
+
+class BulkLoaderTest : public ::testing::Test {
+protected:
+    Ledger ledger_;
+    AuthService auth_{ledger_};
+};
+
+std::string generateCsv(int cards) {
+    std::string csv = "card,pin,account_name,balance_cents,blocked\n";
+    for (int i = 0; i < cards; ++i) {
+        const std::string card = "card" + std::to_string(i);
+        csv += card + "," + std::to_string(1000 + i % 9000) + ",Saving," + std::to_string(i) + ",0\n";
+        csv += card + "," + std::to_string(1000 + i % 9000) + ",\"Checking\"," + std::to_string(2 * i) + ",0\n";
+    }
+    return csv;
+}
+
+}  // namespace
+
+TEST_F(BulkLoaderTest, LoadsCardsWithTheirAccountsInParallel) {
+    BulkLoader loader(auth_, ledger_, BulkLoadOptions{4});
+    const BulkLoadReport report = loader.loadCsv(generateCsv(5000));
+    ASSERT_TRUE(report.ok) << report.error;
+    EXPECT_EQ(report.rows, 10000u);
+    EXPECT_EQ(report.cards, 5000u);
+    EXPECT_EQ(ledger_.size(), 10000u);
+
+    EXPECT_TRUE(auth_.checkPIN("1123", "card123"));
+    const auto accounts = auth_.getAccountListForCard("card4321");
+    ASSERT_EQ(accounts.size(), 2u);
+    EXPECT_EQ(accounts[0].name, "Saving");
+    EXPECT_EQ(accounts[1].name, "Checking");
+    EXPECT_EQ(ledger_.getBalance(accounts[0].id), Money(4321));
+    EXPECT_EQ(ledger_.getBalance(accounts[1].id), Money(8642));
+}
+
+TEST_F(BulkLoaderTest, BadRowReportsLineAndImportsNothing) {
+    std::string csv = generateCsv(3000);
+    csv += "broken,12x4,Name,10\n";
+    BulkLoader loader(auth_, ledger_, BulkLoadOptions{4});
+    const BulkLoadReport report = loader.loadCsv(csv);
+    EXPECT_FALSE(report.ok);
+    EXPECT_EQ(report.errorRow, 6002u);  // header + 6000 rows, then the bad one
+    EXPECT_EQ(ledger_.size(), 0u);
+    EXPECT_FALSE(auth_.checkIfCardExist("card1"));
+}
+
+TEST_F(BulkLoaderTest, BinaryRoundTripMatchesCsv) {
+    std::string binary;
+    ASSERT_TRUE(BulkLoader::csvToBinary("c1,1111,A,100,1\nc2,2222,B,200\n", binary).ok);
+    BulkLoader loader(auth_, ledger_);
+    const BulkLoadReport report = loader.loadBinary(binary);
+    ASSERT_TRUE(report.ok) << report.error;
+    EXPECT_EQ(report.cards, 2u);
+    EXPECT_TRUE(auth_.checkPIN("2222", "c2"));
+    EXPECT_EQ(ledger_.getBalance(auth_.getAccountListForCard("c2")[0].id), Money(200));
+
+    binary.pop_back();
+    Ledger other;
+    AuthService otherAuth(other);
+    EXPECT_EQ(BulkLoader(otherAuth, other).loadBinary(binary).errorRow, 2u);
+}
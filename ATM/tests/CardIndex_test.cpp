@@ -0,0 +1,54 @@
+#include "atm/bank/CardIndex.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace atm;
+
+TEST(CardIndex, PackRoundTripsSupportedCards) {
+    for (const char* card : {"1", "pera123", "4000123412341234", "ABCDEFGHIJabcdefghij", "card-7"}) {
+        auto key = CardIndex::pack(card);
+        ASSERT_TRUE(key.has_value()) << card;
+        EXPECT_EQ(CardIndex::unpack(*key), card);
+    }
+    EXPECT_FALSE(CardIndex::pack("").has_value());
+    EXPECT_FALSE(CardIndex::pack("123456789012345678901").has_value());  // 21 characters
+    EXPECT_FALSE(CardIndex::pack("card 1").has_value());
+}
+
+TEST(CardIndex, FindsEveryCardAcrossRehashesAndOverflow) {
+    CardIndex index;
+    for (int i = 0; i < 5000; ++i) {
+        CardRecord& record = index.findOrInsert("c" + std::to_string(i));
+        record.pinDigest = static_cast<std::uint64_t>(i);
+    }
+    index.findOrInsert("card with spaces").pinDigest = 99999;
+    EXPECT_EQ(index.size(), 5001u);
+    for (int i = 0; i < 5000; ++i) {
+        const CardRecord* record = index.find("c" + std::to_string(i));
+        ASSERT_NE(record, nullptr);
+        EXPECT_EQ(record->pinDigest, static_cast<std::uint64_t>(i));
+    }
+    ASSERT_NE(index.find("card with spaces"), nullptr);
+    EXPECT_EQ(index.find("card with spaces")->pinDigest, 99999u);
+    EXPECT_EQ(index.find("c5000"), nullptr);
+
+    std::size_t visited = 0;
+    index.forEach([&](std::string_view, const CardRecord&) { ++visited; });
+    EXPECT_EQ(visited, 5001u);
+}
+
+TEST(CardIndex, AppendingToAnOlderCardKeepsBothRanges) {
+    CardIndex index;
+    const std::vector<AccountId> first{1, 2};
+    const std::vector<AccountId> second{3};
+    index.appendAccounts(index.findOrInsert("a"), first);
+    index.appendAccounts(index.findOrInsert("b"), second);
+    const AccountId extra = 4;
+    index.appendAccounts(*index.find("a"), std::span<const AccountId>(&extra, 1));
+
+    auto a = index.accountsOf(*index.find("a"));
+    EXPECT_EQ(std::vector<AccountId>(a.begin(), a.end()), (std::vector<AccountId>{1, 2, 4}));
+    auto b = index.accountsOf(*index.find("b"));
+    EXPECT_EQ(std::vector<AccountId>(b.begin(), b.end()), (std::vector<AccountId>{3}));
+}
@@ -0,0 +1,157 @@
+#include "atm/machine/DispensePlanner.h"
+#include "atm/machine/Hardware.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+std::int64_t planValue(const std::vector<Cassette>& cassettes, const DispensePlan& plan) {
+    std::int64_t cents = 0;
+    for (std::size_t i = 0; i < cassettes.size(); ++i) {
+        cents += cassettes[i].denomination.getCents() * plan[i];
+    }
+    return cents;
+}
+
+}  // namespace
+
+TEST(DispensePlannerTest, PlansRespectNoteCounts) {
+    const std::vector<Cassette> cassettes{{Money(2000), 5}, {Money(5000), 2}};
+    DispensePlanner planner;
+    planner.build(cassettes);
+    EXPECT_EQ(planner.total().getCents(), 20000);
+
+    const std::optional<DispensePlan> plan = planner.plan(Money(16000));
+    ASSERT_TRUE(plan.has_value());
+    EXPECT_EQ((*plan)[1], 2u);  // larger notes first
+    EXPECT_EQ((*plan)[0], 3u);
+    EXPECT_EQ(planValue(cassettes, *plan), 16000);
+
+    // 60.00 cannot use a 50, so it takes three 20s.
+    ASSERT_TRUE(planner.plan(Money(6000)).has_value());
+    EXPECT_EQ((*planner.plan(Money(6000)))[0], 3u);
+    EXPECT_TRUE(planner.canDispense(Money(20000)));
+    EXPECT_FALSE(planner.canDispense(Money(20001)));
+    EXPECT_FALSE(planner.canDispense(Money(3000)));
+    EXPECT_FALSE(planner.canDispense(Money(1000)));
+    EXPECT_TRUE(planner.canDispense(Money(0)));
+    EXPECT_FALSE(planner.canDispense(Money(-2000)));
+}
+
+TEST(DispensePlannerTest, NearestAmountsAroundAnUnpayableOne) {
+    const std::vector<Cassette> cassettes{{Money(5000), 2}, {Money(2000), 5}};
+    DispensePlanner planner;
+    planner.build(cassettes);
+    EXPECT_EQ(planner.nearestBelow(Money(3000)).getCents(), 2000);
+    EXPECT_EQ(planner.nearestAbove(Money(3000)).getCents(), 4000);
+    EXPECT_EQ(planner.nearestBelow(Money(1999)).getCents(), 0);
+    EXPECT_EQ(planner.nearestAbove(Money(1)).getCents(), 2000);
+    EXPECT_EQ(planner.nearestAbove(Money(19999)).getCents(), 20000);
+    EXPECT_EQ(planner.nearestAbove(Money(20001)).getCents(), 0);
+    EXPECT_EQ(planner.nearestBelow(Money(99999)).getCents(), 20000);
+    EXPECT_EQ(planner.nearestBelow(Money(18000)).getCents(), 18000);
+}
+
+TEST(DispensePlannerTest, AmountsBeyondTheTableAreSearched) {
+    // Unit is 1.00, so the table covers up to 4096.00 of the 8550.00 loaded.
+    const std::vector<Cassette> cassettes{{Money(10000), 50}, {Money(5000), 50}, {Money(2000), 50}, {Money(100), 50}};
+    DispensePlanner planner;
+    planner.build(cassettes);
+    EXPECT_EQ(planner.total().getCents(), 855000);
+
+    const std::optional<DispensePlan> plan = planner.plan(Money(612300));
+    ASSERT_TRUE(plan.has_value());
+    EXPECT_EQ(planValue(cassettes, *plan), 612300);
+    EXPECT_LE((*plan)[0], 50u);
+    EXPECT_FALSE(planner.canDispense(Money(612350)));
+    EXPECT_EQ(planner.nearestBelow(Money(612350)).getCents(), 612300);
+    EXPECT_EQ(planner.nearestAbove(Money(612350)).getCents(), 612400);
+    EXPECT_EQ(planner.nearestBelow(Money(900000)).getCents(), 855000);
+}
+
+TEST(DispensePlannerTest, ProposalsBeyondTheTableStayBounded) {
+    // Unit is 1.00: hundreds plus a single 1.00 note, 100001.00 in all.
+    const std::vector<Cassette> cassettes{{Money(10000), 1000}, {Money(100), 1}};
+    DispensePlanner planner;
+    planner.build(cassettes);
+
+    // The top of the range mirrors the table.
+    EXPECT_TRUE(planner.canDispense(Money(9990100)));
+    EXPECT_FALSE(planner.canDispense(Money(9995000)));
+    EXPECT_EQ(planner.nearestBelow(Money(9995000)).getCents(), 9990100);
+    EXPECT_EQ(planner.nearestAbove(Money(9995000)).getCents(), 10000000);
+
+    // In between, a fractional amount rounds to a payable whole unit...
+    EXPECT_EQ(planner.nearestBelow(Money(5000050)).getCents(), 5000000);
+    EXPECT_EQ(planner.nearestAbove(Money(5000050)).getCents(), 5000100);
+    // ...and anything else is capped at the table and its mirror instead of scanning for it.
+    EXPECT_EQ(planner.nearestBelow(Money(5005000)).getCents(), 400100);
+    EXPECT_EQ(planner.nearestAbove(Money(5005000)).getCents(), 9600000);
+}
+
+TEST(DispensePlannerTest, SingleCassetteNeedsNoTable) {
+    const std::vector<Cassette> cassettes{{Money(2000), 1000}};
+    DispensePlanner planner;
+    planner.build(cassettes);
+    EXPECT_TRUE(planner.canDispense(Money(2000000)));
+    EXPECT_FALSE(planner.canDispense(Money(2002000)));
+    EXPECT_FALSE(planner.canDispense(Money(2500)));
+    EXPECT_EQ(planner.nearestBelow(Money(2500)).getCents(), 2000);
+    EXPECT_EQ(planner.nearestAbove(Money(2500)).getCents(), 4000);
+    EXPECT_EQ((*planner.plan(Money(10000)))[0], 5u);
+
+    DispensePlanner empty;
+    empty.build({});
+    EXPECT_FALSE(empty.canDispense(Money(100)));
+    EXPECT_TRUE(empty.canDispense(Money(0)));
+    EXPECT_EQ(empty.nearestAbove(Money(100)).getCents(), 0);
+}
+
+TEST(DispensePlannerTest, ParseCassettes) {
+    std::vector<Cassette> cassettes;
+    std::string error;
+    ASSERT_TRUE(parseCassettes("5000x200,2000x500", &cassettes, &error)) << error;
+    ASSERT_EQ(cassettes.size(), 2u);
+    EXPECT_EQ(cassettes[0].denomination.getCents(), 5000);
+    EXPECT_EQ(cassettes[1].notes, 500u);
+
+    EXPECT_FALSE(parseCassettes("5000", &cassettes, &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(parseCassettes("0x10", &cassettes));
+    EXPECT_FALSE(parseCassettes("5000x-1", &cassettes));
+    EXPECT_FALSE(parseCassettes("1x1,1x1,1x1,1x1,1x1,1x1,1x1,1x1,1x1", &cassettes));
+    EXPECT_EQ(cassettes.size(), 2u);  // untouched on failure
+}
+
+TEST(CashDispenserTest, DispenseTakesNotesAndDepositsRecycle) {
+    CashDispenser dispenser({{Money(5000), 2}, {Money(2000), 5}});
+    EXPECT_EQ(dispenser.getAvailableCash().getCents(), 20000);
+    EXPECT_FALSE(dispenser.hasEnoughCash(Money(3000)));
+    EXPECT_FALSE(dispenser.dispense(Money(3000)));
+    EXPECT_EQ(dispenser.getAvailableCash().getCents(), 20000);
+
+    ASSERT_TRUE(dispenser.dispense(Money(9000)));  // 50 + 2 x 20
+    EXPECT_EQ(dispenser.getCassettes()[0].notes, 1u);
+    EXPECT_EQ(dispenser.getCassettes()[1].notes, 3u);
+    EXPECT_EQ(dispenser.getAvailableCash().getCents(), 11000);
+
+    // 70.50 becomes one 50 and one 20; the 0.50 goes to the bin.
+    dispenser.addCash(Money(7050));
+    EXPECT_EQ(dispenser.getCassettes()[0].notes, 2u);
+    EXPECT_EQ(dispenser.getCassettes()[1].notes, 4u);
+    EXPECT_EQ(dispenser.getDepositBinCash().getCents(), 50);
+    EXPECT_EQ(dispenser.getAvailableCash().getCents(), 18000);
+}
+
+TEST(CashDispenserTest, LegacyDispenserPaysAnyAmount) {
+    CashDispenser dispenser(Money(10000));
+    EXPECT_TRUE(dispenser.hasEnoughCash(Money(1234)));
+    ASSERT_TRUE(dispenser.dispense(Money(1234)));
+    EXPECT_EQ(dispenser.getAvailableCash().getCents(), 8766);
+    dispenser.addCash(Money(34));
+    EXPECT_EQ(dispenser.getAvailableCash().getCents(), 8800);
+    EXPECT_EQ(dispenser.getDepositBinCash().getCents(), 0);
+    EXPECT_FALSE(dispenser.hasEnoughCash(Money(8801)));
+}
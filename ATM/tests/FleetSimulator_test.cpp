@@ -0,0 +1,59 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/FleetSimulator.h"
+#include "atm/machine/LatencyHistogram.h"
+#include <gtest/gtest.h>
+
+using namespace atm;
+
+TEST(LatencyHistogram, BucketsKeepSixPercentPrecisionAndPercentilesFollowRank) {
+    for (std::uint64_t value : {0ull, 31ull, 32ull, 1000ull, 123456789ull, ~0ull}) {
+        const std::size_t bucket = LatencyHistogram::bucketOf(value);
+        ASSERT_LT(bucket, LatencyHistogram::kBucketCount);
+        const std::uint64_t lower = LatencyHistogram::bucketLowerBound(bucket);
+        EXPECT_LE(lower, value);
+        EXPECT_LE(value - lower, value / 16);
+    }
+
+    LatencyHistogram histogram;
+    for (std::uint64_t i = 1; i <= 1000; ++i) histogram.record(i * 1000);
+    EXPECT_EQ(histogram.count(), 1000u);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(0.5)), 500000.0, 500000.0 / 16);
+    EXPECT_NEAR(static_cast<double>(histogram.percentile(0.99)), 990000.0, 990000.0 / 16);
+    EXPECT_EQ(histogram.percentile(1.0), 1000000u);
+
+    LatencyHistogram other;
+    other.record(5'000'000);
+    histogram.merge(other);
+    EXPECT_EQ(histogram.summary().count, 1001u);
+    EXPECT_DOUBLE_EQ(histogram.summary().maxUs, 5000.0);
+}
+
+TEST(FleetSimulator, TerminalsShareOneLedgerAndEveryMovementIsAccountedFor) {
+    Ledger ledger;
+    AuthService auth(ledger);
+    TransactionManager tm(ledger);
+    Bank bank(tm, auth);
+    FleetConfig config;
+    config.terminals = 60;
+    config.threads = 3;
+    config.sessionsPerTerminal = 5;
+    config.cards = 20;
+    config.stateTimings = true;
+    FleetSimulator::provisionCards(auth, config);
+
+    const FleetReport report = FleetSimulator(bank, config).run();
+    EXPECT_EQ(report.sessions, 300u);
+    EXPECT_EQ(report.session.count, 300u);
+    EXPECT_EQ(report.login.count, 300u);
+    EXPECT_GT(report.balance.count + report.withdraw.count + report.deposit.count, 300u);
+    ASSERT_TRUE(report.stateTimings);
+    EXPECT_EQ(report.stateTimings->latency(StateId::EjectCard).handle.count, 300u);
+    EXPECT_EQ(report.stateTimings->latency(StateId::AskForPIN).bank.count, 300u);
+
+    std::int64_t total = 0;
+    ledger.forEachAccount([&](AccountId, std::string_view, Money balance) { total += balance.getCents(); });
+    EXPECT_EQ(total, 20 * 1'000'000'000LL - report.withdrawn.getCents() + report.deposited.getCents());
+}
@@ -0,0 +1,104 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/GatewayCache.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+using namespace atm;
+
+namespace {
+
+class GatewayCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auth_.setPinForCard("card", "1234");
+        id_ = auth_.addAccountToCard("card", SavingAccount("Savings", Money(5000)));
+    }
+
+    Ledger ledger_;
+    TransactionManager tm_{ledger_};
+    AuthService auth_{ledger_};
+    Bank bank_{tm_, auth_};
+    Gateway gateway_{bank_};
+    AccountId id_ = kInvalidAccountId;
+};
+
+}  // namespace
+
+TEST_F(GatewayCacheTest, RepeatedBalanceChecksHitTheCache) {
+    gateway_.enableCache(std::chrono::seconds(60), 16);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(gateway_.showBalance(id_).getCents(), 5000);
+    }
+    GatewayCacheStats stats = gateway_.cacheStats();
+    EXPECT_EQ(stats.balanceMisses, 1u);
+    EXPECT_EQ(stats.balanceHits, 2u);
+}
+
+TEST_F(GatewayCacheTest, OwnWithdrawalAndDepositInvalidateTheBalance) {
+    gateway_.enableCache(std::chrono::seconds(60), 16);
+    EXPECT_EQ(gateway_.showBalance(id_).getCents(), 5000);
+    ASSERT_TRUE(gateway_.withdrawCash(id_, Money(1000)));
+    EXPECT_EQ(gateway_.showBalance(id_).getCents(), 4000);
+    ASSERT_TRUE(gateway_.depositCashAsync(id_, Money(500)).get());
+    EXPECT_EQ(gateway_.showBalanceAsync(id_).get().getCents(), 4500);
+    EXPECT_EQ(gateway_.cacheStats().balanceMisses, 3u);
+
+    // A change made elsewhere is only seen once the entry expires.
+    ASSERT_TRUE(bank_.withdrawCash(id_, Money(500), kNoTerminal, kNoCard, kNoRequest));
+    EXPECT_EQ(gateway_.showBalance(id_).getCents(), 4500);
+}
+
+TEST_F(GatewayCacheTest, EntriesExpireAfterTtl) {
+    gateway_.enableCache(std::chrono::milliseconds(20), 16);
+    EXPECT_EQ(gateway_.showBalance(id_).getCents(), 5000);
+    ASSERT_TRUE(bank_.withdrawCash(id_, Money(100), kNoTerminal, kNoCard, kNoRequest));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    EXPECT_EQ(gateway_.showBalance(id_).getCents(), 4900);
+    EXPECT_EQ(gateway_.cacheStats().balanceHits, 0u);
+}
+
+TEST_F(GatewayCacheTest, LoginFillsTheAccountListCache) {
+    gateway_.enableCache(std::chrono::seconds(60), 16);
+    ASSERT_EQ(gateway_.authenticate("card", "1234").pinVerdict, PinVerdict::Accepted);
+    ASSERT_EQ(gateway_.getAccountListForCard("card").size(), 1u);
+    EXPECT_EQ(gateway_.cacheStats().accountListHits, 1u);
+    EXPECT_EQ(gateway_.cacheStats().accountListMisses, 0u);
+}
+
+TEST(GatewayCache, InvalidationOnlyBlocksStoresForItsOwnAccount) {
+    GatewayCache cache(std::chrono::seconds(60), 16);
+    // Find two accounts in different version stripes (most pairs are).
+    const AccountId first = 1;
+    AccountId second = 2;
+    while (true) {
+        const std::uint64_t before = cache.balanceToken(second);
+        cache.invalidateBalance(first);
+        if (cache.balanceToken(second) == before) break;
+        ++second;
+    }
+    const std::uint64_t firstToken = cache.balanceToken(first);
+    const std::uint64_t secondToken = cache.balanceToken(second);
+    cache.invalidateBalance(first);  // a withdrawal on the first account while both fetches are in flight
+    cache.storeBalance(first, Money(100), firstToken);
+    cache.storeBalance(second, Money(200), secondToken);
+    EXPECT_FALSE(cache.findBalance(first).has_value());
+    ASSERT_TRUE(cache.findBalance(second).has_value());
+    EXPECT_EQ(cache.findBalance(second)->getCents(), 200);
+}
+
+TEST(TtlCache, EvictsLeastRecentlyUsedBeyondCapacity) {
+    TtlCache<int, int> cache(std::chrono::seconds(60), 2);
+    cache.put(1, 10);
+    cache.put(2, 20);
+    ASSERT_TRUE(cache.get(1).has_value());  // 2 is now the least recently used
+    EXPECT_EQ(cache.put(3, 30), 1u);
+    EXPECT_FALSE(cache.get(2).has_value());
+    EXPECT_EQ(cache.get(1), 10);
+    EXPECT_EQ(cache.get(3), 30);
+}
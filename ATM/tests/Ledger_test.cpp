@@ -0,0 +1,70 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/Money.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+TEST(Ledger, OpenAccountAssignsDistinctStableIds) {
+    Ledger ledger(4);
+    AccountId a = ledger.openAccount(Account("A", Money(100)));
+    AccountId b = ledger.openAccount(Account("B", Money(200)));
+    EXPECT_NE(a, kInvalidAccountId);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(ledger.size(), 2u);
+    EXPECT_EQ(ledger.getName(a), "A");
+    EXPECT_EQ(ledger.getBalance(b)->getCents(), 200);
+}
+
+TEST(Ledger, UnknownIdHasNoBalanceAndIsNotUpdated) {
+    Ledger ledger;
+    EXPECT_FALSE(ledger.contains(42));
+    EXPECT_FALSE(ledger.getBalance(42).has_value());
+    EXPECT_EQ(ledger.debit(42, Money(1)), LedgerStatus::UnknownAccount);
+    EXPECT_EQ(ledger.credit(42, Money(1)), LedgerStatus::UnknownAccount);
+    EXPECT_EQ(ledger.getHandle(42).id, kInvalidAccountId);
+}
+
+TEST(Ledger, DebitAndCreditChangeBalanceInPlace) {
+    Ledger ledger;
+    AccountId id = ledger.openAccount(Account("A", Money(1000)));
+    Money resulting;
+    ASSERT_EQ(ledger.debit(id, Money(250), &resulting), LedgerStatus::Ok);
+    EXPECT_EQ(resulting.getCents(), 750);
+    ASSERT_EQ(ledger.credit(id, Money(50), &resulting), LedgerStatus::Ok);
+    EXPECT_EQ(resulting.getCents(), 800);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 800);
+}
+
+TEST(Ledger, DebitNeverDrivesBalanceNegative) {
+    Ledger ledger;
+    AccountId id = ledger.openAccount(Account("A", Money(100)));
+    EXPECT_EQ(ledger.debit(id, Money(101)), LedgerStatus::InsufficientFunds);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 100);
+    EXPECT_EQ(ledger.debit(id, Money(100)), LedgerStatus::Ok);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 0);
+}
+
+TEST(Ledger, ConcurrentUpdatesAcrossShardsAreNotLost) {
+    Ledger ledger(8);
+    std::vector<AccountId> ids;
+    for (int i = 0; i < 16; ++i) {
+        ids.push_back(ledger.openAccount(Account("A", Money(0))));
+    }
+    constexpr int kThreads = 4;
+    constexpr int kIncrements = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kIncrements; ++i) {
+                ledger.credit(ids[static_cast<size_t>(i) % ids.size()], Money(1));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    std::int64_t total = 0;
+    for (AccountId id : ids) total += ledger.getBalance(id)->getCents();
+    EXPECT_EQ(total, kThreads * kIncrements);
+}
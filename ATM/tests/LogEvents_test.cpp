@@ -0,0 +1,150 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/LogEvents.h"
+#include "atm/machine/Logger.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace atm;
+
+static_assert(detail::countPlaceholders("Card {card} in {state}") == 2);
+static_assert(detail::countPlaceholders("no arguments") == 0);
+static_assert(detail::countPlaceholders("empty {}") == -1);
+static_assert(detail::countPlaceholders("unclosed {card") == -1);
+static_assert(detail::countPlaceholders("stray }") == -1);
+static_assert(detail::unzigzag(detail::zigzag(static_cast<std::uint64_t>(-5))) == static_cast<std::uint64_t>(-5));
+
+namespace {
+
+struct Event {
+    std::string name;
+    std::string text;
+    std::string json;
+    std::vector<std::int64_t> args;
+};
+
+class LogEventsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const std::string test = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        textPath_ = (std::filesystem::temp_directory_path() / ("atm_" + test + ".log")).string();
+        eventPath_ = (std::filesystem::temp_directory_path() / ("atm_" + test + ".events")).string();
+        std::filesystem::remove(textPath_);
+        std::filesystem::remove(eventPath_);
+        account_ = ledger_.openAccount(Account("Test", Money(1000)));
+    }
+    void TearDown() override {
+        Logger::configure(LoggerConfig{});
+        std::filesystem::remove(textPath_);
+        std::filesystem::remove(eventPath_);
+    }
+
+    void use(bool eventFile) {
+        LoggerConfig config;
+        config.path = textPath_;
+        if (eventFile) config.eventPath = eventPath_;
+        std::string error;
+        ASSERT_TRUE(Logger::configure(config, &error)) << error;
+    }
+
+    std::vector<Event> replay() const {
+        std::vector<Event> events;
+        std::string error;
+        EXPECT_TRUE(replayLogEvents(
+            eventPath_,
+            [&](const DecodedLogEvent& e) {
+                events.push_back(Event{e.info->name, formatLogEvent(e), logEventJson(e),
+                                       std::vector<std::int64_t>(e.args.begin(), e.args.begin() + e.info->argCount)});
+            },
+            &error))
+            << error;
+        return events;
+    }
+
+    std::string text() const {
+        std::ifstream in(textPath_);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    std::string textPath_;
+    std::string eventPath_;
+    Ledger ledger_;
+    TransactionManager transactions_{ledger_};
+    AccountId account_ = kInvalidAccountId;
+};
+
+}  // namespace
+
+TEST_F(LogEventsTest, EventFileKeepsRawArgumentsForLogcat) {
+    use(true);
+    EXPECT_FALSE(transactions_.withdrawCash(account_, Money(5000)));
+    EXPECT_FALSE(transactions_.depositCash(account_ + 100, Money(250)));
+    Logger::event<LogEventId::CardBlocked>(std::string("pera123"));
+    Logger::event<LogEventId::AtmCashShort>(StateId::WithdrawFunds, Money(-7));
+    Logger::flush();
+
+    const std::vector<Event> events = replay();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[0].name, "WithdrawInsufficientFunds");
+    EXPECT_EQ(events[0].args, (std::vector<std::int64_t>{static_cast<std::int64_t>(account_), 5000}));
+    EXPECT_EQ(events[0].text, "Withdraw failed: insufficient account funds (account " + std::to_string(account_) +
+                                  ", 5000 cents)");
+    EXPECT_EQ(events[1].name, "DepositUnknownAccount");
+    EXPECT_EQ(events[1].args[1], 250);
+    EXPECT_EQ(events[2].args[0], static_cast<std::int64_t>(fnv1a64("pera123")));
+    EXPECT_EQ(events[2].text.find("pera123"), std::string::npos);
+    EXPECT_EQ(events[3].text, "Withdraw failed: insufficient ATM cash in WithdrawFunds for -7 cents");
+    EXPECT_NE(events[3].json.find("\"event\":\"AtmCashShort\",\"state\":\"WithdrawFunds\",\"cents\":-7}"),
+              std::string::npos);
+    EXPECT_EQ(text(), "");
+}
+
+TEST_F(LogEventsTest, RequestIdsPrintUnsigned) {
+    use(true);
+    const RequestId request = 0xF000000000000001ull;
+    Logger::event<LogEventId::BankRequestIdReused>(request, account_, Money(300));
+    Logger::flush();
+
+    const std::vector<Event> events = replay();
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(static_cast<std::uint64_t>(events[0].args[0]), request);
+    EXPECT_EQ(events[0].text.find("Request 17293822569102704641 rejected"), 0u);
+    EXPECT_NE(events[0].json.find("\"request\":17293822569102704641,"), std::string::npos);
+}
+
+TEST_F(LogEventsTest, WithoutEventFileEventsBecomeTextLines) {
+    use(false);
+    EXPECT_FALSE(transactions_.withdrawCash(account_, Money(0)));
+    Logger::log("plain line");
+    Logger::flush();
+    EXPECT_EQ(text(), "[ATM] Withdraw rejected: amount must be positive (account " + std::to_string(account_) +
+                          ", 0 cents)\n[ATM] plain line\n");
+}
+
+TEST_F(LogEventsTest, ReconfigureAppendsSegmentAndTornTailEndsTheFile) {
+    use(true);
+    Logger::event<LogEventId::DepositNegative>(account_, Money(-1));
+    use(true);
+    Logger::event<LogEventId::DepositNegative>(account_, Money(-2));
+    Logger::configure(LoggerConfig{});
+    {
+        std::ofstream out(eventPath_, std::ios::binary | std::ios::app);
+        out << static_cast<char>(static_cast<int>(LogEventId::DepositNegative) + 1) << '\x85';
+    }
+    const std::vector<Event> events = replay();
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].args[1], -1);
+    EXPECT_EQ(events[1].args[1], -2);
+}
+
+TEST_F(LogEventsTest, RejectsFilesThatAreNotEventLogs) {
+    { std::ofstream(eventPath_) << "[ATM] text log\n"; }
+    std::string error;
+    EXPECT_FALSE(replayLogEvents(eventPath_, [](const DecodedLogEvent&) {}, &error));
+    EXPECT_NE(error.find("not an event log"), std::string::npos);
+}
@@ -0,0 +1,167 @@
+#include "atm/machine/Logger.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+// Points the logger at a temp file for the test and back at stderr afterwards.
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = (std::filesystem::temp_directory_path() /
+                 ("atm_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".log"))
+                    .string();
+        std::filesystem::remove(path_);
+    }
+    void TearDown() override {
+        Logger::configure(LoggerConfig{});
+        std::filesystem::remove(path_);
+    }
+
+    void use(LoggerConfig config) {
+        config.path = path_;
+        std::string error;
+        ASSERT_TRUE(Logger::configure(config, &error)) << error;
+    }
+
+    std::vector<std::string> lines() const {
+        std::ifstream in(path_);
+        std::vector<std::string> result;
+        for (std::string line; std::getline(in, line);) result.push_back(line);
+        return result;
+    }
+
+    std::string path_;
+};
+
+}  // namespace
+
+TEST_F(LoggerTest, FormatsEventAndDetailLikeBefore) {
+    use(LoggerConfig{});
+    Logger::log("Bank connection lost");
+    Logger::log("Withdraw rejected", "amount below minimum");
+    Logger::log("Journal write failed", std::size_t{42});
+    Logger::log("Card blocked", std::string("pera123"));
+    Logger::log("Ratio", 0.5);
+    Logger::flush();
+
+    const std::vector<std::string> expected = {"[ATM] Bank connection lost",
+                                               "[ATM] Withdraw rejected: amount below minimum",
+                                               "[ATM] Journal write failed: 42", "[ATM] Card blocked: pera123",
+                                               "[ATM] Ratio: 0.5"};
+    EXPECT_EQ(lines(), expected);
+}
+
+TEST_F(LoggerTest, LongMessagesStayWholeAndLongDetailsAreCut) {
+    use(LoggerConfig{});
+    std::string table = "State timings";
+    for (int row = 0; row < 20; ++row) table += "\nrow " + std::to_string(row) + std::string(100, '.');
+    Logger::log(table);
+    Logger::log("Detail", std::string(1000, 'x'));
+    Logger::flush();
+
+    std::ifstream in(path_);
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(text.substr(0, 6 + table.size() + 1), "[ATM] " + table + "\n");
+    const std::vector<std::string> all = lines();
+    ASSERT_EQ(all.size(), 22u);
+    EXPECT_EQ(all.back().size(), 6 + kLogLineMax + 3);
+    EXPECT_EQ(all.back().substr(all.back().size() - 3), "...");
+}
+
+TEST_F(LoggerTest, BlockPolicyKeepsEveryLineInPerThreadOrder) {
+    LoggerConfig config;
+    config.ringCapacity = 8;
+    config.overflow = LogOverflow::Block;
+    use(config);
+    const LoggerStats before = Logger::stats();
+
+    constexpr int kThreads = 4;
+    constexpr int kLines = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < kLines; ++i) Logger::log("t" + std::to_string(t), i);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    Logger::flush();
+
+    std::vector<int> next(kThreads, 0);
+    for (const std::string& line : lines()) {
+        int thread = 0;
+        int value = 0;
+        ASSERT_EQ(std::sscanf(line.c_str(), "[ATM] t%d: %d", &thread, &value), 2) << line;
+        EXPECT_EQ(value, next[thread]++);
+    }
+    for (int count : next) EXPECT_EQ(count, kLines);
+    EXPECT_EQ(Logger::stats().dropped, before.dropped);
+    EXPECT_EQ(Logger::stats().written - before.written, std::uint64_t{kThreads * kLines});
+}
+
+TEST_F(LoggerTest, DropPolicyCountsWhatItDiscards) {
+    LoggerConfig config;
+    config.ringCapacity = 2;
+    config.flushInterval = std::chrono::milliseconds(1000);
+    use(config);
+    const LoggerStats before = Logger::stats();
+
+    constexpr int kLines = 1000;
+    std::thread([] {
+        for (int i = 0; i < kLines; ++i) Logger::log("Withdraw rejected", i);
+    }).join();
+    Logger::flush();
+
+    const LoggerStats after = Logger::stats();
+    const std::uint64_t dropped = after.dropped - before.dropped;
+    EXPECT_EQ(after.written - before.written + dropped, std::uint64_t{kLines});
+    std::uint64_t reported = 0;
+    std::size_t logged = 0;
+    for (const std::string& line : lines()) {
+        unsigned long long count = 0;
+        if (std::sscanf(line.c_str(), "[ATM] Log lines dropped: %llu", &count) == 1) {
+            reported += count;
+        }
+        else {
+            ++logged;
+        }
+    }
+    EXPECT_EQ(reported, dropped);
+    EXPECT_EQ(logged + dropped, std::size_t{kLines});
+}
+
+TEST_F(LoggerTest, ShutdownWritesPendingLinesThenLogsSynchronously) {
+    LoggerConfig config;
+    config.flushInterval = std::chrono::milliseconds(1000);
+    use(config);
+    Logger::log("queued");
+    Logger::shutdown();
+    EXPECT_EQ(lines(), std::vector<std::string>{"[ATM] queued"});
+
+    Logger::log("direct");
+    EXPECT_EQ(lines(), (std::vector<std::string>{"[ATM] queued", "[ATM] direct"}));
+}
+
+TEST_F(LoggerTest, SyncModeWritesOnTheCallingThread) {
+    LoggerConfig config;
+    config.async = false;
+    use(config);
+    Logger::log("Snapshot load failed", "bad magic");
+    EXPECT_EQ(lines(), std::vector<std::string>{"[ATM] Snapshot load failed: bad magic"});
+}
+
+TEST_F(LoggerTest, ConfigureRejectsUnwritablePath) {
+    LoggerConfig config;
+    config.path = (std::filesystem::temp_directory_path() / "atm_no_such_dir" / "x.log").string();
+    std::string error;
+    EXPECT_FALSE(Logger::configure(config, &error));
+    EXPECT_NE(error.find("cannot open"), std::string::npos);
+}
@@ -0,0 +1,126 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/Hardware.h"
+#include "atm/machine/Metrics.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(MetricsTest, CounterSumsIncrementsFromAllThreads) {
+    Counter counter;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; ++i) counter.inc();
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    counter.inc(5);
+    EXPECT_EQ(counter.value(), 80005u);
+}
+
+TEST(MetricsTest, SameNameAndLabelsReturnSameSeries) {
+    MetricsRegistry registry;
+    Counter& a = registry.counter("x_total", "X.", {{"reason", "a"}});
+    Counter& b = registry.counter("x_total", "X.", {{"reason", "b"}});
+    EXPECT_EQ(&a, &registry.counter("x_total", "X.", {{"reason", "a"}}));
+    EXPECT_NE(&a, &b);
+    EXPECT_EQ(&registry.gauge("y", "Y."), &registry.gauge("y", "Y."));
+}
+
+TEST(MetricsTest, ConcurrentRegistrationKeepsEverySeries) {
+    MetricsRegistry registry;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&registry, t] {
+            // Each new label grows the family's series vector while the other threads register too.
+            for (int i = 0; i < 200; ++i) {
+                registry.counter("grow_total", "Grow.", {{"series", std::to_string(t * 1000 + i)}}).inc();
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (int t = 0; t < 4; ++t) {
+        EXPECT_EQ(registry.counter("grow_total", "Grow.", {{"series", std::to_string(t * 1000 + 199)}}).value(), 1u);
+    }
+}
+
+TEST(MetricsTest, RendersPrometheusTextFormat) {
+    MetricsRegistry registry;
+    registry.counter("atm_x_total", "Things \\ done.\nSecond line", {{"reason", "say \"hi\""}}).inc(3);
+    registry.counter("atm_x_total", "ignored", {{"reason", "b"}});
+    registry.gauge("atm_cash_cents", "Cash.").set(-42);
+    EXPECT_EQ(registry.renderPrometheus(),
+              "# HELP atm_x_total Things \\\\ done.\\nSecond line\n"
+              "# TYPE atm_x_total counter\n"
+              "atm_x_total{reason=\"say \\\"hi\\\"\"} 3\n"
+              "atm_x_total{reason=\"b\"} 0\n"
+              "# HELP atm_cash_cents Cash.\n"
+              "# TYPE atm_cash_cents gauge\n"
+              "atm_cash_cents -42\n");
+}
+
+TEST(MetricsTest, ExporterWritesTextFileAndReportsFailure) {
+    const std::string path = (std::filesystem::temp_directory_path() / "atm_metrics_test.prom").string();
+    std::filesystem::remove(path);
+    MetricsRegistry registry;
+    registry.counter("atm_y_total", "Y.").inc();
+    {
+        MetricsTextFileExporter exporter(registry, path, std::chrono::milliseconds(10));
+        registry.counter("atm_y_total", "Y.").inc();
+    }
+    EXPECT_EQ(readFile(path), "# HELP atm_y_total Y.\n# TYPE atm_y_total counter\natm_y_total 2\n");
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+    std::filesystem::remove(path);
+
+    std::string error;
+    EXPECT_FALSE(registry.writeTextFile("/nonexistent-dir/atm.prom", &error));
+    EXPECT_NE(error.find("/nonexistent-dir/atm.prom.tmp"), std::string::npos);
+}
+
+TEST(MetricsTest, AtmMetricsCountTransactionsAndRejections) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    const AccountId account = ledger.openAccount(Account("Test", Money(100000)));
+    AtmMetrics& metrics = atmMetrics();
+    const std::uint64_t overLimit = metrics.rejected(LogEventId::WithdrawOverLimit).value();
+    const std::uint64_t unknown = metrics.rejected(LogEventId::DepositUnknownAccount).value();
+    const std::uint64_t withdrawals = metrics.withdrawals.value();
+    const std::uint64_t withdrawnCents = metrics.withdrawnCents.value();
+
+    EXPECT_TRUE(transactions.withdrawCash(account, Money(5000)));
+    EXPECT_FALSE(transactions.withdrawCash(account, Money(10'000'000)));
+    EXPECT_FALSE(transactions.depositCash(account + 100, Money(250)));
+    EXPECT_EQ(metrics.withdrawals.value() - withdrawals, 1u);
+    EXPECT_EQ(metrics.withdrawnCents.value() - withdrawnCents, 5000u);
+    EXPECT_EQ(metrics.rejected(LogEventId::WithdrawOverLimit).value() - overLimit, 1u);
+    EXPECT_EQ(metrics.rejected(LogEventId::DepositUnknownAccount).value() - unknown, 1u);
+    EXPECT_NE(MetricsRegistry::global().renderPrometheus().find(
+                  "atm_rejections_total{reason=\"WithdrawOverLimit\"}"),
+              std::string::npos);
+
+    Gauge gauge;
+    CashDispenser dispenser(Money(1000));
+    dispenser.setCashGauge(&gauge);
+    EXPECT_EQ(gauge.value(), 1000);
+    dispenser.dispense(Money(300));
+    dispenser.addCash(Money(50));
+    EXPECT_EQ(gauge.value(), 750);
+}
@@ -0,0 +1,133 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RequestDedupe.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/Metrics.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace atm;
+
+TEST(RequestDedupeTest, RepeatsGetTheFirstResult) {
+    RequestDedupe dedupe(64, 1);
+    bool result = false;
+    ASSERT_EQ(dedupe.begin(11, 100, &result), DedupeOutcome::New);
+    dedupe.finish(11, true);
+    EXPECT_EQ(dedupe.begin(11, 100, &result), DedupeOutcome::Repeat);
+    EXPECT_TRUE(result);
+    EXPECT_EQ(dedupe.begin(11, 101, &result), DedupeOutcome::Mismatch);  // same id, other operation
+
+    ASSERT_EQ(dedupe.begin(12, 100, &result), DedupeOutcome::New);
+    dedupe.finish(12, false);
+    result = true;
+    EXPECT_EQ(dedupe.begin(12, 100, &result), DedupeOutcome::Repeat);
+    EXPECT_FALSE(result);
+}
+
+TEST(RequestDedupeTest, OldestFinishedRequestIsEvictedWhenFull) {
+    RequestDedupe dedupe(0, 1);  // one shard of kMaxProbe slots
+    ASSERT_EQ(dedupe.capacity(), RequestDedupe::kMaxProbe);
+    for (RequestId id = 1; id <= RequestDedupe::kMaxProbe; ++id) {
+        ASSERT_EQ(dedupe.begin(id, id, nullptr), DedupeOutcome::New);
+    }
+    // Running requests are never evicted.
+    EXPECT_EQ(dedupe.begin(100, 100, nullptr), DedupeOutcome::TableFull);
+
+    for (RequestId id = 1; id <= RequestDedupe::kMaxProbe; ++id) dedupe.finish(id, true);
+    EXPECT_EQ(dedupe.begin(100, 100, nullptr), DedupeOutcome::New);  // takes request 1's slot
+    dedupe.finish(100, true);
+    EXPECT_EQ(dedupe.begin(2, 2, nullptr), DedupeOutcome::Repeat);
+    EXPECT_EQ(dedupe.begin(1, 1, nullptr), DedupeOutcome::New);  // forgotten
+}
+
+TEST(RequestDedupeTest, RepeatWaitsForTheRunningAttempt) {
+    RequestDedupe dedupe(64);
+    ASSERT_EQ(dedupe.begin(5, 1, nullptr), DedupeOutcome::New);
+    std::atomic<bool> answered{false};
+    bool result = false;
+    std::thread retry([&] {
+        EXPECT_EQ(dedupe.begin(5, 1, &result), DedupeOutcome::Repeat);
+        answered = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(answered.load());
+    dedupe.finish(5, true);
+    retry.join();
+    EXPECT_TRUE(answered.load());
+    EXPECT_TRUE(result);
+}
+
+TEST(RequestDedupeTest, NewRequestIdsAreDistinctAndNeverZero) {
+    std::unordered_set<RequestId> seen;
+    for (int i = 0; i < 10000; ++i) {
+        const RequestId id = newRequestId();
+        ASSERT_NE(id, kNoRequest);
+        ASSERT_TRUE(seen.insert(id).second);
+    }
+}
+
+TEST(RequestDedupeTest, BankMovesMoneyOncePerRequest) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    AuthService auth(ledger);
+    Bank bank(transactions, auth);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(100000)));
+    RequestDedupe dedupe(1024);
+    bank.setRequestDedupe(&dedupe);
+    EXPECT_EQ(bank.getRequestDedupe(), &dedupe);
+    AtmMetrics& metrics = atmMetrics();
+    const std::uint64_t repeats = metrics.requestRepeats.value();
+    const std::uint64_t reused = metrics.rejected(LogEventId::BankRequestIdReused).value();
+
+    const RequestId withdrawal = newRequestId();
+    EXPECT_TRUE(bank.withdrawCash(account, Money(1000), 1, kNoCard, withdrawal));
+    EXPECT_TRUE(bank.withdrawCash(account, Money(1000), 1, kNoCard, withdrawal));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 99000);
+
+    // A refused withdrawal stays refused on retry, even once the money is there.
+    const RequestId tooMuch = newRequestId();
+    EXPECT_FALSE(bank.withdrawCash(account, Money(200000), 1, kNoCard, tooMuch));
+    ASSERT_TRUE(bank.depositCash(account, Money(200000), 1, newRequestId()));
+    EXPECT_FALSE(bank.withdrawCash(account, Money(200000), 1, kNoCard, tooMuch));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 299000);
+
+    // The same id for a different operation is refused; kNoRequest is never deduplicated.
+    EXPECT_FALSE(bank.depositCash(account, Money(1000), 1, withdrawal));
+    EXPECT_TRUE(bank.withdrawCash(account, Money(500), 1, kNoCard, kNoRequest));
+    EXPECT_TRUE(bank.withdrawCash(account, Money(500), 1, kNoCard, kNoRequest));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 298000);
+
+    EXPECT_EQ(metrics.requestRepeats.value() - repeats, 2u);
+    EXPECT_EQ(metrics.rejected(LogEventId::BankRequestIdReused).value() - reused, 1u);
+}
+
+TEST(RequestDedupeTest, ConcurrentRetriesDebitOnce) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    AuthService auth(ledger);
+    Bank bank(transactions, auth);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(1'000'000)));
+    RequestDedupe dedupe(4096, 4);
+    bank.setRequestDedupe(&dedupe);
+    std::vector<RequestId> requests(500);
+    for (RequestId& id : requests) id = newRequestId();
+
+    std::atomic<int> succeeded{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (RequestId id : requests) {
+                if (bank.withdrawCash(account, Money(100), 1, kNoCard, id)) succeeded.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    EXPECT_EQ(succeeded.load(), 2000);  // every attempt is answered as a success
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 1'000'000 - 500 * 100);
+}
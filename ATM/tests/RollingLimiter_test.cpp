@@ -0,0 +1,131 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/Hashing.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RollingLimiter.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/Metrics.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+// 24-second window: one bucket per second.
+constexpr std::int64_t kWindow = 24;
+
+}  // namespace
+
+TEST(RollingLimiterTest, LimitHoldsForTheWindowThenExpires) {
+    RollingLimiter limiter(1000, 16, kWindow, 1);
+    EXPECT_EQ(limiter.tryAdd(7, 700, 1000), LimitVerdict::Allowed);
+    EXPECT_EQ(limiter.tryAdd(7, 400, 1010), LimitVerdict::OverLimit);
+    EXPECT_EQ(limiter.tryAdd(7, 300, 1010), LimitVerdict::Allowed);
+    EXPECT_EQ(limiter.used(7, 1010), 1000);
+    EXPECT_EQ(limiter.tryAdd(8, 1000, 1010), LimitVerdict::Allowed);  // keys are independent
+    EXPECT_EQ(limiter.tryAdd(7, 1001, 5000), LimitVerdict::OverLimit);
+
+    // Counted until one bucket after the window, so never more than the limit in any window.
+    EXPECT_EQ(limiter.tryAdd(7, 100, 1000 + kWindow), LimitVerdict::OverLimit);
+    EXPECT_EQ(limiter.used(7, 1000 + kWindow + 1), 300);
+    EXPECT_EQ(limiter.tryAdd(7, 700, 1000 + kWindow + 1), LimitVerdict::Allowed);
+    EXPECT_EQ(limiter.used(7, 1000 + 2 * kWindow + 2), 0);
+
+    EXPECT_EQ(limiter.tryAdd(0, 5000, 1000), LimitVerdict::Allowed);  // key 0 is not tracked
+    EXPECT_EQ(limiter.used(0, 1000), 0);
+}
+
+TEST(RollingLimiterTest, ExtraBucketsAreFoldedIntoLaterOnes) {
+    RollingLimiter limiter(1000, 16, kWindow, 1);
+    for (std::int64_t t = 0; t < 6; ++t) {
+        ASSERT_EQ(limiter.tryAdd(3, 100, 100 + t), LimitVerdict::Allowed);  // six buckets, four fit
+    }
+    EXPECT_EQ(limiter.used(3, 110), 600);
+    // The first amounts were folded forward, so they expire with a later bucket, not sooner.
+    EXPECT_EQ(limiter.used(3, 100 + kWindow + 1), 600);
+    EXPECT_EQ(limiter.used(3, 103 + kWindow + 1), 200);
+    EXPECT_EQ(limiter.used(3, 105 + kWindow + 1), 0);
+}
+
+TEST(RollingLimiterTest, RefundGivesRoomBack) {
+    RollingLimiter limiter(1000, 16, kWindow, 1);
+    ASSERT_EQ(limiter.tryAdd(5, 600, 50), LimitVerdict::Allowed);
+    ASSERT_EQ(limiter.tryAdd(5, 400, 51), LimitVerdict::Allowed);
+    limiter.refund(5, 400, 51);
+    EXPECT_EQ(limiter.used(5, 52), 600);
+    EXPECT_EQ(limiter.tryAdd(5, 400, 52), LimitVerdict::Allowed);
+    limiter.refund(5, 5000, 52);  // never below zero
+    EXPECT_EQ(limiter.used(5, 52), 600);
+    limiter.refund(99, 100, 52);  // unknown key
+}
+
+TEST(RollingLimiterTest, FullTableRefusesNewKeysUntilSlotsExpire) {
+    RollingLimiter limiter(1000, 0, kWindow, 1);  // one shard of kMaxProbe slots
+    ASSERT_EQ(limiter.capacity(), RollingLimiter::kMaxProbe);
+    for (std::uint64_t key = 1; key <= RollingLimiter::kMaxProbe; ++key) {
+        ASSERT_EQ(limiter.tryAdd(key, 10, 0), LimitVerdict::Allowed);
+    }
+    EXPECT_EQ(limiter.tryAdd(100, 10, 0), LimitVerdict::TableFull);
+    EXPECT_EQ(limiter.tryAdd(1, 10, 0), LimitVerdict::Allowed);  // known keys still work
+    EXPECT_EQ(limiter.tryAdd(100, 10, kWindow + 1), LimitVerdict::Allowed);
+    EXPECT_EQ(limiter.used(100, kWindow + 1), 10);
+}
+
+TEST(RollingLimiterTest, ConcurrentAddsNeverPassTheLimit) {
+    RollingLimiter limiter(5000, 1024, RollingLimiter::kDaySeconds, 4);
+    std::atomic<int> allowed{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 4000; ++i) {
+                if (limiter.tryAdd(42, 1, 1000) == LimitVerdict::Allowed) allowed.fetch_add(1);
+                limiter.tryAdd(static_cast<std::uint64_t>(i % 200 + 100), 1, 1000);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    EXPECT_EQ(allowed.load(), 5000);
+    EXPECT_EQ(limiter.used(42, 1000), 5000);
+    EXPECT_EQ(limiter.used(100, 1000), 80);
+}
+
+TEST(RollingLimiterTest, TransactionManagerEnforcesCardAndTerminalLimits) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    const AccountId saving = ledger.openAccount(Account("Saving", Money(100000)));
+    const AccountId checking = ledger.openAccount(Account("Checking", Money(100000)));
+    const AccountId poor = ledger.openAccount(Account("Poor", Money(100)));
+    RollingLimiter perCard(1000, 64);
+    RollingLimiter perTerminal(1500, 64);
+    transactions.setWithdrawalLimits(&perCard, &perTerminal);
+    EXPECT_EQ(transactions.getCardLimiter(), &perCard);
+    EXPECT_EQ(transactions.getTerminalLimiter(), &perTerminal);
+    const CardHash card = cardHash("card1");
+    AtmMetrics& metrics = atmMetrics();
+    const std::uint64_t overCard = metrics.rejected(LogEventId::WithdrawOverCardDailyLimit).value();
+    const std::uint64_t overTerminal = metrics.rejected(LogEventId::WithdrawOverTerminalDailyLimit).value();
+
+    // The card limit spans every account the card reaches.
+    EXPECT_TRUE(transactions.withdrawCash(saving, Money(600), 1, card));
+    EXPECT_FALSE(transactions.withdrawCash(checking, Money(500), 1, card));
+    EXPECT_TRUE(transactions.withdrawCash(checking, Money(400), 1, card));
+    EXPECT_EQ(ledger.getBalance(checking)->getCents(), 100000 - 400);
+
+    // A failed debit does not use up the limit.
+    EXPECT_FALSE(transactions.withdrawCash(poor, Money(400), 1, cardHash("card2")));
+    EXPECT_EQ(perCard.used(cardHash("card2"), RollingLimiter::nowSeconds()), 0);
+    EXPECT_EQ(perTerminal.used(1, RollingLimiter::nowSeconds()), 1000);
+
+    // Terminal 1 has 500 left; another card hits that limit instead.
+    EXPECT_FALSE(transactions.withdrawCash(saving, Money(600), 1, cardHash("card3")));
+    EXPECT_EQ(perCard.used(cardHash("card3"), RollingLimiter::nowSeconds()), 0);
+    EXPECT_TRUE(transactions.withdrawCash(saving, Money(600), 2, cardHash("card3")));
+
+    // Withdrawals without a card or terminal skip those limits.
+    EXPECT_TRUE(transactions.withdrawCash(saving, Money(900), kNoTerminal, kNoCard));
+
+    EXPECT_EQ(metrics.rejected(LogEventId::WithdrawOverCardDailyLimit).value() - overCard, 1u);
+    EXPECT_EQ(metrics.rejected(LogEventId::WithdrawOverTerminalDailyLimit).value() - overTerminal, 1u);
+}
@@ -0,0 +1,101 @@
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/ATM.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/Hardware.h"
+#include "atm/machine/ScriptedUserInterface.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace atm;
+
+TEST(SessionScript, ParsesAndPrintsTheCompactFormat) {
+    SessionScript script;
+    std::string error;
+    ASSERT_TRUE(script.append("# card pins account steps\n"
+                              "pera123 1234 1 B W2000 D5000 S\n"
+                              "\n"
+                              "mika7 0000,1111 2   # two attempts\n"
+                              "zika 9 1 B X W100\n",
+                              &error))
+        << error;
+    ASSERT_EQ(script.size(), 3u);
+    EXPECT_EQ(script.card(0), "pera123");
+    EXPECT_EQ(script.steps(0).size(), 4u);
+    EXPECT_EQ(script.steps(0)[1].option, MenuOption::Withdraw);
+    EXPECT_EQ(script.steps(0)[1].cents, 2000);
+    EXPECT_EQ(script.steps(0)[3].option, MenuOption::MiniStatement);
+    EXPECT_EQ(script.pinCount(1), 2u);
+    EXPECT_EQ(script.pin(1, 0), "0000");
+    EXPECT_EQ(script.pin(1, 5), "1111");  // the last PIN repeats
+    EXPECT_EQ(script.account(1), 2);
+    EXPECT_TRUE(script.steps(1).empty());
+    EXPECT_EQ(script.steps(2).size(), 1u);  // nothing after X
+
+    SessionScript copy;
+    ASSERT_TRUE(copy.append(script.toText()));
+    EXPECT_EQ(copy.toText(), script.toText());
+
+    EXPECT_FALSE(script.append("ok 1 1 B\nbad 1 1 Q\n", &error));
+    EXPECT_EQ(error.rfind("line 2:", 0), 0u);
+    EXPECT_EQ(script.size(), 3u);  // the good line before the bad one was not kept
+    EXPECT_FALSE(script.append("card 1234\n", &error));
+    EXPECT_FALSE(script.append("card 1234 1 W\n", &error));
+}
+
+TEST(ScriptedUserInterface, ReplaysSessionsAndRecordsOutputs) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    TransactionHistory history;
+    tm.setHistory(&history);
+    AuthService auth(ledger);
+    auth.setPinForCard("card1", "1234");
+    AccountId id = auth.addAccountToCard("card1", SavingAccount("Savings", Money(10000)));
+    Bank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(Money(100000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+
+    auto script = std::make_shared<SessionScript>();
+    ASSERT_TRUE(script->append("card1 0000,1234 1 B W3000\n"
+                               "card1 1234 7 D500 W20000 S\n"
+                               "nosuch 1234 1 B\n"));
+    auto ui = std::make_shared<ScriptedUserInterface>(script, 0, 3, 64);
+    AtmConfig config;
+    config.terminalId = 4;
+    ATM atm(ui, dispenser, depositSlot, gateway, config);
+    for (int i = 0; i < 200 && ui->hasPendingInput(); ++i) atm.runOnce();
+    for (int i = 0; i < 20 && atm.getCurrentState() != StateId::Idle; ++i) atm.runOnce();
+
+    EXPECT_FALSE(ui->hasPendingInput());
+    EXPECT_EQ(ui->sessionsDone(), 3u);
+    EXPECT_EQ(ui->count(UiOutput::PinRejected), 1u);
+    EXPECT_EQ(ui->count(UiOutput::PinAccepted), 2u);
+    EXPECT_EQ(ui->count(UiOutput::InvalidAccountSelection), 1u);  // account 7, then falls back to 1
+    EXPECT_EQ(ui->count(UiOutput::InsufficientAccountFunds), 1u);
+    EXPECT_EQ(ui->count(UiOutput::CardInsertedFailure), 1u);
+    EXPECT_EQ(ui->withdrawnCents(), 3000);
+    EXPECT_EQ(ui->depositedCents(), 500);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 10000 - 3000 + 500);
+    ASSERT_EQ(history.count(id), 2u);
+    EXPECT_EQ(history.last(id, 1)[0].terminal, 4u);
+
+    bool sawBalance = false;
+    for (const UiOutputRecord& record : ui->records()) {
+        if (record.output == UiOutput::Balance) {
+            EXPECT_EQ(record.session, 0u);
+            EXPECT_EQ(record.value, 10000);
+            sawBalance = true;
+        }
+        if (record.output == UiOutput::MiniStatement) {
+            EXPECT_EQ(record.value, 2);
+        }
+    }
+    EXPECT_TRUE(sawBalance);
+    EXPECT_EQ(ui->count(UiOutput::MiniStatement), 1u);
+}
@@ -0,0 +1,183 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Checksum.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/Snapshot.h"
+#include "atm/bank/TransactionManager.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace atm;
+
+namespace {
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = (std::filesystem::temp_directory_path() /
+                 ("atm_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) +
+                  ".snap"))
+                    .string();
+        std::filesystem::remove(path_);
+
+        Ledger ledger;
+        AuthService auth(ledger);
+        auth.setPinForCard("pera123", "1234");
+        savingId_ = auth.addAccountToCard("pera123", Account("Pera saving account", Money(200000)));
+        checkingId_ = auth.addAccountToCard("pera123", Account("Checking Account", Money(0)));
+        auth.setPinForCard("blocked1", "0000");
+        auth.addAccountToCard("blocked1", Account("Old", Money(5)));
+        auth.blockCard("blocked1");
+        for (int i = 0; i < 100; ++i) {
+            auth.setPinForCard("card" + std::to_string(i), std::to_string(1000 + i));
+        }
+        std::string error;
+        ASSERT_TRUE(SnapshotWriter::write(path_, auth, ledger, 42, &error)) << error;
+    }
+    void TearDown() override { std::filesystem::remove(path_); }
+
+    std::string path_;
+    AccountId savingId_ = kInvalidAccountId;
+    AccountId checkingId_ = kInvalidAccountId;
+};
+
+}  // namespace
+
+TEST_F(SnapshotTest, QueriesCardsAndAccountsInPlace) {
+    std::string error;
+    auto view = SnapshotView::open(path_, &error);
+    ASSERT_TRUE(view) << error;
+    EXPECT_TRUE(view->verify());
+    EXPECT_EQ(view->header().cardCount, 102u);
+    EXPECT_EQ(view->header().accountCount, 3u);
+    EXPECT_EQ(view->header().journalSequence, 42u);
+
+    const SnapshotCard* card = view->findCard("pera123");
+    ASSERT_NE(card, nullptr);
+    EXPECT_FALSE(card->flags & SnapshotCard::kBlocked);
+    auto accounts = view->accountsOf(*card);
+    ASSERT_EQ(accounts.size(), 2u);
+    EXPECT_EQ(accounts[0], savingId_);
+    const SnapshotAccount* saving = view->findAccount(savingId_);
+    ASSERT_NE(saving, nullptr);
+    EXPECT_EQ(saving->balanceCents, 200000);
+    EXPECT_EQ(view->accountName(*saving), "Pera saving account");
+
+    ASSERT_NE(view->findCard("card57"), nullptr);
+    EXPECT_EQ(view->findCard("nope"), nullptr);
+    EXPECT_TRUE(view->findCard("blocked1")->flags & SnapshotCard::kBlocked);
+}
+
+TEST_F(SnapshotTest, AttachedServicesAuthenticateAndDebitWithoutLoading) {
+    auto view = SnapshotView::open(path_);
+    ASSERT_TRUE(view);
+    Ledger ledger;
+    ASSERT_TRUE(ledger.attachSnapshot(*view));
+    AuthService auth(ledger);
+    auth.attachSnapshot(view.get());
+    TransactionManager tm(ledger);
+
+    EXPECT_TRUE(auth.checkIfCardExist("pera123"));
+    EXPECT_TRUE(auth.checkPIN("1234", "pera123"));
+    EXPECT_FALSE(auth.checkPIN("9999", "pera123"));
+    EXPECT_TRUE(auth.checkPIN("1057", "card57"));
+    EXPECT_FALSE(auth.checkIfCardExist("blocked1"));
+    EXPECT_FALSE(auth.checkIfCardExist("unknown"));
+
+    std::vector<AccountHandle> accounts = auth.getAccountListForCard("pera123");
+    ASSERT_EQ(accounts.size(), 2u);
+    EXPECT_EQ(accounts[0].name, "Pera saving account");
+    ASSERT_TRUE(tm.withdrawCash(accounts[0].id, Money(1500)));
+    EXPECT_EQ(ledger.getBalance(accounts[0].id)->getCents(), 198500);
+
+    // New accounts continue after the snapshot's IDs; blocks layer on top.
+    AccountId fresh = auth.addAccountToCard("newcard", Account("New", Money(10)));
+    EXPECT_EQ(fresh, 4u);
+    auth.blockCard("pera123");
+    EXPECT_FALSE(auth.checkPIN("1234", "pera123"));
+
+    // The mapping is private: the file still has the original balance.
+    auto reopened = SnapshotView::open(path_);
+    EXPECT_EQ(reopened->findAccount(savingId_)->balanceCents, 200000);
+}
+
+TEST_F(SnapshotTest, RewritingAnAttachedStateMergesSnapshotAndMemory) {
+    const std::string secondPath = path_ + ".2";
+    {
+        auto view = SnapshotView::open(path_);
+        Ledger ledger;
+        ledger.attachSnapshot(*view);
+        AuthService auth(ledger);
+        auth.attachSnapshot(view.get());
+        ledger.debit(savingId_, Money(100));
+        auth.addAccountToCard("newcard", Account("New", Money(10)));
+        auth.blockCard("card3");
+        ASSERT_TRUE(SnapshotWriter::write(secondPath, auth, ledger));
+    }
+    auto view = SnapshotView::open(secondPath);
+    ASSERT_TRUE(view);
+    EXPECT_EQ(view->header().cardCount, 103u);
+    EXPECT_EQ(view->findAccount(savingId_)->balanceCents, 199900);
+    EXPECT_TRUE(view->findCard("card3")->flags & SnapshotCard::kBlocked);
+    ASSERT_NE(view->findCard("newcard"), nullptr);
+    view.reset();
+    std::filesystem::remove(secondPath);
+}
+
+TEST_F(SnapshotTest, CorruptionIsDetected) {
+    {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(sizeof(SnapshotHeader) + 3));
+        file.put('X');
+    }
+    auto view = SnapshotView::open(path_);
+    ASSERT_TRUE(view);  // header is intact, payload check is explicit
+    EXPECT_FALSE(view->verify());
+
+    {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(20);
+        file.put('X');
+    }
+    std::string error;
+    EXPECT_FALSE(SnapshotView::open(path_, &error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(SnapshotView::open(path_ + ".missing"));
+}
+
+TEST_F(SnapshotTest, FullCardTableNeverHangsALookup) {
+    SnapshotHeader header{};
+    {
+        // Mark every slot used, as a corrupt payload could; open() does not check the payload.
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        for (std::uint64_t i = 0; i < header.cardSlotCount; ++i) {
+            const auto offset = static_cast<std::streamoff>(sizeof(SnapshotHeader) + i * sizeof(SnapshotCard));
+            SnapshotCard slot{};
+            file.seekg(offset);
+            file.read(reinterpret_cast<char*>(&slot), sizeof(slot));
+            slot.flags |= SnapshotCard::kUsed;
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(&slot), sizeof(slot));
+        }
+    }
+    auto view = SnapshotView::open(path_);
+    ASSERT_TRUE(view);
+    EXPECT_EQ(view->findCard("no-such-card"), nullptr);
+    ASSERT_NE(view->findCard("pera123"), nullptr);
+
+    // A header that claims as many cards as slots is refused outright.
+    header.cardCount = header.cardSlotCount;
+    header.headerChecksum = 0;
+    header.headerChecksum = crc32(&header, sizeof(header));
+    {
+        std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    std::string error;
+    EXPECT_FALSE(SnapshotView::open(path_, &error));
+    EXPECT_NE(error.find("no free slot"), std::string::npos);
+}
@@ -1,18 +1,30 @@
 #include "atm/bank/Account.h"
+#include "atm/bank/AsyncBankAdapter.h"
 #include "atm/bank/AuthService.h"
 #include "atm/bank/SavingAccount.h"
 #include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
 #include "atm/bank/Money.h"
 #include "atm/bank/TransactionManager.h"
+#include "atm/bank/TransactionHistory.h"
 #include "atm/machine/ATM.h"
 #include "atm/machine/AtmConstants.h"
 #include "atm/machine/Gateway.h"
 #include "atm/machine/Hardware.h"
 #include "atm/machine/IUserInterface.h"
 #include "atm/machine/MenuOption.h"
+#include "atm/machine/Metrics.h"
+#include "atm/machine/StateTransitions.h"
+#include "atm/machine/TerminalLoop.h"
+#include "atm/machine/TerminalScheduler.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace atm;
@@ -57,6 +69,9 @@ public:
     void showBalance(Money balance) override {
         logCall("showBalance:" + std::to_string(balance.getCents()));
     }
+    void showMiniStatement(const std::vector<HistoryEntry>& entries) override {
+        logCall("showMiniStatement:" + std::to_string(entries.size()));
+    }
     Money promptWithdrawAmount() override {
         logCall("promptWithdrawAmount");
         return Money(nextWithdrawCents);
@@ -71,6 +86,9 @@ public:
     void showDepositAmount(Money) override { logCall("showDepositAmount"); }
     void promptTakeCard() override { logCall("promptTakeCard"); }
     void showInsufficientAtmFunds() override { logCall("showInsufficientAtmFunds"); }
+    void showDispensableAmounts(Money lower, Money higher) override {
+        logCall("showDispensableAmounts:" + std::to_string(lower.getCents()) + ":" + std::to_string(higher.getCents()));
+    }
     void showInsufficientAccountFunds() override { logCall("showInsufficientAccountFunds"); }
     void promptInsertEnvelope() override { logCall("promptInsertEnvelope"); }
     void showDepositSuccess() override { logCall("showDepositSuccess"); }
@@ -100,8 +118,9 @@ static bool logContains(const std::vector<std::string>& log, const std::string&
 }
 
 TEST(StateMachine, StartsInIdleState) {
-    TransactionManager tm;
-    AuthService auth;
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
     Bank bank(tm, auth);
     auto gateway = std::make_shared<Gateway>(bank);
     auto dispenser = std::make_shared<CashDispenser>(Money(10000));
@@ -113,8 +132,9 @@ TEST(StateMachine, StartsInIdleState) {
 }
 
 TEST(StateMachine, IdleReadsCardAndTransitionsToCardInsertedState) {
-    TransactionManager tm;
-    AuthService auth;
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
     auth.setPinForCard("testcard", "1234");
     auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
     Bank bank(tm, auth);
@@ -133,8 +153,9 @@ TEST(StateMachine, IdleReadsCardAndTransitionsToCardInsertedState) {
 }
 
 TEST(StateMachine, FullFlowToCheckBalanceShowsCorrectBalance) {
-    TransactionManager tm;
-    AuthService auth;
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
     auth.setPinForCard("testcard", "1234");
     auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
     Bank bank(tm, auth);
@@ -163,9 +184,149 @@ TEST(StateMachine, FullFlowToCheckBalanceShowsCorrectBalance) {
     EXPECT_TRUE(logContains(fakeUi->log, "showBalance:5000"));
 }
 
-TEST(StateMachine, UnknownCardLeadsToCardNotExistAndEject) {
-    TransactionManager tm;
-    AuthService auth;
+TEST(StateMachine, RevisitedStateStartsFreshBankCall) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    Bank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 1000;
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    atm.runOnce();
+    EXPECT_EQ(atm.getCurrentState(), StateId::ShowOptions);
+    // Same state object again: the first withdrawal's result must not be reused.
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    atm.runOnce();
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 3000);
+}
+
+static bool tableHasEdge(StateId from, StateId to) {
+    for (const Transition& t : kTransitions) {
+        if (t.from == from && t.to == to) return true;
+    }
+    return false;
+}
+
+TEST(StateMachine, EveryStepFollowsTransitionTable) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    Bank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "0000";  // wrong every time: retries, then block and eject
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    std::vector<StateId> visited{atm.getCurrentState()};
+    for (int i = 0; i < 40 && (visited.size() == 1 || atm.getCurrentState() != StateId::Idle); ++i) {
+        atm.runOnce();
+        const StateId previous = visited.back();
+        visited.push_back(atm.getCurrentState());
+        EXPECT_TRUE(tableHasEdge(previous, visited.back()))
+            << stateIdName(previous) << " -> " << stateIdName(visited.back());
+    }
+    EXPECT_EQ(atm.getCurrentState(), StateId::Idle);
+    EXPECT_NE(std::find(visited.begin(), visited.end(), StateId::BlockCard), visited.end());
+}
+
+// Counts calls reaching the bank, to check how many round trips a login costs.
+class CountingBankService : public IBankService {
+public:
+    explicit CountingBankService(IBankService& inner) : inner_(inner) {}
+    int calls = 0;
+
+    bool checkIfCardExist(const std::string& card) override {
+        ++calls;
+        return inner_.checkIfCardExist(card);
+    }
+    bool checkPIN(const std::string& pin, const std::string& card) override {
+        ++calls;
+        return inner_.checkPIN(pin, card);
+    }
+    AuthResult authenticate(const std::string& card, const std::string& pin) override {
+        ++calls;
+        return inner_.authenticate(card, pin);
+    }
+    void blockCard(const std::string& card) override {
+        ++calls;
+        inner_.blockCard(card);
+    }
+    Money showBalance(AccountId account) override {
+        ++calls;
+        return inner_.showBalance(account);
+    }
+    bool withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId request) override {
+        ++calls;
+        return inner_.withdrawCash(account, amount, terminal, card, request);
+    }
+    bool depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) override {
+        ++calls;
+        return inner_.depositCash(account, amount, terminal, request);
+    }
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override {
+        ++calls;
+        return inner_.reserveCash(account, amount, terminal, card, hold);
+    }
+    bool commitCash(RequestId hold) override {
+        ++calls;
+        return inner_.commitCash(hold);
+    }
+    bool releaseCash(RequestId hold) override {
+        ++calls;
+        return inner_.releaseCash(hold);
+    }
+    std::vector<HistoryEntry> getMiniStatement(AccountId account, std::size_t count) override {
+        ++calls;
+        return inner_.getMiniStatement(account, count);
+    }
+    std::vector<AccountHandle> getAccountListForCard(const std::string& card) override {
+        ++calls;
+        return inner_.getAccountListForCard(card);
+    }
+
+private:
+    IBankService& inner_;
+};
+
+TEST(StateMachine, LoginTakesOneBankCall) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    Bank bank(tm, auth);
+    CountingBankService counting(bank);
+    auto gateway = std::make_shared<Gateway>(counting);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "ShowOptionsState");
+    EXPECT_EQ(counting.calls, 1);
+}
+
+TEST(StateMachine, UnknownCardIsRejectedAfterThePinPrompt) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
     auth.setPinForCard("othercard", "1234");
     Bank bank(tm, auth);
     auto gateway = std::make_shared<Gateway>(bank);
@@ -178,6 +339,8 @@ TEST(StateMachine, UnknownCardLeadsToCardNotExistAndEject) {
     atm.runOnce();
     EXPECT_EQ(atm.getCurrentStateName(), "CardInsertedState");
     atm.runOnce();
+    EXPECT_EQ(atm.getCurrentStateName(), "AskForPINState");
+    atm.runOnce();
     EXPECT_EQ(atm.getCurrentStateName(), "CardNotExistInSystemState");
     atm.runOnce();
     EXPECT_EQ(atm.getCurrentStateName(), "EjectCardState");
@@ -189,8 +352,9 @@ TEST(StateMachine, UnknownCardLeadsToCardNotExistAndEject) {
 TEST(StateMachine, WrongPinLeadsToUnsuccessfulPinState) {
     AtmConfig config;
     config.maxPinAttempts = 2;
-    TransactionManager tm(config);
-    AuthService auth;
+    Ledger ledger;
+    TransactionManager tm(ledger, config);
+    AuthService auth(ledger);
     auth.setPinForCard("testcard", "1234");
     auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
     Bank bank(tm, auth);
@@ -210,3 +374,415 @@ TEST(StateMachine, WrongPinLeadsToUnsuccessfulPinState) {
     atm.runOnce();
     EXPECT_TRUE(logContains(fakeUi->log, "showPinRejected"));
 }
+
+TEST(StateMachine, WithdrawDebitsTheBankLedgerNotASessionCopy) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    Bank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 1200;
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    atm.runOnce();
+    EXPECT_TRUE(logContains(fakeUi->log, "showWithdrawAmount:1200"));
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 3800);
+    EXPECT_EQ(tm.holds().held(), 0u);  // committed once the notes were out
+
+    // A fresh session for the same card sees the debited balance.
+    atm.resetSession();
+    atm.createSession("testcard");
+    auto accounts = gateway->getAccountListForCard("testcard");
+    ASSERT_EQ(accounts.size(), 1u);
+    EXPECT_EQ(gateway->showBalance(accounts[0].id).getCents(), 3800);
+}
+
+TEST(StateMachine, UnpayableWithdrawProposesNearestAmounts) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(50000)));
+    Bank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(std::vector<Cassette>{{Money(5000), 2}, {Money(2000), 5}});
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 3000;
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    atm.runOnce();
+    EXPECT_TRUE(logContains(fakeUi->log, "showDispensableAmounts:2000:4000"));
+    EXPECT_FALSE(logContains(fakeUi->log, "showWithdrawAmount"));
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 50000);
+    EXPECT_EQ(dispenser->getAvailableCash().getCents(), 20000);
+}
+
+// Bank whose reserve succeeds while the notes run out meanwhile (another cassette jams, say).
+class JammingBank : public Bank {
+public:
+    JammingBank(TransactionManager& tm, AuthService& auth, CashDispenser& dispenser)
+        : Bank(tm, auth), dispenser_(dispenser) {}
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override {
+        const bool ok = Bank::reserveCash(account, amount, terminal, card, hold);
+        dispenser_.dispense(dispenser_.getAvailableCash());
+        return ok;
+    }
+
+private:
+    CashDispenser& dispenser_;
+};
+
+TEST(StateMachine, FailedDispenseReleasesTheHeldFunds) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    TransactionHistory history;
+    tm.setHistory(&history);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    JammingBank bank(tm, auth, *dispenser);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 1200;
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    atm.runOnce();
+    EXPECT_TRUE(logContains(fakeUi->log, "showInsufficientAtmFunds"));
+    EXPECT_FALSE(logContains(fakeUi->log, "showWithdrawAmount"));
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 5000);
+    EXPECT_TRUE(history.last(id, 10).empty());
+    EXPECT_EQ(tm.holds().held(), 0u);
+}
+
+// Bank whose hold is gone by the time the commit arrives, as if the sweeper had expired it.
+class ExpiringBank : public Bank {
+public:
+    using Bank::Bank;
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override {
+        const bool ok = Bank::reserveCash(account, amount, terminal, card, hold);
+        Bank::releaseCash(hold);
+        return ok;
+    }
+};
+
+TEST(StateMachine, CommitRefusedAfterDispenseIsFlaggedForReconciliation) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    ExpiringBank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 1200;
+    Counter& refused = atmMetrics().rejected(LogEventId::AtmCommitRefusedAfterDispense);
+    const std::uint64_t refusedBefore = refused.value();
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    atm.runOnce();
+    EXPECT_TRUE(logContains(fakeUi->log, "showWithdrawAmount:1200"));
+    EXPECT_EQ(dispenser->getAvailableCash().getCents(), 8800);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 5000);  // the bank gave the funds back
+    EXPECT_EQ(refused.value() - refusedBefore, 1u);
+}
+
+// Async bank whose commit answers get lost on the way back, as with a dropped frame; the first
+// `lost` commits still run at the bank.
+class LossyCommitBank : public AsyncBankAdapter {
+public:
+    LossyCommitBank(IBankService& service, int lost) : AsyncBankAdapter(service), lost_(lost) {}
+    BankCall<std::optional<bool>> commitCash(RequestId hold) override {
+        ++attempts;
+        BankCall<std::optional<bool>> call = AsyncBankAdapter::commitCash(hold);
+        if (lost_ < 0 || lost_-- > 0) return BankCall<std::optional<bool>>::completed(std::nullopt);
+        return call;
+    }
+    int attempts = 0;
+
+private:
+    int lost_;
+};
+
+TEST(StateMachine, UnansweredCommitIsSentAgainUntilTheBankAnswers) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    Bank bank(tm, auth);
+    LossyCommitBank lossy(bank, 2);
+    auto gateway = std::make_shared<Gateway>(lossy);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 1200;
+    Counter& refused = atmMetrics().rejected(LogEventId::AtmCommitRefusedAfterDispense);
+    Counter& unanswered = atmMetrics().rejected(LogEventId::AtmCommitUnanswered);
+    const std::uint64_t refusedBefore = refused.value();
+    const std::uint64_t unansweredBefore = unanswered.value();
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, AtmConfig{});
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    for (int i = 0; i < 10 && atm.getCurrentStateName() == "WithdrawFundsState"; ++i) atm.runOnce();
+    EXPECT_NE(atm.getCurrentStateName(), "WithdrawFundsState");
+    EXPECT_EQ(lossy.attempts, 3);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 3800);
+    EXPECT_EQ(tm.holds().held(), 0u);
+    EXPECT_EQ(refused.value(), refusedBefore);  // lost answers are not refusals
+    EXPECT_EQ(unanswered.value(), unansweredBefore);
+}
+
+TEST(StateMachine, CommitUnansweredUntilTheHoldTtlIsFlagged) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    auth.addAccountToCard("testcard", SavingAccount("Savings", Money(5000)));
+    Bank bank(tm, auth);
+    LossyCommitBank lossy(bank, -1);
+    auto gateway = std::make_shared<Gateway>(lossy);
+    auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+    auto depositSlot = std::make_shared<DepositSlot>(*dispenser);
+    auto fakeUi = std::make_shared<FakeUserInterface>();
+    fakeUi->nextCard = "testcard";
+    fakeUi->nextPin = "1234";
+    fakeUi->nextMenuOption = MenuOption::Withdraw;
+    fakeUi->nextWithdrawCents = 1200;
+    Counter& unanswered = atmMetrics().rejected(LogEventId::AtmCommitUnanswered);
+    const std::uint64_t unansweredBefore = unanswered.value();
+    AtmConfig config;
+    config.withdrawHoldTtlMs = 250;
+
+    ATM atm(fakeUi, dispenser, depositSlot, gateway, config);
+    runUntilState(atm, *fakeUi, "WithdrawFundsState");
+    for (int i = 0; i < 20 && atm.getCurrentStateName() == "WithdrawFundsState"; ++i) atm.runOnce();
+    EXPECT_NE(atm.getCurrentStateName(), "WithdrawFundsState");
+    EXPECT_GE(lossy.attempts, 2);
+    EXPECT_EQ(unanswered.value() - unansweredBefore, 1u);
+}
+
+// Bank that takes a while to answer, as a remote one would.
+class SlowBankService : public Bank {
+public:
+    using Bank::Bank;
+    AuthResult authenticate(const std::string& card, const std::string& pin) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return Bank::authenticate(card, pin);
+    }
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return Bank::reserveCash(account, amount, terminal, card, hold);
+    }
+};
+
+// One customer: insert card once, withdraw once, then exit.
+class OneWithdrawalUi : public FakeUserInterface {
+public:
+    std::string readCard() override {
+        std::string card = FakeUserInterface::readCard();
+        nextCard.clear();
+        return card;
+    }
+    MenuOption promptMenuOption() override {
+        MenuOption option = FakeUserInterface::promptMenuOption();
+        nextMenuOption = MenuOption::Exit;
+        return option;
+    }
+};
+
+TEST(StateMachine, OneThreadDrivesManyTerminalsWhileBankCallsAreInFlight) {
+    constexpr int kTerminals = 300;
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(1'000'000)));
+    SlowBankService bank(tm, auth);
+    AsyncBankAdapter adapter(bank, 4);
+    auto gateway = std::make_shared<Gateway>(adapter);
+
+    std::vector<std::shared_ptr<OneWithdrawalUi>> uis;
+    std::vector<std::unique_ptr<ATM>> atms;
+    TerminalLoop loop;
+    for (int i = 0; i < kTerminals; ++i) {
+        auto ui = std::make_shared<OneWithdrawalUi>();
+        ui->nextCard = "testcard";
+        ui->nextPin = "1234";
+        ui->nextMenuOption = MenuOption::Withdraw;
+        ui->nextWithdrawCents = 100;
+        auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+        atms.push_back(std::make_unique<ATM>(ui, dispenser, std::make_shared<DepositSlot>(*dispenser), gateway));
+        uis.push_back(ui);
+        loop.add(*atms.back());
+    }
+
+    std::size_t maxWaiting = 0;
+    loop.runUntil([&] {
+        std::size_t waiting = 0;
+        bool allEjected = true;
+        for (int i = 0; i < kTerminals; ++i) {
+            waiting += atms[i]->isWaitingForBank() ? 1 : 0;
+            allEjected = allEjected && logContains(uis[i]->log, "showCardEjected");
+        }
+        maxWaiting = std::max(maxWaiting, waiting);
+        return allEjected;
+    });
+
+    EXPECT_GT(maxWaiting, 4u);  // more requests in flight than bank worker threads
+    for (const auto& ui : uis) EXPECT_TRUE(logContains(ui->log, "showWithdrawAmount:100"));
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 1'000'000 - 100 * kTerminals);
+}
+
+// A customer who walks up only when told to (notifyInput), then withdraws once.
+class WalkUpUi : public OneWithdrawalUi {
+public:
+    explicit WalkUpUi(std::atomic<int>& ejected) : ejected_(ejected) {}
+    std::atomic<bool> customerWaiting{false};
+
+    bool hasPendingInput() const override { return customerWaiting.load(); }
+    std::string readCard() override {
+        if (!customerWaiting.exchange(false)) return {};
+        return OneWithdrawalUi::readCard();
+    }
+    void showCardEjected(const std::string& card) override {
+        OneWithdrawalUi::showCardEjected(card);
+        ejected_.fetch_add(1);
+    }
+
+private:
+    std::atomic<int>& ejected_;
+};
+
+TEST(StateMachine, SchedulerParksIdleTerminalsUntilInputArrives) {
+    constexpr int kTerminals = 200;
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    auth.setPinForCard("testcard", "1234");
+    AccountId id = auth.addAccountToCard("testcard", SavingAccount("Savings", Money(1'000'000)));
+    SlowBankService bank(tm, auth);
+    AsyncBankAdapter adapter(bank, 4);
+    auto gateway = std::make_shared<Gateway>(adapter);
+
+    std::atomic<int> ejected{0};
+    std::vector<std::shared_ptr<WalkUpUi>> uis;
+    std::vector<std::unique_ptr<ATM>> atms;
+    TerminalScheduler scheduler(4);
+    for (int i = 0; i < kTerminals; ++i) {
+        auto ui = std::make_shared<WalkUpUi>(ejected);
+        ui->nextCard = "testcard";
+        ui->nextPin = "1234";
+        ui->nextMenuOption = MenuOption::Withdraw;
+        ui->nextWithdrawCents = 100;
+        auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+        atms.push_back(std::make_unique<ATM>(ui, dispenser, std::make_shared<DepositSlot>(*dispenser), gateway));
+        uis.push_back(ui);
+        scheduler.add(*atms.back());
+    }
+    scheduler.start();
+
+    // With nobody at the terminals each is stepped once, then parks.
+    const auto startDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (scheduler.stats().steps < kTerminals && std::chrono::steady_clock::now() < startDeadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(scheduler.stats().steps, static_cast<std::uint64_t>(kTerminals));
+
+    for (int i = 0; i < kTerminals; ++i) {
+        uis[i]->customerWaiting = true;
+        atms[i]->notifyInput();
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (ejected.load() < kTerminals && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(ejected.load(), kTerminals);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 1'000'000 - 100 * kTerminals);
+
+    // Back at Idle with no input: no more steps.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const std::uint64_t settled = scheduler.stats().steps;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(scheduler.stats().steps, settled);
+    scheduler.stop();
+    for (const auto& ui : uis) EXPECT_TRUE(logContains(ui->log, "showWithdrawAmount:100"));
+}
+
+// Idle terminal whose every step asks to be stepped again from inside the step, the way a bank
+// completion or notifyInput() can arrive mid-step; notes if two workers ever step it at once.
+class SelfWakingUi : public FakeUserInterface {
+public:
+    ATM* atm = nullptr;
+    std::atomic<int> inside{0};
+    std::atomic<int> maxInside{0};
+    std::atomic<int> steps{0};
+
+    bool hasPendingInput() const override { return false; }
+    std::string readCard() override {
+        const int now = inside.fetch_add(1) + 1;
+        int seen = maxInside.load();
+        while (now > seen && !maxInside.compare_exchange_weak(seen, now)) {
+        }
+        atm->notifyInput();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));  // give another worker time to pick it up
+        steps.fetch_add(1);
+        inside.fetch_sub(1);
+        return {};
+    }
+};
+
+TEST(StateMachine, SchedulerNeverStepsOneTerminalOnTwoWorkers) {
+    Ledger ledger;
+    TransactionManager tm(ledger);
+    AuthService auth(ledger);
+    Bank bank(tm, auth);
+    auto gateway = std::make_shared<Gateway>(bank);
+    std::vector<std::shared_ptr<SelfWakingUi>> uis;
+    std::vector<std::unique_ptr<ATM>> atms;
+    TerminalScheduler scheduler(4);
+    for (int i = 0; i < 3; ++i) {
+        auto ui = std::make_shared<SelfWakingUi>();
+        auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+        atms.push_back(std::make_unique<ATM>(ui, dispenser, std::make_shared<DepositSlot>(*dispenser), gateway));
+        ui->atm = atms.back().get();
+        uis.push_back(ui);
+        scheduler.add(*atms.back());
+    }
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    scheduler.stop();
+    for (const auto& ui : uis) {
+        EXPECT_GT(ui->steps.load(), 10);  // the wake-up during the step was not lost
+        EXPECT_EQ(ui->maxInside.load(), 1);
+    }
+}
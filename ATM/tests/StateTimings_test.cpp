@@ -0,0 +1,148 @@
+#include "atm/bank/AsyncBankAdapter.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/SavingAccount.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/machine/ATM.h"
+#include "atm/machine/Gateway.h"
+#include "atm/machine/Hardware.h"
+#include "atm/machine/Logger.h"
+#include "atm/machine/ScriptedUserInterface.h"
+#include "atm/machine/StateTimings.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace atm;
+
+namespace {
+
+constexpr auto kSlow = std::chrono::milliseconds(3);
+constexpr double kSlowUs = 3000.0;
+
+// Balance lookups take kSlow; everything else goes straight through.
+class SlowBalanceBank : public IBankService {
+public:
+    explicit SlowBalanceBank(IBankService& inner) : inner_(inner) {}
+    bool checkIfCardExist(const std::string& card) override { return inner_.checkIfCardExist(card); }
+    bool checkPIN(const std::string& pin, const std::string& card) override { return inner_.checkPIN(pin, card); }
+    AuthResult authenticate(const std::string& card, const std::string& pin) override {
+        return inner_.authenticate(card, pin);
+    }
+    void blockCard(const std::string& card) override { inner_.blockCard(card); }
+    Money showBalance(AccountId account) override {
+        std::this_thread::sleep_for(kSlow);
+        return inner_.showBalance(account);
+    }
+    bool withdrawCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId request) override {
+        return inner_.withdrawCash(account, amount, terminal, card, request);
+    }
+    bool depositCash(AccountId account, Money amount, TerminalId terminal, RequestId request) override {
+        return inner_.depositCash(account, amount, terminal, request);
+    }
+    bool reserveCash(AccountId account, Money amount, TerminalId terminal, CardHash card, RequestId hold) override {
+        return inner_.reserveCash(account, amount, terminal, card, hold);
+    }
+    bool commitCash(RequestId hold) override { return inner_.commitCash(hold); }
+    bool releaseCash(RequestId hold) override { return inner_.releaseCash(hold); }
+    std::vector<HistoryEntry> getMiniStatement(AccountId account, std::size_t count) override {
+        return inner_.getMiniStatement(account, count);
+    }
+    std::vector<AccountHandle> getAccountListForCard(const std::string& card) override {
+        return inner_.getAccountListForCard(card);
+    }
+
+private:
+    IBankService& inner_;
+};
+
+// Customer who takes kSlow to pick each menu option.
+class SlowMenuCustomer : public ScriptedUserInterface {
+public:
+    using ScriptedUserInterface::ScriptedUserInterface;
+    MenuOption promptMenuOption() override {
+        std::this_thread::sleep_for(kSlow);
+        return ScriptedUserInterface::promptMenuOption();
+    }
+};
+
+struct TimedSession {
+    Ledger ledger;
+    TransactionManager tm{ledger};
+    AuthService auth{ledger};
+    Bank bank{tm, auth};
+    SlowBalanceBank slowBank{bank};
+    std::shared_ptr<StateTimings> timings = std::make_shared<StateTimings>();
+
+    TimedSession() {
+        auth.setPinForCard("card1", "1234");
+        auth.addAccountToCard("card1", SavingAccount("Savings", Money(5000)));
+    }
+
+    // Runs sessions "card1 1234 1 B B" to completion on an ATM using gateway.
+    void run(const std::shared_ptr<Gateway>& gateway, int sessions) {
+        auto script = std::make_shared<SessionScript>();
+        script->append("card1 1234 1 B B\n");
+        auto ui = std::make_shared<SlowMenuCustomer>(script, 0, sessions);
+        auto dispenser = std::make_shared<CashDispenser>(Money(10000));
+        ATM atm(ui, dispenser, std::make_shared<DepositSlot>(*dispenser), gateway, AtmConfig{});
+        atm.setStateTimings(timings);
+        while (ui->sessionsDone() < static_cast<std::uint64_t>(sessions)) {
+            if (!atm.runOnce()) std::this_thread::yield();
+        }
+    }
+};
+
+}  // namespace
+
+TEST(StateTimings, SeparatesOwnTimeFromUiAndBankTime) {
+    TimedSession session;
+    session.run(std::make_shared<Gateway>(session.slowBank), 2);
+
+    const StateLatency balance = session.timings->latency(StateId::CheckBalance);
+    EXPECT_EQ(balance.bank.count, 4u);  // two lookups per session
+    EXPECT_GE(balance.bank.p50Us, kSlowUs);
+    EXPECT_LT(balance.handle.p99Us, kSlowUs);  // the sleep is not the state's own time
+    EXPECT_GE(balance.ui.count, 4u);            // showBalance
+
+    const StateLatency menu = session.timings->latency(StateId::ShowOptions);
+    EXPECT_EQ(menu.ui.count, 6u);  // B, B, exit per session
+    EXPECT_GE(menu.ui.p50Us, kSlowUs);
+    EXPECT_LT(menu.handle.p99Us, kSlowUs);
+    EXPECT_EQ(menu.bank.count, 0u);
+
+    EXPECT_NE(session.timings->report().find("CheckBalance"), std::string::npos);
+}
+
+TEST(StateTimings, ParkedBankWaitCountsOncePerVisit) {
+    TimedSession session;
+    AsyncBankAdapter workers(session.slowBank, 1);
+    session.run(std::make_shared<Gateway>(workers), 1);
+
+    const StateLatency balance = session.timings->latency(StateId::CheckBalance);
+    EXPECT_EQ(balance.bank.count, 2u);
+    EXPECT_GE(balance.bank.p50Us, kSlowUs * 0.9);  // completion is stamped on the worker
+    EXPECT_LT(balance.handle.p99Us, kSlowUs);
+    EXPECT_GE(balance.handle.count, 4u);  // each visit: start and park, then finish
+}
+
+#ifdef SIGUSR1
+TEST(StateTimings, DumpsReportOnSignal) {
+    auto timings = std::make_shared<StateTimings>();
+    timings->recordHandle(StateId::Idle, 1000);
+    testing::internal::CaptureStderr();
+    {
+        StateTimingsDumper dumper(timings, SIGUSR1);
+        std::raise(SIGUSR1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    }
+    Logger::flush();
+    const std::string output = testing::internal::GetCapturedStderr();
+    EXPECT_NE(output.find("State timings"), std::string::npos);
+    EXPECT_NE(output.find("Idle"), std::string::npos);
+}
+#endif
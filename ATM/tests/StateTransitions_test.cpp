@@ -0,0 +1,31 @@
+#include "atm/machine/StateTransitions.h"
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace atm;
+
+// Resolved at compile time; a missing edge here would fail the build, not the test.
+static_assert(kNextState<StateId::AskForPIN, StateEvent::PinAccepted> == StateId::SuccessfulPin);
+static_assert(kNextState<StateId::Reset, StateEvent::Next> == StateId::Idle);
+static_assert(!isValidTransition(StateId::Idle, StateEvent::PinAccepted));
+
+TEST(StateTransitions, LookupFollowsTable) {
+    for (const Transition& t : kTransitions) {
+        ASSERT_TRUE(nextState(t.from, t.event).has_value());
+        EXPECT_EQ(*nextState(t.from, t.event), t.to);
+    }
+    EXPECT_FALSE(nextState(StateId::Idle, StateEvent::Done).has_value());
+    EXPECT_FALSE(nextState(StateId::WithdrawFunds, StateEvent::CardRead).has_value());
+}
+
+TEST(StateTransitions, DotExportListsEveryEdge) {
+    const std::string dot = transitionGraphDot();
+    EXPECT_EQ(dot.rfind("digraph ATM {", 0), 0u);
+    EXPECT_NE(dot.find("AskForPIN -> SuccessfulPin [label=\"PinAccepted\"];"), std::string::npos);
+    EXPECT_NE(dot.find("Reset -> Idle [label=\"Next\"];"), std::string::npos);
+    std::size_t edges = 0;
+    for (std::size_t pos = dot.find(" -> "); pos != std::string::npos; pos = dot.find(" -> ", pos + 1)) {
+        ++edges;
+    }
+    EXPECT_EQ(edges, std::size(kTransitions));
+}
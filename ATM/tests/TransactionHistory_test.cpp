@@ -0,0 +1,130 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionManager.h"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+HistoryEntry entryAt(std::int64_t timeUs, std::int64_t amountCents) {
+    HistoryEntry entry;
+    entry.timeUs = timeUs;
+    entry.type = HistoryType::Deposit;
+    entry.amount = Money(amountCents);
+    entry.balance = Money(amountCents * 10);
+    entry.terminal = 3;
+    return entry;
+}
+
+}  // namespace
+
+TEST(TransactionHistoryTest, LastReturnsNewestFirstAcrossChunks) {
+    TransactionHistory history(1);  // both accounts share one shard, so their rows interleave
+    const std::int64_t rows = static_cast<std::int64_t>(TransactionHistory::kChunkRows) + 100;
+    for (std::int64_t i = 0; i < rows; ++i) {
+        history.append(1, entryAt(1000 + i, i));
+        history.append(2, entryAt(1000 + i, -i));
+    }
+    EXPECT_EQ(history.size(), static_cast<std::size_t>(2 * rows));
+    EXPECT_EQ(history.count(1), static_cast<std::size_t>(rows));
+    EXPECT_EQ(history.count(3), 0u);
+    EXPECT_TRUE(history.last(3, 5).empty());
+
+    std::vector<HistoryEntry> last = history.last(1, 3);
+    ASSERT_EQ(last.size(), 3u);
+    EXPECT_EQ(last[0].amount.getCents(), rows - 1);
+    EXPECT_EQ(last[2].amount.getCents(), rows - 3);
+    EXPECT_EQ(last[0].balance.getCents(), (rows - 1) * 10);
+    EXPECT_EQ(last[0].type, HistoryType::Deposit);
+    EXPECT_EQ(last[0].terminal, 3u);
+    EXPECT_EQ(history.last(2, 1)[0].amount.getCents(), -(rows - 1));
+    EXPECT_EQ(history.last(1, 100000).size(), static_cast<std::size_t>(rows));
+}
+
+TEST(TransactionHistoryTest, RangeIsHalfOpenOldestFirstAndLimited) {
+    TransactionHistory history;
+    for (std::int64_t i = 0; i < 100; ++i) history.append(7, entryAt(i * 10, i));
+
+    std::vector<HistoryEntry> entries = history.range(7, 200, 300);
+    ASSERT_EQ(entries.size(), 10u);
+    EXPECT_EQ(entries.front().timeUs, 200);
+    EXPECT_EQ(entries.back().timeUs, 290);
+
+    entries = history.range(7, 205, 10000, 2);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].timeUs, 210);
+    EXPECT_EQ(entries[1].timeUs, 220);
+
+    EXPECT_TRUE(history.range(7, 300, 300).empty());
+    EXPECT_TRUE(history.range(7, 5000, 6000).empty());
+    EXPECT_TRUE(history.range(8, 0, 1000).empty());
+}
+
+TEST(TransactionHistoryTest, OlderTimestampIsRaisedToKeepOrder) {
+    TransactionHistory history;
+    history.append(1, entryAt(500, 1));
+    history.append(1, entryAt(400, 2));  // clock stepped back
+    history.append(2, entryAt(100, 3));  // other accounts are not affected
+
+    std::vector<HistoryEntry> entries = history.range(1, 0, 1000);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].timeUs, 500);
+    EXPECT_EQ(entries[1].timeUs, 500);
+    EXPECT_EQ(entries[1].amount.getCents(), 2);
+    EXPECT_EQ(history.last(2, 1)[0].timeUs, 100);
+}
+
+TEST(TransactionHistoryTest, ConcurrentAppendsKeepEveryRowInOrder) {
+    TransactionHistory history(4);
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&history, t] {
+            for (int i = 0; i < kPerThread; ++i) {
+                history.append(static_cast<AccountId>(i % 10), entryAt(i, t));
+                if (i % 100 == 0) history.last(static_cast<AccountId>(t), 5);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    EXPECT_EQ(history.size(), static_cast<std::size_t>(kThreads * kPerThread));
+    for (AccountId id = 0; id < 10; ++id) {
+        EXPECT_EQ(history.count(id), static_cast<std::size_t>(kThreads * kPerThread / 10));
+        std::vector<HistoryEntry> entries = history.range(id, 0, kPerThread);
+        ASSERT_EQ(entries.size(), history.count(id));
+        for (std::size_t i = 1; i < entries.size(); ++i) EXPECT_LE(entries[i - 1].timeUs, entries[i].timeUs);
+    }
+}
+
+TEST(TransactionHistoryTest, TransactionManagerRecordsOnlySuccessfulChanges) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    const AccountId account = ledger.openAccount(Account("Test", Money(10000)));
+    EXPECT_TRUE(transactions.miniStatement(account, 5).empty());  // no history attached
+
+    TransactionHistory history;
+    transactions.setHistory(&history);
+    EXPECT_EQ(transactions.getHistory(), &history);
+    EXPECT_TRUE(transactions.withdrawCash(account, Money(3000), 42));
+    EXPECT_FALSE(transactions.withdrawCash(account, Money(50000), 42));
+    EXPECT_TRUE(transactions.depositCash(account, Money(500)));
+    EXPECT_FALSE(transactions.depositCash(account + 100, Money(500)));
+
+    std::vector<HistoryEntry> entries = transactions.miniStatement(account, 5);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].type, HistoryType::Deposit);
+    EXPECT_EQ(entries[0].amount.getCents(), 500);
+    EXPECT_EQ(entries[0].balance.getCents(), 7500);
+    EXPECT_EQ(entries[0].terminal, kNoTerminal);
+    EXPECT_EQ(entries[1].type, HistoryType::Withdraw);
+    EXPECT_EQ(entries[1].amount.getCents(), 3000);
+    EXPECT_EQ(entries[1].balance.getCents(), 7000);
+    EXPECT_EQ(entries[1].terminal, 42u);
+    EXPECT_EQ(history.size(), 2u);
+}
@@ -0,0 +1,232 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/Money.h"
+#include "atm/bank/TransactionJournal.h"
+#include "atm/bank/TransactionManager.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+// Journal file in the temp directory, removed before and after each test.
+class TempJournalPath {
+public:
+    explicit TempJournalPath(const std::string& name)
+        : path_((std::filesystem::temp_directory_path() / ("atm_" + name + ".journal")).string()) {
+        std::filesystem::remove(path_);
+    }
+    ~TempJournalPath() { std::filesystem::remove(path_); }
+    const std::string& str() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+std::vector<JournalRecord> readAll(const std::string& path) {
+    std::vector<JournalRecord> records;
+    TransactionJournal::replay(path, [&](const JournalRecord& r) { records.push_back(r); });
+    return records;
+}
+
+}  // namespace
+
+TEST(TransactionJournal, AppendsInEveryDurabilityModeAndReplaysInOrder) {
+    TempJournalPath path("journal_modes");
+    {
+        TransactionJournal journal(path.str());
+        ASSERT_TRUE(journal.isHealthy());
+        JournalRecord record;
+        record.type = JournalRecordType::Deposit;
+        record.accountId = 7;
+        record.amountCents = 100;
+        EXPECT_EQ(journal.append(record, Durability::Sync), 1u);
+        EXPECT_EQ(journal.durableSequence(), 1u);
+        record.amountCents = 200;
+        EXPECT_EQ(journal.append(record, Durability::Group), 2u);
+        EXPECT_EQ(journal.durableSequence(), 2u);
+        record.amountCents = 300;
+        EXPECT_EQ(journal.append(record, Durability::Async), 3u);
+        EXPECT_TRUE(journal.flush());
+        EXPECT_EQ(journal.durableSequence(), 3u);
+        EXPECT_GT(journal.appendCardBlock("card1"), 0u);
+    }
+    std::vector<JournalRecord> records = readAll(path.str());
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].amountCents, 100);
+    EXPECT_EQ(records[2].amountCents, 300);
+    EXPECT_EQ(records[2].sequence, 3u);
+    EXPECT_EQ(records[3].type, JournalRecordType::CardBlock);
+    EXPECT_EQ(records[3].cardNumber(), "card1");
+}
+
+TEST(TransactionJournal, RecoverRebuildsBalancesAndBlockedCards) {
+    TempJournalPath path("journal_recover");
+    AccountId id;
+    {
+        Ledger ledger;
+        AuthService auth(ledger);
+        TransactionManager tm(ledger);
+        auth.setPinForCard("card1", "1234");
+        id = auth.addAccountToCard("card1", Account("Savings", Money(10000)));
+        TransactionJournal journal(path.str());
+        tm.setJournal(&journal);
+        Bank bank(tm, auth);
+        ASSERT_TRUE(bank.withdrawCash(id, Money(2500), kNoTerminal, kNoCard, kNoRequest));
+        ASSERT_TRUE(bank.depositCash(id, Money(300), kNoTerminal, kNoRequest));
+        ASSERT_FALSE(bank.withdrawCash(id, Money(999999), kNoTerminal, kNoCard, kNoRequest));  // rejected, not journaled
+        bank.blockCard("card1");
+    }
+    // Restart: same seed, then replay.
+    Ledger ledger;
+    AuthService auth(ledger);
+    auth.setPinForCard("card1", "1234");
+    ASSERT_EQ(auth.addAccountToCard("card1", Account("Savings", Money(10000))), id);
+    EXPECT_EQ(TransactionJournal::recover(path.str(), ledger, auth), 3u);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 7800);
+    EXPECT_FALSE(auth.checkIfCardExist("card1"));
+}
+
+TEST(TransactionJournal, RecoverReleasesHoldsLeftOpen) {
+    TempJournalPath path("journal_holds");
+    const RequestId committed = newRequestId();
+    const RequestId open = newRequestId();
+    const RequestId released = newRequestId();
+    AccountId id;
+    {
+        Ledger ledger;
+        TransactionManager tm(ledger);
+        id = ledger.openAccount(Account("Savings", Money(10000)));
+        TransactionJournal journal(path.str());
+        tm.setJournal(&journal);
+        ASSERT_TRUE(tm.reserveWithdrawal(id, Money(1000), 1, kNoCard, committed));
+        ASSERT_TRUE(tm.commitWithdrawal(committed));
+        ASSERT_TRUE(tm.reserveWithdrawal(id, Money(2000), 1, kNoCard, open));
+        ASSERT_TRUE(tm.reserveWithdrawal(id, Money(500), 1, kNoCard, released));
+        ASSERT_TRUE(tm.releaseWithdrawal(released));
+        EXPECT_EQ(ledger.getBalance(id)->getCents(), 7000);
+    }
+    const std::vector<JournalRecord> records = readAll(path.str());
+    ASSERT_EQ(records.size(), 5u);
+    EXPECT_EQ(records[1].type, JournalRecordType::HoldCommit);
+    EXPECT_EQ(records[1].holdId(), committed);
+
+    // Restart: the open hold is still debited after replay, then released and journaled as such.
+    {
+        Ledger ledger;
+        TransactionManager tm(ledger);
+        AuthService auth(ledger);
+        ASSERT_EQ(ledger.openAccount(Account("Savings", Money(10000))), id);
+        std::vector<JournalRecord> openHolds;
+        EXPECT_EQ(TransactionJournal::recover(path.str(), ledger, auth, 0, &openHolds), 5u);
+        EXPECT_EQ(ledger.getBalance(id)->getCents(), 7000);
+        ASSERT_EQ(openHolds.size(), 1u);
+        EXPECT_EQ(openHolds[0].holdId(), open);
+        EXPECT_EQ(openHolds[0].amountCents, 2000);
+        TransactionJournal journal(path.str());
+        tm.setJournal(&journal);
+        EXPECT_EQ(tm.releaseRecoveredHolds(openHolds), 1u);
+        EXPECT_EQ(ledger.getBalance(id)->getCents(), 9000);
+    }
+    // A second restart sees the release and finds nothing open.
+    std::vector<JournalRecord> openHolds;
+    {
+        Ledger ledger;
+        AuthService auth(ledger);
+        ASSERT_EQ(ledger.openAccount(Account("Savings", Money(10000))), id);
+        EXPECT_EQ(TransactionJournal::recover(path.str(), ledger, auth, 0, &openHolds), 6u);
+        EXPECT_EQ(ledger.getBalance(id)->getCents(), 9000);
+        EXPECT_TRUE(openHolds.empty());
+    }
+    // Same from a snapshot taken while the hold was open: its reserve is behind the snapshot.
+    Ledger ledger;
+    AuthService auth(ledger);
+    ASSERT_EQ(ledger.openAccount(Account("Savings", Money(7000))), id);
+    EXPECT_EQ(TransactionJournal::recover(path.str(), ledger, auth, records.back().sequence, &openHolds), 1u);
+    EXPECT_EQ(ledger.getBalance(id)->getCents(), 9000);
+    EXPECT_TRUE(openHolds.empty());
+}
+
+TEST(TransactionJournal, TornTailIsIgnoredAndTruncatedOnReopen) {
+    TempJournalPath path("journal_torn");
+    {
+        TransactionJournal journal(path.str());
+        journal.appendDeposit(1, Money(10));
+        journal.appendDeposit(1, Money(20));
+    }
+    {
+        std::ofstream out(path.str(), std::ios::binary | std::ios::app);
+        out << "half a record";
+    }
+    EXPECT_EQ(readAll(path.str()).size(), 2u);
+    {
+        TransactionJournal journal(path.str());
+        EXPECT_EQ(journal.appendDeposit(1, Money(30)), 3u);
+    }
+    std::vector<JournalRecord> records = readAll(path.str());
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[2].amountCents, 30);
+}
+
+TEST(TransactionJournal, ConcurrentGroupCommitKeepsEveryRecord) {
+    TempJournalPath path("journal_group");
+    constexpr int kThreads = 8;
+    constexpr int kPerThread = 250;
+    {
+        JournalConfig config;
+        config.durability = Durability::Group;
+        TransactionJournal journal(path.str(), config);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < kPerThread; ++i) {
+                    EXPECT_GT(journal.appendDeposit(static_cast<AccountId>(t + 1), Money(1)), 0u);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        EXPECT_EQ(journal.durableSequence(), static_cast<std::uint64_t>(kThreads * kPerThread));
+    }
+    std::vector<JournalRecord> records = readAll(path.str());
+    ASSERT_EQ(records.size(), static_cast<size_t>(kThreads * kPerThread));
+    std::set<std::uint64_t> sequences;
+    for (const auto& record : records) sequences.insert(record.sequence);
+    EXPECT_EQ(sequences.size(), records.size());
+}
+
+TEST(TransactionJournal, UnjournaledDepositIsTakenBackWithoutGoingNegative) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(1000)));
+    TransactionJournal broken((std::filesystem::temp_directory_path() / "atm_no_such_dir" / "x.journal").string());
+    ASSERT_FALSE(broken.isHealthy());
+    transactions.setJournal(&broken);
+
+    EXPECT_FALSE(transactions.depositCash(account, Money(500)));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 1000);
+    EXPECT_FALSE(transactions.withdrawCash(account, Money(200)));  // not journaled either, so put back
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 1000);
+}
+
+TEST(TransactionJournal, CardNumbersTooLongForARecordAreNotCut) {
+    TempJournalPath path("journal_long_card");
+    const std::string longCard(30, '7');
+    const std::string cutCard = longCard.substr(0, JournalRecord::kCardSize);
+    {
+        TransactionJournal journal(path.str());
+        EXPECT_EQ(journal.appendCardBlock(longCard), 0u);
+        EXPECT_TRUE(journal.isHealthy());  // only that record is refused
+        EXPECT_GT(journal.appendCardBlock(cutCard), 0u);
+    }
+    const std::vector<JournalRecord> records = readAll(path.str());
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].cardNumber(), cutCard);
+}
@@ -1,8 +1,13 @@
 #include "atm/bank/Account.h"
+#include "atm/bank/Ledger.h"
 #include "atm/bank/TransactionManager.h"
 #include "atm/bank/Money.h"
 #include "atm/machine/AtmConstants.h"
 #include <gtest/gtest.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
 
 using namespace atm;
 
@@ -12,101 +17,167 @@ protected:
         // Strict limits so we can test rejections: max 500 cents per withdrawal
         config_.minWithdrawCents = 1;
         config_.maxWithdrawPerTransactionCents = 500;
-        manager_ = std::make_unique<TransactionManager>(config_);
+        manager_ = std::make_unique<TransactionManager>(ledger_, config_);
     }
 
+    AccountId open(std::int64_t cents) { return ledger_.openAccount(Account("Test", Money(cents))); }
+    std::int64_t balance(AccountId id) const { return ledger_.getBalance(id)->getCents(); }
+
     AtmConfig config_;
+    Ledger ledger_;
     std::unique_ptr<TransactionManager> manager_;
 };
 
 TEST_F(TransactionManagerTest, ShowBalanceReturnsAccountAmount) {
-    Account account("Test", Money(12345));
-    EXPECT_EQ(manager_->showBalance(&account).getCents(), 12345);
+    AccountId account = open(12345);
+    EXPECT_EQ(manager_->showBalance(account).getCents(), 12345);
 }
 
 TEST_F(TransactionManagerTest, ValidWithdrawUpdatesBalance) {
-    Account account("Test", Money(10000));
-    bool ok = manager_->withdrawCash(&account, Money(300));
+    AccountId account = open(10000);
+    bool ok = manager_->withdrawCash(account, Money(300));
     ASSERT_TRUE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 9700);
+    EXPECT_EQ(balance(account), 9700);
 }
 
 TEST_F(TransactionManagerTest, ValidDepositUpdatesBalance) {
-    Account account("Test", Money(1000));
-    bool ok = manager_->depositCash(&account, Money(500));
+    AccountId account = open(1000);
+    bool ok = manager_->depositCash(account, Money(500));
     ASSERT_TRUE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 1500);
+    EXPECT_EQ(balance(account), 1500);
 }
 
 TEST_F(TransactionManagerTest, NegativeWithdrawRejected) {
-    Account account("Test", Money(10000));
-    bool ok = manager_->withdrawCash(&account, Money(-100));
+    AccountId account = open(10000);
+    bool ok = manager_->withdrawCash(account, Money(-100));
     EXPECT_FALSE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 10000);
+    EXPECT_EQ(balance(account), 10000);
 }
 
 TEST_F(TransactionManagerTest, ZeroWithdrawRejected) {
-    Account account("Test", Money(10000));
-    bool ok = manager_->withdrawCash(&account, Money(0));
+    AccountId account = open(10000);
+    bool ok = manager_->withdrawCash(account, Money(0));
     EXPECT_FALSE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 10000);
+    EXPECT_EQ(balance(account), 10000);
 }
 
 TEST_F(TransactionManagerTest, NegativeDepositRejected) {
-    Account account("Test", Money(1000));
-    bool ok = manager_->depositCash(&account, Money(-50));
+    AccountId account = open(1000);
+    bool ok = manager_->depositCash(account, Money(-50));
     EXPECT_FALSE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 1000);
+    EXPECT_EQ(balance(account), 1000);
 }
 
-TEST_F(TransactionManagerTest, NullAccountWithdrawRejected) {
-    bool ok = manager_->withdrawCash(nullptr, Money(100));
+TEST_F(TransactionManagerTest, UnknownAccountWithdrawRejected) {
+    bool ok = manager_->withdrawCash(kInvalidAccountId, Money(100));
     EXPECT_FALSE(ok);
 }
 
-TEST_F(TransactionManagerTest, NullAccountDepositRejected) {
-    bool ok = manager_->depositCash(nullptr, Money(100));
+TEST_F(TransactionManagerTest, UnknownAccountDepositRejected) {
+    bool ok = manager_->depositCash(kInvalidAccountId, Money(100));
     EXPECT_FALSE(ok);
 }
 
 TEST_F(TransactionManagerTest, WithdrawOverConfigLimitRejected) {
-    Account account("Test", Money(10000));
+    AccountId account = open(10000);
     // config max is 500
-    bool ok = manager_->withdrawCash(&account, Money(501));
+    bool ok = manager_->withdrawCash(account, Money(501));
     EXPECT_FALSE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 10000);
+    EXPECT_EQ(balance(account), 10000);
 }
 
 TEST_F(TransactionManagerTest, WithdrawAtConfigLimitSucceeds) {
-    Account account("Test", Money(10000));
-    bool ok = manager_->withdrawCash(&account, Money(500));
+    AccountId account = open(10000);
+    bool ok = manager_->withdrawCash(account, Money(500));
     ASSERT_TRUE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 9500);
+    EXPECT_EQ(balance(account), 9500);
 }
 
 TEST_F(TransactionManagerTest, InsufficientFundsWithdrawRejected) {
-    Account account("Test", Money(100));
-    bool ok = manager_->withdrawCash(&account, Money(200));
+    AccountId account = open(100);
+    bool ok = manager_->withdrawCash(account, Money(200));
     EXPECT_FALSE(ok);
-    EXPECT_EQ(account.getAmount().getCents(), 100);
+    EXPECT_EQ(balance(account), 100);
 }
 
 TEST_F(TransactionManagerTest, FullFlowBalanceConsistency) {
-    Account account("Savings", Money(10000));  // 100.00
+    AccountId account = open(10000);  // 100.00
+
+    EXPECT_EQ(manager_->showBalance(account).getCents(), 10000);
+
+    ASSERT_TRUE(manager_->withdrawCash(account, Money(250)));
+    EXPECT_EQ(balance(account), 9750);
 
-    EXPECT_EQ(manager_->showBalance(&account).getCents(), 10000);
+    ASSERT_TRUE(manager_->depositCash(account, Money(100)));
+    EXPECT_EQ(balance(account), 9850);
 
-    ASSERT_TRUE(manager_->withdrawCash(&account, Money(250)));
-    EXPECT_EQ(account.getAmount().getCents(), 9750);
+    ASSERT_TRUE(manager_->withdrawCash(account, Money(500)));  // at limit
+    EXPECT_EQ(balance(account), 9350);
 
-    ASSERT_TRUE(manager_->depositCash(&account, Money(100)));
-    EXPECT_EQ(account.getAmount().getCents(), 9850);
+    EXPECT_FALSE(manager_->withdrawCash(account, Money(10000)));  // over balance
+    EXPECT_EQ(balance(account), 9350);
+
+    EXPECT_EQ(manager_->showBalance(account).getCents(), 9350);
+}
 
-    ASSERT_TRUE(manager_->withdrawCash(&account, Money(500)));  // at limit
-    EXPECT_EQ(account.getAmount().getCents(), 9350);
+TEST_F(TransactionManagerTest, ConcurrentWithdrawalsNeverOverdraw) {
+    AccountId account = open(200);
+    constexpr int kThreads = 4;
+    constexpr int kAttemptsPerThread = 100;
+    std::atomic<int> succeeded{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kAttemptsPerThread; ++i) {
+                if (manager_->withdrawCash(account, Money(1))) succeeded.fetch_add(1);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(succeeded.load(), 200);
+    EXPECT_EQ(balance(account), 0);
+}
 
-    EXPECT_FALSE(manager_->withdrawCash(&account, Money(10000)));  // over balance
-    EXPECT_EQ(account.getAmount().getCents(), 9350);
+TEST_F(TransactionManagerTest, ConcurrentStressConservesMoney) {
+    constexpr int kAccounts = 8;
+    constexpr int kThreads = 4;
+    constexpr int kOpsPerThread = 20000;
+    std::vector<AccountId> accounts;
+    std::int64_t initialTotal = 0;
+    for (int i = 0; i < kAccounts; ++i) {
+        accounts.push_back(open(1'000'000));
+        initialTotal += 1'000'000;
+    }
+    std::atomic<std::int64_t> withdrawn{0};
+    std::atomic<std::int64_t> deposited{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<unsigned>(t + 1));
+            std::uniform_int_distribution<int> pick(0, kAccounts - 1);
+            std::uniform_int_distribution<std::int64_t> cents(1, 500);
+            std::int64_t localWithdrawn = 0;
+            std::int64_t localDeposited = 0;
+            for (int i = 0; i < kOpsPerThread; ++i) {
+                AccountId account = accounts[static_cast<size_t>(pick(rng))];
+                Money amount(cents(rng));
+                if (i % 2 == 0) {
+                    if (manager_->withdrawCash(account, amount)) localWithdrawn += amount.getCents();
+                }
+                else if (manager_->depositCash(account, amount)) {
+                    localDeposited += amount.getCents();
+                }
+            }
+            withdrawn.fetch_add(localWithdrawn);
+            deposited.fetch_add(localDeposited);
+        });
+    }
+    for (auto& thread : threads) thread.join();
 
-    EXPECT_EQ(manager_->showBalance(&account).getCents(), 9350);
+    std::int64_t finalTotal = 0;
+    for (AccountId account : accounts) {
+        EXPECT_GE(balance(account), 0);
+        finalTotal += balance(account);
+    }
+    EXPECT_EQ(finalTotal, initialTotal - withdrawn.load() + deposited.load());
 }
@@ -0,0 +1,280 @@
+#include "atm/bank/Account.h"
+#include "atm/bank/AuthService.h"
+#include "atm/bank/Bank.h"
+#include "atm/bank/Ledger.h"
+#include "atm/bank/RollingLimiter.h"
+#include "atm/bank/TransactionHistory.h"
+#include "atm/bank/TransactionJournal.h"
+#include "atm/bank/TransactionManager.h"
+#include "atm/bank/WithdrawHolds.h"
+#include "atm/machine/AtmConstants.h"
+#include "atm/machine/Metrics.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace atm;
+
+namespace {
+
+// Journal file in the temp directory, removed before and after the test.
+class TempJournalPath {
+public:
+    explicit TempJournalPath(const std::string& name)
+        : path_((std::filesystem::temp_directory_path() / ("atm_" + name + ".journal")).string()) {
+        std::filesystem::remove(path_);
+    }
+    ~TempJournalPath() { std::filesystem::remove(path_); }
+    const std::string& str() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+AtmConfig configWithTtl(std::int64_t ttlMs) {
+    AtmConfig config;
+    config.withdrawHoldTtlMs = ttlMs;
+    return config;
+}
+
+}  // namespace
+
+TEST(WithdrawHoldsTest, TableTransitionsOnlyFromHeld) {
+    WithdrawHolds holds(std::chrono::milliseconds(1000));
+    EXPECT_TRUE(holds.add(7, WithdrawHold{1, Money(500)}));
+    EXPECT_FALSE(holds.add(7, WithdrawHold{1, Money(500)}));
+    EXPECT_EQ(holds.state(7), HoldState::Pending);
+    EXPECT_EQ(holds.finish(7, HoldState::Released, nullptr), HoldState::Pending);  // debit still running
+    EXPECT_EQ(holds.held(), 0u);
+    holds.setBalance(7, Money(9500));
+    EXPECT_EQ(holds.held(), 1u);
+    EXPECT_EQ(holds.state(7), HoldState::Held);
+
+    WithdrawHold hold;
+    EXPECT_EQ(holds.finish(7, HoldState::Committed, &hold), HoldState::Held);
+    EXPECT_EQ(hold.amount.getCents(), 500);
+    EXPECT_EQ(holds.finish(7, HoldState::Released, nullptr), HoldState::Committed);  // unchanged
+    EXPECT_EQ(holds.state(7), HoldState::Committed);
+    EXPECT_EQ(holds.held(), 0u);
+    EXPECT_EQ(holds.finish(8, HoldState::Released, nullptr), HoldState::None);
+
+    ASSERT_TRUE(holds.add(9, WithdrawHold{1, Money(100)}));
+    holds.erase(9);  // its debit failed
+    EXPECT_EQ(holds.state(9), HoldState::None);
+    EXPECT_EQ(holds.held(), 0u);
+}
+
+TEST(WithdrawHoldsTest, ExpiredHoldsAreTakenOnceThenForgotten) {
+    WithdrawHolds holds(std::chrono::milliseconds(1000));
+    ASSERT_TRUE(holds.add(1, WithdrawHold{1, Money(100)}));
+    ASSERT_TRUE(holds.add(2, WithdrawHold{1, Money(200)}));
+    ASSERT_TRUE(holds.add(3, WithdrawHold{1, Money(300)}));  // stays Pending: never expires
+    holds.setBalance(1, Money(0));
+    holds.setBalance(2, Money(0));
+    ASSERT_EQ(holds.finish(2, HoldState::Committed, nullptr), HoldState::Held);
+    const WithdrawHolds::Clock::time_point now = WithdrawHolds::Clock::now();
+
+    EXPECT_TRUE(holds.takeExpired(now).empty());
+    const auto expired = holds.takeExpired(now + std::chrono::seconds(2));
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0].first, 1u);
+    EXPECT_EQ(expired[0].second.amount.getCents(), 100);
+    EXPECT_EQ(holds.state(1), HoldState::Expired);
+    EXPECT_EQ(holds.state(2), HoldState::None);  // finished long ago, forgotten
+
+    EXPECT_TRUE(holds.takeExpired(now + std::chrono::seconds(5)).empty());
+    EXPECT_EQ(holds.state(1), HoldState::None);
+    EXPECT_EQ(holds.state(3), HoldState::Pending);
+}
+
+TEST(WithdrawHoldsTest, ReleaseWaitsForTheReserveDebit) {
+    TempJournalPath path("holds_pending");
+    Ledger ledger;
+    TransactionManager transactions(ledger, configWithTtl(1));
+    const AccountId account = ledger.openAccount(Account("Saving", Money(10000)));
+    // A long group-commit window keeps the reserve blocked in its journal append.
+    JournalConfig slow;
+    slow.groupCommitWindow = std::chrono::milliseconds(300);
+    TransactionJournal journal(path.str(), slow);
+    transactions.setJournal(&journal);
+
+    const RequestId hold = newRequestId();
+    std::atomic<bool> reserved{false};
+    std::thread reserver([&] { reserved = transactions.reserveWithdrawal(account, Money(3000), 1, kNoCard, hold); });
+    while (transactions.holds().state(hold) != HoldState::Pending) std::this_thread::yield();
+    // A client retrying a timed-out reserve, and the sweeper: neither may touch the hold yet.
+    EXPECT_FALSE(transactions.releaseWithdrawal(hold));
+    EXPECT_EQ(transactions.releaseExpiredHolds(), 0u);
+    reserver.join();
+    ASSERT_TRUE(reserved.load());
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 7000);
+
+    EXPECT_TRUE(transactions.releaseWithdrawal(hold));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 10000);
+    transactions.setJournal(nullptr);
+    journal.flush();
+    std::vector<JournalRecordType> types;
+    TransactionJournal::replay(path.str(), [&](const JournalRecord& r) { types.push_back(r.type); });
+    EXPECT_EQ(types, (std::vector<JournalRecordType>{JournalRecordType::HoldReserve, JournalRecordType::HoldRelease}));
+}
+
+TEST(WithdrawHoldsTest, CommitRecordsTheWithdrawalOnce) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    TransactionHistory history;
+    transactions.setHistory(&history);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(10000)));
+
+    const RequestId hold = newRequestId();
+    ASSERT_TRUE(transactions.reserveWithdrawal(account, Money(3000), 4, kNoCard, hold));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 7000);  // taken at reserve time
+    EXPECT_TRUE(history.last(account, 10).empty());
+    EXPECT_FALSE(transactions.reserveWithdrawal(account, Money(3000), 4, kNoCard, hold));
+    EXPECT_FALSE(transactions.reserveWithdrawal(account, Money(3000), 4, kNoCard, kNoRequest));
+    ASSERT_TRUE(transactions.depositCash(account, Money(500)));  // lands between reserve and commit
+
+    EXPECT_TRUE(transactions.commitWithdrawal(hold));
+    EXPECT_TRUE(transactions.commitWithdrawal(hold));
+    EXPECT_FALSE(transactions.releaseWithdrawal(hold));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 7500);
+    const std::vector<HistoryEntry> entries = history.last(account, 10);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].type, HistoryType::Withdraw);  // newest first: recorded at commit
+    EXPECT_EQ(entries[0].amount.getCents(), 3000);
+    EXPECT_EQ(entries[0].balance.getCents(), 7000);     // what the debit left, not the later 7500
+    EXPECT_EQ(entries[0].terminal, 4u);
+
+    EXPECT_FALSE(transactions.commitWithdrawal(newRequestId()));
+}
+
+TEST(WithdrawHoldsTest, UnjournaledStepsLeaveTheHoldOpenForRecovery) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(10000)));
+    const RequestId hold = newRequestId();
+    ASSERT_TRUE(transactions.reserveWithdrawal(account, Money(3000), 1, kNoCard, hold));
+
+    // Recovery would release a hold whose commit is not in the journal, so the commit must fail.
+    TransactionJournal broken("/nonexistent-dir/atm.journal");
+    transactions.setJournal(&broken);
+    EXPECT_FALSE(transactions.commitWithdrawal(hold));
+    EXPECT_EQ(transactions.holds().state(hold), HoldState::Held);
+
+    // A release that cannot be journaled still gives the funds back and is flagged as such.
+    Counter& releaseFailed = atmMetrics().rejected(LogEventId::WithdrawReleaseJournalFailed);
+    Counter& depositFailed = atmMetrics().rejected(LogEventId::DepositJournalFailed);
+    const std::uint64_t releaseFailedBefore = releaseFailed.value();
+    const std::uint64_t depositFailedBefore = depositFailed.value();
+    EXPECT_TRUE(transactions.releaseWithdrawal(hold));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 10000);
+    EXPECT_EQ(releaseFailed.value() - releaseFailedBefore, 1u);
+    EXPECT_EQ(depositFailed.value(), depositFailedBefore);
+    transactions.setJournal(nullptr);
+}
+
+TEST(WithdrawHoldsTest, ReleaseReturnsFundsAndLimits) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    RollingLimiter cardLimits(5000, 16);
+    transactions.setWithdrawalLimits(&cardLimits, nullptr);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(10000)));
+    const CardHash card = cardHash("card1");
+
+    const RequestId first = newRequestId();
+    ASSERT_TRUE(transactions.reserveWithdrawal(account, Money(4000), 1, card, first));
+    EXPECT_FALSE(transactions.reserveWithdrawal(account, Money(2000), 1, card, newRequestId()));  // over the card limit
+    EXPECT_TRUE(transactions.releaseWithdrawal(first));
+    EXPECT_TRUE(transactions.releaseWithdrawal(first));
+    EXPECT_FALSE(transactions.commitWithdrawal(first));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 10000);
+
+    // The released amount no longer counts against the card.
+    const RequestId second = newRequestId();
+    ASSERT_TRUE(transactions.reserveWithdrawal(account, Money(5000), 1, card, second));
+    EXPECT_TRUE(transactions.commitWithdrawal(second));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 5000);
+
+    // A refused reserve leaves no hold behind, so the id can be used again.
+    const RequestId tooMuch = newRequestId();
+    EXPECT_FALSE(transactions.reserveWithdrawal(account, Money(9000), 2, kNoCard, tooMuch));
+    EXPECT_EQ(transactions.holds().state(tooMuch), HoldState::None);
+    EXPECT_FALSE(transactions.releaseWithdrawal(tooMuch));
+}
+
+TEST(WithdrawHoldsTest, SweeperReturnsFundsOfExpiredHolds) {
+    Ledger ledger;
+    TransactionManager transactions(ledger, configWithTtl(20));
+    const AccountId account = ledger.openAccount(Account("Saving", Money(10000)));
+    Counter& expiredCount = atmMetrics().holdsExpired;
+    const std::uint64_t expiredBefore = expiredCount.value();
+
+    const RequestId hold = newRequestId();
+    ASSERT_TRUE(transactions.reserveWithdrawal(account, Money(2500), 1, kNoCard, hold));
+    {
+        HoldSweeper sweeper(transactions, std::chrono::milliseconds(5));
+        for (int i = 0; i < 400 && sweeper.expired() == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        EXPECT_EQ(sweeper.expired(), 1u);
+    }
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 10000);
+    EXPECT_EQ(transactions.holds().state(hold), HoldState::Expired);
+    EXPECT_FALSE(transactions.commitWithdrawal(hold));  // too late: the ATM must not count it as paid
+    EXPECT_TRUE(transactions.releaseWithdrawal(hold));
+    EXPECT_EQ(expiredCount.value() - expiredBefore, 1u);
+}
+
+TEST(WithdrawHoldsTest, BankAnswersRetriedReservesFromTheDedupeTable) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    AuthService auth(ledger);
+    Bank bank(transactions, auth);
+    RequestDedupe dedupe(256);
+    bank.setRequestDedupe(&dedupe);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(10000)));
+
+    const RequestId hold = newRequestId();
+    EXPECT_TRUE(bank.reserveCash(account, Money(1000), 1, kNoCard, hold));
+    EXPECT_TRUE(bank.reserveCash(account, Money(1000), 1, kNoCard, hold));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 9000);
+    EXPECT_FALSE(bank.withdrawCash(account, Money(1000), 1, kNoCard, hold));  // same id, other operation
+    EXPECT_TRUE(bank.commitCash(hold));
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 9000);
+}
+
+TEST(WithdrawHoldsTest, ConcurrentSettlesMoveFundsOnce) {
+    Ledger ledger;
+    TransactionManager transactions(ledger);
+    const AccountId account = ledger.openAccount(Account("Saving", Money(100000)));
+    constexpr int kHolds = 200;
+    std::vector<RequestId> ids;
+    for (int i = 0; i < kHolds; ++i) {
+        ids.push_back(newRequestId());
+        ASSERT_TRUE(transactions.reserveWithdrawal(account, Money(100), 1, kNoCard, ids.back()));
+    }
+    // One thread commits, one releases, one sweeps; each hold ends up exactly one way.
+    std::atomic<int> committed{0};
+    std::atomic<int> released{0};
+    std::thread committer([&] {
+        for (RequestId id : ids) {
+            if (transactions.commitWithdrawal(id)) committed.fetch_add(1);
+        }
+    });
+    std::thread releaser([&] {
+        for (auto it = ids.rbegin(); it != ids.rend(); ++it) {
+            if (transactions.holds().state(*it) != HoldState::Committed && transactions.releaseWithdrawal(*it)) {
+                released.fetch_add(1);
+            }
+        }
+    });
+    std::thread sweeper([&] { transactions.releaseExpiredHolds(); });
+    committer.join();
+    releaser.join();
+    sweeper.join();
+    EXPECT_EQ(committed.load() + released.load(), kHolds);
+    EXPECT_EQ(ledger.getBalance(account)->getCents(), 100000 - committed.load() * 100);
+}